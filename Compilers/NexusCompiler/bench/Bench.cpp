@@ -0,0 +1,568 @@
+// Compiler phase benchmark over synthetic corpora.
+//
+//   nexus_bench [--scale=N] [--rounds=N] [-O<level>] [--print=<corpus>]
+//               [corpus...]
+//
+// Each corpus stresses one shape of input: deeply nested expressions, many
+// small functions, long string literals, large array initialisers,
+// generic-heavy declarations and a program split over many imported
+// modules. Every round runs the phases the driver runs, one after the other,
+// on a fresh copy of the source:
+//
+//   tokenize   Lexer::Tokenize over the whole input
+//   parse      Parser::parse, including the lexing it pulls on demand
+//   resolve    ModuleManager::resolveAll, parsing every imported module
+//   typecheck  TypeChecker::check
+//   codegen    CodeGenerator::generate, writing an object file
+//
+// The report is JSON on stdout. Per phase it gives the best time over the
+// rounds, throughput in source bytes and tokens per second, the number and
+// size of operator new calls, and the process's peak RSS once the phase has
+// finished. Each corpus runs in its own forked process so the peak RSS of
+// one does not hide that of the next. Compiler diagnostics are swallowed;
+// a phase that fails reports "ok": false with its first line, and the
+// process exits with status 2 once the report is written. The corpora are
+// valid Nexus, so a failure is a compiler bug, not noise.
+//
+// Nexus has no array literal syntax, so the "arrays" corpus initialises
+// large `new` arrays one element at a time instead.
+
+#include "CodeGen/CodeGen.h"
+#include "CodeGen/CodeGenOptions.h"
+#include "CodeGen/Manager/ModuleManager.h"
+#include "Driver/OutputCapture.h"
+#include "Driver/TempDir.h"
+#include "FileReader/FileReader.h"
+#include "Lexer/Lexer.h"
+#include "Parser/Parser.h"
+#include "TypeChecker/TypeChecker.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// ------------------- //
+// Allocation counting //
+// ------------------- //
+
+namespace {
+std::atomic<size_t> gAllocs{0};
+std::atomic<size_t> gAllocBytes{0};
+} // namespace
+
+void *operator new(size_t n) {
+  gAllocs.fetch_add(1, std::memory_order_relaxed);
+  gAllocBytes.fetch_add(n, std::memory_order_relaxed);
+  if (void *p = std::malloc(n ? n : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// ----------------- //
+// Corpus generators //
+// ----------------- //
+
+struct Module {
+  std::string path; // relative to the main file, e.g. "lib/M0.nx"
+  std::string source;
+};
+
+struct Corpus {
+  const char *name;
+  std::string (*generate)(int scale);
+  // Files the main source imports, written next to it before the first
+  // round. Null for single-file corpora.
+  std::vector<Module> (*modules)(int scale) = nullptr;
+};
+
+// Functions whose bodies are one expression nested 48 parentheses deep.
+std::string deepExpressions(int scale) {
+  std::ostringstream os;
+  const int depth = 48;
+  for (int i = 0; i < 200 * scale; ++i) {
+    os << "fn E" << i << "(i32 a, i32 b) -> i32 {\n    i32 r = ";
+    os << std::string(depth, '(') << "a";
+    for (int d = 0; d < depth; ++d)
+      os << (d % 3 == 0 ? " + b * " : d % 3 == 1 ? " - " : " / ") << d + 1
+         << ")";
+    os << ";\n    return r;\n}\n\n";
+  }
+  os << "fn Main() -> i32 {\n    return E0(1, 2);\n}\n";
+  return os.str();
+}
+
+// Thousands of three-line functions, the shape of most real programs.
+std::string manyFunctions(int scale) {
+  std::ostringstream os;
+  for (int i = 0; i < 3000 * scale; ++i)
+    os << "fn F" << i << "(i32 a) -> i32 {\n    i32 b = a + " << i
+       << ";\n    return b * 2;\n}\n\n";
+  os << "fn Main() -> i32 {\n    return F0(1);\n}\n";
+  return os.str();
+}
+
+// Functions that each hold a 2 KB string literal.
+std::string longStrings(int scale) {
+  static const char *const words[] = {"lorem", "ipsum", "dolor", "sit",
+                                      "amet",  "nexus", "token", "buffer"};
+  std::ostringstream os;
+  for (int i = 0; i < 200 * scale; ++i) {
+    os << "fn S" << i << "() -> i32 {\n    str s = \"";
+    size_t len = 0;
+    for (int w = 0; len < 2048; ++w) {
+      const char *word = words[(i + w) % 8];
+      os << word << (w % 16 == 15 ? "\\n" : " ");
+      len += std::char_traits<char>::length(word) + 1;
+    }
+    os << "\";\n    return " << i << ";\n}\n\n";
+  }
+  os << "fn Main() -> i32 {\n    return S0();\n}\n";
+  return os.str();
+}
+
+// Large arrays filled element by element.
+std::string largeArrays(int scale) {
+  std::ostringstream os;
+  const int elems = 1000;
+  for (int i = 0; i < 20 * scale; ++i) {
+    os << "fn A" << i << "() -> i32 {\n    i32[] a = new i32[" << elems
+       << "];\n";
+    for (int k = 0; k < elems; ++k)
+      os << "    a[" << k << "] = " << (k * 7919 + i) % 100000 << ";\n";
+    os << "    return a[" << i % elems << "];\n}\n\n";
+  }
+  os << "fn Main() -> i32 {\n    return A0();\n}\n";
+  return os.str();
+}
+
+// Generic enums, structs and functions, and calls with explicit type
+// arguments.
+std::string heavyGenerics(int scale) {
+  std::ostringstream os;
+  const int types = 100 * scale;
+  for (int i = 0; i < types; ++i) {
+    os << "enum Option" << i << "<T> {\n    None,\n    Some(T value)\n}\n\n";
+    os << "struct Pair" << i << "<K, V> {\n    K key;\n    V value;\n}\n\n";
+  }
+  for (int i = 0; i < 4 * types; ++i)
+    os << "fn Pick" << i << "(<T, U> T a, U b) -> T {\n    T r = a;\n"
+       << "    return r;\n}\n\n";
+  os << "fn Main() -> i32 {\n    i32 total = 0;\n";
+  for (int i = 0; i < 4 * types; ++i)
+    os << "    total = total + Pick" << i << "<i32, f32>(" << i << ", 1.5);\n";
+  os << "    return total;\n}\n";
+  return os.str();
+}
+
+// A main file that imports lib::M0 .. lib::M<n> and calls into each.
+const int kModulesPerScale = 40;
+
+std::string importingMain(int scale) {
+  std::ostringstream os;
+  const int count = kModulesPerScale * scale;
+  for (int m = 0; m < count; ++m)
+    os << "import lib::M" << m << ";\n";
+  os << "\nfn Main() -> i32 {\n    i32 total = 0;\n";
+  for (int m = 0; m < count; ++m)
+    os << "    total = total + M" << m << "F0(" << m << ");\n";
+  os << "    return total;\n}\n";
+  return os.str();
+}
+
+// The modules importingMain pulls in: a chain of public functions and an
+// unused private helper the import filter has to drop.
+std::vector<Module> importedModules(int scale) {
+  std::vector<Module> mods;
+  const int count = kModulesPerScale * scale;
+  const int fns = 50;
+  for (int m = 0; m < count; ++m) {
+    std::ostringstream os;
+    const std::string prefix = "M" + std::to_string(m);
+    for (int f = 0; f < fns; ++f) {
+      os << "public fn " << prefix << "F" << f << "(i32 a) -> i32 {\n";
+      if (f + 1 < fns)
+        os << "    i32 b = " << prefix << "F" << f + 1 << "(a) + " << f
+           << ";\n";
+      else
+        os << "    i32 b = a * 3;\n";
+      os << "    return b;\n}\n\n";
+    }
+    os << "fn " << prefix << "Helper(i32 a) -> i32 {\n    return a * 3;\n}\n";
+    mods.push_back({"lib/" + prefix + ".nx", os.str()});
+  }
+  return mods;
+}
+
+const Corpus kCorpora[] = {
+    {"expressions", deepExpressions},
+    {"functions", manyFunctions},
+    {"strings", longStrings},
+    {"arrays", largeArrays},
+    {"generics", heavyGenerics},
+    {"modules", importingMain, importedModules},
+};
+
+// --------------- //
+// Phase recording //
+// --------------- //
+
+struct PhaseResult {
+  PhaseResult(const char *n) : name(n) {}
+
+  const char *name;
+  bool ok = true;
+  std::string error;
+  double bestMs = 1e300;
+  size_t allocs = 0;
+  size_t allocBytes = 0;
+  long peakRssKb = 0;
+};
+
+long peakRssKb() {
+  rusage ru{};
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss; // kilobytes on Linux
+}
+
+// Drops the ANSI colour sequences diagnostics are wrapped in.
+std::string stripColour(const std::string &s) {
+  std::string out;
+  for (size_t i = 0; i < s.size(); ++i) {
+    if (s[i] == '\033' && i + 1 < s.size() && s[i + 1] == '[') {
+      i = s.find('m', i);
+      if (i == std::string::npos)
+        break;
+      continue;
+    }
+    out += s[i];
+  }
+  return out;
+}
+
+// Runs fn with the compiler's output captured, and folds the time,
+// allocations and outcome into r. fn returns false on failure, optionally
+// describing it in its std::string & argument.
+template <class Fn> bool runPhase(PhaseResult &r, Fn fn) {
+  OutputCapture capture;
+  size_t allocs = gAllocs.load(std::memory_order_relaxed);
+  size_t bytes = gAllocBytes.load(std::memory_order_relaxed);
+  auto start = std::chrono::steady_clock::now();
+
+  bool ok;
+  std::string error;
+  try {
+    ok = fn(error);
+  } catch (const std::exception &e) {
+    ok = false;
+    error = e.what();
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  double ms = std::chrono::duration<double, std::milli>(end - start).count();
+  if (ms < r.bestMs)
+    r.bestMs = ms;
+  r.allocs = gAllocs.load(std::memory_order_relaxed) - allocs;
+  r.allocBytes = gAllocBytes.load(std::memory_order_relaxed) - bytes;
+  r.peakRssKb = peakRssKb();
+
+  if (!ok && r.ok) {
+    r.ok = false;
+    // Followed by the first thing the phase wrote to std::cerr, if anything.
+    for (const auto &chunk : capture.take())
+      if (chunk.isErr) {
+        std::string line =
+            stripColour(chunk.text.substr(0, chunk.text.find('\n')));
+        error = error.empty() ? line : error + ": " + line;
+        break;
+      }
+    r.error = error;
+  }
+  return ok;
+}
+
+// ----------- //
+// JSON output //
+// ----------- //
+
+std::string jsonString(const std::string &s) {
+  std::string out = "\"";
+  for (char c : s) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (u < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", u);
+      out += buf;
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+void printPhase(FILE *out, const PhaseResult &r, size_t bytes, size_t tokens,
+                bool last) {
+  double s = r.bestMs / 1000.0;
+  if (s <= 0.0)
+    s = 1e-9;
+  std::fprintf(out, "        {\"phase\": \"%s\", \"ok\": %s, \"ms\": %.3f, "
+              "\"mb_per_s\": %.2f, \"tokens_per_s\": %.0f, "
+              "\"allocs\": %zu, \"alloc_bytes\": %zu, "
+              "\"peak_rss_kb\": %ld",
+              r.name, r.ok ? "true" : "false", r.bestMs,
+              static_cast<double>(bytes) / s / 1e6,
+              static_cast<double>(tokens) / s, r.allocs, r.allocBytes,
+              r.peakRssKb);
+  if (!r.ok)
+    std::fprintf(out, ", \"error\": %s", jsonString(r.error).c_str());
+  std::fprintf(out, "}%s\n", last ? "" : ",");
+}
+
+// ---------------- //
+// Running a corpus //
+// ---------------- //
+
+struct BenchConfig {
+  int scale = 1;
+  int rounds = 3;
+  CodeGenOptions cgOpts;
+};
+
+// Benchmarks one corpus and writes its JSON object to out. Returns false if
+// any phase failed.
+bool runCorpus(const Corpus &corpus, const BenchConfig &cfg, FILE *out) {
+  std::string source = corpus.generate(cfg.scale);
+  size_t lines = 0;
+  for (char c : source)
+    lines += c == '\n';
+
+  TempDir scratch;
+  fs::path dir = scratch.valid() ? scratch.path() : fs::current_path();
+  std::string object = (dir / (std::string(corpus.name) + ".o")).string();
+
+  std::vector<Module> modules;
+  if (corpus.modules)
+    modules = corpus.modules(cfg.scale);
+  size_t moduleBytes = 0;
+  for (const Module &m : modules) {
+    fs::path file = dir / m.path;
+    fs::create_directories(file.parent_path());
+    std::ofstream(file, std::ios::binary) << m.source;
+    moduleBytes += m.source.size();
+  }
+
+  PhaseResult phases[] = {"tokenize", "parse", "resolve", "typecheck",
+                          "codegen"};
+  size_t tokens = 0;
+
+  for (int round = 0; round < cfg.rounds; ++round) {
+    SourceBuffer tokenizeBuf(source);
+    runPhase(phases[0], [&](std::string &) {
+      Lexer lexer(std::move(tokenizeBuf));
+      tokens = lexer.Tokenize().size();
+      return true;
+    });
+
+    SourceBuffer parseBuf(source);
+    std::unique_ptr<Program> program;
+    bool parsed = runPhase(phases[1], [&](std::string &) {
+      Lexer lexer(std::move(parseBuf));
+      Parser parser(lexer);
+      program = parser.parse();
+      return program != nullptr;
+    });
+    if (!parsed) {
+      for (PhaseResult &later : phases)
+        if (&later > &phases[1]) {
+          later.ok = false;
+          later.error = "not run: parse failed";
+          later.bestMs = 0.0;
+        }
+      break;
+    }
+
+    ModuleCache cache;
+    ModuleManager mm(dir, dir, cache);
+    runPhase(phases[2], [&](std::string &) {
+      mm.resolveAll(*program);
+      return true;
+    });
+
+    runPhase(phases[3], [&](std::string &error) {
+      TypeChecker tc;
+      if (tc.check(*program))
+        return true;
+      error = tc.errors().front();
+      return false;
+    });
+
+    CodeGenerator cg(cfg.cgOpts);
+    runPhase(phases[4], [&](std::string &error) {
+      if (cg.generate(*program, object) && !cg.reportedErrors())
+        return true;
+      error = "code generation failed";
+      return false;
+    });
+  }
+
+  std::fprintf(out, "    {\"corpus\": \"%s\", \"bytes\": %zu, \"lines\": %zu, "
+              "\"tokens\": %zu, ",
+              corpus.name, source.size(), lines, tokens);
+  if (!modules.empty())
+    std::fprintf(out, "\"modules\": %zu, \"module_bytes\": %zu, ",
+                 modules.size(), moduleBytes);
+  std::fprintf(out, "\"phases\": [\n");
+  size_t count = sizeof(phases) / sizeof(phases[0]);
+  bool allOk = true;
+  for (size_t i = 0; i < count; ++i) {
+    printPhase(out, phases[i], source.size(), tokens, i + 1 == count);
+    allOk = allOk && phases[i].ok;
+  }
+  std::fprintf(out, "    ]}");
+  return allOk;
+}
+
+// Runs runCorpus in a forked child and returns the JSON it wrote, or an
+// empty string if the child crashed. phasesOk is cleared if a phase failed.
+std::string runCorpusIsolated(const Corpus &corpus, const BenchConfig &cfg,
+                              bool &phasesOk) {
+  int fds[2];
+  if (pipe(fds) != 0)
+    return "";
+
+  std::fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    FILE *out = fdopen(fds[1], "w");
+    bool ok = runCorpus(corpus, cfg, out);
+    std::fclose(out);
+    _exit(ok ? 0 : 2);
+  }
+  close(fds[1]);
+
+  std::string json;
+  char buf[4096];
+  ssize_t n;
+  while (pid > 0 && (n = read(fds[0], buf, sizeof(buf))) > 0)
+    json.append(buf, static_cast<size_t>(n));
+  close(fds[0]);
+
+  int status = 1;
+  if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status))
+    return "";
+  if (WEXITSTATUS(status) == 2)
+    phasesOk = false;
+  else if (WEXITSTATUS(status) != 0)
+    return "";
+  return json;
+}
+
+const Corpus *findCorpus(const std::string &name) {
+  for (const Corpus &c : kCorpora)
+    if (name == c.name)
+      return &c;
+  return nullptr;
+}
+
+void printUsage() {
+  std::cerr << "Usage: nexus_bench [--scale=N] [--rounds=N] [-O<level>] "
+               "[--print=<corpus>] [corpus...]\n";
+  std::cerr << "Corpora:";
+  for (const Corpus &c : kCorpora)
+    std::cerr << " " << c.name;
+  std::cerr << "\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  BenchConfig cfg;
+  std::vector<const Corpus *> selected;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("--scale=", 0) == 0) {
+      cfg.scale = std::atoi(arg.c_str() + 8);
+    } else if (arg.rfind("--rounds=", 0) == 0) {
+      cfg.rounds = std::atoi(arg.c_str() + 9);
+    } else if (auto level = parseOptLevel(arg)) {
+      cfg.cgOpts.optLevel = *level;
+    } else if (arg.rfind("--print=", 0) == 0) {
+      const Corpus *c = findCorpus(arg.substr(8));
+      if (!c) {
+        printUsage();
+        return 1;
+      }
+      int scale = cfg.scale < 1 ? 1 : cfg.scale;
+      std::cout << c->generate(scale);
+      if (c->modules)
+        for (const Module &m : c->modules(scale))
+          std::cout << "\n// ---- " << m.path << " ----\n" << m.source;
+      return 0;
+    } else if (const Corpus *c = findCorpus(arg)) {
+      selected.push_back(c);
+    } else {
+      printUsage();
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+  if (cfg.scale < 1 || cfg.rounds < 1) {
+    printUsage();
+    return 1;
+  }
+  if (selected.empty())
+    for (const Corpus &c : kCorpora)
+      selected.push_back(&c);
+
+  OutputCapture::install();
+
+  std::printf("{\n  \"scale\": %d,\n  \"rounds\": %d,\n  \"opt\": \"%s\",\n"
+              "  \"corpora\": [\n",
+              cfg.scale, cfg.rounds, optLevelFlag(cfg.cgOpts.optLevel));
+
+  int status = 0;
+  const char *separator = "";
+  for (const Corpus *c : selected) {
+    bool phasesOk = true;
+    std::string json = runCorpusIsolated(*c, cfg, phasesOk);
+    if (json.empty()) {
+      std::fprintf(stderr, "nexus_bench: corpus '%s' did not complete\n",
+                   c->name);
+      status = 1;
+      continue;
+    }
+    if (!phasesOk) {
+      std::fprintf(stderr, "nexus_bench: corpus '%s' failed a phase\n",
+                   c->name);
+      if (status == 0)
+        status = 2;
+    }
+    std::printf("%s%s", separator, json.c_str());
+    separator = ",\n";
+  }
+
+  std::printf("\n  ]\n}\n");
+  return status;
+}
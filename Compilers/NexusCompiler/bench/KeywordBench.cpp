@@ -0,0 +1,151 @@
+// Keyword recognition micro-benchmark: the perfect hash in Token/Keywords.h
+// against the length switch the Lexer used before it.
+//
+//   nexus_keyword_bench [lookups]
+//
+// Both matchers classify the same word stream (keywords mixed with the
+// kind of identifiers real sources contain); the best of several rounds is
+// reported per matcher, and the run fails if they ever disagree.
+
+#include "Token/Keywords.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// The Lexer's matcher before Keywords.h, kept verbatim as the baseline.
+TokenKind lengthSwitch(std::string_view w) {
+  switch (w.size()) {
+  case 2:
+    if (w == "if")
+      return TokenKind::IF;
+    if (w == "fn")
+      return TokenKind::FN;
+    if (w == "as")
+      return TokenKind::AS;
+    break;
+  case 3:
+    if (w == "new")
+      return TokenKind::NEW;
+    if (w == "for")
+      return TokenKind::FOR;
+    if (w == "mut")
+      return TokenKind::MUT;
+    break;
+  case 4:
+    if (w == "else")
+      return TokenKind::ElSE;
+    if (w == "true")
+      return TokenKind::LIT_BOOL;
+    if (w == "loop")
+      return TokenKind::LOOP;
+    if (w == "enum")
+      return TokenKind::ENUM;
+    break;
+  case 5:
+    if (w == "while")
+      return TokenKind::WHILE;
+    if (w == "false")
+      return TokenKind::LIT_BOOL;
+    if (w == "const")
+      return TokenKind::CONST;
+    if (w == "break")
+      return TokenKind::BREAK;
+    if (w == "match")
+      return TokenKind::MATCH;
+    break;
+  case 6:
+    if (w == "return")
+      return TokenKind::RETURN;
+    if (w == "import")
+      return TokenKind::IMPORT;
+    if (w == "public")
+      return TokenKind::PUBLIC;
+    break;
+  case 7:
+    if (w == "private")
+      return TokenKind::PRIVATE;
+    break;
+  case 8:
+    if (w == "continue")
+      return TokenKind::CONTINUE;
+    break;
+  case 9:
+    if (w == "protected")
+      return TokenKind::PRIVATE;
+    break;
+  }
+  return TokenKind::IDENTIFIER;
+}
+
+// Roughly one keyword per three words, as in the example programs.
+std::vector<std::string> makeCorpus() {
+  static const char *const idents[] = {
+      "i",      "j",     "x",        "n",       "len",    "i32",
+      "i64",    "f32",   "str",      "bool",    "char",   "void",
+      "string", "count", "value",    "result",  "Printf", "arr",
+      "node",   "next",  "head",     "tail",    "total",  "index",
+      "buffer", "width", "height",   "matches", "format", "Person",
+      "age",    "name",  "sum",      "main",    "tmp",    "data",
+  };
+  std::vector<std::string> words;
+  unsigned seed = 12345;
+  auto rnd = [&seed] {
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0x7fff;
+  };
+  for (int i = 0; i < 4096; ++i) {
+    if (rnd() % 3 == 0)
+      words.emplace_back(kKeywords[rnd() % keyword_detail::kCount].spelling);
+    else
+      words.emplace_back(idents[rnd() % (sizeof(idents) / sizeof(*idents))]);
+  }
+  return words;
+}
+
+template <class Fn>
+double bestNsPerLookup(const std::vector<std::string_view> &words,
+                       size_t lookups, Fn fn, unsigned &sink) {
+  double best = 1e300;
+  for (int round = 0; round < 5; ++round) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+      sink += static_cast<unsigned>(fn(words[i & (words.size() - 1)]));
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    if (ns < best)
+      best = ns;
+  }
+  return best / static_cast<double>(lookups);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t lookups = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+
+  std::vector<std::string> corpus = makeCorpus();
+  std::vector<std::string_view> words(corpus.begin(), corpus.end());
+
+  for (std::string_view w : words)
+    if (keywordKind(w) != lengthSwitch(w)) {
+      std::fprintf(stderr, "mismatch on '%.*s'\n", static_cast<int>(w.size()),
+                   w.data());
+      return 1;
+    }
+
+  unsigned sink = 0;
+  double sw = bestNsPerLookup(
+      words, lookups, [](std::string_view w) { return lengthSwitch(w); }, sink);
+  double ph = bestNsPerLookup(
+      words, lookups, [](std::string_view w) { return keywordKind(w); }, sink);
+
+  std::printf("length switch : %.2f ns/lookup\n", sw);
+  std::printf("perfect hash  : %.2f ns/lookup (%.2fx)\n", ph, sw / ph);
+  std::printf("checksum      : %u\n", sink);
+  return 0;
+}
@@ -2,20 +2,30 @@
 #define AST_H
 
 #include "../Token/TokenType.h"
+#include "Arena.h"
 #include "ExprVisitor.h"
+#include "llvm/Support/Casting.h"
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
+using llvm::cast;
+using llvm::dyn_cast;
+using llvm::dyn_cast_or_null;
+using llvm::isa;
+
 // ------------- //
 // JSON helpers  //
 // ------------- //
 namespace json_utils {
-inline std::string escape(const std::string &s) {
+inline std::string escape(std::string_view s) {
   std::ostringstream oss;
   oss << '"';
   for (char c : s) {
@@ -64,7 +74,7 @@ struct Statement;
 struct Block;
 struct Function;
 
-using ExprPtr = std::unique_ptr<Expression>;
+using ExprPtr = AstPtr<Expression>;
 
 // ------------------ //
 // Core token wrapper //
@@ -72,6 +82,7 @@ using ExprPtr = std::unique_ptr<Expression>;
 struct Identifier {
   Token token;
   explicit Identifier(const Token &t) : token(t) {}
+  Symbol symbol() const { return token.getSymbol(); }
 };
 
 // ---------------- //
@@ -96,23 +107,37 @@ struct TypeDesc {
 
   const Identifier &elementType() const { return base; }
 
-  std::string fullName() const {
+  // Spells the type once the parser has read all of it, so fullName() is a
+  // field read. Call again after changing base, typeArgs or dimensions.
+  void seal() { spelled_ = spell(); }
+
+  // The spelled type, e.g. "Pair<str, i32>" or "array.i32", interned. An
+  // unsealed TypeDesc spells itself on each call.
+  Symbol fullName() const { return spelled_.empty() ? spell() : spelled_; }
+
+private:
+  // A plain name is the base's own symbol and builds nothing.
+  Symbol spell() const {
     if (isPtr)
-      return "ptr";
-    std::string name = base.token.getWord();
+      return Symbol::intern("ptr");
+    if (typeArgs.empty() && dimensions == 0)
+      return base.symbol();
+    std::string name(base.token.getWord());
     if (!typeArgs.empty()) {
       name += "<";
       for (size_t i = 0; i < typeArgs.size(); ++i) {
         if (i)
           name += ", ";
-        name += typeArgs[i].fullName();
+        name += typeArgs[i].fullName().str();
       }
       name += ">";
     }
     for (int i = 0; i < dimensions; ++i)
       name = "array." + name;
-    return name;
+    return Symbol::intern(name);
   }
+
+  Symbol spelled_;
 };
 
 using ArrayType = TypeDesc;
@@ -203,16 +228,40 @@ inline std::string toString(UnaryOp op) {
 // --------------- //
 // Expression base //
 // --------------- //
+enum class ExprKind : uint8_t {
+  IntLit, FloatLit, StrLit, BoolLit, CharLit, NullLit, Ident, BorrowArg,
+  BorrowMutArg, Binary, ChainedCmp, Unary, Cast, Call, GenericCall, Assign,
+  Increment, Decrement, CompoundAssign, NewArray, ArrayIndex, ArrayIndexAssign,
+  LengthProperty, IndexedLength, FieldAccess, FieldAssign, StructLit,
+  TypeIntrinsic, EnumConstructor, Error
+};
+
+// Every node carries its concrete class as a kind tag. ExprNode<K> supplies
+// classof(), so isa/cast/dyn_cast (LLVM's, re-exported below) test an AST
+// pointer with one byte compare instead of a dynamic_cast, and hot
+// dispatchers can switch on getKind().
 struct Expression {
+  explicit Expression(ExprKind k) : nodeKind(k) {}
   virtual ~Expression() = default;
   virtual void toJson(std::ostream &os, int indent = 0) const = 0;
   virtual llvm::Value *accept(ExprVisitor &v) const = 0;
+
+  ExprKind getKind() const { return nodeKind; }
+
+private:
+  const ExprKind nodeKind;
+};
+
+template <ExprKind K> struct ExprNode : Expression {
+  static constexpr ExprKind Kind = K;
+  ExprNode() : Expression(K) {}
+  static bool classof(const Expression *e) { return e->getKind() == K; }
 };
 
 // ------------------- //
 // Literal expressions //
 // ------------------- //
-struct IntLitExpr : Expression {
+struct IntLitExpr : ExprNode<ExprKind::IntLit> {
   Token lit;
   explicit IntLitExpr(const Token &t) : lit(t) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -225,7 +274,7 @@ struct IntLitExpr : Expression {
   }
 };
 
-struct FloatLitExpr : Expression {
+struct FloatLitExpr : ExprNode<ExprKind::FloatLit> {
   Token lit;
   explicit FloatLitExpr(const Token &t) : lit(t) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -238,7 +287,7 @@ struct FloatLitExpr : Expression {
   }
 };
 
-struct StrLitExpr : Expression {
+struct StrLitExpr : ExprNode<ExprKind::StrLit> {
   Token lit;
   explicit StrLitExpr(const Token &t) : lit(t) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -251,7 +300,7 @@ struct StrLitExpr : Expression {
   }
 };
 
-struct BoolLitExpr : Expression {
+struct BoolLitExpr : ExprNode<ExprKind::BoolLit> {
   Token lit;
   explicit BoolLitExpr(const Token &t) : lit(t) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -264,7 +313,7 @@ struct BoolLitExpr : Expression {
   }
 };
 
-struct CharLitExpr : Expression {
+struct CharLitExpr : ExprNode<ExprKind::CharLit> {
   Token lit;
   explicit CharLitExpr(const Token &t) : lit(t) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -277,7 +326,7 @@ struct CharLitExpr : Expression {
   }
 };
 
-struct NullLitExpr : Expression {
+struct NullLitExpr : ExprNode<ExprKind::NullLit> {
   NullLitExpr() = default;
   llvm::Value *accept(ExprVisitor &v) const override {
     return v.visitNullLit(*this);
@@ -287,7 +336,7 @@ struct NullLitExpr : Expression {
   }
 };
 
-struct IdentExpr : Expression {
+struct IdentExpr : ExprNode<ExprKind::Ident> {
   Identifier name;
   explicit IdentExpr(const Identifier &n) : name(n) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -300,7 +349,7 @@ struct IdentExpr : Expression {
   }
 };
 
-struct BorrowArgExpr : Expression {
+struct BorrowArgExpr : ExprNode<ExprKind::BorrowArg> {
   Identifier name;
   explicit BorrowArgExpr(const Identifier &n) : name(n) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -313,7 +362,7 @@ struct BorrowArgExpr : Expression {
   }
 };
 
-struct BorrowMutArgExpr : Expression {
+struct BorrowMutArgExpr : ExprNode<ExprKind::BorrowMutArg> {
   Identifier name;
   explicit BorrowMutArgExpr(const Identifier &n) : name(n) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -326,7 +375,7 @@ struct BorrowMutArgExpr : Expression {
   }
 };
 
-struct BinaryExpr : Expression {
+struct BinaryExpr : ExprNode<ExprKind::Binary> {
   BinaryOp op;
   ExprPtr left, right;
   BinaryExpr(BinaryOp o, ExprPtr l, ExprPtr r)
@@ -347,7 +396,7 @@ struct BinaryExpr : Expression {
   }
 };
 
-struct ChainedCmpExpr : Expression {
+struct ChainedCmpExpr : ExprNode<ExprKind::ChainedCmp> {
   ExprPtr lhs;
   std::vector<BinaryOp> ops;
   std::vector<ExprPtr> operands;
@@ -378,7 +427,7 @@ struct ChainedCmpExpr : Expression {
   }
 };
 
-struct UnaryExpr : Expression {
+struct UnaryExpr : ExprNode<ExprKind::Unary> {
   UnaryOp op;
   ExprPtr operand;
   UnaryExpr(UnaryOp o, ExprPtr e) : op(o), operand(std::move(e)) {}
@@ -395,7 +444,7 @@ struct UnaryExpr : Expression {
   }
 };
 
-struct CastExpr : Expression {
+struct CastExpr : ExprNode<ExprKind::Cast> {
   ExprPtr expr;
   TypeDesc targetType;
 
@@ -408,17 +457,17 @@ struct CastExpr : Expression {
   void toJson(std::ostream &os, int indent) const override {
     std::string p(indent, ' ');
     os << p << "{\"kind\":\"CastExpr\",\"target\":"
-       << json_utils::escape(targetType.fullName()) << ",\"expr\":";
+       << json_utils::escape(targetType.fullName().str()) << ",\"expr\":";
     expr->toJson(os, indent + 2);
     os << "}";
   }
 };
 
-struct CallExpr : Expression {
-  std::unique_ptr<Expression> callee;
+struct CallExpr : ExprNode<ExprKind::Call> {
+  AstPtr<Expression> callee;
   std::vector<ExprPtr> arguments;
 
-  CallExpr(std::unique_ptr<Expression> c, std::vector<ExprPtr> args)
+  CallExpr(AstPtr<Expression> c, std::vector<ExprPtr> args)
       : callee(std::move(c)), arguments(std::move(args)) {}
 
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -437,7 +486,7 @@ struct CallExpr : Expression {
   }
 };
 
-struct GenericCallExpr : Expression {
+struct GenericCallExpr : ExprNode<ExprKind::GenericCall> {
   Identifier callee;
   std::vector<TypeDesc> typeArgs;
   std::vector<ExprPtr> arguments;
@@ -457,7 +506,7 @@ struct GenericCallExpr : Expression {
     for (size_t i = 0; i < typeArgs.size(); ++i) {
       if (i)
         os << ",";
-      os << json_utils::escape(typeArgs[i].fullName());
+      os << json_utils::escape(typeArgs[i].fullName().str());
     }
     os << "],\"args\":[";
     for (size_t i = 0; i < arguments.size(); ++i) {
@@ -469,7 +518,7 @@ struct GenericCallExpr : Expression {
   }
 };
 
-struct AssignExpr : Expression {
+struct AssignExpr : ExprNode<ExprKind::Assign> {
   Identifier target;
   ExprPtr value;
   AssignKind kind;
@@ -487,7 +536,7 @@ struct AssignExpr : Expression {
   }
 };
 
-struct Increment : Expression {
+struct Increment : ExprNode<ExprKind::Increment> {
   Identifier target;
   explicit Increment(const Identifier &t) : target(t) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -499,7 +548,7 @@ struct Increment : Expression {
   }
 };
 
-struct Decrement : Expression {
+struct Decrement : ExprNode<ExprKind::Decrement> {
   Identifier target;
   explicit Decrement(const Identifier &t) : target(t) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -511,7 +560,7 @@ struct Decrement : Expression {
   }
 };
 
-struct CompoundAssignExpr : Expression {
+struct CompoundAssignExpr : ExprNode<ExprKind::CompoundAssign> {
   Identifier target;
   BinaryOp op;
   ExprPtr value;
@@ -533,7 +582,7 @@ struct CompoundAssignExpr : Expression {
 };
 
 // ARRAYS AST Structures
-struct NewArrayExpr : Expression {
+struct NewArrayExpr : ExprNode<ExprKind::NewArray> {
   TypeDesc arrayType;
   std::vector<ExprPtr> sizes;
   NewArrayExpr(TypeDesc t, std::vector<ExprPtr> sz)
@@ -544,12 +593,12 @@ struct NewArrayExpr : Expression {
   void toJson(std::ostream &os, int indent) const override {
     std::string p(indent, ' ');
     os << p << "{\"kind\":\"NewArrayExpr\",\"type\":"
-       << json_utils::escape(arrayType.fullName())
+       << json_utils::escape(arrayType.fullName().str())
        << ",\"dims\":" << sizes.size() << "}";
   }
 };
 
-struct ArrayIndexExpr : Expression {
+struct ArrayIndexExpr : ExprNode<ExprKind::ArrayIndex> {
   Identifier array;
   ExprPtr object;
   std::vector<ExprPtr> indices;
@@ -578,7 +627,7 @@ struct ArrayIndexExpr : Expression {
   }
 };
 
-struct ArrayIndexAssignExpr : Expression {
+struct ArrayIndexAssignExpr : ExprNode<ExprKind::ArrayIndexAssign> {
   Identifier array;
   ExprPtr object;
   std::vector<ExprPtr> indices;
@@ -609,7 +658,7 @@ struct ArrayIndexAssignExpr : Expression {
   }
 };
 
-struct LengthPropertyExpr : Expression {
+struct LengthPropertyExpr : ExprNode<ExprKind::LengthProperty> {
   Identifier name;
   explicit LengthPropertyExpr(const Identifier &n) : name(n) {}
   llvm::Value *accept(ExprVisitor &v) const override {
@@ -622,7 +671,7 @@ struct LengthPropertyExpr : Expression {
   }
 };
 
-struct IndexedLengthExpr : Expression {
+struct IndexedLengthExpr : ExprNode<ExprKind::IndexedLength> {
   Identifier arrayName;
   std::vector<ExprPtr> indices;
   IndexedLengthExpr(Identifier name, std::vector<ExprPtr> idxs)
@@ -638,7 +687,7 @@ struct IndexedLengthExpr : Expression {
   }
 };
 
-struct FieldAccessExpr : Expression {
+struct FieldAccessExpr : ExprNode<ExprKind::FieldAccess> {
   ExprPtr object;
   std::string field;
   FieldAccessExpr(ExprPtr obj, std::string f)
@@ -655,7 +704,7 @@ struct FieldAccessExpr : Expression {
   }
 };
 
-struct FieldAssignExpr : Expression {
+struct FieldAssignExpr : ExprNode<ExprKind::FieldAssign> {
   ExprPtr object;
   std::string field;
   ExprPtr value;
@@ -673,7 +722,7 @@ struct FieldAssignExpr : Expression {
   }
 };
 
-struct StructLitExpr : Expression {
+struct StructLitExpr : ExprNode<ExprKind::StructLit> {
   std::string typeName;
   std::vector<ExprPtr> values;
   StructLitExpr(std::string tn, std::vector<ExprPtr> vals)
@@ -694,10 +743,10 @@ struct StructLitExpr : Expression {
   }
 };
 
-struct TypeIntrinsicExpr : Expression {
-  std::unique_ptr<Expression> value;
+struct TypeIntrinsicExpr : ExprNode<ExprKind::TypeIntrinsic> {
+  AstPtr<Expression> value;
   TypeDesc typeDesc;
-  TypeIntrinsicExpr(std::unique_ptr<Expression> v, TypeDesc td)
+  TypeIntrinsicExpr(AstPtr<Expression> v, TypeDesc td)
       : value(std::move(v)), typeDesc(std::move(td)) {}
   llvm::Value *accept(ExprVisitor &v) const override {
     return v.visitTypeIntrinsic(*this);
@@ -711,19 +760,61 @@ struct TypeIntrinsicExpr : Expression {
   }
 };
 
+// Stands in for an expression the parser could not read. Its diagnostic
+// has already been recorded; `at` is the token the error was reported on.
+struct ErrorExpr : ExprNode<ExprKind::Error> {
+  Token at;
+  explicit ErrorExpr(const Token &t) : at(t) {}
+  llvm::Value *accept(ExprVisitor &v) const override {
+    return v.visitErrorExpr(*this);
+  }
+  void toJson(std::ostream &os, int indent) const override {
+    os << std::string(indent, ' ') << "{\"kind\":\"Error\",\"line\":"
+       << at.getLine() << "}";
+  }
+};
+
 // -------------- //
 // Statement base //
 // -------------- //
+enum class StmtKind : uint8_t {
+  VarDecl, If, While, ForRange, ForEach, Return, Break, Continue, Expr, Match,
+  Error
+};
+
 struct Statement {
+  explicit Statement(StmtKind k) : nodeKind(k) {}
   virtual ~Statement() = default;
   virtual void toJson(std::ostream &os, int indent = 0) const = 0;
   virtual llvm::Value *accept(StmtVisitor &v) const = 0;
+
+  StmtKind getKind() const { return nodeKind; }
+
+  // Where the statement starts, for debug line tables. Set by the parser;
+  // 0 when unknown.
+  int getLine() const { return static_cast<int>(line); }
+  int getColumn() const { return column; }
+  void setLocation(const Token &t) {
+    line = static_cast<uint32_t>(t.getLine());
+    column = static_cast<uint16_t>(std::min(t.getColumn(), 0xffff));
+  }
+
+private:
+  const StmtKind nodeKind;
+  uint16_t column = 0;
+  uint32_t line = 0;
+};
+
+template <StmtKind K> struct StmtNode : Statement {
+  static constexpr StmtKind Kind = K;
+  StmtNode() : Statement(K) {}
+  static bool classof(const Statement *s) { return s->getKind() == K; }
 };
 
 // -------------------- //
 // Variable declaration //
 // -------------------- //
-struct VarDecl : Statement {
+struct VarDecl : StmtNode<StmtKind::VarDecl> {
   TypeDesc type;
   Identifier name;
   ExprPtr initializer;
@@ -747,7 +838,7 @@ struct VarDecl : Statement {
     std::string p(indent, ' ');
     os << p << "{\"kind\":\"VarDecl\","
        << "\"const\":" << (isConst ? "true" : "false") << ","
-       << "\"type\":" << json_utils::escape(type.fullName()) << ","
+       << "\"type\":" << json_utils::escape(type.fullName().str()) << ","
        << "\"name\":" << json_utils::escape(name.token.getWord()) << ","
        << "\"assignKind\":\""
        << (kind == AssignKind::Copy   ? "Copy"
@@ -767,10 +858,10 @@ struct VarDecl : Statement {
 // Control flow //
 // ------------ //
 struct Block {
-  std::vector<std::unique_ptr<Statement>> statements;
+  std::vector<AstPtr<Statement>> statements;
 
   Block() = default;
-  explicit Block(std::vector<std::unique_ptr<Statement>> s)
+  explicit Block(std::vector<AstPtr<Statement>> s)
       : statements(std::move(s)) {}
   void toJson(std::ostream &os, int indent = 0) const {
     std::string p(indent, ' ');
@@ -784,13 +875,12 @@ struct Block {
   }
 };
 
-struct IfStmt : Statement {
+struct IfStmt : StmtNode<StmtKind::If> {
   ExprPtr condition;
-  std::unique_ptr<Block> thenBranch;
-  std::unique_ptr<Block> elseBranch;
+  AstPtr<Block> thenBranch;
+  AstPtr<Block> elseBranch;
 
-  IfStmt(ExprPtr cond, std::unique_ptr<Block> thenB,
-         std::unique_ptr<Block> elseB = nullptr)
+  IfStmt(ExprPtr cond, AstPtr<Block> thenB, AstPtr<Block> elseB = nullptr)
       : condition(std::move(cond)), thenBranch(std::move(thenB)),
         elseBranch(std::move(elseB)) {}
   llvm::Value *accept(StmtVisitor &v) const override {
@@ -804,10 +894,10 @@ struct IfStmt : Statement {
   }
 };
 
-struct WhileStmt : Statement {
+struct WhileStmt : StmtNode<StmtKind::While> {
   ExprPtr condition;
-  std::unique_ptr<Block> doBranch;
-  WhileStmt(ExprPtr cond, std::unique_ptr<Block> body)
+  AstPtr<Block> doBranch;
+  WhileStmt(ExprPtr cond, AstPtr<Block> body)
       : condition(std::move(cond)), doBranch(std::move(body)) {}
   llvm::Value *accept(StmtVisitor &v) const override {
     return v.visitWhileStmt(*this);
@@ -820,16 +910,16 @@ struct WhileStmt : Statement {
   }
 };
 
-struct ForRangeStmt : Statement {
+struct ForRangeStmt : StmtNode<StmtKind::ForRange> {
   TypeDesc varType;
   Identifier varName;
   ExprPtr start;
   ExprPtr end;
   ExprPtr step;
-  std::unique_ptr<Block> body;
+  AstPtr<Block> body;
 
   ForRangeStmt(TypeDesc t, Identifier n, ExprPtr s, ExprPtr e, ExprPtr st,
-               std::unique_ptr<Block> b)
+               AstPtr<Block> b)
       : varType(std::move(t)), varName(std::move(n)), start(std::move(s)),
         end(std::move(e)), step(std::move(st)), body(std::move(b)) {}
   llvm::Value *accept(StmtVisitor &v) const override {
@@ -843,13 +933,13 @@ struct ForRangeStmt : Statement {
 };
 
 // for (T elem : arrayExpr) — generic foreach over any array value
-struct ForEachStmt : Statement {
+struct ForEachStmt : StmtNode<StmtKind::ForEach> {
   TypeDesc varType;
   Identifier varName;
   ExprPtr iterable; // any expression that yields an array
-  std::unique_ptr<Block> body;
+  AstPtr<Block> body;
 
-  ForEachStmt(TypeDesc t, Identifier n, ExprPtr iter, std::unique_ptr<Block> b)
+  ForEachStmt(TypeDesc t, Identifier n, ExprPtr iter, AstPtr<Block> b)
       : varType(std::move(t)), varName(std::move(n)), iterable(std::move(iter)),
         body(std::move(b)) {}
 
@@ -860,11 +950,11 @@ struct ForEachStmt : Statement {
     std::string p(indent, ' ');
     os << p << "{\"kind\":\"ForEachStmt\","
        << "\"var\":" << json_utils::escape(varName.token.getWord()) << ","
-       << "\"type\":" << json_utils::escape(varType.fullName()) << "}";
+       << "\"type\":" << json_utils::escape(varType.fullName().str()) << "}";
   }
 };
 
-struct Return : Statement {
+struct Return : StmtNode<StmtKind::Return> {
   std::optional<ExprPtr> value;
   Return() = default;
   explicit Return(ExprPtr v) : value(std::move(v)) {}
@@ -882,7 +972,7 @@ struct Return : Statement {
   }
 };
 
-struct Break : Statement {
+struct Break : StmtNode<StmtKind::Break> {
   Break() = default;
   llvm::Value *accept(StmtVisitor &v) const override {
     return v.visitBreak(*this);
@@ -892,7 +982,7 @@ struct Break : Statement {
   }
 };
 
-struct Continue : Statement {
+struct Continue : StmtNode<StmtKind::Continue> {
   Continue() = default;
   llvm::Value *accept(StmtVisitor &v) const override {
     return v.visitContinue(*this);
@@ -902,7 +992,21 @@ struct Continue : Statement {
   }
 };
 
-struct ExprStmt : Statement {
+// A statement the parser skipped while recovering from an error; `at` is
+// its first token. Passes treat it as a no-op.
+struct ErrorStmt : StmtNode<StmtKind::Error> {
+  Token at;
+  explicit ErrorStmt(const Token &t) : at(t) {}
+  llvm::Value *accept(StmtVisitor &v) const override {
+    return v.visitErrorStmt(*this);
+  }
+  void toJson(std::ostream &os, int indent) const override {
+    os << std::string(indent, ' ') << "{\"kind\":\"Error\",\"line\":"
+       << at.getLine() << "}";
+  }
+};
+
+struct ExprStmt : StmtNode<StmtKind::Expr> {
   ExprPtr expr;
   ExprStmt() = default;
   explicit ExprStmt(ExprPtr e) : expr(std::move(e)) {}
@@ -927,11 +1031,12 @@ struct Function {
   Identifier name;
   std::vector<std::string> typeParams;
   std::vector<Parameter> params;
-  std::unique_ptr<Block> body;
+  AstPtr<Block> body;
   TypeDesc returnType;
   bool isPublic = false;
+  std::string sourcePath; // module it was imported from; empty in the entry file
 
-  Function(Identifier n, std::vector<Parameter> p, std::unique_ptr<Block> b,
+  Function(Identifier n, std::vector<Parameter> p, AstPtr<Block> b,
            TypeDesc ret, bool pub = false)
       : name(std::move(n)), params(std::move(p)), body(std::move(b)),
         returnType(std::move(ret)), isPublic(pub) {}
@@ -940,7 +1045,7 @@ struct Function {
     os << p << "{\"kind\":\"Function\","
        << "\"name\":" << json_utils::escape(name.token.getWord()) << ","
        << "\"public\":" << (isPublic ? "true" : "false") << ","
-       << "\"return\":" << json_utils::escape(returnType.fullName()) << "}";
+       << "\"return\":" << json_utils::escape(returnType.fullName().str()) << "}";
   }
 };
 
@@ -962,7 +1067,7 @@ struct ExternFuncDecl {
     os << p << "{\"kind\":\"ExternFuncDecl\","
        << "\"name\":" << json_utils::escape(name) << ","
        << "\"private\":" << (isPrivate ? "true" : "false") << ","
-       << "\"return\":" << json_utils::escape(returnType.fullName()) << "}";
+       << "\"return\":" << json_utils::escape(returnType.fullName().str()) << "}";
   }
 };
 
@@ -986,13 +1091,13 @@ struct MatchArm {
   bool isWildcard = false;
   std::string enumName;
   std::string variantName;
-  std::vector<std::string> bindings;
-  std::unique_ptr<Block> body;
+  std::vector<Identifier> bindings;
+  AstPtr<Block> body;
 
   MatchArm() = default;
 };
 
-struct MatchStmt : Statement {
+struct MatchStmt : StmtNode<StmtKind::Match> {
   ExprPtr subject;
   std::vector<MatchArm> arms;
 
@@ -1019,7 +1124,7 @@ struct StructField {
   void toJson(std::ostream &os, int indent = 0) const {
     std::string p(indent, ' ');
     os << p << "{\"kind\":\"StructField\","
-       << "\"type\":" << json_utils::escape(type.fullName()) << ","
+       << "\"type\":" << json_utils::escape(type.fullName().str()) << ","
        << "\"name\":" << json_utils::escape(name) << "}";
   }
 };
@@ -1082,10 +1187,10 @@ struct EnumDecl {
   }
 };
 
-struct EnumConstructorExpr : public Expression {
+struct EnumConstructorExpr : ExprNode<ExprKind::EnumConstructor> {
   std::string enumName;
   std::string variantName;
-  std::vector<std::unique_ptr<Expression>> arguments;
+  std::vector<AstPtr<Expression>> arguments;
 };
 
 // ------------------- //
@@ -1114,18 +1219,19 @@ struct ImportDecl {
 struct GlobalVarDecl {
   TypeDesc type;
   std::string name;
-  std::unique_ptr<Expression> init;
+  Symbol symbol; // name, interned
+  AstPtr<Expression> init;
   bool isConst = false;
   bool isPublic = false;
 
-  GlobalVarDecl(TypeDesc t, std::string n, std::unique_ptr<Expression> i,
+  GlobalVarDecl(TypeDesc t, const Token &n, AstPtr<Expression> i,
                 bool c = false, bool pub = false)
-      : type(std::move(t)), name(std::move(n)), init(std::move(i)), isConst(c),
-        isPublic(pub) {}
+      : type(std::move(t)), name(n.getWord()), symbol(n.getSymbol()),
+        init(std::move(i)), isConst(c), isPublic(pub) {}
   void toJson(std::ostream &os, int indent = 0) const {
     std::string p(indent, ' ');
     os << p << "{\"kind\":\"GlobalVarDecl\","
-       << "\"type\":" << json_utils::escape(type.fullName()) << ","
+       << "\"type\":" << json_utils::escape(type.fullName().str()) << ","
        << "\"name\":" << json_utils::escape(name) << ","
        << "\"const\":" << (isConst ? "true" : "false") << ","
        << "\"public\":" << (isPublic ? "true" : "false") << ","
@@ -1141,12 +1247,18 @@ struct GlobalVarDecl {
 // ------- //
 // Program //
 // ------- //
+// Top-level declarations are held by shared_ptr so that a module parsed once
+// (see ModuleCache) can be spliced into every program that imports it
+// without copying or re-parsing. Nodes are never mutated after parsing.
+// Every node lives in the arena of the program that parsed it; a shared
+// declaration keeps that arena alive, even after the program itself is gone.
 struct Program {
-  std::vector<std::unique_ptr<ImportDecl>> imports;
-  std::vector<std::unique_ptr<GlobalVarDecl>> globals;
-  std::vector<std::unique_ptr<Function>> functions;
-  std::vector<std::unique_ptr<StructDecl>> structs;
-  std::vector<std::unique_ptr<EnumDecl>> enums;
+  std::shared_ptr<AstArena> arena = std::make_shared<AstArena>();
+  std::vector<std::shared_ptr<ImportDecl>> imports;
+  std::vector<std::shared_ptr<GlobalVarDecl>> globals;
+  std::vector<std::shared_ptr<Function>> functions;
+  std::vector<std::shared_ptr<StructDecl>> structs;
+  std::vector<std::shared_ptr<EnumDecl>> enums;
   std::vector<ExternBlock> externBlocks;
 
   Program() = default;
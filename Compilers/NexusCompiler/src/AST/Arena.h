@@ -0,0 +1,85 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Destroys an arena-allocated node without freeing its storage; the memory
+// goes back all at once when the owning AstArena is destroyed.
+struct AstDeleter {
+  template <class T> void operator()(T *node) const { node->~T(); }
+};
+
+// Owning pointer to an AST node that lives in an AstArena. Converts from
+// AstPtr<Derived> to AstPtr<Base> like std::unique_ptr does.
+template <class T> using AstPtr = std::unique_ptr<T, AstDeleter>;
+
+// Bump allocator backing every node of one parsed Program.
+//
+// Nodes are carved out of 64 KiB blocks in the order the parser builds them,
+// so a function's statements and expressions end up next to each other, and
+// tearing a Program down releases a handful of blocks instead of one heap
+// allocation per node. Not thread-safe: one arena belongs to one Parser.
+class AstArena {
+public:
+  AstArena() = default;
+  AstArena(const AstArena &) = delete;
+  AstArena &operator=(const AstArena &) = delete;
+
+  template <class T, class... Args> AstPtr<T> make(Args &&...args) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "over-aligned AST nodes are not supported");
+    void *mem = allocate(sizeof(T), alignof(T));
+    ++nodes;
+    return AstPtr<T>(new (mem) T(std::forward<Args>(args)...));
+  }
+
+  void *allocate(size_t size, size_t align) {
+    uintptr_t p = (reinterpret_cast<uintptr_t>(cur) + align - 1) &
+                  ~static_cast<uintptr_t>(align - 1);
+    if (!cur || p + size > reinterpret_cast<uintptr_t>(end)) {
+      grow(size);
+      p = reinterpret_cast<uintptr_t>(cur);
+    }
+    cur = reinterpret_cast<char *>(p + size);
+    used += size;
+    return reinterpret_cast<void *>(p);
+  }
+
+  // Bytes handed out so far (excluding alignment padding and slack).
+  size_t bytesUsed() const { return used; }
+
+  // Nodes constructed with make() so far.
+  size_t nodeCount() const { return nodes; }
+
+private:
+  static constexpr size_t kBlockSize = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char *cur = nullptr;
+  char *end = nullptr;
+  size_t used = 0;
+  size_t nodes = 0;
+
+  void grow(size_t minSize) {
+    size_t size = minSize > kBlockSize ? minSize : kBlockSize;
+    blocks.emplace_back(new char[size]);
+    cur = blocks.back().get();
+    end = cur + size;
+  }
+};
+
+// Moves an arena node into shared ownership (top-level declarations are
+// shared between importing programs). The arena is kept alive for as long
+// as the node is.
+template <class T>
+std::shared_ptr<T> shareNode(AstPtr<T> node, std::shared_ptr<AstArena> arena) {
+  return std::shared_ptr<T>(node.release(),
+                            [arena = std::move(arena)](T *p) { p->~T(); });
+}
+
+#endif // AST_ARENA_H
@@ -30,6 +30,7 @@ struct StructLitExpr;
 struct CompoundAssignExpr;
 struct ChainedCmpExpr;
 struct TypeIntrinsicExpr;
+struct ErrorExpr;
 
 namespace llvm {
 class Value;
@@ -68,6 +69,7 @@ struct ExprVisitor {
   virtual llvm::Value *visitCompoundAssign(const CompoundAssignExpr &) = 0;
   virtual llvm::Value *visitChainedCmp(const ChainedCmpExpr &) = 0;
   virtual llvm::Value *visitTypeIntrinsic(const TypeIntrinsicExpr &) = 0;
+  virtual llvm::Value *visitErrorExpr(const ErrorExpr &) = 0;
 };
 
 // Pure-virtual visitor for Statement nodes.
@@ -81,6 +83,7 @@ struct ForEachStmt;
 struct Return;
 struct Break;
 struct Continue;
+struct ErrorStmt;
 
 struct StmtVisitor {
   virtual ~StmtVisitor() = default;
@@ -95,6 +98,7 @@ struct StmtVisitor {
   virtual llvm::Value *visitReturn(const Return &) = 0;
   virtual llvm::Value *visitBreak(const Break &) = 0;
   virtual llvm::Value *visitContinue(const Continue &) = 0;
+  virtual llvm::Value *visitErrorStmt(const ErrorStmt &) = 0;
 };
 
 #endif // EXPR_VISITOR_H
@@ -1,21 +1,45 @@
 #include "CodeGen.h"
+#include "../Driver/TimeReport.h"
 #include "CodeGenUtils.h"
 #include "Emitters/BuiltinEmitter.h"
 #include "Emitters/PrintEmitter.h"
 #include "Emitters/StringEmitter.h"
 #include "Manager/ArithmeticManager.h"
 #include "TypeResolver.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Passes/OptimizationLevel.h"
+#include "llvm/Passes/PassBuilder.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_os_ostream.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/Instrumentation/AddressSanitizer.h"
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Type.h>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_set>
+#include <utility>
 
 using namespace llvm;
 
+// Diagnostics are written through std::cerr rather than llvm::errs(), which
+// goes straight to fd 2, so the driver can capture them per compilation.
+static llvm::raw_ostream &diag() {
+  thread_local llvm::raw_os_ostream os(std::cerr);
+  os.SetUnbuffered();
+  return os;
+}
+
 static bool blockHasTerminator(llvm::IRBuilder<> &B) {
   llvm::BasicBlock *bb = B.GetInsertBlock();
   if (!bb || bb->empty())
@@ -53,6 +77,15 @@ static bool passAsPointer(llvm::Type *pt) {
          pt->isStructTy();
 }
 
+/**
+ * Returns true for an addition a + b. A chain a + b + c parses as (a + b) + c,
+ * so its additions nest down the left operand.
+ */
+static bool isAddition(const Expression &e) {
+  auto *b = dyn_cast<BinaryExpr>(&e);
+  return b && b->op == BinaryOp::Add;
+}
+
 /*---------------------------------------*/
 /*    String interpolation in StrLit     */
 /*---------------------------------------*/
@@ -217,10 +250,14 @@ Value *CodeGenerator::visitStrLit(const StrLitExpr &e) {
  * The module is named "nexus" and its target triple is set to the host
  * platform so the emitted IR can be compiled without further flags.
  */
-CodeGenerator::CodeGenerator()
-    : module(std::make_unique<Module>("nexus", context)), builder(context),
-      scopeMgr(builder, context, module.get(), namedValues) {
+CodeGenerator::CodeGenerator(const CodeGenOptions &options)
+    : opts(options), module(std::make_unique<Module>("nexus", context)),
+      builder(context),
+      scopeMgr(builder, context, module.get(), namedValues),
+      boundsMgr(builder, context, module.get()) {
+  boundsMgr.setMode(opts.boundsCheck);
   module->setTargetTriple(Triple(LLVM_HOST_TRIPLE));
+  createTargetMachine();
 }
 
 /**
@@ -254,7 +291,8 @@ llvm::Function *CodeGenerator::getFree() {
  * @return always nullptr
  */
 Value *CodeGenerator::logError(const char *msg) {
-  errs() << "\033[31mCodeGen error: " << msg << "\033[0m\n";
+  hadError = true;
+  diag() << "\033[31mCodeGen error: " << msg << "\033[0m\n";
   return nullptr;
 }
 
@@ -277,6 +315,8 @@ Value *CodeGenerator::codegen(const Expression &expr) {
  * @return the LLVM Value* produced by the statement (often nullptr)
  */
 Value *CodeGenerator::codegen(const Statement &stmt) {
+  if (debugInfo)
+    debugInfo->setLocation(stmt.getLine(), stmt.getColumn());
   return stmt.accept(*this);
 }
 
@@ -292,13 +332,16 @@ Value *CodeGenerator::codegen(const Block &block) { return visitBlock(block); }
 /*---------------------------------------*/
 
 /**
- * Generates a 32-bit integer constant.
+ * Generates an integer constant: i32, or i64 when the value does not fit.
  * @param e the integer literal AST node
- * @return an llvm::ConstantInt with i32 type
+ * @return an llvm::ConstantInt with i32 or i64 type
  */
 Value *CodeGenerator::visitIntLit(const IntLitExpr &e) {
-  return ConstantInt::get(Type::getInt32Ty(context),
-                          std::stoll(e.lit.getWord()));
+  const long long v = std::stoll(std::string(e.lit.getWord()));
+  const bool fits = v >= INT32_MIN && v <= INT32_MAX;
+  return ConstantInt::get(fits ? Type::getInt32Ty(context)
+                               : Type::getInt64Ty(context),
+                          v);
 }
 
 /**
@@ -307,7 +350,8 @@ Value *CodeGenerator::visitIntLit(const IntLitExpr &e) {
  * @return an llvm::ConstantFP with float type
  */
 Value *CodeGenerator::visitFloatLit(const FloatLitExpr &e) {
-  return ConstantFP::get(Type::getFloatTy(context), std::stod(e.lit.getWord()));
+  return ConstantFP::get(Type::getFloatTy(context),
+                         std::stod(std::string(e.lit.getWord())));
 }
 
 /**
@@ -327,7 +371,7 @@ Value *CodeGenerator::visitBoolLit(const BoolLitExpr &e) {
  * @return an llvm::ConstantInt with i8 type
  */
 Value *CodeGenerator::visitCharLit(const CharLitExpr &e) {
-  const std::string &word = e.lit.getWord();
+  const std::string word(e.lit.getWord());
   char c = 0;
   if (word.size() == 1) {
     c = word[0];
@@ -378,18 +422,17 @@ Value *CodeGenerator::visitNullLit(const NullLitExpr &) {
  * @return the LLVM Value* holding the variable's current value
  */
 Value *CodeGenerator::visitIdentifier(const IdentExpr &e) {
-  const std::string &name = e.name.token.getWord();
-  auto it = namedValues.find(name);
-  if (it == namedValues.end())
+  const std::string name(e.name.token.getWord());
+  VarInfo *it = namedValues.lookup(e.name.symbol());
+  if (!it)
     return logError(("Unknown variable: " + name).c_str());
-  if (it->second.isMoved)
+  if (it->isMoved)
     return logError(("Use of moved variable: " + name).c_str());
 
-  if (it->second.isReference) {
+  if (it->isReference) {
     Value *ptr = builder.CreateLoad(PointerType::get(context, 0),
-                                    it->second.allocaInst, name + ".ref");
-    Type *pointee =
-        it->second.pointeeType ? it->second.pointeeType : it->second.type;
+                                    it->allocaInst, name + ".ref");
+    Type *pointee = it->pointeeType ? it->pointeeType : it->type;
     // Aggregate references are returned as raw pointers; scalars are loaded.
     if (TypeResolver::isString(pointee) || TypeResolver::isArray(pointee))
       return ptr;
@@ -400,12 +443,11 @@ Value *CodeGenerator::visitIdentifier(const IdentExpr &e) {
   // Structs are included here so that visitReturn's dyn_cast<AllocaInst>
   // succeeds and can null out owned string/array field data pointers before
   // scope cleanup runs — preventing a use-after-free on struct return.
-  if (TypeResolver::isString(it->second.type) ||
-      TypeResolver::isArray(it->second.type) || it->second.type->isStructTy())
-    return it->second.allocaInst;
+  if (TypeResolver::isString(it->type) || TypeResolver::isArray(it->type) ||
+      it->type->isStructTy())
+    return it->allocaInst;
 
-  return builder.CreateLoad(it->second.type, it->second.allocaInst,
-                            name + ".load");
+  return builder.CreateLoad(it->type, it->allocaInst, name + ".load");
 }
 
 /*---------------------------------------*/
@@ -419,7 +461,8 @@ Value *CodeGenerator::visitIdentifier(const IdentExpr &e) {
  * The method resolves the semantic types of both operands and handles the
  * following special cases before delegating to ArithmeticManager:
  *  - String concatenation: any Add where at least one side is a string.
- *  - String equality: Eq/Ne between two strings uses strcmp.
+ *    A chain a + b + c + ... is built in one allocation (emitAddChain).
+ *  - String equality: Eq/Ne between two strings compares lengths, then bytes.
  *  - Numeric promotion: int/float mismatches are widened to a common type.
  *  - Null comparisons: integer literal 0 beside a pointer becomes nullptr.
  *
@@ -427,26 +470,101 @@ Value *CodeGenerator::visitIdentifier(const IdentExpr &e) {
  * @return the LLVM Value* of the expression result, or nullptr on error
  */
 Value *CodeGenerator::visitBinary(const BinaryExpr &expr) {
+  if (expr.op == BinaryOp::Add && isAddition(*expr.left))
+    return emitAddChain(expr);
+
   Value *lhs = codegen(*expr.left);
   Value *rhs = codegen(*expr.right);
   if (!lhs || !rhs)
     return nullptr;
+  return emitBinary(expr, lhs, rhs);
+}
+
+/**
+ * Resolves the declared type of an operand, preferring the symbol table entry
+ * over the IR type (which may already be a pointer for aggregates).
+ */
+Type *CodeGenerator::operandType(Value *v, const Expression &e) {
+  if (auto *id = dyn_cast<IdentExpr>(&e)) {
+    VarInfo *it = namedValues.lookup(id->name.symbol());
+    if (it)
+      return it->type;
+  }
+  if (auto *ai = llvm::dyn_cast<llvm::AllocaInst>(v))
+    return ai->getAllocatedType();
+  return v->getType();
+}
+
+/**
+ * Generates IR for a left-leaning chain of additions, a + b + c + ...
+ *
+ * Operands are evaluated left to right as the nested form would. The chain
+ * stays numeric until the first string operand; from there on every operand
+ * is one piece of the result, which StringOps::concatAll builds with a single
+ * allocation instead of one per +. Pieces made along the way, by conversion
+ * or by a parenthesised +, are freed as soon as they have been copied.
+ *
+ * @param expr the outermost addition of the chain
+ * @return the LLVM Value* of the chain's result, or nullptr on error
+ */
+Value *CodeGenerator::emitAddChain(const BinaryExpr &expr) {
+  std::vector<const BinaryExpr *> adds;
+  const Expression *first = &expr;
+  while (isAddition(*first)) {
+    adds.push_back(cast<BinaryExpr>(first));
+    first = adds.back()->left.get();
+  }
+  std::reverse(adds.begin(), adds.end());
 
-  // Resolves the declared type of a value, preferring the symbol table entry
-  // over the IR type (which may already be a pointer for aggregates).
-  auto resolveType = [&](Value *v, const Expression &e) -> Type * {
-    if (auto *id = dynamic_cast<const IdentExpr *>(&e)) {
-      auto it = namedValues.find(id->name.token.getWord());
-      if (it != namedValues.end())
-        return it->second.type;
+  Value *acc = codegen(*first);
+  if (!acc)
+    return nullptr;
+  std::vector<Value *> pieces, temps;
+  auto addPiece = [&](Value *v, const Expression &e) {
+    if (TypeResolver::isString(operandType(v, e))) {
+      pieces.push_back(v);
+      if (isAddition(e))
+        temps.push_back(v);
+      return;
     }
-    if (auto *ai = llvm::dyn_cast<llvm::AllocaInst>(v))
-      return ai->getAllocatedType();
-    return v->getType();
+    pieces.push_back(StringOps::fromValue(builder, context, module.get(), v));
+    temps.push_back(pieces.back());
   };
+  if (TypeResolver::isString(operandType(acc, *first)))
+    pieces.push_back(acc);
 
-  Type *lTy = resolveType(lhs, *expr.left);
-  Type *rTy = resolveType(rhs, *expr.right);
+  for (const BinaryExpr *add : adds) {
+    Value *v = codegen(*add->right);
+    if (!v)
+      return nullptr;
+    bool isStr = TypeResolver::isString(operandType(v, *add->right));
+    if (pieces.empty() && !isStr) {
+      acc = emitBinary(*add, acc, v);
+      if (!acc)
+        return nullptr;
+      continue;
+    }
+    if (pieces.empty())
+      addPiece(acc, *add->left);
+    addPiece(v, *add->right);
+  }
+  if (pieces.empty())
+    return acc;
+
+  Value *result = StringOps::concatAll(builder, context, module.get(), pieces);
+  for (Value *tmp : temps)
+    StringOps::release(builder, context, module.get(), tmp);
+  return result;
+}
+
+/**
+ * Applies a binary operator to operands that have already been evaluated;
+ * the operand expressions are consulted only for their declared types.
+ */
+Value *CodeGenerator::emitBinary(const BinaryExpr &expr, Value *lhs,
+                                 Value *rhs) {
+  Type *lTy = operandType(lhs, *expr.left);
+  Type *rTy = operandType(rhs, *expr.right);
   auto liftEnumToTag = [&](Value *&val, Type *&ty, Value *other) {
     // If `val` is a pointer to an enum struct (has i32 tag at field 0)
     // and `other` is an integer, extract the tag and use that instead.
@@ -608,24 +726,23 @@ Value *CodeGenerator::visitUnary(const UnaryExpr &e) {
  * @return the assigned LLVM Value*, or nullptr on error
  */
 Value *CodeGenerator::visitAssign(const AssignExpr &e) {
-  const std::string &tgt = e.target.token.getWord();
-  auto it = namedValues.find(tgt);
-  if (it == namedValues.end())
+  const std::string tgt(e.target.token.getWord());
+  VarInfo *it = namedValues.lookup(e.target.symbol());
+  if (!it)
     return logError(("Undeclared variable: " + tgt).c_str());
-  if (it->second.isConst)
+  if (it->isConst)
     return logError(("Cannot reassign const variable: " + tgt + " on line " +
                      std::to_string(e.target.token.getLine()))
                         .c_str());
 
   // Reference target: store through the stored pointer.
-  if (it->second.isReference) {
+  if (it->isReference) {
     Value *val = codegen(*e.value);
     if (!val)
       return nullptr;
-    Type *pointee =
-        it->second.pointeeType ? it->second.pointeeType : it->second.type;
+    Type *pointee = it->pointeeType ? it->pointeeType : it->type;
     Value *ptr = builder.CreateLoad(PointerType::get(context, 0),
-                                    it->second.allocaInst, tgt + ".ref");
+                                    it->allocaInst, tgt + ".ref");
     if (TypeResolver::isString(pointee) || TypeResolver::isArray(pointee)) {
       Value *loaded = builder.CreateLoad(pointee, val);
       builder.CreateStore(loaded, ptr);
@@ -635,25 +752,40 @@ Value *CodeGenerator::visitAssign(const AssignExpr &e) {
     return val;
   }
 
-  if (it->second.isBorrowed)
+  if (it->isBorrowed)
     return logError(("Cannot modify borrowed variable: " + tgt).c_str());
 
+  // s = s + a + b ...: append to s rather than rebuilding it each time.
+  if (TypeResolver::isString(it->type) && isAddition(*e.value)) {
+    std::vector<const Expression *> pieces;
+    const Expression *first = e.value.get();
+    while (isAddition(*first)) {
+      pieces.insert(pieces.begin(), cast<BinaryExpr>(first)->right.get());
+      first = cast<BinaryExpr>(first)->left.get();
+    }
+    auto *self = dyn_cast<IdentExpr>(first);
+    if (self && self->name.symbol() == e.target.symbol()) {
+      if (it->isMoved)
+        return logError(("Use of moved variable: " + tgt).c_str());
+      if (!emitStringAppend(it->allocaInst, pieces))
+        return nullptr;
+      return it->allocaInst;
+    }
+  }
+
   Value *val = codegen(*e.value);
   if (!val)
     return nullptr;
 
-  Type *targetTy = it->second.type;
+  Type *targetTy = it->type;
 
   // String assignment: free the old heap buffer first, then store the new one.
   // The source's data pointer is nulled to prevent a double-free.
   if (TypeResolver::isString(targetTy)) {
-    Value *oldVal =
-        builder.CreateLoad(targetTy, it->second.allocaInst, tgt + ".old");
-    Value *oldData = builder.CreateExtractValue(oldVal, {0}, "old.data");
-    builder.CreateCall(getFree(), {oldData});
+    StringOps::release(builder, context, module.get(), it->allocaInst);
 
     Value *loaded = builder.CreateLoad(targetTy, val);
-    builder.CreateStore(loaded, it->second.allocaInst);
+    builder.CreateStore(loaded, it->allocaInst);
 
     // Null the source's data pointer to prevent a double-free.
     if (auto *ai = llvm::dyn_cast<llvm::AllocaInst>(val)) {
@@ -663,7 +795,7 @@ Value *CodeGenerator::visitAssign(const AssignExpr &e) {
           llvm::ConstantPointerNull::get(llvm::PointerType::get(context, 0)),
           dataField);
     }
-    return it->second.allocaInst;
+    return it->allocaInst;
   }
 
   // Enum-to-integer implicit conversion: extract the tag from an enum struct
@@ -690,37 +822,37 @@ Value *CodeGenerator::visitAssign(const AssignExpr &e) {
 
   switch (e.kind) {
   case AssignKind::Copy:
-    builder.CreateStore(val, it->second.allocaInst);
+    builder.CreateStore(val, it->allocaInst);
     break;
 
   case AssignKind::Move: {
-    auto *sid = dynamic_cast<const IdentExpr *>(e.value.get());
+    auto *sid = dyn_cast<IdentExpr>(e.value.get());
     if (!sid)
       return logError("Move requires an identifier on the right-hand side");
-    const std::string &src = sid->name.token.getWord();
-    auto sit = namedValues.find(src);
-    if (sit == namedValues.end())
+    const std::string src(sid->name.token.getWord());
+    VarInfo *sit = namedValues.lookup(sid->name.symbol());
+    if (!sit)
       return logError(("Unknown variable: " + src).c_str());
-    if (sit->second.isMoved)
+    if (sit->isMoved)
       return logError(("Already moved: " + src).c_str());
-    if (sit->second.isBorrowed)
+    if (sit->isBorrowed)
       return logError(("Cannot move borrowed value: " + src).c_str());
-    builder.CreateStore(val, it->second.allocaInst);
-    sit->second.isMoved = true;
+    builder.CreateStore(val, it->allocaInst);
+    sit->isMoved = true;
     break;
   }
 
   case AssignKind::Borrow: {
-    auto *sid = dynamic_cast<const IdentExpr *>(e.value.get());
+    auto *sid = dyn_cast<IdentExpr>(e.value.get());
     if (!sid)
       return logError("Borrow requires an identifier on the right-hand side");
-    const std::string &src = sid->name.token.getWord();
-    auto sit = namedValues.find(src);
-    if (sit == namedValues.end())
+    const std::string src(sid->name.token.getWord());
+    VarInfo *sit = namedValues.lookup(sid->name.symbol());
+    if (!sit)
       return logError(("Unknown variable: " + src).c_str());
-    if (sit->second.isMoved)
+    if (sit->isMoved)
       return logError(("Cannot borrow moved value: " + src).c_str());
-    namedValues[tgt] = {sit->second.allocaInst, sit->second.type, true, false};
+    *it = {sit->allocaInst, sit->type, true, false};
     break;
   }
   }
@@ -733,7 +865,7 @@ Value *CodeGenerator::visitAssign(const AssignExpr &e) {
  * @return the incremented value, or nullptr on error
  */
 Value *CodeGenerator::visitIncrement(const Increment &e) {
-  return generateIncrDecr(e.target.token.getWord(), true);
+  return generateIncrDecr(e.target, true);
 }
 
 /**
@@ -742,28 +874,28 @@ Value *CodeGenerator::visitIncrement(const Increment &e) {
  * @return the decremented value, or nullptr on error
  */
 Value *CodeGenerator::visitDecrement(const Decrement &e) {
-  return generateIncrDecr(e.target.token.getWord(), false);
+  return generateIncrDecr(e.target, false);
 }
 
 /**
  * Shared implementation for ++ and --. Handles both reference and direct
  * variables, and works for both integer and floating-point types.
- * @param name the name of the variable to modify
+ * @param target the variable to modify
  * @param isInc true for increment, false for decrement
  * @return the updated value, or nullptr on error
  */
-Value *CodeGenerator::generateIncrDecr(const std::string &name, bool isInc) {
-  auto it = namedValues.find(name);
-  if (it == namedValues.end())
+Value *CodeGenerator::generateIncrDecr(const Identifier &target, bool isInc) {
+  const std::string name(target.token.getWord());
+  VarInfo *it = namedValues.lookup(target.symbol());
+  if (!it)
     return logError(("Unknown variable: " + name).c_str());
-  if (it->second.isConst)
+  if (it->isConst)
     return logError(("Cannot modify const variable: " + name).c_str());
 
-  if (it->second.isReference) {
-    Type *pt =
-        it->second.pointeeType ? it->second.pointeeType : it->second.type;
+  if (it->isReference) {
+    Type *pt = it->pointeeType ? it->pointeeType : it->type;
     Value *ptr = builder.CreateLoad(PointerType::get(context, 0),
-                                    it->second.allocaInst, name + ".ref");
+                                    it->allocaInst, name + ".ref");
     Value *cur = builder.CreateLoad(pt, ptr);
     Value *res =
         pt->isFloatingPointTy()
@@ -776,87 +908,54 @@ Value *CodeGenerator::generateIncrDecr(const std::string &name, bool isInc) {
     return res;
   }
 
-  if (it->second.isBorrowed || it->second.isMoved)
+  if (it->isBorrowed || it->isMoved)
     return logError(("Cannot modify " + name).c_str());
 
-  Type *ty = it->second.type;
-  Value *cur = builder.CreateLoad(ty, it->second.allocaInst, name + ".load");
+  Type *ty = it->type;
+  Value *cur = builder.CreateLoad(ty, it->allocaInst, name + ".load");
   Value *res =
       ty->isFloatingPointTy()
           ? (isInc ? builder.CreateFAdd(cur, ConstantFP::get(ty, 1.0), "finc")
                    : builder.CreateFSub(cur, ConstantFP::get(ty, 1.0), "fdec"))
           : (isInc ? builder.CreateAdd(cur, ConstantInt::get(ty, 1), "inc")
                    : builder.CreateSub(cur, ConstantInt::get(ty, 1), "dec"));
-  builder.CreateStore(res, it->second.allocaInst);
+  builder.CreateStore(res, it->allocaInst);
   return res;
 }
 
 /**
  * Generates IR for a compound assignment (+=, -=, *=, /=, etc.).
- * Handles string += by concatenating in-place and freeing the old buffer.
+ * Handles string += by appending in place (see emitStringAppend).
  * For numeric types, promotes the RHS to match the target before delegating
  * to ArithmeticManager, then coerces the result back if needed.
  * @param e the compound-assignment expression AST node
  * @return the updated value, or nullptr on error
  */
 Value *CodeGenerator::visitCompoundAssign(const CompoundAssignExpr &e) {
-  const std::string &name = e.target.token.getWord();
-  auto it = namedValues.find(name);
-  if (it == namedValues.end())
+  const std::string name(e.target.token.getWord());
+  VarInfo *it = namedValues.lookup(e.target.symbol());
+  if (!it)
     return logError(("Unknown variable: " + name).c_str());
-  if (it->second.isConst)
+  if (it->isConst)
     return logError(
         ("Cannot compound-assign to const variable: " + name).c_str());
 
-  Type *targetTy = it->second.type;
+  Type *targetTy = it->type;
 
-  // String += : concatenate in-place, replacing the heap buffer.
+  // String += : append in place, growing the heap buffer when it is full.
   if (TypeResolver::isString(targetTy)) {
     if (e.op != BinaryOp::Add)
       return logError(
           ("Compound operator not supported on string: " + name).c_str());
+    if (it->isMoved)
+      return logError(("Use of moved variable: " + name).c_str());
 
-    Value *rhs = codegen(*e.value);
-    if (!rhs)
+    if (!emitStringAppend(it->allocaInst, {e.value.get()}))
       return nullptr;
-
-    // Determine whether the RHS is already a string or needs conversion.
-    Type *rhsTy = nullptr;
-    if (auto *ai = llvm::dyn_cast<llvm::AllocaInst>(rhs))
-      rhsTy = ai->getAllocatedType();
-    else
-      rhsTy = rhs->getType();
-
-    Value *rhsStr =
-        TypeResolver::isString(rhsTy)
-            ? rhs
-            : StringOps::fromValue(builder, context, module.get(), rhs);
-
-    Value *concat = StringOps::concat(builder, context, module.get(),
-                                      it->second.allocaInst, rhsStr);
-
-    // Free the old buffer before installing the new one.
-    llvm::StructType *strSt = TypeResolver::getStringType(context);
-    Value *oldVal =
-        builder.CreateLoad(strSt, it->second.allocaInst, name + ".old");
-    Value *oldData = builder.CreateExtractValue(oldVal, {0}, "old.data");
-    builder.CreateCall(getFree(), {oldData});
-
-    Value *newVal = builder.CreateLoad(strSt, concat, "concat.val");
-    builder.CreateStore(newVal, it->second.allocaInst);
-
-    // Null the temporary concat buffer's data pointer to avoid double-free.
-    if (auto *ai = llvm::dyn_cast<llvm::AllocaInst>(concat)) {
-      Value *dataField = builder.CreateStructGEP(strSt, ai, 0, "tmp.data.ptr");
-      builder.CreateStore(
-          llvm::ConstantPointerNull::get(llvm::PointerType::get(context, 0)),
-          dataField);
-    }
-    return it->second.allocaInst;
+    return it->allocaInst;
   }
 
-  Value *cur =
-      builder.CreateLoad(targetTy, it->second.allocaInst, name + ".load");
+  Value *cur = builder.CreateLoad(targetTy, it->allocaInst, name + ".load");
 
   Value *rhs = codegen(*e.value);
   if (!rhs)
@@ -897,10 +996,54 @@ Value *CodeGenerator::visitCompoundAssign(const CompoundAssignExpr &e) {
     }
   }
 
-  builder.CreateStore(result, it->second.allocaInst);
+  builder.CreateStore(result, it->allocaInst);
   return result;
 }
 
+/**
+ * Appends pieces to the string at `target` in place (StringOps::append).
+ *
+ * Every piece is evaluated before the target changes, so pieces that read
+ * it see its old value. Several pieces are first joined with one allocation.
+ * Strings made here, by conversion or by a + inside a piece, are freed once
+ * copied.
+ *
+ * Whether the target's buffer may be grown in place is decided at run time
+ * (StringOps::ownsBuffer), so a view such as a parameter gets a buffer of its
+ * own, which the variable's scope then frees.
+ *
+ * @param target the string's alloca
+ * @param pieces the expressions to append, in order
+ * @return false if a piece failed to generate
+ */
+bool CodeGenerator::emitStringAppend(
+    Value *target, const std::vector<const Expression *> &pieces) {
+  std::vector<Value *> strs, temps;
+  for (const Expression *piece : pieces) {
+    Value *v = codegen(*piece);
+    if (!v)
+      return false;
+    if (TypeResolver::isString(operandType(v, *piece))) {
+      strs.push_back(v);
+      if (isAddition(*piece))
+        temps.push_back(v);
+    } else {
+      strs.push_back(StringOps::fromValue(builder, context, module.get(), v));
+      temps.push_back(strs.back());
+    }
+  }
+
+  Value *tail = strs[0];
+  if (strs.size() > 1) {
+    tail = StringOps::concatAll(builder, context, module.get(), strs);
+    temps.push_back(tail);
+  }
+  StringOps::append(builder, context, module.get(), target, tail);
+  for (Value *tmp : temps)
+    StringOps::release(builder, context, module.get(), tmp);
+  return true;
+}
+
 /*---------------------------------------*/
 /*             Array types               */
 /*---------------------------------------*/
@@ -930,11 +1073,95 @@ static Type *resolveElemType(llvm::LLVMContext &context,
   return nullptr;
 }
 
+/**
+ * Applies indices to the array stored at ptr, using the dense row-major
+ * layout. Indexing every dimension yields a pointer to the element; indexing
+ * fewer yields a stack slot holding a view of the sub-array. Each index is
+ * range-checked unless bounds checking is off or a loop proves it.
+ *
+ * The elements of a jagged array are rows with lengths of their own, so
+ * indices past its rank continue into the row they select. Loop proofs
+ * cover only the outer array: `range(m[r].length)` says nothing about
+ * another row.
+ *
+ * @param ptr pointer to the array value
+ * @param arrSt the array struct type
+ * @param array the subscripted variable (empty for expression bases)
+ * @param indices one expression per indexed dimension
+ * @param resultTy set to the element type, or the view's array type
+ * @return the element pointer or view slot, or nullptr on error
+ */
+Value *CodeGenerator::emitSubscript(Value *ptr, StructType *arrSt,
+                                    const Identifier &array,
+                                    const std::vector<ExprPtr> &indices,
+                                    Type *&resultTy) {
+  Type *i64Ty = Type::getInt64Ty(context);
+  std::vector<Value *> idxs;
+  for (const auto &ie : indices) {
+    Value *idx = codegen(*ie);
+    if (!idx)
+      return nullptr;
+    if (!idx->getType()->isIntegerTy())
+      return logError("Array index must be an integer");
+    if (idx->getType() != i64Ty)
+      idx = builder.CreateSExtOrTrunc(idx, i64Ty);
+    idxs.push_back(idx);
+  }
+
+  for (size_t first = 0;;) {
+    unsigned rank = TypeResolver::arrayRank(arrSt);
+    size_t count = std::min<size_t>(rank, idxs.size() - first);
+
+    Type *leafTy = arrSt;
+    Type *viewTy = nullptr;
+    for (unsigned d = 0; d < rank; ++d) {
+      if (d == count)
+        viewTy = leafTy;
+      leafTy = resolveElemType(context, cast<StructType>(leafTy));
+      if (!leafTy)
+        return logError("Cannot resolve element type");
+    }
+    if (idxs.size() - first > rank && !TypeResolver::isArray(leafTy))
+      return logError("Too many indices for array");
+
+    ArrayRef<Value *> here = ArrayRef<Value *>(idxs).slice(first, count);
+    Value *arr = builder.CreateLoad(arrSt, ptr, "arr.load");
+    if (boundsMgr.enabled())
+      for (unsigned d = 0; d < count; ++d)
+        if (first != 0 ||
+            !boundsMgr.isProven(array.symbol(), d, *indices[d]))
+          boundsMgr.emitCheck(here[d], ArrayEmitter::emitDim(builder, arr, d),
+                              array.token);
+
+    if (count < rank) {
+      auto *viewSt = cast<StructType>(viewTy);
+      AllocaInst *slot = createEntryAlloca(viewSt, "arr.view");
+      builder.CreateStore(
+          ArrayEmitter::emitView(builder, arr, rank, viewSt, leafTy, here),
+          slot);
+      arrayViews.insert(slot);
+      resultTy = viewSt;
+      return slot;
+    }
+
+    Value *elemPtr =
+        ArrayEmitter::emitSubscript(builder, arr, rank, leafTy, here);
+    first += count;
+    if (first == idxs.size()) {
+      resultTy = leafTy;
+      return elemPtr;
+    }
+    // A row of a jagged array: index into it with the rest.
+    ptr = elemPtr;
+    arrSt = cast<StructType>(leafTy);
+  }
+}
+
 /**
  * Generates IR for an array index read expression (e.g. arr[i] or arr[i][j]).
  *
- * Handles multi-dimensional indexing by iterating through each dimension:
- * loads the array struct, extracts the data pointer, then GEPs to the element.
+ * All indices are folded into one offset into the array's dense buffer (see
+ * emitSubscript); indexing fewer dimensions than the array has yields a view.
  * String indexing is a special case that returns a single i8 character.
  *
  * @param e the array-index expression AST node
@@ -959,12 +1186,12 @@ Value *CodeGenerator::visitArrayIndex(const ArrayIndexExpr &e) {
     name = "<expr>";
   } else {
     name = e.array.token.getWord();
-    auto it = namedValues.find(name);
-    if (it == namedValues.end())
+    VarInfo *it = namedValues.lookup(e.array.symbol());
+    if (!it)
       return logError(("Unknown variable: " + name).c_str());
 
     // String indexing yields a single character.
-    if (TypeResolver::isString(it->second.type)) {
+    if (TypeResolver::isString(it->type)) {
       if (e.indices.size() != 1)
         return logError("String indexing takes exactly one index");
       Value *idx = codegen(*e.indices[0]);
@@ -973,21 +1200,25 @@ Value *CodeGenerator::visitArrayIndex(const ArrayIndexExpr &e) {
       if (idx->getType()->isIntegerTy(32))
         idx = builder.CreateSExt(idx, Type::getInt64Ty(context));
       llvm::StructType *strSt = TypeResolver::getStringType(context);
-      Value *loaded =
-          builder.CreateLoad(strSt, it->second.allocaInst, "str.load");
+      Value *loaded = builder.CreateLoad(strSt, it->allocaInst, "str.load");
+      if (boundsMgr.enabled() &&
+          !boundsMgr.isProven(e.array.symbol(), 0, *e.indices[0]))
+        boundsMgr.emitCheck(
+            builder.CreateSExtOrTrunc(idx, Type::getInt64Ty(context)),
+            builder.CreateExtractValue(loaded, {1}, "str.len"), e.array.token);
       Value *dataPtr = builder.CreateExtractValue(loaded, {0}, "str.data");
       Value *charPtr =
           builder.CreateGEP(Type::getInt8Ty(context), dataPtr, idx, "char.ptr");
       return builder.CreateLoad(Type::getInt8Ty(context), charPtr, "char");
     }
 
-    ptr = it->second.allocaInst;
-    ty = it->second.type;
+    ptr = it->allocaInst;
+    ty = it->type;
 
-    if (it->second.isReference) {
+    if (it->isReference) {
       ptr = builder.CreateLoad(PointerType::get(context, 0), ptr);
-      if (it->second.pointeeType)
-        ty = it->second.pointeeType;
+      if (it->pointeeType)
+        ty = it->pointeeType;
     }
   }
 
@@ -1002,38 +1233,20 @@ Value *CodeGenerator::visitArrayIndex(const ArrayIndexExpr &e) {
     }
   }
 
-  for (size_t d = 0; d < e.indices.size(); ++d) {
-    Value *idx = codegen(*e.indices[d]);
-    if (!idx)
-      return nullptr;
-    if (idx->getType()->isIntegerTy(32))
-      idx = builder.CreateSExt(idx, Type::getInt64Ty(context));
+  auto *arrSt = dyn_cast<StructType>(ty);
+  if (!arrSt || !TypeResolver::isArray(arrSt))
+    return logError(("Not an array: " + name).c_str());
 
-    auto *arrSt = dyn_cast<StructType>(ty);
-    if (!arrSt || !TypeResolver::isArray(arrSt))
-      return logError(("Not an array: " + name).c_str());
-
-    Value *loaded = builder.CreateLoad(arrSt, ptr, "arr.load");
-    Value *dataPtr = builder.CreateExtractValue(loaded, {1}, "arr.data");
-    Type *elemTy = resolveElemType(context, arrSt);
-    if (!elemTy)
-      return logError("Cannot resolve element type");
-
-    Value *elemPtr = builder.CreateGEP(elemTy, dataPtr, idx, "elem.ptr");
-
-    if (d == e.indices.size() - 1) {
-      // At the last dimension: return a pointer for aggregates, a load for
-      // scalars.
-      if (TypeResolver::isArray(elemTy) || TypeResolver::isString(elemTy))
-        return elemPtr;
-      if (TypeResolver::isString(ty))
-        return builder.CreateLoad(Type::getInt8Ty(context), elemPtr, "char");
-      return builder.CreateLoad(elemTy, elemPtr, "elem");
-    }
-    ptr = elemPtr;
-    ty = elemTy;
-  }
-  return nullptr;
+  Type *elemTy = nullptr;
+  Value *elemPtr = emitSubscript(ptr, arrSt, e.array, e.indices, elemTy);
+  if (!elemPtr)
+    return nullptr;
+
+  // Return a pointer for aggregates (including sub-array views), a load for
+  // scalars and structs.
+  if (TypeResolver::isArray(elemTy) || TypeResolver::isString(elemTy))
+    return elemPtr;
+  return builder.CreateLoad(elemTy, elemPtr, "elem");
 }
 
 /**
@@ -1061,21 +1274,21 @@ Value *CodeGenerator::visitArrayIndexAssign(const ArrayIndexAssignExpr &e) {
     name = "<expr>";
   } else {
     name = e.array.token.getWord();
-    auto it = namedValues.find(name);
-    if (it == namedValues.end())
+    VarInfo *it = namedValues.lookup(e.array.symbol());
+    if (!it)
       return logError(("Unknown variable: " + name).c_str());
-    if (it->second.isConst)
+    if (it->isConst)
       return logError(
           ("Cannot assign to element of const array: " + name).c_str());
 
-    ptr = it->second.allocaInst;
-    ty = it->second.type;
+    ptr = it->allocaInst;
+    ty = it->type;
 
-    if (it->second.isReference) {
+    if (it->isReference) {
       ptr =
           builder.CreateLoad(PointerType::get(context, 0), ptr, name + ".ref");
-      if (it->second.pointeeType)
-        ty = it->second.pointeeType;
+      if (it->pointeeType)
+        ty = it->pointeeType;
     }
   }
 
@@ -1089,51 +1302,90 @@ Value *CodeGenerator::visitArrayIndexAssign(const ArrayIndexAssignExpr &e) {
     }
   }
 
-  for (size_t d = 0; d < e.indices.size(); ++d) {
-    Value *idx = codegen(*e.indices[d]);
-    if (!idx)
-      return nullptr;
-    if (idx->getType()->isIntegerTy(32))
-      idx = builder.CreateSExt(idx, Type::getInt64Ty(context));
+  auto *arrSt = dyn_cast<StructType>(ty);
+  if (!arrSt || !TypeResolver::isArray(arrSt))
+    return logError(("Not an array: " + name).c_str());
 
-    auto *arrSt = dyn_cast<StructType>(ty);
-    if (!arrSt || !TypeResolver::isArray(arrSt))
-      return logError(("Not an array: " + name).c_str());
+  Type *elemTy = nullptr;
+  Value *elemPtr = emitSubscript(ptr, arrSt, e.array, e.indices, elemTy);
+  if (!elemPtr)
+    return nullptr;
 
-    Value *loaded = builder.CreateLoad(arrSt, ptr, "arr.load");
-    Value *dataPtr = builder.CreateExtractValue(loaded, {1}, "arr.data");
-    Type *elemTy = resolveElemType(context, arrSt);
-    if (!elemTy)
-      return logError("Cannot resolve element type");
+  Value *val = codegen(*e.value);
+  if (!val)
+    return nullptr;
 
-    Value *elemPtr = builder.CreateGEP(elemTy, dataPtr, idx, "elem.ptr");
+  // A row of a dense array is not a separate object; assigning to it copies
+  // the source's elements in, which must match the row's shape.
+  if (arrayViews.count(elemPtr)) {
+    auto *viewSt = cast<StructType>(elemTy);
+    Value *src = val;
+    if (val->getType()->isPointerTy())
+      val = builder.CreateLoad(viewSt, val, "slot.val");
+    if (val->getType() != viewSt)
+      return logError("Array assignment needs an array of the same rank");
+
+    unsigned rank = TypeResolver::arrayRank(viewSt);
+    Type *leafTy = viewSt;
+    for (unsigned d = 0; d < rank; ++d)
+      leafTy = resolveElemType(context, cast<StructType>(leafTy));
+
+    Value *dst = builder.CreateLoad(viewSt, elemPtr, "view.load");
+    boundsMgr.emitShapeCheck(val, dst, rank, e.array.token);
+    Value *count = ArrayEmitter::emitElementCount(builder, dst, rank);
+    uint64_t leafSize = module->getDataLayout().getTypeAllocSize(leafTy);
+    Value *bytes = builder.CreateMul(
+        count, ConstantInt::get(Type::getInt64Ty(context), leafSize), "bytes");
+    Value *srcData = builder.CreateExtractValue(val, {1}, "src.data");
+    builder.CreateMemCpy(builder.CreateExtractValue(dst, {1}, "dst.data"),
+                         MaybeAlign(1), srcData, MaybeAlign(1), bytes);
+
+    // A temporary 'new' array is consumed here.
+    if (isa<NewArrayExpr>(e.value.get()) && src->getType()->isPointerTy()) {
+      builder.CreateCall(getFree(), {srcData});
+      builder.CreateCall(getFree(), {src});
+    }
+    return val;
+  }
 
-    if (d == e.indices.size() - 1) {
-      Value *val = codegen(*e.value);
-      if (!val)
-        return nullptr;
+  // A row of a jagged array owns its buffer: the row it replaces is freed
+  // and the new one is taken over, leaving a named source empty.
+  if (TypeResolver::isArray(elemTy)) {
+    auto *rowSt = cast<StructType>(elemTy);
+    Value *src = val;
+    if (arrayViews.count(src))
+      return logError("A jagged row cannot share a dense array's buffer; "
+                      "assign a new array to it");
+    if (val->getType()->isPointerTy())
+      val = builder.CreateLoad(rowSt, val, "row.val");
+    if (val->getType() != rowSt)
+      return logError("Row assignment needs an array of the row's type");
+
+    scopeMgr.releaseArray(elemPtr, rowSt);
+    builder.CreateStore(val, elemPtr);
+    if (isa<NewArrayExpr>(e.value.get()) && src->getType()->isPointerTy())
+      builder.CreateCall(getFree(), {src});
+    else if (src->getType()->isPointerTy() && src != elemPtr)
+      builder.CreateStore(Constant::getNullValue(rowSt), src);
+    return val;
+  }
 
-      if (TypeResolver::isArray(elemTy) || TypeResolver::isString(elemTy)) {
-        if (val->getType()->isPointerTy())
-          val = builder.CreateLoad(elemTy, val, "slot.val");
-        builder.CreateStore(val, elemPtr);
-        return val;
-      }
-      if (llvm::dyn_cast<llvm::StructType>(elemTy)) {
-        Value *structVal = val->getType()->isPointerTy()
-                               ? builder.CreateLoad(elemTy, val, "struct.val")
-                               : val;
-        builder.CreateStore(structVal, elemPtr);
-        return val;
-      }
-      val = TypeResolver::coerce(builder, val, elemTy);
-      builder.CreateStore(val, elemPtr);
-      return val;
-    }
-    ptr = elemPtr;
-    ty = elemTy;
+  if (TypeResolver::isString(elemTy)) {
+    if (val->getType()->isPointerTy())
+      val = builder.CreateLoad(elemTy, val, "slot.val");
+    builder.CreateStore(val, elemPtr);
+    return val;
   }
-  return nullptr;
+  if (llvm::dyn_cast<llvm::StructType>(elemTy)) {
+    Value *structVal = val->getType()->isPointerTy()
+                           ? builder.CreateLoad(elemTy, val, "struct.val")
+                           : val;
+    builder.CreateStore(structVal, elemPtr);
+    return val;
+  }
+  val = TypeResolver::coerce(builder, val, elemTy);
+  builder.CreateStore(val, elemPtr);
+  return val;
 }
 
 /**
@@ -1143,18 +1395,18 @@ Value *CodeGenerator::visitArrayIndexAssign(const ArrayIndexAssignExpr &e) {
  * @return an i64 LLVM Value* holding the length, or nullptr on error
  */
 Value *CodeGenerator::visitLengthProperty(const LengthPropertyExpr &e) {
-  const std::string &name = e.name.token.getWord();
-  auto it = namedValues.find(name);
-  if (it == namedValues.end())
+  const std::string name(e.name.token.getWord());
+  VarInfo *it = namedValues.lookup(e.name.symbol());
+  if (!it)
     return logError(("Unknown variable: " + name).c_str());
 
-  Type *ty = it->second.type;
+  Type *ty = it->type;
   if (TypeResolver::isArray(ty)) {
-    Value *loaded = builder.CreateLoad(ty, it->second.allocaInst);
+    Value *loaded = builder.CreateLoad(ty, it->allocaInst);
     return builder.CreateExtractValue(loaded, {0}, "length");
   }
   if (TypeResolver::isString(ty)) {
-    Value *loaded = builder.CreateLoad(ty, it->second.allocaInst);
+    Value *loaded = builder.CreateLoad(ty, it->allocaInst);
     return builder.CreateExtractValue(loaded, {1}, "length");
   }
   return logError(".length not applicable to this type");
@@ -1162,58 +1414,55 @@ Value *CodeGenerator::visitLengthProperty(const LengthPropertyExpr &e) {
 
 /**
  * Generates IR for .length on a nested array element (e.g. arr[i].length).
- * Navigates each index dimension and then reads field 0 of the resulting
- * array struct.
+ * Dense arrays keep every extent in the descriptor, so this is the extent of
+ * the dimension after the last index; the indices are still evaluated. The
+ * row of a jagged array is looked up and its own length read.
  * @param e the indexed-length expression AST node
  * @return an i64 LLVM Value* holding the sub-array length, or nullptr
  */
 Value *CodeGenerator::visitIndexedLength(const IndexedLengthExpr &e) {
-  const std::string &name = e.arrayName.token.getWord();
-  auto it = namedValues.find(name);
-  if (it == namedValues.end())
+  const std::string name(e.arrayName.token.getWord());
+  VarInfo *it = namedValues.lookup(e.arrayName.symbol());
+  if (!it)
     return logError(("Unknown variable: " + name).c_str());
 
-  Value *ptr = it->second.allocaInst;
-  Type *ty = it->second.type;
-
-  for (size_t d = 0; d < e.indices.size(); ++d) {
-    auto *arrSt = dyn_cast<StructType>(ty);
-    if (!arrSt || !TypeResolver::isArray(arrSt))
-      return logError("Not an array");
-
-    Value *idx = codegen(*e.indices[d]);
-    if (!idx)
+  auto *arrSt = dyn_cast<StructType>(it->type);
+  if (!arrSt || !TypeResolver::isArray(arrSt))
+    return logError("Not an array");
+  unsigned dim = e.indices.size();
+  if (dim >= TypeResolver::arrayRank(arrSt)) {
+    // A row of a jagged array carries its own length.
+    if (!TypeResolver::isJagged(arrSt))
+      return logError(".length: element is not an array");
+    Type *rowTy = nullptr;
+    Value *row =
+        emitSubscript(it->allocaInst, arrSt, e.arrayName, e.indices, rowTy);
+    if (!row)
       return nullptr;
-    if (idx->getType()->isIntegerTy(32))
-      idx = builder.CreateSExt(idx, Type::getInt64Ty(context));
-
-    Value *loaded = builder.CreateLoad(arrSt, ptr, "arr.load");
-    Value *dataPtr = builder.CreateExtractValue(loaded, {1}, "arr.data");
-    Type *elemTy = resolveElemType(context, arrSt);
-    if (!elemTy)
-      return logError("Cannot resolve element type");
-
-    ptr = builder.CreateGEP(elemTy, dataPtr, idx, "elem.ptr");
-    ty = elemTy;
+    if (!TypeResolver::isArray(rowTy))
+      return logError(".length: element is not an array");
+    Value *loaded = builder.CreateLoad(rowTy, row, "row.load");
+    return ArrayEmitter::emitDim(builder, loaded, 0);
   }
 
-  auto *subSt = dyn_cast<StructType>(ty);
-  if (!subSt || !TypeResolver::isArray(subSt))
-    return logError(".length: element is not an array");
+  for (const auto &idx : e.indices)
+    if (!codegen(*idx))
+      return nullptr;
 
-  Value *loaded = builder.CreateLoad(subSt, ptr, "subarr.load");
-  return builder.CreateExtractValue(loaded, {0}, "length");
+  Value *loaded = builder.CreateLoad(arrSt, it->allocaInst, "arr.load");
+  return ArrayEmitter::emitDim(builder, loaded, dim);
 }
 
 /**
  * Generates IR to allocate a new heap array with the given dimensions.
- * Delegates to ArrayEmitter::makeND which handles both 1-D and N-D cases.
+ * new T[a][b]... delegates to ArrayEmitter::makeND, which stores every rank
+ * in one dense buffer; new T[][n] opts into a jagged array (makeJagged).
  *
  * @param e the new-array expression AST node
  * @return an AllocaInst* pointing to the initialised array struct, or nullptr
  */
 Value *CodeGenerator::visitNewArray(const NewArrayExpr &e) {
-  std::string typeName = e.arrayType.base.token.getWord();
+  std::string typeName(e.arrayType.base.token.getWord());
   Type *elemType = TypeResolver::fromName(context, typeName);
   if (!elemType)
     elemType = llvm::StructType::getTypeByName(context, typeName);
@@ -1227,7 +1476,7 @@ Value *CodeGenerator::visitNewArray(const NewArrayExpr &e) {
         t = llvm::StructType::getTypeByName(context, arg.base.token.getWord());
       if (t) {
         concreteArgs.push_back(t);
-        argNames.push_back(arg.base.token.getWord());
+        argNames.emplace_back(arg.base.token.getWord());
       }
     }
     if (!concreteArgs.empty()) {
@@ -1240,6 +1489,21 @@ Value *CodeGenerator::visitNewArray(const NewArrayExpr &e) {
   if (!elemType)
     return logError(("Unknown element type: " + typeName).c_str());
 
+  // new T[][n]: n rows that are arrays of their own (see makeJagged).
+  if (e.arrayType.dimensions > 0) {
+    if (e.sizes.size() != 1)
+      return logError(("Jagged array 'new " + typeName +
+                       "[][...]' takes one size, the number of rows")
+                          .c_str());
+    Type *rowType = elemType;
+    for (int d = 0; d < e.arrayType.dimensions; ++d)
+      rowType = TypeResolver::getOrCreateArrayStruct(context, rowType);
+    Value *rows = codegen(*e.sizes[0]);
+    if (!rows)
+      return nullptr;
+    return ArrayEmitter::makeJagged(builder, context, *module, rowType, rows);
+  }
+
   std::vector<Value *> dimValues;
   for (auto &sizeExpr : e.sizes) {
     Value *v = codegen(*sizeExpr);
@@ -1266,7 +1530,7 @@ Value *CodeGenerator::visitCast(const CastExpr &e) {
   if (!val)
     return nullptr;
 
-  const std::string &targetName = e.targetType.base.token.getWord();
+  const std::string targetName(e.targetType.base.token.getWord());
   Type *srcTy = val->getType();
   Type *dstTy = TypeResolver::fromName(context, targetName);
   if (!dstTy)
@@ -1328,18 +1592,31 @@ Value *CodeGenerator::visitCast(const CastExpr &e) {
 /**
  * Mangles a user function name to "Name$arity" to support overloading.
  * Built-in names (Main, Printf, Print, Random, Read) bypass mangling and
- * are instead passed through normalizeFunctionName().
+ * are instead passed through normalizeFunctionName(). Results are interned
+ * and remembered, so each name and arity is spelled out only once.
  * @param name the function name as written in source
- * @param params the parameter list (used to derive the arity suffix)
+ * @param arity the number of parameters (or call arguments)
  * @return the mangled function name for use in the IR
  */
-static std::string mangleName(const std::string &name,
-                              const std::vector<Parameter> &params) {
-  static const std::unordered_set<std::string> kNoMangle = {
+Symbol CodeGenerator::mangleName(Symbol name, size_t arity) {
+  uint64_t key = (static_cast<uint64_t>(name.id()) << 32) | arity;
+  auto it = mangledNames.find(key);
+  if (it != mangledNames.end())
+    return it->second;
+
+  static const std::unordered_set<std::string_view> kNoMangle = {
       "Main", "Printf", "Print", "Random", "Read"};
-  if (kNoMangle.count(name))
-    return normalizeFunctionName(name);
-  return name + "$" + std::to_string(params.size());
+  Symbol mangled;
+  if (kNoMangle.count(name.str())) {
+    mangled = Symbol::intern(normalizeFunctionName(std::string(name.str())));
+  } else {
+    std::string spelled(name.str());
+    spelled += "$";
+    spelled += std::to_string(arity);
+    mangled = Symbol::intern(spelled);
+  }
+  mangledNames.emplace(key, mangled);
+  return mangled;
 }
 
 /*---------------------------------------*/
@@ -1367,13 +1644,13 @@ Value *CodeGenerator::visitCall(const CallExpr &e) {
   std::string rawName = "";
   std::string enumPrefix = "";
 
-  if (auto *id = dynamic_cast<const IdentExpr *>(e.callee.get())) {
+  if (auto *id = dyn_cast<IdentExpr>(e.callee.get())) {
     rawName = id->name.token.getWord();
-  } else if (auto *fa = dynamic_cast<const FieldAccessExpr *>(e.callee.get())) {
+  } else if (auto *fa = dyn_cast<FieldAccessExpr>(e.callee.get())) {
     std::string variantName = fa->field;
 
-    if (auto *baseId = dynamic_cast<const IdentExpr *>(fa->object.get())) {
-      std::string enumName = baseId->name.token.getWord();
+    if (auto *baseId = dyn_cast<IdentExpr>(fa->object.get())) {
+      std::string enumName(baseId->name.token.getWord());
 
       // Try the plain name first (non-generic enums).
       llvm::StructType *enumType =
@@ -1393,26 +1670,32 @@ Value *CodeGenerator::visitCall(const CallExpr &e) {
         if (tmpl) {
           std::function<llvm::Type *(const Expression *)> inferArgStaticType =
               [&](const Expression *argExpr) -> llvm::Type * {
-            if (auto *argId = dynamic_cast<const IdentExpr *>(argExpr)) {
-              auto it = namedValues.find(argId->name.token.getWord());
-              return it != namedValues.end() ? it->second.type : nullptr;
+            switch (argExpr->getKind()) {
+            case ExprKind::Ident: {
+              VarInfo *it =
+                  namedValues.lookup(cast<IdentExpr>(argExpr)->name.symbol());
+              return it ? it->type : nullptr;
             }
-            if (dynamic_cast<const StrLitExpr *>(argExpr))
+            case ExprKind::StrLit:
               return TypeResolver::getStringType(context);
-            if (dynamic_cast<const IntLitExpr *>(argExpr))
+            case ExprKind::IntLit:
               return llvm::Type::getInt32Ty(context);
-            if (dynamic_cast<const FloatLitExpr *>(argExpr))
+            case ExprKind::FloatLit:
               return llvm::Type::getFloatTy(context);
-            if (dynamic_cast<const BoolLitExpr *>(argExpr))
+            case ExprKind::BoolLit:
               return llvm::Type::getInt1Ty(context);
-            if (dynamic_cast<const CharLitExpr *>(argExpr))
+            case ExprKind::CharLit:
               return llvm::Type::getInt8Ty(context);
-            if (auto *un = dynamic_cast<const UnaryExpr *>(argExpr))
-              return inferArgStaticType(un->operand.get()); // e.g. -5
+            case ExprKind::Unary: // e.g. -5
+              return inferArgStaticType(
+                  cast<UnaryExpr>(argExpr)->operand.get());
+            default:
+              break;
+            }
             return nullptr;
           };
 
-          std::unordered_map<std::string, llvm::Type *> typeSubst;
+          std::unordered_map<std::string, llvm::Type *> variantSubst;
           for (const auto &v : tmpl->variants) {
             if (v.name != variantName)
               continue;
@@ -1423,7 +1706,7 @@ Value *CodeGenerator::visitCall(const CallExpr &e) {
                 if (tp != fieldTypeName)
                   continue;
                 if (llvm::Type *t = inferArgStaticType(e.arguments[i].get()))
-                  typeSubst[tp] = t;
+                  variantSubst[tp] = t;
                 break;
               }
             }
@@ -1435,8 +1718,8 @@ Value *CodeGenerator::visitCall(const CallExpr &e) {
           std::vector<std::string> argNames;
           bool allResolved = true;
           for (const auto &tp : tmpl->typeParams) {
-            auto it = typeSubst.find(tp);
-            if (it == typeSubst.end()) {
+            auto it = variantSubst.find(tp);
+            if (it == variantSubst.end()) {
               allResolved = false;
               break;
             }
@@ -1587,28 +1870,54 @@ Value *CodeGenerator::visitCall(const CallExpr &e) {
   if (rawName == "Random")
     return BuiltinEmitter::handleRandom(builder, context, module.get());
 
-  llvm::Function *callee = module->getFunction(
-      calleeName + "$" + std::to_string(e.arguments.size()));
+  // Plain calls resolve through the callee's symbol; enum constructors and
+  // externs fall back to their spelled names.
+  auto *calleeId = dyn_cast<IdentExpr>(e.callee.get());
+  llvm::Function *callee =
+      calleeId && enumPrefix.empty()
+          ? module->getFunction(
+                mangleName(calleeId->name.symbol(), e.arguments.size()).str())
+          : module->getFunction(calleeName + "$" +
+                                std::to_string(e.arguments.size()));
   if (!callee)
     callee = module->getFunction(calleeName);
   if (!callee)
     return logError(("Unknown function: " + calleeName).c_str());
 
-  auto refIt = borrowRefParams.find(callee->getName().str());
+  auto refIt = borrowRefParams.find(callee);
+  auto mutIt = borrowMutParams.find(callee);
   std::vector<Value *> args;
 
   for (size_t i = 0; i < e.arguments.size(); ++i) {
     bool paramIsRef = refIt != borrowRefParams.end() &&
                       i < refIt->second.size() && refIt->second[i];
 
-    auto mutIt = borrowMutParams.find(callee->getName().str());
     bool paramIsMut = mutIt != borrowMutParams.end() &&
                       i < mutIt->second.size() && mutIt->second[i];
 
+    // Parameters are typed as dense arrays, so a jagged array stays in the
+    // function that allocated it.
+    if (!callee->isDeclaration()) {
+      const Identifier *argVar = nullptr;
+      if (auto *id = dyn_cast<IdentExpr>(e.arguments[i].get()))
+        argVar = &id->name;
+      else if (auto *ba = dyn_cast<BorrowArgExpr>(e.arguments[i].get()))
+        argVar = &ba->name;
+      else if (auto *bm = dyn_cast<BorrowMutArgExpr>(e.arguments[i].get()))
+        argVar = &bm->name;
+      VarInfo *argInfo = argVar ? namedValues.lookup(argVar->symbol()) : nullptr;
+      if (argInfo && TypeResolver::isJagged(argInfo->type))
+        return logError(("Jagged array '" +
+                         std::string(argVar->token.getWord()) +
+                         "' cannot be passed to '" + rawName +
+                         "': parameters take dense arrays")
+                            .c_str());
+    }
+
     Value *v = nullptr;
 
     // BorrowArg / BorrowMutArg: pass the alloca address directly.
-    if (auto *ba = dynamic_cast<const BorrowArgExpr *>(e.arguments[i].get())) {
+    if (auto *ba = dyn_cast<BorrowArgExpr>(e.arguments[i].get())) {
       if (paramIsMut) {
         return logError(("Argument " + std::to_string(i + 1) + " of '" +
                          rawName +
@@ -1622,43 +1931,40 @@ Value *CodeGenerator::visitCall(const CallExpr &e) {
                          "': parameter is not a reference, remove '&'")
                             .c_str());
       }
-      auto sit = namedValues.find(ba->name.token.getWord());
-      if (sit == namedValues.end())
+      VarInfo *sit = namedValues.lookup(ba->name.symbol());
+      if (!sit)
         return logError(
-            ("Unknown variable: " + ba->name.token.getWord()).c_str());
+            ("Unknown variable: " + std::string(ba->name.token.getWord()))
+                .c_str());
 
-      if (sit->second.isReference) {
-        v = builder.CreateLoad(PointerType::get(context, 0),
-                               sit->second.allocaInst,
+      if (sit->isReference) {
+        v = builder.CreateLoad(PointerType::get(context, 0), sit->allocaInst,
                                ba->name.token.getWord() + ".deref");
       } else {
-        v = sit->second.allocaInst;
+        v = sit->allocaInst;
       }
-    } else if (auto *bm = dynamic_cast<const BorrowMutArgExpr *>(
-                   e.arguments[i].get())) {
+    } else if (auto *bm = dyn_cast<BorrowMutArgExpr>(e.arguments[i].get())) {
       if (!paramIsRef && !paramIsMut) {
         return logError(("Argument " + std::to_string(i + 1) + " of '" +
                          rawName +
                          "': parameter is not a reference, remove '&mut'")
                             .c_str());
       }
-      auto sit = namedValues.find(bm->name.token.getWord());
-      if (sit == namedValues.end())
+      VarInfo *sit = namedValues.lookup(bm->name.symbol());
+      if (!sit)
         return logError(
-            ("Unknown variable: " + bm->name.token.getWord()).c_str());
+            ("Unknown variable: " + std::string(bm->name.token.getWord()))
+                .c_str());
 
-      if (sit->second.isReference) {
-        v = builder.CreateLoad(PointerType::get(context, 0),
-                               sit->second.allocaInst,
+      if (sit->isReference) {
+        v = builder.CreateLoad(PointerType::get(context, 0), sit->allocaInst,
                                bm->name.token.getWord() + ".deref");
       } else {
-        v = sit->second.allocaInst;
+        v = sit->allocaInst;
       }
     } else if (paramIsRef || paramIsMut) {
-      bool isBorrowMut = dynamic_cast<const BorrowMutArgExpr *>(
-                             e.arguments[i].get()) != nullptr;
-      bool isBorrow =
-          dynamic_cast<const BorrowArgExpr *>(e.arguments[i].get()) != nullptr;
+      bool isBorrowMut = isa<BorrowMutArgExpr>(e.arguments[i].get());
+      bool isBorrow = isa<BorrowArgExpr>(e.arguments[i].get());
 
       if (!isBorrowMut && !isBorrow) {
         return logError(("Argument " + std::to_string(i + 1) + " of '" +
@@ -1674,10 +1980,10 @@ Value *CodeGenerator::visitCall(const CallExpr &e) {
                          "passed use '&mut <var>'")
                             .c_str());
       }
-      if (auto *id = dynamic_cast<const IdentExpr *>(e.arguments[i].get())) {
-        auto sit = namedValues.find(id->name.token.getWord());
-        if (sit != namedValues.end())
-          v = sit->second.allocaInst;
+      if (auto *id = dyn_cast<IdentExpr>(e.arguments[i].get())) {
+        VarInfo *sit = namedValues.lookup(id->name.symbol());
+        if (sit)
+          v = sit->allocaInst;
       }
       if (!v) {
         v = codegen(*e.arguments[i]);
@@ -1704,11 +2010,10 @@ Value *CodeGenerator::visitCall(const CallExpr &e) {
         } else if (vTy->isPointerTy() && expectedTy->isPointerTy() &&
                    callee->isDeclaration()) {
           llvm::Type *pointeeTy = nullptr;
-          if (auto *id =
-                  dynamic_cast<const IdentExpr *>(e.arguments[i].get())) {
-            auto sit = namedValues.find(id->name.token.getWord());
-            if (sit != namedValues.end())
-              pointeeTy = sit->second.type;
+          if (auto *id = dyn_cast<IdentExpr>(e.arguments[i].get())) {
+            VarInfo *sit = namedValues.lookup(id->name.symbol());
+            if (sit)
+              pointeeTy = sit->type;
           }
           if (!pointeeTy) {
             if (auto *ai = llvm::dyn_cast<llvm::AllocaInst>(v))
@@ -1749,16 +2054,14 @@ Value *CodeGenerator::visitCall(const CallExpr &e) {
     if (callee->isDeclaration() && i < callee->arg_size()) {
       Type *expectedTy = callee->getFunctionType()->getParamType(i);
       if (expectedTy->isPointerTy()) {
-        if (auto *id = dynamic_cast<const IdentExpr *>(e.arguments[i].get())) {
-          auto sit = namedValues.find(id->name.token.getWord());
-          if (sit != namedValues.end() &&
-              !TypeResolver::isString(sit->second.type) &&
-              !TypeResolver::isArray(sit->second.type)) {
-            v = sit->second.type->isPointerTy()
-                    ? builder.CreateLoad(sit->second.type,
-                                         sit->second.allocaInst,
+        if (auto *id = dyn_cast<IdentExpr>(e.arguments[i].get())) {
+          VarInfo *sit = namedValues.lookup(id->name.symbol());
+          if (sit && !TypeResolver::isString(sit->type) &&
+              !TypeResolver::isArray(sit->type)) {
+            v = sit->type->isPointerTy()
+                    ? builder.CreateLoad(sit->type, sit->allocaInst,
                                          id->name.token.getWord() + ".load")
-                    : sit->second.allocaInst;
+                    : sit->allocaInst;
           }
         } else if (!v->getType()->isPointerTy()) {
           AllocaInst *tmp = createEntryAlloca(v->getType(), "");
@@ -1781,7 +2084,7 @@ Value *CodeGenerator::visitCall(const CallExpr &e) {
 }
 
 Value *CodeGenerator::visitGenericCall(const GenericCallExpr &e) {
-  const std::string rawName = e.callee.token.getWord();
+  const std::string rawName(e.callee.token.getWord());
 
   std::vector<llvm::Type *> resolvedTypeArgs;
   for (const auto &td : e.typeArgs) {
@@ -1790,7 +2093,8 @@ Value *CodeGenerator::visitGenericCall(const GenericCallExpr &e) {
       t = llvm::StructType::getTypeByName(context, td.base.token.getWord());
     if (!t)
       return logError(
-          ("Unknown type argument: " + td.base.token.getWord()).c_str());
+          ("Unknown type argument: " + std::string(td.base.token.getWord()))
+              .c_str());
     resolvedTypeArgs.push_back(t);
   }
 
@@ -1829,6 +2133,7 @@ Value *CodeGenerator::visitGenericCall(const GenericCallExpr &e) {
     if (!callee)
       return nullptr;
     genericCache[mangledName] = callee;
+    TimeReport::count("generic functions instantiated");
   }
 
   std::vector<Value *> args;
@@ -1863,15 +2168,15 @@ llvm::Function *CodeGenerator::emitGenericSpecialization(
     const AST_H::Function &astFn, const std::string &mangledName,
     const std::vector<llvm::Type *> &typeArgs) {
 
-  std::unordered_map<std::string, llvm::Type *> typeSubst;
+  std::unordered_map<std::string, llvm::Type *> specSubst;
   for (size_t i = 0; i < astFn.typeParams.size(); ++i)
-    typeSubst[astFn.typeParams[i]] = typeArgs[i];
+    specSubst[astFn.typeParams[i]] = typeArgs[i];
 
   auto resolveType = [&](const TypeDesc &td) -> llvm::Type * {
-    const std::string &baseName = td.base.token.getWord();
+    const std::string baseName(td.base.token.getWord());
     llvm::Type *base = nullptr;
-    auto subIt = typeSubst.find(baseName);
-    if (subIt != typeSubst.end())
+    auto subIt = specSubst.find(baseName);
+    if (subIt != specSubst.end())
       base = subIt->second;
     else {
       base = TypeResolver::fromTypeDesc(context, td);
@@ -1909,45 +2214,56 @@ llvm::Function *CodeGenerator::emitGenericSpecialization(
     paramIsRef.push_back(p.isBorrowRef);
     paramIsMut.push_back(p.isBorrowRef && p.isMut);
   }
-  borrowRefParams[mangledName] = paramIsRef;
-  borrowMutParams[mangledName] = paramIsMut;
+  borrowRefParams[f] = paramIsRef;
+  borrowMutParams[f] = paramIsMut;
 
-  auto savedNamedValues = namedValues;
+  // Set the caller's scopes aside; the specialization sees only globals.
+  auto savedScopes = scopeMgr.suspend();
+  auto savedFacts = boundsMgr.suspend();
   auto *savedBB = builder.GetInsertBlock();
   auto savedIP = builder.GetInsertPoint();
+  std::optional<DebugInfoManager::Saved> savedDebug;
+  if (debugInfo)
+    savedDebug = debugInfo->enterFunction(f, astFn.name.token.getWord(),
+                                          astFn.name.token.getLine(),
+                                          astFn.sourcePath);
 
   llvm::BasicBlock *entry = llvm::BasicBlock::Create(context, "entry", f);
   builder.SetInsertPoint(entry);
 
-  namedValues = globalValues;
   scopeMgr.reset();
   scopeMgr.pushScope();
 
   size_t idx = 0;
   for (auto &arg : f->args()) {
     const auto &param = astFn.params[idx++];
-    const std::string pname = param.name.token.getWord();
+    const std::string pname(param.name.token.getWord());
     llvm::Type *declaredTy = resolveType(param.type);
     if (!declaredTy)
       declaredTy = arg.getType();
 
     llvm::AllocaInst *a = createEntryAlloca(declaredTy, pname);
+    VarInfo vi(a, declaredTy, false, false, false, param.isConst);
     if (TypeResolver::isString(declaredTy) ||
         TypeResolver::isArray(declaredTy) || declaredTy->isStructTy()) {
       Value *val = builder.CreateLoad(declaredTy, &arg, pname + ".param");
       builder.CreateStore(val, a);
-      VarInfo vi(a, declaredTy, false, false, false, param.isConst);
       vi.ownsHeap = false;
-      namedValues[pname] = vi;
+      if (TypeResolver::isString(declaredTy)) {
+        // A view of the caller's buffer: appending gives it one of its own,
+        // which is then freed here (or handed back on return).
+        StringOps::makeView(builder, context, a);
+        vi.ownsHeap = true;
+      }
     } else {
       builder.CreateStore(&arg, a);
-      namedValues[pname] =
-          VarInfo(a, declaredTy, false, false, false, param.isConst);
     }
-    scopeMgr.declare(pname);
+    scopeMgr.declare(param.name.symbol(), vi);
   }
 
+  auto *savedSubst = std::exchange(typeSubst, &specSubst);
   codegen(*astFn.body);
+  typeSubst = savedSubst;
 
   if (!blockHasTerminator(builder)) {
     scopeMgr.popAll();
@@ -1959,13 +2275,18 @@ llvm::Function *CodeGenerator::emitGenericSpecialization(
       builder.CreateRet(llvm::ConstantInt::get(retTy, 0));
   }
 
-  namedValues = savedNamedValues;
+  scopeMgr.resume(std::move(savedScopes));
+  boundsMgr.resume(std::move(savedFacts));
   if (savedBB)
     builder.SetInsertPoint(savedBB, savedIP);
+  if (savedDebug)
+    debugInfo->leaveFunction(*savedDebug);
 
-  if (llvm::verifyFunction(*f, &llvm::errs())) {
-    llvm::errs() << "verifyFunction failed for generic specialization: "
+  if (llvm::verifyFunction(*f, &diag())) {
+    diag() << "verifyFunction failed for generic specialization: "
                  << mangledName << "\n";
+    borrowRefParams.erase(f);
+    borrowMutParams.erase(f);
     f->eraseFromParent();
     return nullptr;
   }
@@ -1974,7 +2295,7 @@ llvm::Function *CodeGenerator::emitGenericSpecialization(
 }
 
 llvm::StructType *CodeGenerator::instantiateGenericStruct(const TypeDesc &td) {
-  const std::string &baseName = td.base.token.getWord();
+  const std::string baseName(td.base.token.getWord());
 
   const StructDecl *tmpl = nullptr;
   for (const auto &s : currentProgram->structs) {
@@ -1994,7 +2315,8 @@ llvm::StructType *CodeGenerator::instantiateGenericStruct(const TypeDesc &td) {
       t = llvm::StructType::getTypeByName(context, arg.base.token.getWord());
     if (!t)
       return nullptr;
-    mangledName += "$" + arg.base.token.getWord();
+    mangledName += "$";
+    mangledName += arg.base.token.getWord();
     concreteArgs.push_back(t);
   }
 
@@ -2008,7 +2330,7 @@ llvm::StructType *CodeGenerator::instantiateGenericStruct(const TypeDesc &td) {
   auto *st = llvm::StructType::create(context, mangledName);
   std::vector<llvm::Type *> fieldTypes;
   for (const auto &f : tmpl->fields) {
-    const std::string &fn = f.type.base.token.getWord();
+    const std::string fn(f.type.base.token.getWord());
     llvm::Type *ft = nullptr;
     auto it = subst.find(fn);
     if (it != subst.end()) {
@@ -2025,6 +2347,7 @@ llvm::StructType *CodeGenerator::instantiateGenericStruct(const TypeDesc &td) {
     fieldTypes.push_back(ft);
   }
   st->setBody(fieldTypes);
+  TimeReport::count("generic structs instantiated");
 
   concreteStructFields[mangledName] = tmpl;
   auto synth = std::make_unique<StructDecl>(mangledName, tmpl->fields);
@@ -2151,6 +2474,7 @@ llvm::StructType *CodeGenerator::instantiateGenericEnum(
       existingUnion ? existingUnion
                     : llvm::StructType::create(context, mangledBase);
   unionSt->setBody(unionFields);
+  TimeReport::count("generic enums instantiated");
   return unionSt;
 }
 
@@ -2160,7 +2484,8 @@ llvm::StructType *CodeGenerator::instantiateGenericEnum(
  */
 Value *CodeGenerator::visitBorrowArg(const BorrowArgExpr &e) {
   return logError(
-      ("'&" + e.name.token.getWord() + "' is only valid as a call argument")
+      ("'&" + std::string(e.name.token.getWord()) +
+       "' is only valid as a call argument")
           .c_str());
 }
 
@@ -2170,7 +2495,8 @@ Value *CodeGenerator::visitBorrowArg(const BorrowArgExpr &e) {
  */
 Value *CodeGenerator::visitBorrowMutArg(const BorrowMutArgExpr &e) {
   return logError(
-      ("'&mut " + e.name.token.getWord() + "' is only valid as a call argument")
+      ("'&mut " + std::string(e.name.token.getWord()) +
+       "' is only valid as a call argument")
           .c_str());
 }
 
@@ -2217,8 +2543,8 @@ Value *CodeGenerator::visitFieldAccess(const FieldAccessExpr &e) {
   // Check for enum variant access (e.g. Option.None, Code.A) BEFORE trying
   // resolveStructPtr, because the enum name is not a variable and will cause
   // resolveStructPtr to return null, masking the real intent.
-  if (auto *baseId = dynamic_cast<const IdentExpr *>(e.object.get())) {
-    const std::string &enumName = baseId->name.token.getWord();
+  if (auto *baseId = dyn_cast<IdentExpr>(e.object.get())) {
+    const std::string enumName(baseId->name.token.getWord());
     const std::string &varName = e.field;
 
     if (currentProgram) {
@@ -2281,8 +2607,8 @@ Value *CodeGenerator::visitFieldAccess(const FieldAccessExpr &e) {
   auto [structPtr, st] = resolveStructPtr(*e.object);
   if (!structPtr || !st)
     return logError("Field access requires a struct expression");
-  if (auto *baseId = dynamic_cast<const IdentExpr *>(e.object.get())) {
-    const std::string &enumName = baseId->name.token.getWord();
+  if (auto *baseId = dyn_cast<IdentExpr>(e.object.get())) {
+    const std::string enumName(baseId->name.token.getWord());
     const std::string &varName = e.field;
 
     if (currentProgram) {
@@ -2360,18 +2686,18 @@ Value *CodeGenerator::visitFieldAccess(const FieldAccessExpr &e) {
 std::pair<Value *, llvm::StructType *>
 CodeGenerator::resolveStructPtr(const Expression &expr) {
   // Plain identifier: look up the alloca and verify it holds a struct.
-  if (auto *id = dynamic_cast<const IdentExpr *>(&expr)) {
-    const std::string &name = id->name.token.getWord();
-    auto it = namedValues.find(name);
-    if (it == namedValues.end())
+  if (auto *id = dyn_cast<IdentExpr>(&expr)) {
+    const std::string name(id->name.token.getWord());
+    VarInfo *it = namedValues.lookup(id->name.symbol());
+    if (!it)
       return {nullptr, nullptr};
 
-    Value *ptr = it->second.allocaInst;
-    Type *ty = it->second.type;
-    if (it->second.isReference) {
+    Value *ptr = it->allocaInst;
+    Type *ty = it->type;
+    if (it->isReference) {
       ptr =
           builder.CreateLoad(PointerType::get(context, 0), ptr, name + ".ref");
-      ty = it->second.pointeeType ? it->second.pointeeType : ty;
+      ty = it->pointeeType ? it->pointeeType : ty;
     }
     auto *st = llvm::dyn_cast<llvm::StructType>(ty);
     // Fallback: if the VarInfo type isn't a StructType (e.g. it was stored as
@@ -2386,8 +2712,8 @@ CodeGenerator::resolveStructPtr(const Expression &expr) {
       // ty is an opaque pointer — scan structDefs for any struct whose LLVM
       // type matches the pointee of the alloca, or whose name is encoded in
       // the VarInfo via pointeeType.
-      if (it->second.pointeeType)
-        st = llvm::dyn_cast<llvm::StructType>(it->second.pointeeType);
+      if (it->pointeeType)
+        st = llvm::dyn_cast<llvm::StructType>(it->pointeeType);
     }
     if (!st)
       return {nullptr, nullptr};
@@ -2395,7 +2721,7 @@ CodeGenerator::resolveStructPtr(const Expression &expr) {
   }
 
   // Array-indexed expression: navigate to the element, then cast to struct.
-  if (auto *ai = dynamic_cast<const ArrayIndexExpr *>(&expr)) {
+  if (auto *ai = dyn_cast<ArrayIndexExpr>(&expr)) {
     Value *ptr = nullptr;
     Type *ty = nullptr;
 
@@ -2425,60 +2751,42 @@ CodeGenerator::resolveStructPtr(const Expression &expr) {
       else
         return {nullptr, nullptr};
     } else {
-      const std::string &name = ai->array.token.getWord();
-      auto it = namedValues.find(name);
-      if (it == namedValues.end())
+      const std::string name(ai->array.token.getWord());
+      VarInfo *it = namedValues.lookup(ai->array.symbol());
+      if (!it)
         return {nullptr, nullptr};
 
-      ptr = it->second.allocaInst;
-      ty = it->second.type;
+      ptr = it->allocaInst;
+      ty = it->type;
 
-      if (it->second.isReference) {
+      if (it->isReference) {
         ptr = builder.CreateLoad(PointerType::get(context, 0), ptr);
-        if (it->second.pointeeType)
-          ty = it->second.pointeeType;
+        if (it->pointeeType)
+          ty = it->pointeeType;
       }
     }
     ty = ensureArrayDepth(ty, ai->indices.size());
     if (!ty)
       return {nullptr, nullptr};
 
-    for (size_t d = 0; d < ai->indices.size(); ++d) {
-      Value *idx = codegen(*ai->indices[d]);
-      if (!idx)
-        return {nullptr, nullptr};
-      if (idx->getType()->isIntegerTy(32))
-        idx = builder.CreateSExt(idx, Type::getInt64Ty(context));
-
-      auto *arrSt = dyn_cast<StructType>(ty);
-      if (!arrSt || !TypeResolver::isArray(arrSt))
-        return {nullptr, nullptr};
-
-      Value *loaded = builder.CreateLoad(arrSt, ptr, "arr.load");
-      Value *dataPtr = builder.CreateExtractValue(loaded, {1}, "arr.data");
-      Type *elemTy = resolveElemType(context, arrSt);
-      if (!elemTy)
-        return {nullptr, nullptr};
+    auto *arrSt = dyn_cast<StructType>(ty);
+    if (!arrSt || !TypeResolver::isArray(arrSt))
+      return {nullptr, nullptr};
 
-      Value *elemPtr = builder.CreateGEP(elemTy, dataPtr, idx, "elem.ptr");
-      if (d == ai->indices.size() - 1) {
-        auto *st = llvm::dyn_cast<llvm::StructType>(elemTy);
-        if (!st)
-          return {nullptr, nullptr};
-        // Verify the struct type is registered in structDefs.
-        for (const auto *sd : structDefs)
-          if (sd->name == st->getName().str())
-            return {elemPtr, st};
-        return {nullptr, nullptr};
-      }
-      ptr = elemPtr;
-      ty = elemTy;
-    }
+    Type *elemTy = nullptr;
+    Value *elemPtr = emitSubscript(ptr, arrSt, ai->array, ai->indices, elemTy);
+    auto *st = elemPtr ? llvm::dyn_cast<llvm::StructType>(elemTy) : nullptr;
+    if (!st || TypeResolver::isArray(st))
+      return {nullptr, nullptr};
+    // Verify the struct type is registered in structDefs.
+    for (const auto *sd : structDefs)
+      if (sd->name == st->getName().str())
+        return {elemPtr, st};
     return {nullptr, nullptr};
   }
 
   // Chained field access: recurse on the base, then GEP into the named field.
-  if (auto *fa = dynamic_cast<const FieldAccessExpr *>(&expr)) {
+  if (auto *fa = dyn_cast<FieldAccessExpr>(&expr)) {
     auto [basePtr, baseSt] = resolveStructPtr(*fa->object);
     if (!basePtr || !baseSt)
       return {nullptr, nullptr};
@@ -2617,7 +2925,7 @@ Value *CodeGenerator::visitChainedCmp(const ChainedCmpExpr &e) {
  * @return always nullptr (side-effect only)
  */
 Value *CodeGenerator::visitTypeIntrinsic(const TypeIntrinsicExpr &e) {
-  const std::string typeName = e.typeDesc.base.token.getWord();
+  const std::string typeName(e.typeDesc.base.token.getWord());
   std::string msg = typeName;
   if (!e.typeDesc.typeArgs.empty()) {
     msg += "<";
@@ -2641,6 +2949,15 @@ Value *CodeGenerator::visitTypeIntrinsic(const TypeIntrinsicExpr &e) {
   return nullptr;
 }
 
+/**
+ * An expression the parser could not read. Parse errors are reported by the
+ * parser; reaching one here means the caller ignored them.
+ * @return always nullptr
+ */
+Value *CodeGenerator::visitErrorExpr(const ErrorExpr &) {
+  return logError("Cannot generate code for an unparsed expression");
+}
+
 /**
  * Generates IR for a struct field write (e.g. point.x = 5).
  * Resolves the struct pointer, finds the field index, then stores the value.
@@ -2684,23 +3001,7 @@ Value *CodeGenerator::visitFieldAssign(const FieldAssignExpr &e) {
     }
 
     llvm::StructType *strTy = TypeResolver::getStringType(context);
-    Value *oldDataGep =
-        builder.CreateStructGEP(strTy, gep, 0, e.field + ".old.data");
-    Value *oldData = builder.CreateLoad(llvm::PointerType::get(context, 0),
-                                        oldDataGep, e.field + ".old.ptr");
-    llvm::BasicBlock *curBB = builder.GetInsertBlock();
-    llvm::Function *fn = curBB->getParent();
-    auto *freeBB = llvm::BasicBlock::Create(context, "", fn);
-    auto *skipBB = llvm::BasicBlock::Create(context, "", fn);
-    Value *isNull = builder.CreateICmpEQ(
-        oldData,
-        llvm::ConstantPointerNull::get(llvm::PointerType::get(context, 0)),
-        e.field + ".old.null");
-    builder.CreateCondBr(isNull, skipBB, freeBB);
-    builder.SetInsertPoint(freeBB);
-    builder.CreateCall(getFree(), {oldData});
-    builder.CreateBr(skipBB);
-    builder.SetInsertPoint(skipBB);
+    StringOps::release(builder, context, module.get(), gep);
 
     Value *cloned = StringOps::clone(builder, context, module.get(), srcPtr);
     Value *freshVal = builder.CreateLoad(fieldTy, cloned, e.field + ".fresh");
@@ -2769,8 +3070,8 @@ Value *CodeGenerator::visitExprStmt(const ExprStmt &s) {
  * @return the AllocaInst* for the declared variable, or nullptr on error
  */
 Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
-  const std::string name = d.name.token.getWord();
-  const std::string typeName = d.type.base.token.getWord();
+  const std::string name(d.name.token.getWord());
+  const std::string typeName(d.type.base.token.getWord());
 
   bool inferred = (typeName == "let" || typeName.empty());
 
@@ -2805,8 +3106,7 @@ Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
       builder.CreateStore(TypeResolver::coerce(builder, init, ty), alloca);
     }
 
-    namedValues[name] = vi;
-    scopeMgr.declare(name);
+    scopeMgr.declare(d.name.symbol(), vi);
     return alloca;
   }
 
@@ -2824,7 +3124,7 @@ Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
                                               arg.base.token.getWord());
         if (t) {
           concreteArgs.push_back(t);
-          argNames.push_back(arg.base.token.getWord());
+          argNames.emplace_back(arg.base.token.getWord());
         }
       }
       if (!concreteArgs.empty())
@@ -2840,26 +3140,50 @@ Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
     }
   } else {
     ty = TypeResolver::fromTypeDesc(context, d.type);
+    if (!ty && typeSubst) {
+      auto it = typeSubst->find(typeName);
+      if (it != typeSubst->end()) {
+        ty = it->second;
+        for (int dim = 0; dim < d.type.dimensions; ++dim)
+          ty = TypeResolver::getOrCreateArrayStruct(context, ty);
+      }
+    }
     if (!ty)
       ty = llvm::StructType::getTypeByName(context, typeName);
   }
   if (!ty)
     return logError(("Unknown type: " + typeName).c_str());
 
+  // T[][] m = new T[][n] opts into a jagged array: the declared type gives
+  // the rank, the allocation picks the layout.
+  if (auto *na = dyn_cast_or_null<NewArrayExpr>(d.initializer.get());
+      na && na->arrayType.dimensions > 0 && TypeResolver::isArray(ty)) {
+    if (na->arrayType.dimensions + 1 != d.type.dimensions)
+      return logError(("Jagged array '" + name + "' is declared with " +
+                       std::to_string(d.type.dimensions) +
+                       " dimensions but allocated with " +
+                       std::to_string(na->arrayType.dimensions + 1))
+                          .c_str());
+    ty = TypeResolver::getOrCreateJaggedStruct(
+        context, resolveElemType(context, cast<StructType>(ty)));
+  }
+
   AllocaInst *alloca = createEntryAlloca(ty, name);
   VarInfo vi(alloca, ty, false, false, false, d.isConst);
 
   if (!d.initializer) {
-    namedValues[name] = vi;
-    scopeMgr.declare(name);
+    scopeMgr.declare(d.name.symbol(), vi);
     return alloca;
   }
 
   std::string srcName;
-  if (auto *id = dynamic_cast<IdentExpr *>(d.initializer.get()))
+  Symbol srcSym;
+  if (auto *id = dyn_cast<IdentExpr>(d.initializer.get())) {
     srcName = id->name.token.getWord();
+    srcSym = id->name.symbol();
+  }
 
-  if (auto *slit = dynamic_cast<StructLitExpr *>(d.initializer.get())) {
+  if (auto *slit = dyn_cast<StructLitExpr>(d.initializer.get())) {
     if (!d.type.typeArgs.empty()) {
       auto *concreteSt = llvm::dyn_cast<llvm::StructType>(ty);
       if (concreteSt)
@@ -2882,12 +3206,9 @@ Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
       }
 
       auto *srcAI = dyn_cast<AllocaInst>(src);
-      bool isTmp = srcAI && [&]() {
-        for (auto &kv : namedValues)
-          if (kv.second.allocaInst == srcAI)
-            return false;
-        return true;
-      }();
+      bool isTmp = srcAI && !namedValues.anyOf([&](const VarInfo &other) {
+        return other.allocaInst == srcAI;
+      });
 
       if (isTmp) {
         Value *freshVal = builder.CreateLoad(ty, src, name + ".fresh");
@@ -2910,9 +3231,8 @@ Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
       vi.ownsHeap = true;
 
     } else if (TypeResolver::isArray(ty) ||
-               dynamic_cast<const NewArrayExpr *>(d.initializer.get())) {
-      bool isNew =
-          dynamic_cast<const NewArrayExpr *>(d.initializer.get()) != nullptr;
+               isa<NewArrayExpr>(d.initializer.get())) {
+      bool isNew = isa<NewArrayExpr>(d.initializer.get());
       if (isNew) {
         if (auto *srcAI = llvm::dyn_cast<llvm::AllocaInst>(init)) {
           Type *realTy = srcAI->getAllocatedType();
@@ -2929,7 +3249,8 @@ Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
       builder.CreateStore(arrVal, alloca);
       if (isNew && init->getType()->isPointerTy())
         builder.CreateCall(getFree(), {init});
-      vi.ownsHeap = true;
+      // A row of an N-D array shares that array's buffer.
+      vi.ownsHeap = !arrayViews.count(init);
 
     } else if (ty->isStructTy()) {
       Value *structVal = init->getType()->isPointerTy()
@@ -2946,11 +3267,9 @@ Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
       // are not GEPs, so they transfer ownership as-is with no clone needed.
       bool sourceNeedsClone = false;
       if (auto *srcAI = llvm::dyn_cast<llvm::AllocaInst>(init)) {
-        for (auto &kv : namedValues)
-          if (kv.second.allocaInst == srcAI && kv.second.ownsHeap) {
-            sourceNeedsClone = true;
-            break;
-          }
+        sourceNeedsClone = namedValues.anyOf([&](const VarInfo &other) {
+          return other.allocaInst == srcAI && other.ownsHeap;
+        });
       } else if (llvm::isa<llvm::GetElementPtrInst>(init)) {
         // Field access or array element pointer — source is a GEP into live
         // memory that we do not own, so we must clone to get our own buffer.
@@ -3056,7 +3375,14 @@ Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
               coerced = TypeResolver::coerce(builder, tag, ty);
             }
           }
+        } else if (init->getType()->isIntegerTy()) {
+          // e.g. i32 n = a.length;  a length is i64 and must not overrun n.
+          coerced = TypeResolver::coerce(builder, init, ty);
         }
+      } else if (ty->isFloatingPointTy() &&
+                 init->getType()->isFloatingPointTy()) {
+        // e.g. f32 s = x + x;  f32 arithmetic is carried out in f64.
+        coerced = TypeResolver::coerce(builder, init, ty);
       }
       builder.CreateStore(coerced, alloca);
     }
@@ -3066,17 +3392,19 @@ Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
   case AssignKind::Move: {
     if (srcName.empty())
       return logError("Move requires identifier");
-    auto &srcInfo = namedValues[srcName];
+    VarInfo *srcInfo = namedValues.lookup(srcSym);
+    if (!srcInfo)
+      return logError(("Unknown variable: " + srcName).c_str());
     if (TypeResolver::isString(ty) || TypeResolver::isArray(ty)) {
       Value *val =
-          builder.CreateLoad(ty, srcInfo.allocaInst, srcName + ".move");
+          builder.CreateLoad(ty, srcInfo->allocaInst, srcName + ".move");
       builder.CreateStore(val, alloca);
     } else {
       builder.CreateStore(init, alloca);
     }
-    srcInfo.isMoved = true;
-    vi.ownsHeap = srcInfo.ownsHeap;
-    srcInfo.ownsHeap = false;
+    srcInfo->isMoved = true;
+    vi.ownsHeap = srcInfo->ownsHeap;
+    srcInfo->ownsHeap = false;
     break;
   }
 
@@ -3087,24 +3415,27 @@ Value *CodeGenerator::visitVarDecl(const VarDecl &d) {
     if (dyn_cast<AllocaInst>(src) || src->getType()->isPointerTy()) {
       srcAlloca = src;
     } else if (!srcName.empty()) {
-      auto it = namedValues.find(srcName);
-      if (it != namedValues.end()) {
-        srcAlloca = it->second.allocaInst;
-        srcTy = it->second.type;
+      VarInfo *it = namedValues.lookup(srcSym);
+      if (it) {
+        srcAlloca = it->allocaInst;
+        srcTy = it->type;
       }
     }
     if (!srcAlloca)
       return logError("Borrow requires an addressable expression");
+    // The declared T[][] names the dense layout; keep a jagged source's.
+    if (VarInfo *srcInfo = namedValues.lookup(srcSym);
+        srcInfo && TypeResolver::isJagged(srcInfo->type))
+      srcTy = srcInfo->type;
     vi = {srcAlloca, srcTy, true, false};
     vi.ownsHeap = false;
-    if (!srcName.empty() && namedValues.count(srcName))
-      namedValues[srcName].isBorrowed = true;
+    if (VarInfo *srcInfo = namedValues.lookup(srcSym))
+      srcInfo->isBorrowed = true;
     break;
   }
   }
 
-  namedValues[name] = vi;
-  scopeMgr.declare(name);
+  scopeMgr.declare(d.name.symbol(), vi);
   return alloca;
 }
 
@@ -3123,6 +3454,8 @@ Value *CodeGenerator::visitBlock(const Block &b) {
   scopeMgr.pushScope();
   Value *last = nullptr;
   for (const auto &stmt : b.statements) {
+    if (isa<ErrorStmt>(*stmt))
+      continue;
     last = codegen(*stmt);
     if (blockHasTerminator(builder))
       break;
@@ -3239,10 +3572,10 @@ Value *CodeGenerator::visitMatchStmt(const MatchStmt &s) {
   // see Bug 10 in visitForEach). Bindings extracted from such a subject must
   // stay non-owning too, or they'll free memory the real owner also frees.
   bool subjectOwnsHeap = true;
-  if (auto *idExpr = dynamic_cast<const IdentExpr *>(s.subject.get())) {
-    auto subjIt = namedValues.find(idExpr->name.token.getWord());
-    if (subjIt != namedValues.end())
-      subjectOwnsHeap = subjIt->second.ownsHeap;
+  if (auto *idExpr = dyn_cast<IdentExpr>(s.subject.get())) {
+    VarInfo *subjIt = namedValues.lookup(idExpr->name.symbol());
+    if (subjIt)
+      subjectOwnsHeap = subjIt->ownsHeap;
   }
 
   llvm::Type *i32 = Type::getInt32Ty(context);
@@ -3339,6 +3672,8 @@ Value *CodeGenerator::visitMatchStmt(const MatchStmt &s) {
 
       for (size_t fi = 0; fi < arm->bindings.size(); ++fi) {
         unsigned fieldIdx = static_cast<unsigned>(fi) + 1;
+        const Identifier &binding = arm->bindings[fi];
+        const std::string bname(binding.token.getWord());
 
         llvm::Type *fieldTy = nullptr;
         Value *fieldPtr = nullptr;
@@ -3346,23 +3681,23 @@ Value *CodeGenerator::visitMatchStmt(const MatchStmt &s) {
         if (subjectSt && fieldIdx < subjectSt->getNumElements()) {
           fieldTy = subjectSt->getElementType(fieldIdx);
           fieldPtr = builder.CreateStructGEP(subjectSt, subjectPtr, fieldIdx,
-                                             arm->bindings[fi] + ".src");
+                                             bname + ".src");
         }
 
         if (!fieldTy || !fieldPtr) {
-          logError(("match: cannot extract binding '" + arm->bindings[fi] +
+          logError(("match: cannot extract binding '" + bname +
                     "' from variant '" + arm->variantName + "'")
                        .c_str());
           continue;
         }
 
-        AllocaInst *alloca = createEntryAlloca(fieldTy, arm->bindings[fi]);
+        AllocaInst *alloca = createEntryAlloca(fieldTy, bname);
 
         // For string fields: MOVE ownership from source to binding
         if (TypeResolver::isString(fieldTy)) {
           // Load the string from the source
           Value *srcStr =
-              builder.CreateLoad(fieldTy, fieldPtr, arm->bindings[fi] + ".src");
+              builder.CreateLoad(fieldTy, fieldPtr, bname + ".src");
 
           // Store it in the destination alloca
           builder.CreateStore(srcStr, alloca);
@@ -3370,28 +3705,31 @@ Value *CodeGenerator::visitMatchStmt(const MatchStmt &s) {
           // NULL out the source pointer to prevent double-free
           llvm::StructType *strTy = TypeResolver::getStringType(context);
           Value *srcDataGep = builder.CreateStructGEP(
-              strTy, fieldPtr, 0, arm->bindings[fi] + ".src.null");
+              strTy, fieldPtr, 0, bname + ".src.null");
           builder.CreateStore(llvm::ConstantPointerNull::get(
                                   llvm::PointerType::get(context, 0)),
                               srcDataGep);
 
           // The binding only owns the string if the subject did too —
-          // otherwise the real owner (e.g. the source array) will free it.
+          // otherwise the real owner (e.g. the source array) will free it,
+          // and the binding is a view that appending gives its own buffer.
+          if (!subjectOwnsHeap)
+            StringOps::makeView(builder, context, alloca);
           VarInfo vi(alloca, fieldTy, false, false, false, false);
-          vi.ownsHeap = subjectOwnsHeap;
+          vi.ownsHeap = true;
           vi.pointeeType = fieldTy;
-          namedValues[arm->bindings[fi]] = vi;
+          scopeMgr.declare(binding.symbol(), vi);
 
         } else if (TypeResolver::isArray(fieldTy)) {
           // For array fields: MOVE ownership
           Value *srcArr =
-              builder.CreateLoad(fieldTy, fieldPtr, arm->bindings[fi] + ".src");
+              builder.CreateLoad(fieldTy, fieldPtr, bname + ".src");
           builder.CreateStore(srcArr, alloca);
 
           auto *arrSt = llvm::dyn_cast<llvm::StructType>(fieldTy);
           if (arrSt) {
             Value *srcDataGep = builder.CreateStructGEP(
-                arrSt, fieldPtr, 1, arm->bindings[fi] + ".src.null");
+                arrSt, fieldPtr, 1, bname + ".src.null");
             builder.CreateStore(llvm::ConstantPointerNull::get(
                                     llvm::PointerType::get(context, 0)),
                                 srcDataGep);
@@ -3400,7 +3738,7 @@ Value *CodeGenerator::visitMatchStmt(const MatchStmt &s) {
           VarInfo vi(alloca, fieldTy, false, false, false, false);
           vi.ownsHeap = subjectOwnsHeap;
           vi.pointeeType = fieldTy;
-          namedValues[arm->bindings[fi]] = vi;
+          scopeMgr.declare(binding.symbol(), vi);
 
         } else if (auto *payloadSt =
                        llvm::dyn_cast<llvm::StructType>(fieldTy)) {
@@ -3467,30 +3805,27 @@ Value *CodeGenerator::visitMatchStmt(const MatchStmt &s) {
           VarInfo vi(alloca, payloadSt, false, false, false, false);
           vi.ownsHeap = subjectOwnsHeap;
           vi.pointeeType = payloadSt;
-          namedValues[arm->bindings[fi]] = vi;
+          scopeMgr.declare(binding.symbol(), vi);
 
         } else {
           // Scalar values: just copy
           Value *loaded =
-              builder.CreateLoad(fieldTy, fieldPtr, arm->bindings[fi]);
+              builder.CreateLoad(fieldTy, fieldPtr, bname);
           builder.CreateStore(loaded, alloca);
 
           VarInfo vi(alloca, fieldTy, false, false, false, false);
           vi.pointeeType = fieldTy;
           vi.ownsHeap = false;
-          namedValues[arm->bindings[fi]] = vi;
+          scopeMgr.declare(binding.symbol(), vi);
         }
-
-        scopeMgr.declare(arm->bindings[fi]);
       }
     }
 
     codegen(*arm->body);
 
-    // Pop scope first - this emits destructors for all bindings while their
-    // VarInfo entries are still present in namedValues. (Erasing the entries
-    // before this point would leave the scope manager with nothing to look
-    // up, silently skipping the destructors and leaking the memory.)
+    // Popping the arm's scope emits destructors for its bindings and then
+    // unbinds them, so they don't leak into sibling arms or code after the
+    // match statement.
     if (!blockHasTerminator(builder)) {
       scopeMgr.popScope();
       builder.CreateBr(exitBB);
@@ -3501,14 +3836,6 @@ Value *CodeGenerator::visitMatchStmt(const MatchStmt &s) {
       // function returns.
       scopeMgr.popScope();
     }
-
-    // Now it's safe to remove the bindings from namedValues so they don't
-    // leak into sibling arms or code after the match statement.
-    if (!arm->isWildcard) {
-      for (const auto &binding : arm->bindings) {
-        namedValues.erase(binding);
-      }
-    }
   }
 
   fn->insert(fn->end(), exitBB);
@@ -3528,7 +3855,7 @@ Value *CodeGenerator::visitMatchStmt(const MatchStmt &s) {
  * @return always nullptr
  */
 Value *CodeGenerator::visitForRange(const ForRangeStmt &s) {
-  const std::string &vname = s.varName.token.getWord();
+  const std::string vname(s.varName.token.getWord());
 
   Type *varTy = TypeResolver::fromTypeDesc(context, s.varType);
   if (!varTy)
@@ -3548,7 +3875,19 @@ Value *CodeGenerator::visitForRange(const ForRangeStmt &s) {
   builder.CreateStore(startVal, varAlloca);
 
   VarInfo vi(varAlloca, varTy, false, false, false, s.varType.isConst);
-  namedValues[vname] = vi;
+  namedValues.declare(s.varName.symbol(), vi);
+
+  // range(arr.length) over a local array can make the body's arr[i] checks
+  // redundant; globals and references may change behind the loop's back.
+  bool provenInRange = false;
+  if (const Identifier *arr = BoundsManager::loopArray(s)) {
+    VarInfo *arrInfo = namedValues.lookup(arr->symbol());
+    if (arrInfo && isa<AllocaInst>(arrInfo->allocaInst) &&
+        !arrInfo->isReference && varTy->isIntegerTy() &&
+        (TypeResolver::isArray(arrInfo->type) ||
+         TypeResolver::isString(arrInfo->type)))
+      provenInRange = boundsMgr.enterLoop(s);
+  }
 
   llvm::Function *fn = builder.GetInsertBlock()->getParent();
   BasicBlock *condBB = BasicBlock::Create(context, "", fn);
@@ -3588,6 +3927,8 @@ Value *CodeGenerator::visitForRange(const ForRangeStmt &s) {
   loopStack.push_back({stepBB, exitBB});
   codegen(*s.body);
   loopStack.pop_back();
+  if (provenInRange)
+    boundsMgr.exitLoop();
   bool needsBr = !blockHasTerminator(builder);
   if (needsBr)
     builder.CreateBr(stepBB);
@@ -3604,7 +3945,7 @@ Value *CodeGenerator::visitForRange(const ForRangeStmt &s) {
   fn->insert(fn->end(), exitBB);
   builder.SetInsertPoint(exitBB);
 
-  namedValues.erase(vname);
+  namedValues.erase(s.varName.symbol());
   return nullptr;
 }
 
@@ -3614,12 +3955,13 @@ Value *CodeGenerator::visitForRange(const ForRangeStmt &s) {
  * Array struct layout (from TypeResolver::getOrCreateArrayStruct):
  *   field 0 — i64  length
  *   field 1 — ptr  data pointer (opaque, points to elements)
+ *   fields 2.. — i64 inner extents, for arrays of rank 2 and up
  *
  * A counter i (i64) drives the loop: 0 <= i < length.
  * Each iteration loads iterable[i] into the loop variable alloca.
  */
 Value *CodeGenerator::visitForEach(const ForEachStmt &s) {
-  const std::string &vname = s.varName.token.getWord();
+  const std::string vname(s.varName.token.getWord());
 
   // ── evaluate iterable once ───────────────────────────────────────────────
   Value *arrVal = codegen(*s.iterable);
@@ -3655,7 +3997,7 @@ Value *CodeGenerator::visitForEach(const ForEachStmt &s) {
       }
       if (t) {
         concreteArgs.push_back(t);
-        argNames.push_back(arg.base.token.getWord());
+        argNames.emplace_back(arg.base.token.getWord());
       } else {
         allResolved = false;
         break;
@@ -3663,15 +4005,15 @@ Value *CodeGenerator::visitForEach(const ForEachStmt &s) {
     }
 
     if (allResolved && !concreteArgs.empty()) {
-      elemTy = instantiateGenericEnum(s.varType.base.token.getWord(),
-                                      concreteArgs, argNames);
+      elemTy = instantiateGenericEnum(
+          std::string(s.varType.base.token.getWord()), concreteArgs, argNames);
       if (!elemTy)
         elemTy = instantiateGenericStruct(s.varType);
     }
   }
   if (!elemTy)
     return logError(("foreach: unknown element type '" +
-                     s.varType.base.token.getWord() + "'")
+                     std::string(s.varType.base.token.getWord()) + "'")
                         .c_str());
 
   // If it's a pointer, get the pointee array-wrapper struct type.
@@ -3682,6 +4024,11 @@ Value *CodeGenerator::visitForEach(const ForEachStmt &s) {
   bool isPtr = arrValTy->isPointerTy();
   if (isPtr) {
     arrStructTy = TypeResolver::getOrCreateArrayStruct(context, elemTy);
+    // A jagged array's rows are descriptors, so iterate it as rank 1.
+    if (auto *id = dyn_cast<IdentExpr>(s.iterable.get()))
+      if (VarInfo *vi = namedValues.lookup(id->name.symbol());
+          vi && TypeResolver::isJagged(vi->type))
+        arrStructTy = cast<StructType>(vi->type);
   } else if (auto *st = llvm::dyn_cast<llvm::StructType>(arrValTy)) {
     arrStructTy = st;
   }
@@ -3705,6 +4052,27 @@ Value *CodeGenerator::visitForEach(const ForEachStmt &s) {
     dataPtr = builder.CreateExtractValue(arrVal, {1}, "arr.data");
   }
 
+  // ── rows of an N-D array ──────────────────────────────────────────────────
+  // A dense array has no row objects to load. Each row is a view: a template
+  // built once here, whose data pointer is rebased every iteration.
+  Value *rowView = nullptr;
+  Value *rowStride = nullptr;
+  llvm::Type *leafTy = nullptr;
+  unsigned rank = TypeResolver::arrayRank(arrStructTy);
+  if (rank >= 2) {
+    if (elemTy != resolveElemType(context, arrStructTy))
+      return logError("foreach: loop variable must have the row type");
+    leafTy = elemTy;
+    for (unsigned d = 1; d < rank; ++d)
+      leafTy = resolveElemType(context, cast<StructType>(leafTy));
+    Value *arrAgg = isPtr ? builder.CreateLoad(arrStructTy, arrVal, "arr.load")
+                          : arrVal;
+    rowView = ArrayEmitter::emitView(builder, arrAgg, rank,
+                                     cast<StructType>(elemTy), leafTy,
+                                     {llvm::ConstantInt::get(i64, 0)});
+    rowStride = ArrayEmitter::emitElementCount(builder, rowView, rank - 1);
+  }
+
   // ── allocas: loop counter and loop variable ───────────────────────────────
   AllocaInst *idxAlloca = createEntryAlloca(i64, "__foreach_idx");
   builder.CreateStore(llvm::ConstantInt::get(i64, 0), idxAlloca);
@@ -3718,6 +4086,7 @@ Value *CodeGenerator::visitForEach(const ForEachStmt &s) {
   builder.CreateStore(lenVal, lenAlloca);
 
   AllocaInst *varAlloca = createEntryAlloca(elemTy, vname);
+  const bool isStringElem = TypeResolver::isString(elemTy);
   {
     // FIX (Bug 10): Mark the loop variable as non-owning (ownsHeap = false).
     //
@@ -3735,7 +4104,14 @@ Value *CodeGenerator::visitForEach(const ForEachStmt &s) {
     // false prevents the scope manager from emitting destructors for it.
     VarInfo vi(varAlloca, elemTy, false, false, false, s.varType.isConst);
     vi.ownsHeap = false;
-    namedValues[vname] = vi;
+    if (isStringElem) {
+      // A string variable is a view instead (capacity -1), so appending to it
+      // builds a buffer of its own. That buffer is freed at the end of each
+      // iteration and, after a break or return, by its scope.
+      builder.CreateStore(llvm::Constant::getNullValue(elemTy), varAlloca);
+      vi.ownsHeap = true;
+    }
+    namedValues.declare(s.varName.symbol(), vi);
   }
 
   // Store a separate alloca for dataPtr so it can be reloaded inside bodyBB.
@@ -3779,9 +4155,19 @@ Value *CodeGenerator::visitForEach(const ForEachStmt &s) {
   Value *bodyDataPtr = builder.CreateLoad(ptrTy, dataPtrAlloca, "data.reload");
 
   // GEP using the opaque data pointer; no bitcast needed with opaque pointers.
-  Value *elemPtr = builder.CreateGEP(elemTy, bodyDataPtr, curIdx, "elem.ptr");
-  Value *elemVal = builder.CreateLoad(elemTy, elemPtr, vname + ".val");
+  Value *elemVal = nullptr;
+  if (rowView) {
+    Value *rowData =
+        builder.CreateGEP(leafTy, bodyDataPtr,
+                          builder.CreateMul(curIdx, rowStride), "row.data");
+    elemVal = builder.CreateInsertValue(rowView, rowData, {1}, vname + ".val");
+  } else {
+    Value *elemPtr = builder.CreateGEP(elemTy, bodyDataPtr, curIdx, "elem.ptr");
+    elemVal = builder.CreateLoad(elemTy, elemPtr, vname + ".val");
+  }
   builder.CreateStore(elemVal, varAlloca);
+  if (isStringElem)
+    StringOps::makeView(builder, context, varAlloca);
 
   loopStack.push_back({stepBB, exitBB});
   codegen(*s.body);
@@ -3793,6 +4179,10 @@ Value *CodeGenerator::visitForEach(const ForEachStmt &s) {
   // ── step: ++i ─────────────────────────────────────────────────────────────
   fn->insert(fn->end(), stepBB);
   builder.SetInsertPoint(stepBB);
+  if (isStringElem) {
+    StringOps::release(builder, context, module.get(), varAlloca);
+    StringOps::makeView(builder, context, varAlloca);
+  }
   // Must reload from idxAlloca — curIdx is an SSA value from condBB and
   // reusing it would always add 1 to the *original* index, freezing the
   // counter and looping forever.
@@ -3805,8 +4195,10 @@ Value *CodeGenerator::visitForEach(const ForEachStmt &s) {
   // ── exit ──────────────────────────────────────────────────────────────────
   fn->insert(fn->end(), exitBB);
   builder.SetInsertPoint(exitBB);
+  if (isStringElem)
+    StringOps::release(builder, context, module.get(), varAlloca);
 
-  namedValues.erase(vname);
+  namedValues.erase(s.varName.symbol());
   return nullptr;
 }
 
@@ -3832,6 +4224,12 @@ Value *CodeGenerator::visitContinue(const Continue &) {
   return nullptr;
 }
 
+/**
+ * A statement dropped by parser error recovery; it generates nothing.
+ * @return always nullptr
+ */
+Value *CodeGenerator::visitErrorStmt(const ErrorStmt &) { return nullptr; }
+
 /**
  * Generates IR for a return statement.
  * Before returning, the scope manager emits destructors for all live strings
@@ -3848,7 +4246,24 @@ Value *CodeGenerator::visitReturn(const Return &s) {
   if (auto *ai = llvm::dyn_cast_or_null<llvm::AllocaInst>(retVal)) {
     llvm::Type *allocTy = ai->getAllocatedType();
 
-    if (TypeResolver::isArray(allocTy)) {
+    if (TypeResolver::isString(allocTy)) {
+      // String return: as for arrays below, the caller takes the buffer, so
+      // null the local's data pointer before the destructors run. A view
+      // (e.g. a parameter) is copied first; its buffer is not ours to give.
+      StringOps::detach(builder, context, module.get(), ai);
+      llvm::Function *fn = builder.GetInsertBlock()->getParent();
+      retVal = builder.CreateLoad(fn->getReturnType(), ai, "ret.load");
+      Value *dataGep = builder.CreateStructGEP(
+          TypeResolver::getStringType(context), ai, 0, "ret.str.null");
+      builder.CreateStore(
+          llvm::ConstantPointerNull::get(llvm::PointerType::get(context, 0)),
+          dataGep);
+
+    } else if (TypeResolver::isJagged(allocTy)) {
+      return logError("A jagged array cannot be returned: return types are "
+                      "dense arrays");
+
+    } else if (TypeResolver::isArray(allocTy)) {
       // Array return: load the value first, then null the alloca's data pointer
       // so the scope manager's emitArrayFree sees null and skips freeing it.
       // This transfers ownership of the heap buffer to the caller.
@@ -3862,13 +4277,12 @@ Value *CodeGenerator::visitReturn(const Return &s) {
           llvm::ConstantPointerNull::get(llvm::PointerType::get(context, 0)),
           dataGep);
 
-      for (auto &kv : namedValues) {
-        if (kv.second.allocaInst == ai) {
-          kv.second.isMoved = true;
-          kv.second.ownsHeap = false;
-          break;
+      namedValues.forEach([&](VarInfo &vi) {
+        if (vi.allocaInst == ai) {
+          vi.isMoved = true;
+          vi.ownsHeap = false;
         }
-      }
+      });
 
     } else if (auto *st = llvm::dyn_cast<llvm::StructType>(allocTy)) {
       llvm::Function *fn = builder.GetInsertBlock()->getParent();
@@ -3916,12 +4330,10 @@ Value *CodeGenerator::visitReturn(const Return &s) {
       nullStringFields(st, ai);
 
     } else {
-      for (auto &kv : namedValues) {
-        if (kv.second.allocaInst == ai) {
-          kv.second.isMoved = true;
-          break;
-        }
-      }
+      namedValues.forEach([&](VarInfo &vi) {
+        if (vi.allocaInst == ai)
+          vi.isMoved = true;
+      });
     }
   }
 
@@ -3973,7 +4385,8 @@ Value *CodeGenerator::visitReturn(const Return &s) {
  * @return the populated llvm::Function*, or nullptr on error
  */
 llvm::Function *CodeGenerator::codegen(const AST_H::Function &func) {
-  const std::string fname = mangleName(func.name.token.getWord(), func.params);
+  const StringRef fname =
+      mangleName(func.name.symbol(), func.params.size()).str();
 
   Type *retTy = TypeResolver::fromTypeDesc(context, func.returnType);
   if (!retTy)
@@ -3984,7 +4397,7 @@ llvm::Function *CodeGenerator::codegen(const AST_H::Function &func) {
   // already present. The forward-declaration pass runs first so the mangled
   // struct should already exist; this is a safety fallback for both passes.
   if (!retTy && !func.returnType.typeArgs.empty()) {
-    const std::string &retBase = func.returnType.base.token.getWord();
+    const std::string retBase(func.returnType.base.token.getWord());
     std::vector<llvm::Type *> concreteArgs;
     std::vector<std::string> argNames;
     for (const auto &arg : func.returnType.typeArgs) {
@@ -3993,7 +4406,7 @@ llvm::Function *CodeGenerator::codegen(const AST_H::Function &func) {
         t = llvm::StructType::getTypeByName(context, arg.base.token.getWord());
       if (t) {
         concreteArgs.push_back(t);
-        argNames.push_back(arg.base.token.getWord());
+        argNames.emplace_back(arg.base.token.getWord());
       }
     }
     if (!concreteArgs.empty()) {
@@ -4025,9 +4438,6 @@ llvm::Function *CodeGenerator::codegen(const AST_H::Function &func) {
     paramIsRef.push_back(p.isBorrowRef);
     paramIsMut.push_back(p.isBorrowRef && p.isMut);
   }
-  borrowRefParams[fname] = paramIsRef;
-  borrowMutParams[fname] = paramIsMut;
-
   llvm::Function *f = module->getFunction(fname);
   if (!f) {
     auto *ft = FunctionType::get(retTy, paramTypes, false);
@@ -4035,20 +4445,27 @@ llvm::Function *CodeGenerator::codegen(const AST_H::Function &func) {
                                *module);
   }
   if (!f->empty()) {
-    logError(("Function already defined: " + fname).c_str());
+    logError(("Function already defined: " + fname).str().c_str());
     return nullptr;
   }
+  borrowRefParams[f] = paramIsRef;
+  borrowMutParams[f] = paramIsMut;
 
   f->addFnAttr("stackrealignment");
+  std::optional<DebugInfoManager::Saved> savedDebug;
+  if (debugInfo)
+    savedDebug = debugInfo->enterFunction(f, func.name.token.getWord(),
+                                          func.name.token.getLine(),
+                                          func.sourcePath);
 
   BasicBlock *entry = BasicBlock::Create(context, "entry", f);
   builder.SetInsertPoint(entry);
 
   if (fname == "main")
-    BuiltinEmitter::emitRuntimeInit(builder, context, module.get());
+    BuiltinEmitter::emitRuntimeInit(builder, context, module.get(),
+                                    opts.outputBuffer);
 
   // Restore global scope and reset per-function tracking.
-  namedValues = globalValues;
   scopeMgr.reset();
   scopeMgr.pushScope();
 
@@ -4056,7 +4473,7 @@ llvm::Function *CodeGenerator::codegen(const AST_H::Function &func) {
   size_t idx = 0;
   for (auto &arg : f->args()) {
     const auto &param = func.params[idx++];
-    const std::string pname = param.name.token.getWord();
+    const std::string pname(param.name.token.getWord());
 
     if (param.isBorrowRef) {
       // Reference parameter: store the incoming pointer into a pointer alloca.
@@ -4072,8 +4489,7 @@ llvm::Function *CodeGenerator::codegen(const AST_H::Function &func) {
       VarInfo vi(ptrAlloca, PointerType::get(context, 0), false, false, true,
                  !param.isMut);
       vi.pointeeType = pointee;
-      namedValues[pname] = vi;
-      scopeMgr.declare(pname);
+      scopeMgr.declare(param.name.symbol(), vi);
     } else {
       Type *declaredTy = TypeResolver::fromTypeDesc(context, param.type);
       if (!declaredTy)
@@ -4083,21 +4499,24 @@ llvm::Function *CodeGenerator::codegen(const AST_H::Function &func) {
         declaredTy = arg.getType();
 
       AllocaInst *a = createEntryAlloca(declaredTy, pname);
+      VarInfo vi(a, declaredTy, false, false, false, param.isConst);
 
       if (TypeResolver::isString(declaredTy) ||
           TypeResolver::isArray(declaredTy) || declaredTy->isStructTy()) {
         // Aggregate: load the entire value and store to the alloca.
         Value *val = builder.CreateLoad(declaredTy, &arg, pname + ".param");
         builder.CreateStore(val, a);
-        VarInfo vi(a, declaredTy, false, false, false, param.isConst);
         vi.ownsHeap = false;
-        namedValues[pname] = vi;
+        if (TypeResolver::isString(declaredTy)) {
+          // A view of the caller's buffer: appending gives it one of its
+          // own, which is then freed here (or handed back on return).
+          StringOps::makeView(builder, context, a);
+          vi.ownsHeap = true;
+        }
       } else {
         builder.CreateStore(&arg, a);
-        namedValues[pname] =
-            VarInfo(a, declaredTy, false, false, false, param.isConst);
       }
-      scopeMgr.declare(pname);
+      scopeMgr.declare(param.name.symbol(), vi);
     }
   }
 
@@ -4113,22 +4532,203 @@ llvm::Function *CodeGenerator::codegen(const AST_H::Function &func) {
     else
       builder.CreateRet(ConstantInt::get(retTy, 0));
   }
-
-  if (verifyFunction(*f, &errs())) {
-    errs() << "verifyFunction failed for: " << fname << "\n";
-    f->print(errs());
+  if (savedDebug)
+    debugInfo->leaveFunction(*savedDebug);
+
+  if (verifyFunction(*f, &diag())) {
+    diag() << "verifyFunction failed for: " << fname << "\n";
+    f->print(diag());
+    borrowRefParams.erase(f);
+    borrowMutParams.erase(f);
     f->eraseFromParent();
     return nullptr;
   }
   return f;
 }
 
+/*---------------------------------------*/
+/*         Optimisation pipeline         */
+/*---------------------------------------*/
+
+/**
+ * Creates the TargetMachine for the host triple and adopts its data layout
+ * so that struct sizes queried during lowering match the emitted object.
+ *
+ * Code is generated for the generic CPU of the host architecture and as
+ * position-independent code, which is what the system linker expects by
+ * default. On failure targetMachine stays null; IR and bitcode can still
+ * be emitted, native output cannot.
+ */
+void CodeGenerator::createTargetMachine() {
+  static std::once_flag initOnce;
+  std::call_once(initOnce, [] {
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+  });
+
+  const Triple triple(LLVM_HOST_TRIPLE);
+  std::string err;
+  const Target *target = TargetRegistry::lookupTarget(triple, err);
+  if (!target) {
+    diag() << "CodeGen warning: no target for '" << triple.str()
+           << "': " << err << "\n";
+    return;
+  }
+
+  CodeGenOptLevel cgLevel = CodeGenOptLevel::Default;
+  switch (opts.optLevel) {
+  case OptLevel::O0:
+    cgLevel = CodeGenOptLevel::None;
+    break;
+  case OptLevel::O1:
+    cgLevel = CodeGenOptLevel::Less;
+    break;
+  case OptLevel::O2:
+  case OptLevel::Os:
+    cgLevel = CodeGenOptLevel::Default;
+    break;
+  case OptLevel::O3:
+    cgLevel = CodeGenOptLevel::Aggressive;
+    break;
+  }
+
+  TargetOptions targetOpts;
+  targetMachine.reset(target->createTargetMachine(
+      triple, "generic", "", targetOpts, Reloc::PIC_, std::nullopt, cgLevel));
+  module->setDataLayout(targetMachine->createDataLayout());
+}
+
+/**
+ * Runs LLVM's standard new-pass-manager pipeline over the module at the
+ * level selected in the code generator options.
+ *
+ * -O0 still goes through buildO0DefaultPipeline so always-inline and the
+ * other mandatory passes behave the same as with clang. Every other level
+ * uses the per-module default pipeline (mem2reg/SROA, inlining, loop and
+ * vectorisation passes, ...), which is what turns our entry-block allocas
+ * into SSA registers. AddressSanitizer is appended when the sanitize
+ * profile is active.
+ */
+void CodeGenerator::runOptimizationPipeline() {
+  OptimizationLevel level = OptimizationLevel::O0;
+  switch (opts.optLevel) {
+  case OptLevel::O0:
+    level = OptimizationLevel::O0;
+    break;
+  case OptLevel::O1:
+    level = OptimizationLevel::O1;
+    break;
+  case OptLevel::O2:
+    level = OptimizationLevel::O2;
+    break;
+  case OptLevel::O3:
+    level = OptimizationLevel::O3;
+    break;
+  case OptLevel::Os:
+    level = OptimizationLevel::Os;
+    break;
+  }
+
+  LoopAnalysisManager lam;
+  FunctionAnalysisManager fam;
+  CGSCCAnalysisManager cgam;
+  ModuleAnalysisManager mam;
+
+  // Under --time-report every pass the pipeline runs is timed. Analyses are
+  // charged to the pass that requested them.
+  PassInstrumentationCallbacks pic;
+  if (TimeReport *report = TimeReport::current()) {
+    pic.registerBeforeNonSkippedPassCallback(
+        [report](StringRef pass, Any) { report->beginPass(pass); });
+    pic.registerAfterPassCallback(
+        [report](StringRef, Any, const PreservedAnalyses &) {
+          report->endPass();
+        });
+    pic.registerAfterPassInvalidatedCallback(
+        [report](StringRef, const PreservedAnalyses &) {
+          report->endPass();
+        });
+  }
+
+  PassBuilder pb(targetMachine.get(), PipelineTuningOptions(), {}, &pic);
+  pb.registerModuleAnalyses(mam);
+  pb.registerCGSCCAnalyses(cgam);
+  pb.registerFunctionAnalyses(fam);
+  pb.registerLoopAnalyses(lam);
+  pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+  ModulePassManager mpm = level == OptimizationLevel::O0
+                              ? pb.buildO0DefaultPipeline(level)
+                              : pb.buildPerModuleDefaultPipeline(level);
+
+  // The sanitize profile instruments our own code, not just the link: mark
+  // every defined function and run ASan after the optimisation pipeline.
+  if (opts.sanitizeAddress) {
+    for (auto &fn : *module)
+      if (!fn.isDeclaration())
+        fn.addFnAttr(Attribute::SanitizeAddress);
+    mpm.addPass(AddressSanitizerPass(AddressSanitizerOptions()));
+  }
+
+  mpm.run(*module, mam);
+}
+
+/**
+ * Writes the module to disk in the format selected by opts.emit.
+ *
+ * IR and bitcode are serialised directly. Object files and assembly are
+ * lowered in-process through the TargetMachine's codegen pipeline, so no
+ * external compiler has to re-parse the module.
+ *
+ * @param path the full output path, including extension
+ * @return true on success, false if the file could not be written
+ */
+bool CodeGenerator::emitOutput(const std::string &path) {
+  TimeScope scope("emit", path);
+  std::error_code ec;
+  raw_fd_ostream out(path, ec, sys::fs::OF_None);
+  if (ec) {
+    diag() << "Cannot open output file: " << ec.message() << "\n";
+    return false;
+  }
+
+  switch (opts.emit) {
+  case EmitKind::LLVMIR:
+    module->print(out, nullptr);
+    return true;
+  case EmitKind::Bitcode:
+    WriteBitcodeToFile(*module, out);
+    return true;
+  case EmitKind::Object:
+  case EmitKind::Assembly:
+    break;
+  }
+
+  if (!targetMachine) {
+    diag() << "Cannot emit native code: no target machine for '"
+           << LLVM_HOST_TRIPLE << "'\n";
+    return false;
+  }
+
+  legacy::PassManager pm;
+  CodeGenFileType fileType = opts.emit == EmitKind::Assembly
+                                 ? CodeGenFileType::AssemblyFile
+                                 : CodeGenFileType::ObjectFile;
+  if (targetMachine->addPassesToEmitFile(pm, out, nullptr, fileType)) {
+    diag() << "Target machine cannot emit a file of this type\n";
+    return false;
+  }
+  pm.run(*module);
+  out.flush();
+  return true;
+}
+
 /*---------------------------------------*/
 /*          Top-level generate           */
 /*---------------------------------------*/
 
 /**
- * Lowers an entire parsed program to an LLVM IR file (.ll).
+ * Lowers an entire parsed program and writes the requested artifact.
  *
  * Steps performed in order:
  *  1. Declare C runtime functions (printf, strcmp, scanf).
@@ -4137,17 +4737,26 @@ llvm::Function *CodeGenerator::codegen(const AST_H::Function &func) {
  *  4. Register extern block declarations.
  *  5. Emit global variable definitions with constant initialisers.
  *  6. Forward-declare all user functions so calls can precede definitions.
- *  7. Emit function bodies.
- *  8. Run the optimisation pipeline (O2).
- *  9. Write the resulting IR to <outputFilename>.ll.
+ *  7. Emit function bodies, with line-table debug info when opts.debugInfo
+ *     is set.
+ *  8. Run the optimisation pipeline at the requested level.
+ *  9. Write the object file, assembly, IR or bitcode (per --emit) to
+ *     outputFilename.
  *
  * @param program the fully-parsed program AST
- * @param outputFilename the base path for the output file (without extension)
+ * @param outputFilename the path of the artifact to write
+ * @param sourcePath the file the program was parsed from, for debug info
  * @return true on success, false if any step failed
  */
 bool CodeGenerator::generate(const Program &program,
-                             const std::string &outputFilename) {
+                             const std::string &outputFilename,
+                             const std::string &sourcePath) {
+  std::optional<TimeScope> lowering(std::in_place, "lower to IR");
   currentProgram = &program;
+  if (opts.debugInfo)
+    debugInfo = std::make_unique<DebugInfoManager>(
+        builder, *module, sourcePath.empty() ? "<input>" : sourcePath,
+        opts.optLevel != OptLevel::O0);
   namedValues.clear();
   structDefs.clear();
   for (const auto &s : program.structs)
@@ -4193,7 +4802,7 @@ bool CodeGenerator::generate(const Program &program,
           ft = llvm::StructType::getTypeByName(context, f.typeName);
         }
         if (!ft) {
-          errs() << "CodeGen warning: cannot resolve type '" << f.typeName
+          diag() << "CodeGen warning: cannot resolve type '" << f.typeName
                  << "' for enum '" << e->name << "::" << v.name
                  << "' — defaulting to i32\n";
           ft = Type::getInt32Ty(context);
@@ -4220,7 +4829,7 @@ bool CodeGenerator::generate(const Program &program,
         ft = llvm::StructType::getTypeByName(context,
                                              f.type.base.token.getWord());
       if (!ft) {
-        errs() << "CodeGen error: cannot resolve type '"
+        diag() << "CodeGen error: cannot resolve type '"
                << f.type.base.token.getWord() << "' for field '" << f.name
                << "' in struct '" << s->name << "'\n";
         allResolved = false;
@@ -4239,7 +4848,7 @@ bool CodeGenerator::generate(const Program &program,
         continue;
       std::vector<llvm::Type *> pts;
       for (const auto &p : decl.paramTypes) {
-        const std::string tname = p.base.token.getWord();
+        const std::string tname(p.base.token.getWord());
         pts.push_back(p.isPtr || p.dimensions > 0 || tname == "str" ||
                               tname == "string"
                           ? llvm::PointerType::get(context, 0)
@@ -4258,7 +4867,7 @@ bool CodeGenerator::generate(const Program &program,
     llvm::Type *ty = TypeResolver::fromTypeDesc(context, gv->type);
     if (!ty) {
       logError(("Global variable '" + gv->name + "': unknown type '" +
-                gv->type.base.token.getWord() + "'")
+                std::string(gv->type.base.token.getWord()) + "'")
                    .c_str());
       return false;
     }
@@ -4267,7 +4876,7 @@ bool CodeGenerator::generate(const Program &program,
     auto evalConstField = [&](const Expression *expr,
                               llvm::Type *fieldTy) -> llvm::Constant * {
       bool negate = false;
-      if (auto *unary = dynamic_cast<const UnaryExpr *>(expr)) {
+      if (auto *unary = dyn_cast<UnaryExpr>(expr)) {
         if (unary->op != UnaryOp::Negate) {
           logError(("Global '" + gv->name + "': unsupported unary op in field")
                        .c_str());
@@ -4278,29 +4887,38 @@ bool CodeGenerator::generate(const Program &program,
       }
 
       llvm::Constant *fc = nullptr;
-      if (auto *fi = dynamic_cast<const IntLitExpr *>(expr)) {
+      switch (expr->getKind()) {
+      case ExprKind::IntLit: {
+        std::string text(cast<IntLitExpr>(expr)->lit.getWord());
         if (fieldTy->isFloatingPointTy()) {
-          double v = std::stod(fi->lit.getWord());
+          double v = std::stod(text);
           if (negate)
             v = -v;
           fc = llvm::ConstantFP::get(fieldTy, v);
         } else {
-          long long v = std::stoll(fi->lit.getWord());
+          long long v = std::stoll(text);
           if (negate)
             v = -v;
           fc = llvm::ConstantInt::get(fieldTy, v);
         }
-      } else if (auto *ff = dynamic_cast<const FloatLitExpr *>(expr)) {
-        double v = std::stod(ff->lit.getWord());
+        break;
+      }
+      case ExprKind::FloatLit: {
+        double v =
+            std::stod(std::string(cast<FloatLitExpr>(expr)->lit.getWord()));
         if (negate)
           v = -v;
         fc = llvm::ConstantFP::get(fieldTy, v);
-      } else if (auto *fb = dynamic_cast<const BoolLitExpr *>(expr)) {
-        long long v = fb->lit.getWord() == "true" ? 1 : 0;
+        break;
+      }
+      case ExprKind::BoolLit: {
+        long long v = cast<BoolLitExpr>(expr)->lit.getWord() == "true" ? 1 : 0;
         if (negate)
           v = -v;
         fc = llvm::ConstantInt::get(fieldTy, v);
-      } else {
+        break;
+      }
+      default:
         logError(
             ("Global '" + gv->name + "': field is not a constant expression")
                 .c_str());
@@ -4317,22 +4935,23 @@ bool CodeGenerator::generate(const Program &program,
 
     llvm::Constant *init = nullptr;
 
-    if (auto *intExpr = dynamic_cast<IntLitExpr *>(gv->init.get())) {
+    if (auto *intExpr = dyn_cast_or_null<IntLitExpr>(gv->init.get())) {
       if (ty->isFloatingPointTy()) {
-        double val = std::stod(intExpr->lit.getWord());
+        double val = std::stod(std::string(intExpr->lit.getWord()));
         init =
             ty->isFloatTy()
                 ? llvm::ConstantFP::get(llvm::Type::getFloatTy(context), val)
                 : llvm::ConstantFP::get(llvm::Type::getDoubleTy(context), val);
       } else {
-        init = llvm::ConstantInt::get(ty, std::stoll(intExpr->lit.getWord()));
+        init = llvm::ConstantInt::get(
+            ty, std::stoll(std::string(intExpr->lit.getWord())));
       }
-    } else if (auto *fltExpr = dynamic_cast<FloatLitExpr *>(gv->init.get())) {
-      double val = std::stod(fltExpr->lit.getWord());
+    } else if (auto *fltExpr = dyn_cast_or_null<FloatLitExpr>(gv->init.get())) {
+      double val = std::stod(std::string(fltExpr->lit.getWord()));
       init = ty->isFloatTy()
                  ? llvm::ConstantFP::get(llvm::Type::getFloatTy(context), val)
                  : llvm::ConstantFP::get(llvm::Type::getDoubleTy(context), val);
-    } else if (auto *slExpr = dynamic_cast<StructLitExpr *>(gv->init.get())) {
+    } else if (auto *slExpr = dyn_cast_or_null<StructLitExpr>(gv->init.get())) {
       auto *st = llvm::dyn_cast<llvm::StructType>(ty);
       if (!st) {
         logError(("Global '" + gv->name + "': type is not a struct").c_str());
@@ -4366,13 +4985,17 @@ bool CodeGenerator::generate(const Program &program,
                                           llvm::GlobalValue::ExternalLinkage,
                                           init, gv->name);
     VarInfo vi(gVar, ty, false, false, false, gv->isConst);
-    namedValues[gv->name] = vi;
-    globalValues[gv->name] = vi;
+    namedValues.declare(gv->symbol, vi);
   }
 
   // Forward-declare all user functions so calls can precede their definitions.
+  // Generic functions are templates: emitGenericSpecialization emits one
+  // copy per set of type arguments, when a call first asks for it.
   for (const auto &fn : program.functions) {
-    const std::string fname = mangleName(fn->name.token.getWord(), fn->params);
+    if (!fn->typeParams.empty())
+      continue;
+    const StringRef fname =
+        mangleName(fn->name.symbol(), fn->params.size()).str();
     if (module->getFunction(fname))
       continue;
 
@@ -4386,7 +5009,7 @@ bool CodeGenerator::generate(const Program &program,
     // registered yet under "Option". Instantiate it now so the forward
     // declaration gets the correct concrete return type instead of void.
     if (!retTy && !fn->returnType.typeArgs.empty()) {
-      const std::string &retBase = fn->returnType.base.token.getWord();
+      const std::string retBase(fn->returnType.base.token.getWord());
       std::vector<llvm::Type *> concreteArgs;
       std::vector<std::string> argNames;
       for (const auto &arg : fn->returnType.typeArgs) {
@@ -4396,7 +5019,7 @@ bool CodeGenerator::generate(const Program &program,
                                               arg.base.token.getWord());
         if (t) {
           concreteArgs.push_back(t);
-          argNames.push_back(arg.base.token.getWord());
+          argNames.emplace_back(arg.base.token.getWord());
         }
       }
       if (!concreteArgs.empty()) {
@@ -4430,17 +5053,29 @@ bool CodeGenerator::generate(const Program &program,
 
   // Emit function bodies.
   for (const auto &fn : program.functions) {
-    const std::string fname = mangleName(fn->name.token.getWord(), fn->params);
+    if (!fn->typeParams.empty())
+      continue;
     if (!codegen(*fn))
       return false;
   }
+  if (debugInfo)
+    debugInfo->finalize();
+  lowering.reset();
 
-  std::error_code ec;
-  raw_fd_ostream out(outputFilename + ".ll", ec, sys::fs::OF_None);
-  if (ec) {
-    errs() << "Cannot open output file: " << ec.message() << "\n";
-    return false;
+  {
+    TimeScope scope("optimize", optLevelFlag(opts.optLevel));
+    runOptimizationPipeline();
   }
-  module->print(out, nullptr);
-  return true;
+
+  if (TimeReport::current()) {
+    size_t defined = 0, instructions = 0;
+    for (const auto &f : *module) {
+      defined += !f.isDeclaration();
+      instructions += f.getInstructionCount();
+    }
+    TimeReport::count("IR functions", defined);
+    TimeReport::count("IR instructions", instructions);
+  }
+
+  return emitOutput(outputFilename);
 }
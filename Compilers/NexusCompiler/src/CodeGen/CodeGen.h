@@ -3,19 +3,22 @@
 
 #include "../AST/AST.h"
 #include "../AST/ExprVisitor.h"
+#include "CodeGenOptions.h"
 #include "Emitters/ArrayEmitter.h"
 #include "Emitters/PrintEmitter.h"
 #include "Emitters/StringEmitter.h"
 #include "Manager/ArithmeticManager.h"
+#include "Manager/BoundsManager.h"
+#include "Manager/DebugInfoManager.h"
 #include "Manager/ScopeManager.h"
 #include "VarInfo.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Value.h"
+#include "llvm/Target/TargetMachine.h"
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Type.h>
-#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -29,10 +32,15 @@ struct LoopContext {
 
 class CodeGenerator : public ExprVisitor, public StmtVisitor {
 public:
-  CodeGenerator();
+  explicit CodeGenerator(const CodeGenOptions &options = {});
   ~CodeGenerator() = default;
 
-  bool generate(const Program &program, const std::string &outputFilename);
+  // sourcePath names the compile unit when opts.debugInfo is set.
+  bool generate(const Program &program, const std::string &outputFilename,
+                const std::string &sourcePath = "");
+
+  // Whether generate reported an error, even one it lowered past.
+  bool reportedErrors() const { return hadError; }
 
   static bool isCStringPointer(llvm::Type *ty);
 
@@ -64,6 +72,7 @@ public:
   llvm::Value *visitStructLit(const StructLitExpr &e) override;
   llvm::Value *visitChainedCmp(const ChainedCmpExpr &e) override;
   llvm::Value *visitTypeIntrinsic(const TypeIntrinsicExpr &e) override;
+  llvm::Value *visitErrorExpr(const ErrorExpr &e) override;
 
   llvm::Value *visitBlock(const Block &b);
   llvm::Value *visitVarDecl(const VarDecl &d) override;
@@ -76,21 +85,28 @@ public:
   llvm::Value *visitReturn(const Return &s) override;
   llvm::Value *visitBreak(const Break &) override;
   llvm::Value *visitContinue(const Continue &) override;
+  llvm::Value *visitErrorStmt(const ErrorStmt &) override;
 
 private:
   // LLVM state
   bool hadError = false;
+  CodeGenOptions opts;
   llvm::LLVMContext context;
+  std::unique_ptr<llvm::TargetMachine> targetMachine;
   std::unique_ptr<llvm::Module> module;
   llvm::IRBuilder<> builder;
   std::vector<LoopContext> loopStack;
 
   // Symbol tables
-  std::map<std::string, VarInfo> namedValues;
-  std::map<std::string, VarInfo> globalValues;
-  std::unordered_map<std::string, std::vector<bool>> borrowRefParams;
-  std::unordered_map<std::string, std::vector<bool>> borrowMutParams;
+  VarTable namedValues;
+  std::unordered_map<const llvm::Function *, std::vector<bool>>
+      borrowRefParams;
+  std::unordered_map<const llvm::Function *, std::vector<bool>>
+      borrowMutParams;
+  std::unordered_map<uint64_t, Symbol> mangledNames; // see mangleName
   std::unordered_map<std::string, llvm::Function *> genericCache;
+  // Type parameters of the generic specialization being emitted, if any.
+  const std::unordered_map<std::string, llvm::Type *> *typeSubst = nullptr;
   std::unordered_map<std::string, long long> enumTagValues;
 
   const Program *currentProgram = nullptr;
@@ -108,6 +124,8 @@ private:
 
   // Subsystems
   ScopeManager scopeMgr;
+  BoundsManager boundsMgr;
+  std::unique_ptr<DebugInfoManager> debugInfo; // null without -g
 
   // Error
   llvm::Value *logError(const char *msg);
@@ -127,13 +145,39 @@ private:
                          const std::vector<llvm::Type *> &concreteArgs,
                          const std::vector<std::string> &argNames);
 
+  // Optimisation and emission
+  void createTargetMachine();
+  void runOptimizationPipeline();
+  bool emitOutput(const std::string &path);
+
   // Helpers
+  Symbol mangleName(Symbol name, size_t arity);
   llvm::AllocaInst *createEntryAlloca(llvm::Type *ty, const std::string &name);
-  llvm::Value *generateIncrDecr(const std::string &varName, bool isInc);
+  llvm::Value *generateIncrDecr(const Identifier &target, bool isInc);
   llvm::Function *getFree();
 
   std::pair<llvm::Value *, llvm::StructType *>
   resolveStructPtr(const Expression &expr);
+
+  // Binary operators. emitBinary works on evaluated operands; emitAddChain
+  // lowers a + b + c ... so that string pieces are joined in one allocation.
+  llvm::Type *operandType(llvm::Value *v, const Expression &e);
+  llvm::Value *emitBinary(const BinaryExpr &e, llvm::Value *lhs,
+                          llvm::Value *rhs);
+  llvm::Value *emitAddChain(const BinaryExpr &e);
+
+  // Appends the values of `pieces` to the string at `target` in place.
+  bool emitStringAppend(llvm::Value *target,
+                        const std::vector<const Expression *> &pieces);
+
+  // Array subscripting. Indexing fewer dimensions than an array has yields a
+  // view slot; views share the array's buffer and are remembered here so that
+  // nothing takes ownership of them.
+  std::set<llvm::Value *> arrayViews;
+  llvm::Value *emitSubscript(llvm::Value *ptr, llvm::StructType *arrSt,
+                             const Identifier &array,
+                             const std::vector<ExprPtr> &indices,
+                             llvm::Type *&resultTy);
 };
 
 #endif // CodeGen_H
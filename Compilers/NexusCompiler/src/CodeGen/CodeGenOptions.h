@@ -0,0 +1,178 @@
+#pragma once
+#include <optional>
+#include <string>
+
+// Optimisation level requested on the command line (-O0 .. -O3, -Os).
+enum class OptLevel { O0, O1, O2, O3, Os };
+
+// Artifact written by CodeGenerator::generate (--emit=...).
+enum class EmitKind { Object, Assembly, LLVMIR, Bitcode };
+
+// Build profile selected with --profile=<name>.
+enum class BuildProfile { Debug, Release, Sanitize };
+
+// Subscript range checking selected with --bounds-check=<mode>.
+//   off    no checks
+//   on     an index out of range traps
+//   debug  an index out of range prints it with the length and source
+//          position to stderr, then aborts
+enum class BoundsCheck { Off, On, Debug };
+
+// How the program buffers stdout, selected with --output-buffer=<mode>.
+//   auto  the C library default: flushed at every newline on a terminal,
+//         in blocks otherwise
+//   line  flushed at every newline
+//   full  flushed when a 64 KiB buffer fills, before Read() and at exit
+enum class OutputBuffer { Auto, Line, Full };
+
+// Knobs the driver hands to CodeGenerator for a single compilation.
+struct CodeGenOptions {
+  OptLevel optLevel = OptLevel::O0;
+  EmitKind emit = EmitKind::Object;
+  bool debugInfo = true;        // emit line tables, pass -g to the link
+  bool sanitizeAddress = false; // ASan-instrument the module, link ASan/LSan
+  BoundsCheck boundsCheck = BoundsCheck::Off;
+  OutputBuffer outputBuffer = OutputBuffer::Auto;
+};
+
+// Applies the optimisation, debug-info and sanitizer defaults of a profile:
+//   debug    -O0, -g
+//   release  -O2, no debug info
+//   sanitize -O1, -g, AddressSanitizer + LeakSanitizer
+inline void applyProfile(CodeGenOptions &opts, BuildProfile profile) {
+  switch (profile) {
+  case BuildProfile::Debug:
+    opts.optLevel = OptLevel::O0;
+    opts.debugInfo = true;
+    opts.sanitizeAddress = false;
+    break;
+  case BuildProfile::Release:
+    opts.optLevel = OptLevel::O2;
+    opts.debugInfo = false;
+    opts.sanitizeAddress = false;
+    break;
+  case BuildProfile::Sanitize:
+    opts.optLevel = OptLevel::O1;
+    opts.debugInfo = true;
+    opts.sanitizeAddress = true;
+    break;
+  }
+}
+
+// Parses a driver flag such as "-O2". Returns nullopt for anything else.
+inline std::optional<OptLevel> parseOptLevel(const std::string &flag) {
+  if (flag == "-O0")
+    return OptLevel::O0;
+  if (flag == "-O1")
+    return OptLevel::O1;
+  if (flag == "-O2")
+    return OptLevel::O2;
+  if (flag == "-O3")
+    return OptLevel::O3;
+  if (flag == "-Os")
+    return OptLevel::Os;
+  return std::nullopt;
+}
+
+// Spelling of the level as understood by clang, used for the link step.
+inline const char *optLevelFlag(OptLevel level) {
+  switch (level) {
+  case OptLevel::O0:
+    return "-O0";
+  case OptLevel::O1:
+    return "-O1";
+  case OptLevel::O2:
+    return "-O2";
+  case OptLevel::O3:
+    return "-O3";
+  case OptLevel::Os:
+    return "-Os";
+  }
+  return "-O0";
+}
+
+// Parses the value of --emit=<kind>. Returns nullopt for unknown kinds.
+inline std::optional<EmitKind> parseEmitKind(const std::string &kind) {
+  if (kind == "obj")
+    return EmitKind::Object;
+  if (kind == "asm")
+    return EmitKind::Assembly;
+  if (kind == "llvm-ir")
+    return EmitKind::LLVMIR;
+  if (kind == "bitcode")
+    return EmitKind::Bitcode;
+  return std::nullopt;
+}
+
+// File extension (including the dot) for each emitted artifact.
+inline const char *emitExtension(EmitKind kind) {
+  switch (kind) {
+  case EmitKind::Object:
+    return ".o";
+  case EmitKind::Assembly:
+    return ".s";
+  case EmitKind::LLVMIR:
+    return ".ll";
+  case EmitKind::Bitcode:
+    return ".bc";
+  }
+  return ".o";
+}
+
+// Parses the value of --profile=<name>. Returns nullopt for unknown names.
+inline std::optional<BuildProfile> parseBuildProfile(const std::string &name) {
+  if (name == "debug")
+    return BuildProfile::Debug;
+  if (name == "release")
+    return BuildProfile::Release;
+  if (name == "sanitize")
+    return BuildProfile::Sanitize;
+  return std::nullopt;
+}
+
+// Parses the value of --bounds-check=<mode>. Returns nullopt for unknown modes.
+inline std::optional<BoundsCheck> parseBoundsCheck(const std::string &mode) {
+  if (mode == "off")
+    return BoundsCheck::Off;
+  if (mode == "on")
+    return BoundsCheck::On;
+  if (mode == "debug")
+    return BoundsCheck::Debug;
+  return std::nullopt;
+}
+
+inline const char *boundsCheckName(BoundsCheck mode) {
+  switch (mode) {
+  case BoundsCheck::Off:
+    return "off";
+  case BoundsCheck::On:
+    return "on";
+  case BoundsCheck::Debug:
+    return "debug";
+  }
+  return "off";
+}
+
+// Parses the value of --output-buffer=<mode>. Returns nullopt for unknown
+// modes.
+inline std::optional<OutputBuffer> parseOutputBuffer(const std::string &mode) {
+  if (mode == "auto")
+    return OutputBuffer::Auto;
+  if (mode == "line")
+    return OutputBuffer::Line;
+  if (mode == "full")
+    return OutputBuffer::Full;
+  return std::nullopt;
+}
+
+inline const char *outputBufferName(OutputBuffer mode) {
+  switch (mode) {
+  case OutputBuffer::Auto:
+    return "auto";
+  case OutputBuffer::Line:
+    return "line";
+  case OutputBuffer::Full:
+    return "full";
+  }
+  return "auto";
+}
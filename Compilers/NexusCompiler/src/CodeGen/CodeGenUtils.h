@@ -4,8 +4,8 @@
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
-#include <map>
 #include <string>
+#include <string_view>
 
 namespace codegen_utils {
 
@@ -13,7 +13,7 @@ namespace codegen_utils {
 // unescapeString              //
 // Process backslash sequences //
 // --------------------------- //
-inline std::string unescapeString(const std::string &s) {
+inline std::string unescapeString(std::string_view s) {
   std::string out;
   out.reserve(s.size());
   for (size_t i = 0; i < s.size(); ++i) {
@@ -64,7 +64,7 @@ inline std::string unescapeString(const std::string &s) {
 // ---------------------------------------------------- //
 inline llvm::Value *evalInterp(const std::string &inner, llvm::LLVMContext &ctx,
                                llvm::IRBuilder<> &B,
-                               const std::map<std::string, VarInfo> &vars) {
+                               const VarTable &vars) {
 
   bool isIdent = !inner.empty();
   for (char c : inner)
@@ -74,13 +74,11 @@ inline llvm::Value *evalInterp(const std::string &inner, llvm::LLVMContext &ctx,
     }
 
   if (isIdent) {
-    auto it = vars.find(inner);
-    if (it != vars.end() && !it->second.isMoved) {
-      if (TypeResolver::isString(it->second.type) ||
-          TypeResolver::isArray(it->second.type))
-        return it->second.allocaInst;
-      return B.CreateLoad(it->second.type, it->second.allocaInst,
-                          inner + ".load");
+    const VarInfo *vi = vars.lookup(Symbol::intern(inner));
+    if (vi && !vi->isMoved) {
+      if (TypeResolver::isString(vi->type) || TypeResolver::isArray(vi->type))
+        return vi->allocaInst;
+      return B.CreateLoad(vi->type, vi->allocaInst, inner + ".load");
     }
     return nullptr;
   }
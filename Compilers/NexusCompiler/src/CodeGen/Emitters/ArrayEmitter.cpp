@@ -1,17 +1,29 @@
 #include "ArrayEmitter.h"
 #include "../TypeResolver.h"
+#include "llvm/IR/Intrinsics.h"
 
 using namespace llvm;
 
 namespace ArrayEmitter {
 
-// ---------------- //
-// Internal helpers //
-// ---------------- //
+// a * b as i64, trapping if the product does not fit: an allocation size
+// that wrapped would give a buffer too small for the array.
+static Value *emitCheckedMul(IRBuilder<> &B, LLVMContext &C, Value *a,
+                             Value *b, const Twine &name) {
+  Value *res = B.CreateIntrinsic(Intrinsic::umul_with_overflow,
+                                 {Type::getInt64Ty(C)}, {a, b});
+  llvm::Function *fn = B.GetInsertBlock()->getParent();
+  BasicBlock *trapBB = BasicBlock::Create(C, "arr.size.overflow", fn);
+  BasicBlock *okBB = BasicBlock::Create(C, "arr.size.ok", fn);
+  B.CreateCondBr(B.CreateExtractValue(res, {1}), trapBB, okBB);
+
+  B.SetInsertPoint(trapBB);
+  B.CreateIntrinsic(Intrinsic::trap, {}, {});
+  B.CreateUnreachable();
 
-static Value *buildLevel(IRBuilder<> &B, LLVMContext &C, Module &M,
-                         Type *elementType, ArrayRef<Value *> dims,
-                         unsigned depth);
+  B.SetInsertPoint(okBB);
+  return B.CreateExtractValue(res, {0}, name);
+}
 
 // ---------- //
 // Public API //
@@ -29,7 +41,7 @@ Value *emitMalloc(IRBuilder<> &B, LLVMContext &C, Module &M, Type *allocTy,
   Type *i64Ty = Type::getInt64Ty(C);
   Value *elemSize = ConstantInt::get(i64Ty, size);
   Value *count64 = B.CreateZExt(count, i64Ty);
-  Value *total = B.CreateMul(elemSize, count64);
+  Value *total = emitCheckedMul(B, C, elemSize, count64, "alloc.bytes");
 
   FunctionCallee mallocFn = M.getOrInsertFunction(
       "malloc", FunctionType::get(PointerType::get(C, 0), {i64Ty}, false));
@@ -39,138 +51,97 @@ Value *emitMalloc(IRBuilder<> &B, LLVMContext &C, Module &M, Type *allocTy,
 
 Value *makeND(IRBuilder<> &B, LLVMContext &C, Module &M, Type *elementType,
               ArrayRef<Value *> dims) {
-  return buildLevel(B, C, M, elementType, dims, 0);
-}
-
-void emitArrayFree(IRBuilder<> &B, LLVMContext &C, Module &M, Value *arrPtr,
-                   StructType *arrSt, int depth) {
-  Type *i64 = Type::getInt64Ty(C);
-
-  // Declare free() if not already present
-  llvm::Function *freeF = M.getFunction("free");
-  if (!freeF) {
-    auto *ft =
-        FunctionType::get(Type::getVoidTy(C), {PointerType::get(C, 0)}, false);
-    freeF =
-        llvm::Function::Create(ft, llvm::Function::ExternalLinkage, "free", M);
-  }
-
-  llvm::Function *fn = B.GetInsertBlock()->getParent();
-
-  Value *loaded = B.CreateLoad(arrSt, arrPtr);
-  Value *dataPtr = B.CreateExtractValue(loaded, {1}, "data");
-  Value *len = B.CreateExtractValue(loaded, {0}, "len");
-
-  Type *elemTy = TypeResolver::elemType(C, arrSt);
-
-  if (elemTy && TypeResolver::isArray(elemTy)) {
-    StructType *elemSt = cast<StructType>(elemTy);
-    std::string sfx = std::to_string(depth);
-
-    BasicBlock *loopBB = BasicBlock::Create(C, "free.loop" + sfx, fn);
-    BasicBlock *bodyBB = BasicBlock::Create(C, "free.body" + sfx, fn);
-    BasicBlock *afterBB = BasicBlock::Create(C, "free.after" + sfx, fn);
-
-    AllocaInst *idx = B.CreateAlloca(i64, nullptr, "fi" + sfx);
-    B.CreateStore(ConstantInt::get(i64, 0), idx);
-    B.CreateBr(loopBB);
+  Type *i64Ty = Type::getInt64Ty(C);
 
-    B.SetInsertPoint(loopBB);
-    Value *cur = B.CreateLoad(i64, idx);
-    Value *cond = B.CreateICmpULT(cur, len);
-    B.CreateCondBr(cond, bodyBB, afterBB);
+  Type *arrTy = elementType;
+  for (size_t i = 0; i < dims.size(); ++i)
+    arrTy = TypeResolver::getOrCreateArrayStruct(C, arrTy);
+  StructType *arrSt = cast<StructType>(arrTy);
 
-    B.SetInsertPoint(bodyBB);
-    Value *slotPtr = B.CreateGEP(elemSt, dataPtr, cur, "slot" + sfx);
-    emitArrayFree(B, C, M, slotPtr, elemSt, depth + 1); // recurse
-    Value *next = B.CreateAdd(cur, ConstantInt::get(i64, 1));
-    B.CreateStore(next, idx);
-    B.CreateBr(loopBB);
+  // Heap-allocate the descriptor so it survives past the enclosing function's
+  // return. A stack alloca here becomes a dangling pointer when the array is
+  // stored into a struct that is returned by value (e.g. Mat4.m).
+  const DataLayout &DL = M.getDataLayout();
+  Value *descSize = ConstantInt::get(i64Ty, DL.getTypeAllocSize(arrSt));
+  FunctionCallee mallocFn = M.getOrInsertFunction(
+      "malloc", FunctionType::get(PointerType::get(C, 0), {i64Ty}, false));
+  Value *descriptor = B.CreateCall(mallocFn, {descSize}, "arr.desc");
 
-    B.SetInsertPoint(afterBB);
+  // Extents go to field 0 (the length) and fields 2.. (inner dimensions).
+  Value *count = dims[0];
+  for (unsigned d = 0; d < dims.size(); ++d) {
+    Value *extentPtr = B.CreateStructGEP(arrSt, descriptor, d == 0 ? 0 : d + 1);
+    B.CreateStore(B.CreateZExt(dims[d], i64Ty), extentPtr);
+    if (d > 0)
+      count = emitCheckedMul(B, C, B.CreateZExt(count, i64Ty),
+                             B.CreateZExt(dims[d], i64Ty), "arr.count");
   }
 
-  B.CreateCall(freeF, {dataPtr});
+  Value *dataPtr = B.CreateStructGEP(arrSt, descriptor, 1);
+  Value *buffer = emitMalloc(B, C, M, elementType, count);
+  B.CreateStore(buffer, dataPtr);
+  return descriptor;
 }
 
-// ------------------------------------------//
-// Private — recursive N-dimensional builder //
-// ----------------------------------------- //
-
-static Value *buildLevel(IRBuilder<> &B, LLVMContext &C, Module &M,
-                         Type *elementType, ArrayRef<Value *> dims,
-                         unsigned depth) {
+Value *makeJagged(IRBuilder<> &B, LLVMContext &C, Module &M, Type *rowType,
+                  Value *rows) {
   Type *i64Ty = Type::getInt64Ty(C);
+  StructType *arrSt = TypeResolver::getOrCreateJaggedStruct(C, rowType);
 
-  Type *childElemTy = elementType;
-  for (unsigned i = depth + 1; i < dims.size(); ++i)
-    childElemTy = TypeResolver::getOrCreateArrayStruct(C, childElemTy);
-
-  StructType *arrTy = TypeResolver::getOrCreateArrayStruct(C, childElemTy);
-  Value *len = dims[depth];
-
-  // Heap-allocate the descriptor so it survives past the enclosing function's
-  // return. A stack alloca here becomes a dangling pointer when the array is
-  // stored into a struct that is returned by value (e.g. Mat4.m).
   const DataLayout &DL = M.getDataLayout();
-  Value *descSize = ConstantInt::get(i64Ty, DL.getTypeAllocSize(arrTy));
+  Value *descSize = ConstantInt::get(i64Ty, DL.getTypeAllocSize(arrSt));
   FunctionCallee mallocFn = M.getOrInsertFunction(
       "malloc", FunctionType::get(PointerType::get(C, 0), {i64Ty}, false));
   Value *descriptor = B.CreateCall(mallocFn, {descSize}, "arr.desc");
-  Value *lenPtr = B.CreateStructGEP(arrTy, descriptor, 0);
-  B.CreateStore(B.CreateZExt(len, i64Ty), lenPtr);
-
-  Value *dataPtr = B.CreateStructGEP(arrTy, descriptor, 1);
-  bool isLeaf = (depth == dims.size() - 1);
-
-  if (isLeaf) {
-    Value *buffer = emitMalloc(B, C, M, elementType, len);
-    B.CreateStore(buffer, dataPtr);
-  } else {
-    Value *childArray = emitMalloc(B, C, M, childElemTy, len);
-    B.CreateStore(childArray, dataPtr);
-
-    StructType *childSt = cast<StructType>(childElemTy);
-
-    llvm::Function *fn = B.GetInsertBlock()->getParent();
-    BasicBlock *loopBB = BasicBlock::Create(C, "nd.loop", fn);
-    BasicBlock *bodyBB = BasicBlock::Create(C, "nd.body", fn);
-    BasicBlock *afterBB = BasicBlock::Create(C, "nd.after", fn);
-
-    Value *index = B.CreateAlloca(i64Ty);
-    B.CreateStore(ConstantInt::get(i64Ty, 0), index);
-    B.CreateBr(loopBB);
-
-    B.SetInsertPoint(loopBB);
-    Value *iVal = B.CreateLoad(i64Ty, index);
-    Value *cond = B.CreateICmpULT(iVal, B.CreateZExt(len, i64Ty));
-    B.CreateCondBr(cond, bodyBB, afterBB);
-
-    B.SetInsertPoint(bodyBB);
-    Value *slot =
-        B.CreateGEP(childSt, childArray, iVal); // ← childSt not childTy
-    Value *childDesc = buildLevel(B, C, M, elementType, dims, depth + 1);
-    Value *childVal = B.CreateLoad(childSt, childDesc);
-    B.CreateStore(childVal, slot);
-    // Free the child descriptor — its value has been copied into the slot.
-    // The data buffer it pointed to is now owned by the slot; only the
-    // heap-allocated descriptor wrapper itself is released here.
-    llvm::Function *freeF = M.getFunction("free");
-    if (!freeF) {
-      auto *ft = FunctionType::get(Type::getVoidTy(C),
-                                   {PointerType::get(C, 0)}, false);
-      freeF = llvm::Function::Create(ft, llvm::Function::ExternalLinkage,
-                                     "free", M);
-    }
-    B.CreateCall(freeF, {childDesc});
-    Value *next = B.CreateAdd(iVal, ConstantInt::get(i64Ty, 1));
-    B.CreateStore(next, index);
-    B.CreateBr(loopBB);
-
-    B.SetInsertPoint(afterBB);
-  }
 
+  Value *count = B.CreateZExt(rows, i64Ty);
+  B.CreateStore(count, B.CreateStructGEP(arrSt, descriptor, 0));
+
+  // Every row starts empty ({0, null}) until one is assigned to it.
+  Value *buffer = emitMalloc(B, C, M, rowType, count);
+  Value *bytes = B.CreateMul(
+      count, ConstantInt::get(i64Ty, DL.getTypeAllocSize(rowType)), "bytes");
+  B.CreateMemSet(buffer, B.getInt8(0), bytes, MaybeAlign(8));
+  B.CreateStore(buffer, B.CreateStructGEP(arrSt, descriptor, 1));
   return descriptor;
 }
 
+Value *emitDim(IRBuilder<> &B, Value *arr, unsigned d) {
+  return B.CreateExtractValue(arr, {d == 0 ? 0u : d + 1}, "arr.dim");
+}
+
+Value *emitElementCount(IRBuilder<> &B, Value *arr, unsigned rank) {
+  Value *count = emitDim(B, arr, 0);
+  for (unsigned d = 1; d < rank; ++d)
+    count = B.CreateMul(count, emitDim(B, arr, d), "arr.count");
+  return count;
+}
+
+Value *emitSubscript(IRBuilder<> &B, Value *arr, unsigned rank, Type *leafTy,
+                     ArrayRef<Value *> indices) {
+  // Row-major: fold the indices in Horner form, then scale by the extents of
+  // the dimensions left unindexed.
+  Value *offset = indices[0];
+  for (unsigned d = 1; d < indices.size(); ++d)
+    offset = B.CreateAdd(B.CreateMul(offset, emitDim(B, arr, d)), indices[d],
+                         "arr.offset");
+  for (unsigned d = indices.size(); d < rank; ++d)
+    offset = B.CreateMul(offset, emitDim(B, arr, d), "arr.offset");
+
+  Value *data = B.CreateExtractValue(arr, {1}, "arr.data");
+  return B.CreateGEP(leafTy, data, offset, "elem.ptr");
+}
+
+Value *emitView(IRBuilder<> &B, Value *arr, unsigned rank, StructType *viewTy,
+                Type *leafTy, ArrayRef<Value *> indices) {
+  unsigned k = indices.size();
+  Value *view = UndefValue::get(viewTy);
+  view = B.CreateInsertValue(view, emitDim(B, arr, k), {0});
+  view = B.CreateInsertValue(view, emitSubscript(B, arr, rank, leafTy, indices),
+                             {1});
+  for (unsigned d = k + 1; d < rank; ++d)
+    view = B.CreateInsertValue(view, emitDim(B, arr, d), {d - k + 1}, "view");
+  return view;
+}
+
 } // namespace ArrayEmitter
@@ -11,6 +11,19 @@
 // ---------------------------------------------------------------- //
 // ArrayEmitter — creation, indexing and length of primitive arrays //
 // ---------------------------------------------------------------- //
+//
+// An array of any rank owns a single row-major data buffer. A rank-N value
+// is {i64 dim0, ptr data, i64 dim1, ..., i64 dimN-1} (see
+// TypeResolver::getOrCreateArrayStruct). Indexing fewer than N dimensions
+// yields a view: an array value of the remaining rank that points into the
+// same buffer and owns nothing.
+//
+// A jagged array (new T[][n]) opts out of this: it is a rank-1 array of row
+// descriptors, each row an array with its own buffer and length (see
+// TypeResolver::getOrCreateJaggedStruct).
+//
+// Allocation sizes are computed with overflow checks; a size that does not
+// fit in 64 bits traps rather than allocating a short buffer.
 namespace ArrayEmitter {
 
 llvm::StructType *getArrayStructTy(llvm::LLVMContext &C);
@@ -19,12 +32,36 @@ llvm::Value *emitMalloc(llvm::IRBuilder<> &B, llvm::LLVMContext &C,
                         llvm::Module &M, llvm::Type *allocTy,
                         llvm::Value *count);
 
+// Allocates new elementType[dims[0]]...[dims[n-1]]. Returns a pointer to a
+// heap-allocated descriptor; the caller loads the value and frees it.
 llvm::Value *makeND(llvm::IRBuilder<> &B, llvm::LLVMContext &C, llvm::Module &M,
                     llvm::Type *elementType,
                     llvm::ArrayRef<llvm::Value *> dims);
 
-void emitArrayFree(llvm::IRBuilder<> &B, llvm::LLVMContext &C, llvm::Module &M,
-                   llvm::Value *arrPtr, llvm::StructType *arrSt, int depth);
+// Allocates a jagged array of `rows` empty rows of rowType. Returns a
+// pointer to a heap-allocated descriptor, as makeND does.
+llvm::Value *makeJagged(llvm::IRBuilder<> &B, llvm::LLVMContext &C,
+                        llvm::Module &M, llvm::Type *rowType,
+                        llvm::Value *rows);
+
+// Extent of dimension d of the array value arr; dimension 0 is its length.
+llvm::Value *emitDim(llvm::IRBuilder<> &B, llvm::Value *arr, unsigned d);
+
+// Number of elements in the data buffer of arr, an array value of `rank`.
+llvm::Value *emitElementCount(llvm::IRBuilder<> &B, llvm::Value *arr,
+                              unsigned rank);
+
+// Address of arr[i0]...[ik-1] for k = indices.size() <= rank: the element
+// itself when k == rank, otherwise the first element of that sub-array.
+// Indices must be i64.
+llvm::Value *emitSubscript(llvm::IRBuilder<> &B, llvm::Value *arr,
+                           unsigned rank, llvm::Type *leafTy,
+                           llvm::ArrayRef<llvm::Value *> indices);
+
+// The view of arr[i0]...[ik-1] (k < rank), a value of viewTy.
+llvm::Value *emitView(llvm::IRBuilder<> &B, llvm::Value *arr, unsigned rank,
+                      llvm::StructType *viewTy, llvm::Type *leafTy,
+                      llvm::ArrayRef<llvm::Value *> indices);
 
 } // namespace ArrayEmitter
 
@@ -20,7 +20,7 @@ Value *BuiltinEmitter::handleRandom(IRBuilder<> &B, LLVMContext &ctx,
 }
 
 void BuiltinEmitter::emitRuntimeInit(IRBuilder<> &B, LLVMContext &ctx,
-                                     Module *M) {
+                                     Module *M, OutputBuffer buffering) {
   llvm::Function *timeF = M->getFunction("time");
   if (!timeF) {
     FunctionType *timeTy = FunctionType::get(
@@ -40,6 +40,36 @@ void BuiltinEmitter::emitRuntimeInit(IRBuilder<> &B, LLVMContext &ctx,
   Value *timeval = B.CreateCall(timeF, {nullPtr}, "time.val");
   Value *seed = B.CreateTrunc(timeval, Type::getInt32Ty(ctx), "seed");
   B.CreateCall(srandF, {seed});
+
+  if (buffering == OutputBuffer::Auto)
+    return;
+
+  // setvbuf(stdout, buf, mode, size). The C library ignores the size unless
+  // it is given the buffer, so 'full' supplies its own.
+  const int IOFBF = 0, IOLBF = 1;
+  const uint64_t FULL_SIZE = 1 << 16;
+  Type *i32Ty = Type::getInt32Ty(ctx);
+  Type *i64Ty = Type::getInt64Ty(ctx);
+  Type *ptrTy = PointerType::getUnqual(ctx);
+  FunctionCallee setvbufF = M->getOrInsertFunction(
+      "setvbuf", FunctionType::get(i32Ty, {ptrTy, ptrTy, i32Ty, i64Ty}, false));
+
+  Value *buf = nullPtr;
+  uint64_t size = 0;
+  if (buffering == OutputBuffer::Full) {
+    auto *bufTy = llvm::ArrayType::get(Type::getInt8Ty(ctx), FULL_SIZE);
+    buf = new GlobalVariable(*M, bufTy, false, GlobalValue::InternalLinkage,
+                             ConstantAggregateZero::get(bufTy),
+                             "nexus.stdout.buf");
+    size = FULL_SIZE;
+  }
+  Value *out = B.CreateLoad(ptrTy, RTDecl::stdout_(M, ctx), "stdout.val");
+  B.CreateCall(setvbufF,
+               {out, buf,
+                ConstantInt::get(i32Ty,
+                                 buffering == OutputBuffer::Full ? IOFBF
+                                                                 : IOLBF),
+                ConstantInt::get(i64Ty, size)});
 }
 
 Value *BuiltinEmitter::handleRead(IRBuilder<> &B, LLVMContext &ctx, Module *M) {
@@ -70,6 +100,10 @@ Value *BuiltinEmitter::handleRead(IRBuilder<> &B, LLVMContext &ctx, Module *M) {
   }
   Value *stdinVal = B.CreateLoad(ptrTy, stdinVar, "stdin.val");
 
+  // A prompt printed without a newline must be visible before we block.
+  Value *stdoutVal = B.CreateLoad(ptrTy, RTDecl::stdout_(M, ctx), "stdout.val");
+  B.CreateCall(RTDecl::fflush_(M, ctx), {stdoutVal});
+
   B.CreateCall(fgetsF, {buf, ConstantInt::get(i32Ty, BUF_SIZE), stdinVal});
 
   Value *len = B.CreateCall(RTDecl::strlen_(M, ctx), {buf}, "read.len");
@@ -2,6 +2,7 @@
 #define BUILTIN_EMITTER_H
 
 #include "../../AST/AST.h"
+#include "../CodeGenOptions.h"
 #include "../VarInfo.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
@@ -18,8 +19,9 @@ public:
   static llvm::Value *handleRandom(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                                    llvm::Module *M);
 
+  // Start of main: seeds Random() and sets up stdout for `buffering`.
   static void emitRuntimeInit(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
-                              llvm::Module *M);
+                              llvm::Module *M, OutputBuffer buffering);
 
   static llvm::Value *handleRead(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                                  llvm::Module *M);
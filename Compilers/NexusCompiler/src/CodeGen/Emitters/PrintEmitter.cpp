@@ -1,9 +1,10 @@
 #include "PrintEmitter.h"
 #include "../CodeGenUtils.h"
+#include "../RTDecl.h"
 #include "../TypeResolver.h"
+#include "StringEmitter.h"
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Value.h>
-#include <regex>
 
 using namespace llvm;
 
@@ -11,31 +12,111 @@ using namespace llvm;
 // Internal types (file-local)           //
 // ------------------------------------- //
 
-struct FmtArg {
-  std::string spec;
-  Value *value;
+namespace {
+
+// Writes one Printf to stdout piece by piece, each with the call that suits
+// its type, and counts the bytes written. Literal text is gathered until
+// the next value so that each run becomes a single write.
+class StdoutWriter {
+public:
+  StdoutWriter(IRBuilder<> &B, LLVMContext &ctx, Module *M)
+      : B_(B), ctx_(ctx), M_(M) {
+    out_ = B.CreateLoad(PointerType::get(ctx, 0), RTDecl::stdout_(M, ctx),
+                        "stdout.val");
+    count_ = ConstantInt::get(Type::getInt64Ty(ctx), 0);
+  }
+
+  void text(char c) { pending_ += c; }
+  void text(const std::string &s) { pending_ += s; }
+
+  void value(Value *val);
+
+  // Writes any remaining text; returns the byte count as printf would.
+  Value *finish() {
+    flushText();
+    return B_.CreateTrunc(count_, Type::getInt32Ty(ctx_), "printf.ret");
+  }
+
+private:
+  IRBuilder<> &B_;
+  LLVMContext &ctx_;
+  Module *M_;
+  Value *out_;
+  Value *count_;
+  std::string pending_;
+
+  void flushText() {
+    if (pending_.empty())
+      return;
+    bytes(B_.CreateGlobalString(pending_, ".str"),
+          ConstantInt::get(Type::getInt64Ty(ctx_), pending_.size()));
+    pending_.clear();
+  }
+
+  void bytes(Value *data, Value *len) {
+    B_.CreateCall(RTDecl::fwrite_(M_, ctx_),
+                  {data, ConstantInt::get(Type::getInt64Ty(ctx_), 1), len,
+                   out_});
+    count_ = B_.CreateAdd(count_, len, "printf.count");
+  }
 };
 
-static std::string buildPrintfFmt(const std::string &raw, LLVMContext &ctx,
-                                  IRBuilder<> &B,
-                                  const std::map<std::string, VarInfo> &vars,
-                                  std::vector<FmtArg> &args) {
-  std::string fmt;
+void StdoutWriter::value(Value *val) {
+  Type *ty = val->getType();
+  Type *i64 = Type::getInt64Ty(ctx_);
+  if (ty->isIntegerTy(1)) {
+    flushText();
+    Value *t = B_.CreateGlobalString("true", "bt");
+    Value *f = B_.CreateGlobalString("false", "bf");
+    bytes(B_.CreateSelect(val, t, f, "bstr"),
+          B_.CreateSelect(val, ConstantInt::get(i64, 4),
+                          ConstantInt::get(i64, 5)));
+  } else if (ty->isIntegerTy(8)) {
+    flushText();
+    B_.CreateCall(RTDecl::fputc_(M_, ctx_),
+                  {B_.CreateZExt(val, Type::getInt32Ty(ctx_)), out_});
+    count_ = B_.CreateAdd(count_, ConstantInt::get(i64, 1), "printf.count");
+  } else if (ty->isIntegerTy()) {
+    flushText();
+    auto [digits, len] = StringOps::formatInt(B_, ctx_, M_, val);
+    bytes(digits, len);
+  } else if (ty->isFloatingPointTy()) {
+    flushText();
+    auto [text, len] = StringOps::formatFloat(B_, ctx_, M_, val);
+    bytes(text, len);
+  } else if (auto *ai = dyn_cast<AllocaInst>(val)) {
+    // Strings carry their length; other aggregates print nothing.
+    if (TypeResolver::isString(ai->getAllocatedType())) {
+      flushText();
+      StructType *st = cast<StructType>(ai->getAllocatedType());
+      Value *load = B_.CreateLoad(st, ai, "str.load");
+      bytes(B_.CreateExtractValue(load, {0}, "str.data"),
+            B_.CreateExtractValue(load, {1}, "str.len"));
+    }
+  } else if (ty->isPointerTy()) {
+    flushText();
+    bytes(val, B_.CreateCall(RTDecl::strlen_(M_, ctx_), {val}, "cstr.len"));
+  }
+}
+
+} // namespace
+
+static void emitPrintfPieces(const std::string &raw, StdoutWriter &out,
+                             LLVMContext &ctx, IRBuilder<> &B,
+                             const VarTable &vars) {
   size_t i = 0;
   while (i < raw.size()) {
     if (raw[i] == '\\' && i + 1 < raw.size() && raw[i + 1] == '{') {
-      fmt += '{';
+      out.text('{');
       i += 2;
       continue;
     }
     if (raw[i] != '{') {
-      if (raw[i] == '%')
-        fmt += '%';
-      fmt += raw[i++];
+      out.text(raw[i++]);
       continue;
     }
     if (i + 1 < raw.size() && raw[i + 1] == '{') {
-      fmt += '{';
+      out.text('{');
       i += 2;
       continue;
     }
@@ -52,50 +133,17 @@ static std::string buildPrintfFmt(const std::string &raw, LLVMContext &ctx,
         break;
     }
     if (j >= raw.size()) {
-      fmt += raw[i++];
+      out.text(raw[i++]);
       continue;
     }
 
     std::string inner = raw.substr(start, j - start);
-    Value *val = codegen_utils::evalInterp(inner, ctx, B, vars);
-    if (val) {
-      Type *ty = val->getType();
-      if (ty->isIntegerTy(1)) {
-        Value *t = B.CreateGlobalString("true", "bt");
-        Value *f = B.CreateGlobalString("false", "bf");
-        args.push_back({"%s", B.CreateSelect(val, t, f, "bstr")});
-        fmt += "%s";
-      } else if (ty->isIntegerTy(8)) {
-        args.push_back({"%c", val});
-        fmt += "%c";
-      } else if (ty->isIntegerTy()) {
-        if (ty->getIntegerBitWidth() < 64)
-          val = B.CreateSExt(val, Type::getInt64Ty(ctx));
-        args.push_back({"%lld", val});
-        fmt += "%lld";
-      } else if (ty->isFloatingPointTy()) {
-        if (!ty->isDoubleTy())
-          val = B.CreateFPExt(val, Type::getDoubleTy(ctx));
-        args.push_back({"%g", val});
-        fmt += "%g";
-      } else if (auto *ai = dyn_cast<AllocaInst>(val)) {
-        if (TypeResolver::isString(ai->getAllocatedType())) {
-          StructType *st = cast<StructType>(ai->getAllocatedType());
-          Value *load = B.CreateLoad(st, ai);
-          Value *ptr = B.CreateExtractValue(load, {0});
-          args.push_back({"%s", ptr});
-          fmt += "%s";
-        }
-      } else if (ty->isPointerTy()) {
-        args.push_back({"%s", val});
-        fmt += "%s";
-      }
-    } else {
-      fmt += '{' + inner + '}';
-    }
+    if (Value *val = codegen_utils::evalInterp(inner, ctx, B, vars))
+      out.value(val);
+    else
+      out.text('{' + inner + '}');
     i = j + 1;
   }
-  return fmt;
 }
 
 // -------------- //
@@ -113,17 +161,25 @@ std::string PrintEmitter::hexToAnsi(const std::string &hex) {
 }
 
 std::string PrintEmitter::replaceHexColors(const std::string &input) {
-  std::regex re(R"(#([0-9a-fA-F]{6}))");
+  auto isHex = [](char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+           (c >= 'A' && c <= 'F');
+  };
   std::string result;
-  std::sregex_iterator it(input.begin(), input.end(), re), end;
-  size_t last = 0;
-  for (; it != end; ++it) {
-    auto &m = *it;
-    result += input.substr(last, m.position() - last);
-    result += hexToAnsi(m.str());
-    last = m.position() + m.length();
+  size_t i = 0;
+  while (i < input.size()) {
+    size_t n = 0;
+    if (input[i] == '#')
+      while (n < 6 && i + 1 + n < input.size() && isHex(input[i + 1 + n]))
+        ++n;
+    if (n == 6) {
+      result += hexToAnsi(input.substr(i, 7));
+      i += 7;
+    } else {
+      result += input[i++];
+    }
   }
-  return result + input.substr(last);
+  return result;
 }
 
 // ---------- //
@@ -132,60 +188,26 @@ std::string PrintEmitter::replaceHexColors(const std::string &input) {
 
 Value *PrintEmitter::handlePrintf(const CallExpr &e, IRBuilder<> &B,
                                   LLVMContext &ctx, Module *M,
-                                  const std::map<std::string, VarInfo> &vars) {
-  auto *strArg = dynamic_cast<const StrLitExpr *>(e.arguments[0].get());
+                                  const VarTable &vars) {
+  auto *strArg = dyn_cast<StrLitExpr>(e.arguments[0].get());
   if (!strArg)
     return nullptr;
 
+  // Only a format that sets a colour needs the reset at its end.
   std::string raw = codegen_utils::unescapeString(strArg->lit.getWord());
-  raw = replaceHexColors(raw) + "\033[0m";
-
-  std::vector<FmtArg> fmtArgs;
-  std::string fmt = buildPrintfFmt(raw, ctx, B, vars, fmtArgs);
-
-  llvm::Function *printfF = M->getFunction("printf");
-  if (!printfF)
-    return nullptr;
-
-  Value *fmtPtr = B.CreateGlobalString(fmt, ".fmt");
-  std::vector<Value *> args = {fmtPtr};
-
-  for (auto &fa : fmtArgs) {
-    Value *toPass = fa.value;
-
-    if (fa.spec == "%s") {
-      if (fa.value->getType()->isPointerTy()) {
-        args.push_back(fa.value);
-        continue;
-      }
-
-      if (auto *ai = dyn_cast<AllocaInst>(fa.value)) {
-        Type *at = ai->getAllocatedType();
-        if (TypeResolver::isString(at)) {
-          StructType *st = cast<StructType>(at);
-          Value *loaded = B.CreateLoad(st, ai, "str.load");
-          Value *dataPtr = B.CreateExtractValue(loaded, {0}, "str.data");
-
-          FunctionCallee colorFn = M->getOrInsertFunction(
-              "rt_colorize_string",
-              FunctionType::get(PointerType::get(ctx, 0),
-                                {PointerType::get(ctx, 0)}, false));
-
-          Value *colored = B.CreateCall(colorFn, {dataPtr}, "colored.str");
-          toPass = colored;
-        }
-      }
-    }
-    args.push_back(toPass);
-  }
+  raw = replaceHexColors(raw);
+  if (raw.find("\033[") != std::string::npos)
+    raw += "\033[0m";
 
-  return B.CreateCall(printfF, args, "printf.ret");
+  StdoutWriter out(B, ctx, M);
+  emitPrintfPieces(raw, out, ctx, B, vars);
+  return out.finish();
 }
 
 Value *PrintEmitter::handlePrint(const CallExpr &e, IRBuilder<> &B,
                                  LLVMContext &ctx, Module *M) {
   (void)ctx;
-  auto *strArg = dynamic_cast<const StrLitExpr *>(e.arguments[0].get());
+  auto *strArg = dyn_cast<StrLitExpr>(e.arguments[0].get());
   if (!strArg)
     return nullptr;
 
@@ -193,7 +215,8 @@ Value *PrintEmitter::handlePrint(const CallExpr &e, IRBuilder<> &B,
   if (!printfF)
     return nullptr;
 
-  std::string fmt = strArg->lit.getWord() + "\n";
+  std::string fmt(strArg->lit.getWord());
+  fmt += "\n";
   Value *fmtPtr = B.CreateGlobalString(fmt, ".fmt");
   return B.CreateCall(printfF, {fmtPtr}, "printf.ret");
 }
@@ -7,7 +7,6 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Value.h"
-#include <map>
 #include <string>
 
 // ------------------------------------------------------------------------ //
@@ -15,9 +14,14 @@
 // ------------------------------------------------------------------------ //
 class PrintEmitter {
 public:
+  // Printf("text {name} ...") becomes one write per run of text and per
+  // interpolated value: fwrite for text and strings (whose length is known),
+  // digits formatted in place for integers, fputc for chars. Nothing parses
+  // a format string at run time. How often stdout reaches the terminal is
+  // set by --output-buffer (see BuiltinEmitter::emitRuntimeInit).
   static llvm::Value *handlePrintf(const CallExpr &e, llvm::IRBuilder<> &B,
                                    llvm::LLVMContext &ctx, llvm::Module *M,
-                                   const std::map<std::string, VarInfo> &vars);
+                                   const VarTable &vars);
 
   static llvm::Value *handlePrint(const CallExpr &e, llvm::IRBuilder<> &B,
                                   llvm::LLVMContext &ctx, llvm::Module *M);
@@ -25,6 +29,7 @@ public:
   // ------------------------------------- //
   // Colour helpers (used by handlePrintf) //
   // ------------------------------------- //
+  // #rrggbb becomes the ANSI escape for that foreground colour.
   static std::string hexToAnsi(const std::string &hex);
   static std::string replaceHexColors(const std::string &input);
 };
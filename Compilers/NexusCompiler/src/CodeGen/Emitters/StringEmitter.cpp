@@ -3,14 +3,97 @@
 #include "../TypeResolver.h"
 #include "llvm/IR/Verifier.h"
 
+namespace {
+
+// String temporaries and formatting buffers live in the entry block, so that
+// string code inside a loop does not grow the stack on every iteration.
+// Unnamed for the same reason as CodeGenerator::createEntryAlloca.
+llvm::AllocaInst *entryAlloca(llvm::IRBuilder<> &B, llvm::Type *ty) {
+  llvm::Function *fn = B.GetInsertBlock()->getParent();
+  llvm::BasicBlock &entry = fn->getEntryBlock();
+  llvm::IRBuilder<> tmpB(&entry, entry.begin());
+  return tmpB.CreateAlloca(ty, nullptr, "");
+}
+
+llvm::AllocaInst *entryBuffer(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                              unsigned size) {
+  return entryAlloca(B,
+                     llvm::ArrayType::get(llvm::Type::getInt8Ty(ctx), size));
+}
+
+// ptr nexus.fmt.i64(ptr end, i64 v): writes the decimal digits of v, and a
+// leading '-' if it is negative, so that they finish just before `end`, and
+// returns where they start. At most 20 bytes are written.
+llvm::Function *formatI64Fn(llvm::Module *M, llvm::LLVMContext &ctx) {
+  const char *name = "nexus.fmt.i64";
+  if (llvm::Function *f = M->getFunction(name))
+    return f;
+
+  llvm::Type *i8 = llvm::Type::getInt8Ty(ctx);
+  llvm::Type *i64 = llvm::Type::getInt64Ty(ctx);
+  llvm::Type *ptrTy = llvm::PointerType::get(ctx, 0);
+  llvm::Function *f = llvm::Function::Create(
+      llvm::FunctionType::get(ptrTy, {ptrTy, i64}, false),
+      llvm::Function::InternalLinkage, name, M);
+  f->addFnAttr(llvm::Attribute::NoUnwind);
+  llvm::Value *end = f->getArg(0);
+  llvm::Value *v = f->getArg(1);
+
+  llvm::BasicBlock *entryBB = llvm::BasicBlock::Create(ctx, "entry", f);
+  llvm::BasicBlock *loopBB = llvm::BasicBlock::Create(ctx, "digit", f);
+  llvm::BasicBlock *doneBB = llvm::BasicBlock::Create(ctx, "sign", f);
+  llvm::IRBuilder<> b(entryBB);
+
+  // 0 - INT64_MIN wraps to itself, which is the right magnitude unsigned.
+  llvm::Value *neg = b.CreateICmpSLT(v, llvm::ConstantInt::get(i64, 0), "neg");
+  llvm::Value *mag = b.CreateSelect(neg, b.CreateNeg(v), v, "mag");
+  b.CreateBr(loopBB);
+
+  b.SetInsertPoint(loopBB);
+  llvm::PHINode *pos = b.CreatePHI(ptrTy, 2, "pos");
+  llvm::PHINode *rest = b.CreatePHI(i64, 2, "rest");
+  llvm::Value *ten = llvm::ConstantInt::get(i64, 10);
+  llvm::Value *quot = b.CreateUDiv(rest, ten, "quot");
+  llvm::Value *digit = b.CreateSub(rest, b.CreateMul(quot, ten));
+  llvm::Value *next = b.CreateGEP(i8, pos, llvm::ConstantInt::get(i64, -1));
+  b.CreateStore(b.CreateAdd(b.CreateTrunc(digit, i8),
+                            llvm::ConstantInt::get(i8, '0')),
+                next);
+  pos->addIncoming(end, entryBB);
+  pos->addIncoming(next, loopBB);
+  rest->addIncoming(mag, entryBB);
+  rest->addIncoming(quot, loopBB);
+  b.CreateCondBr(b.CreateICmpNE(quot, llvm::ConstantInt::get(i64, 0)), loopBB,
+                 doneBB);
+
+  // There is always room for the sign: 19 digits at most, 20 bytes.
+  b.SetInsertPoint(doneBB);
+  llvm::Value *signPos = b.CreateGEP(i8, next, llvm::ConstantInt::get(i64, -1));
+  b.CreateStore(llvm::ConstantInt::get(i8, '-'), signPos);
+  b.CreateRet(b.CreateSelect(neg, signPos, next, "start"));
+  return f;
+}
+
+// A %string operand arrives either as the address of one or, from a call,
+// as the value itself.
+llvm::Value *loadString(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                        llvm::Value *str, const char *name) {
+  if (!str->getType()->isPointerTy())
+    return str;
+  return B.CreateLoad(TypeResolver::getStringType(ctx), str, name);
+}
+
+} // namespace
+
 // Public
 llvm::Value *StringOps::fromLiteral(llvm::IRBuilder<> &B,
                                     llvm::LLVMContext &ctx, llvm::Module *M,
                                     const std::string &literal) {
+  llvm::Type *i64 = llvm::Type::getInt64Ty(ctx);
   llvm::Value *ptr = B.CreateGlobalString(literal, "strl");
-  llvm::Value *len =
-      llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), literal.size());
-  return fromParts(B, ctx, M, ptr, len);
+  return fromRawParts(B, ctx, M, ptr,
+                      llvm::ConstantInt::get(i64, literal.size()),
+                      llvm::ConstantInt::get(i64, 0));
 }
 
 llvm::Value *StringOps::fromParts(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
@@ -26,7 +109,7 @@ llvm::Value *StringOps::fromParts(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
   B.CreateStore(llvm::ConstantInt::get(llvm::Type::getInt8Ty(ctx), 0), nullPos);
 
   llvm::StructType *st = TypeResolver::getStringType(ctx);
-  llvm::AllocaInst *s = B.CreateAlloca(st, nullptr, "string");
+  llvm::AllocaInst *s = entryAlloca(B, st);
   B.CreateStore(mem, B.CreateStructGEP(st, s, 0));
   B.CreateStore(length, B.CreateStructGEP(st, s, 1));
   B.CreateStore(cap, B.CreateStructGEP(st, s, 2));
@@ -37,8 +120,8 @@ llvm::Value *StringOps::concat(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                                llvm::Module *M, llvm::Value *leftStruct,
                                llvm::Value *rightStruct) {
   llvm::StructType *st = TypeResolver::getStringType(ctx);
-  llvm::Value *lv = B.CreateLoad(st, leftStruct, "ls");
-  llvm::Value *rv = B.CreateLoad(st, rightStruct, "rs");
+  llvm::Value *lv = loadString(B, ctx, leftStruct, "ls");
+  llvm::Value *rv = loadString(B, ctx, rightStruct, "rs");
   llvm::Value *ld = B.CreateExtractValue(lv, {0}, "ld");
   llvm::Value *ll = B.CreateExtractValue(lv, {1}, "ll");
   llvm::Value *rd = B.CreateExtractValue(rv, {0}, "rd");
@@ -56,13 +139,108 @@ llvm::Value *StringOps::concat(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
   llvm::Value *null = B.CreateGEP(llvm::Type::getInt8Ty(ctx), mem, total);
   B.CreateStore(llvm::ConstantInt::get(llvm::Type::getInt8Ty(ctx), 0), null);
 
-  llvm::AllocaInst *res = B.CreateAlloca(st, nullptr, "cat.res");
+  llvm::AllocaInst *res = entryAlloca(B, st);
+  B.CreateStore(mem, B.CreateStructGEP(st, res, 0));
+  B.CreateStore(total, B.CreateStructGEP(st, res, 1));
+  B.CreateStore(cap, B.CreateStructGEP(st, res, 2));
+  return res;
+}
+
+llvm::Value *StringOps::concatAll(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                                  llvm::Module *M,
+                                  llvm::ArrayRef<llvm::Value *> parts) {
+  llvm::StructType *st = TypeResolver::getStringType(ctx);
+  llvm::Type *i8 = llvm::Type::getInt8Ty(ctx);
+  llvm::Type *i64 = llvm::Type::getInt64Ty(ctx);
+
+  std::vector<llvm::Value *> data, lens;
+  llvm::Value *total = llvm::ConstantInt::get(i64, 0);
+  for (llvm::Value *p : parts) {
+    llvm::Value *v = loadString(B, ctx, p, "part");
+    data.push_back(B.CreateExtractValue(v, {0}, "part.data"));
+    lens.push_back(B.CreateExtractValue(v, {1}, "part.len"));
+    total = B.CreateAdd(total, lens.back(), "tlen");
+  }
+  llvm::Value *cap = B.CreateAdd(total, llvm::ConstantInt::get(i64, 1), "tcap");
+  llvm::Value *mem = B.CreateCall(RTDecl::malloc_(M, ctx), {cap}, "cat.alloc");
+
+  llvm::Function *mc = RTDecl::memcpy_(M, ctx);
+  llvm::Value *at = mem;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    B.CreateCall(mc, {at, data[i], lens[i], llvm::ConstantInt::getFalse(ctx)});
+    at = B.CreateGEP(i8, at, lens[i]);
+  }
+  B.CreateStore(llvm::ConstantInt::get(i8, 0), at);
+
+  llvm::AllocaInst *res = entryAlloca(B, st);
   B.CreateStore(mem, B.CreateStructGEP(st, res, 0));
   B.CreateStore(total, B.CreateStructGEP(st, res, 1));
   B.CreateStore(cap, B.CreateStructGEP(st, res, 2));
   return res;
 }
 
+void StringOps::append(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                       llvm::Module *M, llvm::Value *dst, llvm::Value *src) {
+  llvm::StructType *st = TypeResolver::getStringType(ctx);
+  llvm::Type *i8 = llvm::Type::getInt8Ty(ctx);
+  llvm::Type *i64 = llvm::Type::getInt64Ty(ctx);
+
+  llvm::Value *dv = B.CreateLoad(st, dst, "app.dst");
+  llvm::Value *sv = loadString(B, ctx, src, "app.src");
+  llvm::Value *dd = B.CreateExtractValue(dv, {0}, "app.dd");
+  llvm::Value *dl = B.CreateExtractValue(dv, {1}, "app.dl");
+  llvm::Value *dc = B.CreateExtractValue(dv, {2}, "app.dc");
+  llvm::Value *sd = B.CreateExtractValue(sv, {0}, "app.sd");
+  llvm::Value *sl = B.CreateExtractValue(sv, {1}, "app.sl");
+
+  llvm::Value *len = B.CreateAdd(dl, sl, "app.len");
+  llvm::Value *need = B.CreateAdd(len, llvm::ConstantInt::get(i64, 1));
+  llvm::Value *owned = ownsBuffer(B, dv);
+  llvm::Value *fits = B.CreateAnd(owned, B.CreateICmpULE(need, dc), "app.fits");
+
+  llvm::Function *fn = B.GetInsertBlock()->getParent();
+  llvm::BasicBlock *fromBB = B.GetInsertBlock();
+  llvm::BasicBlock *growBB = llvm::BasicBlock::Create(ctx, "app.grow", fn);
+  llvm::BasicBlock *copyBB = llvm::BasicBlock::Create(ctx, "app.copy", fn);
+  B.CreateCondBr(fits, copyBB, growBB);
+
+  // A static, borrowed or moved-from buffer is not ours to realloc: start a
+  // new one (realloc of null) and copy the old text over; an owned one keeps
+  // its bytes. If src is dst, its data moves along with the buffer. Only a
+  // buffer that has already grown doubles; the first one is sized to fit.
+  B.SetInsertPoint(growBB);
+  llvm::Value *twice = B.CreateShl(dc, 1, "app.twice");
+  llvm::Value *grown = B.CreateSelect(B.CreateICmpUGT(twice, need), twice,
+                                      need, "app.grown");
+  llvm::Value *cap = B.CreateSelect(owned, grown, need, "app.cap");
+  llvm::Value *ptrNull = llvm::ConstantPointerNull::get(
+      llvm::cast<llvm::PointerType>(dd->getType()));
+  llvm::Value *old = B.CreateSelect(owned, dd, ptrNull);
+  llvm::Value *mem =
+      B.CreateCall(RTDecl::realloc_(M, ctx), {old, cap}, "app.alloc");
+  llvm::Value *keep = B.CreateSelect(owned, llvm::ConstantInt::get(i64, 0), dl);
+  B.CreateCall(RTDecl::memcpy_(M, ctx),
+               {mem, dd, keep, llvm::ConstantInt::getFalse(ctx)});
+  llvm::Value *movedSd =
+      B.CreateSelect(B.CreateICmpEQ(sd, dd), mem, sd, "app.sd.moved");
+  B.CreateStore(mem, B.CreateStructGEP(st, dst, 0));
+  B.CreateStore(cap, B.CreateStructGEP(st, dst, 2));
+  B.CreateBr(copyBB);
+
+  B.SetInsertPoint(copyBB);
+  llvm::PHINode *data = B.CreatePHI(dd->getType(), 2, "app.data");
+  data->addIncoming(dd, fromBB);
+  data->addIncoming(mem, growBB);
+  llvm::PHINode *from = B.CreatePHI(sd->getType(), 2, "app.from");
+  from->addIncoming(sd, fromBB);
+  from->addIncoming(movedSd, growBB);
+  B.CreateCall(RTDecl::memcpy_(M, ctx),
+               {B.CreateGEP(i8, data, dl), from, sl,
+                llvm::ConstantInt::getFalse(ctx)});
+  B.CreateStore(llvm::ConstantInt::get(i8, 0), B.CreateGEP(i8, data, len));
+  B.CreateStore(len, B.CreateStructGEP(st, dst, 1));
+}
+
 llvm::Value *StringOps::equals(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                                llvm::Module *M, llvm::Value *lhs,
                                llvm::Value *rhs) {
@@ -74,25 +252,74 @@ llvm::Value *StringOps::equals(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
 
   llvm::Value *ld = B.CreateExtractValue(lv, {0}, "eq.ld");
   llvm::Value *rd = B.CreateExtractValue(rv, {0}, "eq.rd");
+  llvm::Value *ll = B.CreateExtractValue(lv, {1}, "eq.ll");
+  llvm::Value *rl = B.CreateExtractValue(rv, {1}, "eq.rl");
 
-  llvm::Function *strcmpFn = RTDecl::strcmp_(M, ctx);
-
-  llvm::Value *cmp = B.CreateCall(strcmpFn, {ld, rd}, "strcmp");
+  // Strings of different lengths compare zero bytes, so the shorter one is
+  // never read past its end.
+  llvm::Value *sameLen = B.CreateICmpEQ(ll, rl, "eq.len");
+  llvm::Value *n = B.CreateSelect(
+      sameLen, ll, llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 0));
+  llvm::Value *cmp = B.CreateCall(RTDecl::memcmp_(M, ctx), {ld, rd, n},
+                                  "memcmp");
+  llvm::Value *sameBytes = B.CreateICmpEQ(
+      cmp, llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), 0));
+  return B.CreateAnd(sameLen, sameBytes, "streq");
+}
 
-  return B.CreateICmpEQ(
-      cmp, llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), 0), "streq");
+// A malloc'd, NUL-terminated copy of len bytes at data; returns {mem, cap}.
+static std::pair<llvm::Value *, llvm::Value *>
+copyBytes(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx, llvm::Module *M,
+          llvm::Value *data, llvm::Value *len) {
+  llvm::Type *i64 = llvm::Type::getInt64Ty(ctx);
+  llvm::Type *i8 = llvm::Type::getInt8Ty(ctx);
+  llvm::Value *cap = B.CreateAdd(len, llvm::ConstantInt::get(i64, 1), "cap");
+  llvm::Value *mem = B.CreateCall(RTDecl::malloc_(M, ctx), {cap}, "str.alloc");
+  B.CreateCall(RTDecl::memcpy_(M, ctx),
+               {mem, data, len, llvm::ConstantInt::getFalse(ctx)});
+  B.CreateStore(llvm::ConstantInt::get(i8, 0), B.CreateGEP(i8, mem, len));
+  return {mem, cap};
 }
+
 llvm::Value *StringOps::clone(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                               llvm::Module *M, llvm::Value *strStruct) {
 
   llvm::StructType *st = TypeResolver::getStringType(ctx);
+  llvm::Type *i64 = llvm::Type::getInt64Ty(ctx);
 
   llvm::Value *val = B.CreateLoad(st, strStruct, "clone.src");
 
   llvm::Value *data = B.CreateExtractValue(val, {0}, "clone.data");
   llvm::Value *len = B.CreateExtractValue(val, {1}, "clone.len");
+  llvm::Value *srcCap = B.CreateExtractValue(val, {2}, "clone.srccap");
+  llvm::AllocaInst *res = entryAlloca(B, st);
+
+  // Only static data may be shared: owned buffers and views are copied.
+  llvm::Value *shared = B.CreateOr(B.CreateIsNull(data),
+                                   B.CreateIsNull(srcCap), "clone.shared");
+
+  llvm::Function *fn = B.GetInsertBlock()->getParent();
+  llvm::BasicBlock *fromBB = B.GetInsertBlock();
+  llvm::BasicBlock *copyBB = llvm::BasicBlock::Create(ctx, "clone.copy", fn);
+  llvm::BasicBlock *doneBB = llvm::BasicBlock::Create(ctx, "clone.done", fn);
+  B.CreateCondBr(shared, doneBB, copyBB);
+
+  B.SetInsertPoint(copyBB);
+  auto [mem, cap] = copyBytes(B, ctx, M, data, len);
+  B.CreateBr(doneBB);
+
+  B.SetInsertPoint(doneBB);
+  llvm::PHINode *outData = B.CreatePHI(data->getType(), 2, "clone.out");
+  outData->addIncoming(data, fromBB);
+  outData->addIncoming(mem, copyBB);
+  llvm::PHINode *outCap = B.CreatePHI(i64, 2, "clone.cap");
+  outCap->addIncoming(llvm::ConstantInt::get(i64, 0), fromBB);
+  outCap->addIncoming(cap, copyBB);
 
-  return fromParts(B, ctx, M, data, len);
+  B.CreateStore(outData, B.CreateStructGEP(st, res, 0));
+  B.CreateStore(len, B.CreateStructGEP(st, res, 1));
+  B.CreateStore(outCap, B.CreateStructGEP(st, res, 2));
+  return res;
 }
 
 llvm::Value *StringOps::fromValue(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
@@ -112,7 +339,7 @@ llvm::Value *StringOps::fromValue(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
   if (ty->isIntegerTy(1))
     return boolToStr(B, ctx, M, val);
   if (ty->isIntegerTy(8))
-    return intToStr(B, ctx, M, val, true);
+    return charToStr(B, ctx, M, val);
   if (ty->isIntegerTy())
     return intToStr(B, ctx, M, val);
   if (ty->isFloatingPointTy())
@@ -122,45 +349,71 @@ llvm::Value *StringOps::fromValue(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
 
 // Private
 
-llvm::Value *StringOps::intToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
-                                 llvm::Module *M, llvm::Value *v,
-                                 bool charAsAscii) {
+std::pair<llvm::Value *, llvm::Value *>
+StringOps::formatInt(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                     llvm::Module *M, llvm::Value *v) {
+  llvm::Type *i64 = llvm::Type::getInt64Ty(ctx);
   if (v->getType()->getIntegerBitWidth() < 64)
-    v = B.CreateSExt(v, llvm::Type::getInt64Ty(ctx));
-
-  if (charAsAscii) {
-    auto *buf =
-        B.CreateAlloca(llvm::ArrayType::get(llvm::Type::getInt8Ty(ctx), 2));
-    B.CreateStore(B.CreateTrunc(v, llvm::Type::getInt8Ty(ctx)), buf);
-    llvm::Value *nullPos =
-        B.CreateGEP(llvm::Type::getInt8Ty(ctx), buf,
-                    llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 1));
-    B.CreateStore(llvm::ConstantInt::get(llvm::Type::getInt8Ty(ctx), 0),
-                  nullPos);
-    return fromParts(B, ctx, M, buf,
-                     llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 1));
-  }
+    v = B.CreateSExt(v, i64);
 
-  llvm::Value *fmt = B.CreateGlobalString("%lld", "ifmt");
-  auto *buf = B.CreateAlloca(
-      llvm::ArrayType::get(llvm::Type::getInt8Ty(ctx), 32), nullptr, "ibuf");
-  B.CreateCall(RTDecl::sprintf_(M, ctx), {buf, fmt, v});
-  llvm::Value *len = B.CreateCall(RTDecl::strlen_(M, ctx), {buf}, "il");
-  return fromParts(B, ctx, M, buf, len);
+  llvm::Value *buf = entryBuffer(B, ctx, 20);
+  llvm::Value *end = B.CreateGEP(llvm::Type::getInt8Ty(ctx), buf,
+                                 llvm::ConstantInt::get(i64, 20), "ibuf.end");
+  llvm::Value *start = B.CreateCall(formatI64Fn(M, ctx), {end, v}, "idigits");
+  llvm::Value *len = B.CreateSub(B.CreatePtrToInt(end, i64),
+                                 B.CreatePtrToInt(start, i64), "il");
+  return {start, len};
 }
 
-llvm::Value *StringOps::floatToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
-                                   llvm::Module *M, llvm::Value *v) {
+std::pair<llvm::Value *, llvm::Value *>
+StringOps::formatFloat(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                       llvm::Module *M, llvm::Value *v) {
   if (v->getType()->isFloatTy())
     v = B.CreateFPExt(v, llvm::Type::getDoubleTy(ctx));
   llvm::Value *fmt = B.CreateGlobalString("%g", "ffmt");
-  auto *buf = B.CreateAlloca(
-      llvm::ArrayType::get(llvm::Type::getInt8Ty(ctx), 64), nullptr, "fbuf");
-  B.CreateCall(RTDecl::sprintf_(M, ctx), {buf, fmt, v});
-  llvm::Value *len = B.CreateCall(RTDecl::strlen_(M, ctx), {buf}, "fl");
+  llvm::Value *buf = entryBuffer(B, ctx, 64);
+  llvm::Value *n = B.CreateCall(RTDecl::sprintf_(M, ctx), {buf, fmt, v});
+  return {buf, B.CreateZExt(n, llvm::Type::getInt64Ty(ctx), "fl")};
+}
+
+llvm::Value *StringOps::intToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                                 llvm::Module *M, llvm::Value *v) {
+  auto [start, len] = formatInt(B, ctx, M, v);
+  return fromParts(B, ctx, M, start, len);
+}
+
+llvm::Value *StringOps::floatToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                                   llvm::Module *M, llvm::Value *v) {
+  auto [buf, len] = formatFloat(B, ctx, M, v);
   return fromParts(B, ctx, M, buf, len);
 }
 
+// Every one-character string lives in a static table of NUL-terminated
+// pairs, so a char converts without allocating.
+llvm::Value *StringOps::charToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                                  llvm::Module *M, llvm::Value *v) {
+  const char *name = "nexus.chars";
+  llvm::GlobalVariable *table = M->getNamedGlobal(name);
+  if (!table) {
+    std::vector<uint8_t> pairs(512, 0);
+    for (unsigned c = 0; c < 256; ++c)
+      pairs[2 * c] = c;
+    llvm::Constant *init =
+        llvm::ConstantDataArray::get(ctx, llvm::ArrayRef<uint8_t>(pairs));
+    table = new llvm::GlobalVariable(*M, init->getType(), true,
+                                     llvm::GlobalValue::PrivateLinkage, init,
+                                     name);
+    table->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+  }
+
+  llvm::Type *i64 = llvm::Type::getInt64Ty(ctx);
+  llvm::Value *slot = B.CreateShl(B.CreateZExt(v, i64), 1, "chr.slot");
+  llvm::Value *data =
+      B.CreateGEP(llvm::Type::getInt8Ty(ctx), table, slot, "chr.str");
+  return fromRawParts(B, ctx, M, data, llvm::ConstantInt::get(i64, 1),
+                      llvm::ConstantInt::get(i64, 0));
+}
+
 llvm::Value *StringOps::boolToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                                   llvm::Module *M, llvm::Value *v) {
   llvm::Value *trueStr = fromLiteral(B, ctx, M, "true");
@@ -168,13 +421,68 @@ llvm::Value *StringOps::boolToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
   return B.CreateSelect(v, trueStr, falseStr, "bool.str");
 }
 
+llvm::Value *StringOps::ownsBuffer(llvm::IRBuilder<> &B, llvm::Value *str) {
+  llvm::Value *data = B.CreateExtractValue(str, {0}, "str.data");
+  llvm::Value *cap = B.CreateExtractValue(str, {2}, "str.cap");
+  llvm::Value *isNull = B.CreateIsNull(data, "is.null");
+  llvm::Value *isHeap = B.CreateICmpSGT(
+      cap, llvm::ConstantInt::get(cap->getType(), 0), "is.heap");
+  return B.CreateAnd(B.CreateNot(isNull), isHeap, "owns.buf");
+}
+
+void StringOps::makeView(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                         llvm::Value *strPtr) {
+  llvm::StructType *st = TypeResolver::getStringType(ctx);
+  B.CreateStore(llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), -1, true),
+                B.CreateStructGEP(st, strPtr, 2));
+}
+
+void StringOps::detach(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                       llvm::Module *M, llvm::Value *strPtr) {
+  llvm::StructType *st = TypeResolver::getStringType(ctx);
+  llvm::Value *str = B.CreateLoad(st, strPtr, "str.view");
+  llvm::Value *data = B.CreateExtractValue(str, {0}, "view.data");
+  llvm::Value *cap = B.CreateExtractValue(str, {2}, "view.cap");
+  llvm::Value *isView = B.CreateAnd(
+      B.CreateIsNotNull(data),
+      B.CreateICmpSLT(cap, llvm::ConstantInt::get(cap->getType(), 0)),
+      "is.view");
+
+  llvm::Function *fn = B.GetInsertBlock()->getParent();
+  llvm::BasicBlock *copyBB = llvm::BasicBlock::Create(ctx, "view.copy", fn);
+  llvm::BasicBlock *doneBB = llvm::BasicBlock::Create(ctx, "view.done", fn);
+  B.CreateCondBr(isView, copyBB, doneBB);
+  B.SetInsertPoint(copyBB);
+  auto [mem, newCap] =
+      copyBytes(B, ctx, M, data, B.CreateExtractValue(str, {1}, "view.len"));
+  B.CreateStore(mem, B.CreateStructGEP(st, strPtr, 0));
+  B.CreateStore(newCap, B.CreateStructGEP(st, strPtr, 2));
+  B.CreateBr(doneBB);
+  B.SetInsertPoint(doneBB);
+}
+
+void StringOps::release(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                        llvm::Module *M, llvm::Value *strPtr) {
+  llvm::StructType *st = TypeResolver::getStringType(ctx);
+  llvm::Value *str = B.CreateLoad(st, strPtr, "str.old");
+
+  llvm::Function *fn = B.GetInsertBlock()->getParent();
+  llvm::BasicBlock *freeBB = llvm::BasicBlock::Create(ctx, "str.free", fn);
+  llvm::BasicBlock *skipBB = llvm::BasicBlock::Create(ctx, "str.skip", fn);
+  B.CreateCondBr(ownsBuffer(B, str), freeBB, skipBB);
+  B.SetInsertPoint(freeBB);
+  B.CreateCall(RTDecl::free_(M, ctx), {B.CreateExtractValue(str, {0})});
+  B.CreateBr(skipBB);
+  B.SetInsertPoint(skipBB);
+}
+
 // StringEmitter.cpp
 llvm::Value *StringOps::fromRawParts(llvm::IRBuilder<> &B,
                                      llvm::LLVMContext &ctx, llvm::Module *M,
                                      llvm::Value *data, llvm::Value *len,
                                      llvm::Value *cap) {
   llvm::StructType *strTy = TypeResolver::getStringType(ctx);
-  llvm::AllocaInst *s = B.CreateAlloca(strTy, nullptr);
+  llvm::AllocaInst *s = entryAlloca(B, strTy);
   B.CreateStore(data, B.CreateStructGEP(strTy, s, 0));
   B.CreateStore(len, B.CreateStructGEP(strTy, s, 1));
   B.CreateStore(cap, B.CreateStructGEP(strTy, s, 2));
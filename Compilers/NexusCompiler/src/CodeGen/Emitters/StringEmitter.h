@@ -1,6 +1,7 @@
 #ifndef STRING_EMITTER_H
 #define STRING_EMITTER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
@@ -8,9 +9,17 @@
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Value.h>
 #include <memory>
+#include <utility>
 
+// A string is %string = {ptr data, i64 len, i64 cap}. data is always
+// NUL-terminated. cap == 0 marks data in static storage (a literal or a
+// formatted constant), which is never freed or written and can be shared.
+// cap == -1 marks a view of a buffer someone else owns (a parameter, say):
+// it is read in place but copied by anything that keeps it. Anything else
+// is a malloc'd buffer of cap bytes.
 class StringOps {
 public:
+  // A non-owning string over the interned literal; allocates nothing.
   static llvm::Value *fromLiteral(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                                   llvm::Module *M, const std::string &literal);
 
@@ -22,12 +31,27 @@ public:
                              llvm::Module *M, llvm::Value *leftStruct,
                              llvm::Value *rightStruct);
 
+  // a + b + ... in one allocation sized for the whole result.
+  static llvm::Value *concatAll(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                                llvm::Module *M,
+                                llvm::ArrayRef<llvm::Value *> parts);
+
+  // dst += src in place. A heap buffer with room is written into; otherwise
+  // the buffer grows to at least twice its capacity, so a run of appends
+  // costs amortised linear time. src may be dst itself. When dst does not
+  // own its buffer (see ownsBuffer) it gets a new one sized for the result,
+  // which dst then owns.
+  static void append(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                     llvm::Module *M, llvm::Value *dst, llvm::Value *src);
+
   static llvm::Value *fromValue(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                                 llvm::Module *M, llvm::Value *val);
 
+  // An owned copy of a heap string or view; static strings are shared.
   static llvm::Value *clone(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                             llvm::Module *M, llvm::Value *strStruct);
 
+  // Compares lengths first and the bytes only when they match.
   static llvm::Value *equals(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                              llvm::Module *M, llvm::Value *lhs,
                              llvm::Value *rhs);
@@ -36,14 +60,43 @@ public:
                                    llvm::Module *M, llvm::Value *data,
                                    llvm::Value *len, llvm::Value *cap);
 
+  // i1: whether the loaded %string value str holds a buffer to free.
+  static llvm::Value *ownsBuffer(llvm::IRBuilder<> &B, llvm::Value *str);
+
+  // Turns the %string at strPtr into a view of its buffer (capacity -1): it
+  // is still read, but never freed or grown in place.
+  static void makeView(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                       llvm::Value *strPtr);
+
+  // Replaces a view at strPtr with an owned copy, so it can outlive the
+  // buffer it was viewing (e.g. when returned). Other strings are untouched.
+  static void detach(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                     llvm::Module *M, llvm::Value *strPtr);
+
+  // Frees the buffer of the %string at strPtr if it owns one.
+  static void release(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                      llvm::Module *M, llvm::Value *strPtr);
+
+  // Decimal text of an integer or %g text of a float in a stack buffer of
+  // the current function, with no allocation. Returns {first byte, length};
+  // the text is not NUL-terminated.
+  static std::pair<llvm::Value *, llvm::Value *>
+  formatInt(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx, llvm::Module *M,
+            llvm::Value *v);
+  static std::pair<llvm::Value *, llvm::Value *>
+  formatFloat(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx, llvm::Module *M,
+              llvm::Value *v);
+
 private:
   static llvm::Value *intToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
-                               llvm::Module *M, llvm::Value *v,
-                               bool charAsAscii = false);
+                               llvm::Module *M, llvm::Value *v);
 
   static llvm::Value *floatToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                                  llvm::Module *M, llvm::Value *v);
 
+  static llvm::Value *charToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
+                                llvm::Module *M, llvm::Value *v);
+
   static llvm::Value *boolToStr(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx,
                                 llvm::Module *M, llvm::Value *v);
 };
@@ -0,0 +1,306 @@
+#include "BoundsManager.h"
+#include "../Emitters/ArrayEmitter.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
+
+using namespace llvm;
+
+namespace {
+
+// Value of a small non-negative integer literal, or -1. Small enough to fit
+// every integer type a loop variable can have.
+int smallLiteral(const Expression *e) {
+  auto *lit = e ? dyn_cast<IntLitExpr>(e) : nullptr;
+  if (!lit)
+    return -1;
+  std::string_view w = lit->lit.getWord();
+  if (w.empty() || w.size() > 3)
+    return -1;
+  int v = 0;
+  for (char c : w) {
+    if (c < '0' || c > '9')
+      return -1;
+    v = v * 10 + (c - '0');
+  }
+  return v <= 127 ? v : -1;
+}
+
+// Whether a loop body leaves the array and the loop variable alone: neither
+// is declared again, assigned or mutably borrowed, and the array is only
+// ever subscripted or measured, never used as a whole value. Anything not
+// understood counts as interference.
+class BodyScan {
+public:
+  BodyScan(Symbol index, Symbol array) : index_(index), array_(array) {}
+
+  bool block(const Block *b) {
+    if (!b)
+      return true;
+    for (const auto &s : b->statements)
+      if (!stmt(*s))
+        return false;
+    return true;
+  }
+
+private:
+  Symbol index_;
+  Symbol array_;
+
+  bool binds(Symbol s) const { return s == index_ || s == array_; }
+
+  bool exprs(const std::vector<ExprPtr> &es) {
+    for (const auto &e : es)
+      if (!expr(e.get()))
+        return false;
+    return true;
+  }
+
+  bool stmt(const Statement &s) {
+    switch (s.getKind()) {
+    case StmtKind::VarDecl: {
+      auto &d = cast<VarDecl>(s);
+      return !binds(d.name.symbol()) && expr(d.initializer.get());
+    }
+    case StmtKind::If: {
+      auto &i = cast<IfStmt>(s);
+      return expr(i.condition.get()) && block(i.thenBranch.get()) &&
+             block(i.elseBranch.get());
+    }
+    case StmtKind::While: {
+      auto &w = cast<WhileStmt>(s);
+      return expr(w.condition.get()) && block(w.doBranch.get());
+    }
+    case StmtKind::ForRange: {
+      auto &f = cast<ForRangeStmt>(s);
+      return !binds(f.varName.symbol()) && expr(f.start.get()) &&
+             expr(f.end.get()) && expr(f.step.get()) && block(f.body.get());
+    }
+    case StmtKind::ForEach: {
+      auto &f = cast<ForEachStmt>(s);
+      return !binds(f.varName.symbol()) && expr(f.iterable.get()) &&
+             block(f.body.get());
+    }
+    case StmtKind::Return: {
+      auto &r = cast<Return>(s);
+      return !r.value || expr(r.value->get());
+    }
+    case StmtKind::Expr:
+      return expr(cast<ExprStmt>(s).expr.get());
+    case StmtKind::Match: {
+      auto &m = cast<MatchStmt>(s);
+      if (!expr(m.subject.get()))
+        return false;
+      for (const auto &arm : m.arms) {
+        for (const auto &b : arm.bindings)
+          if (binds(b.symbol()))
+            return false;
+        if (!block(arm.body.get()))
+          return false;
+      }
+      return true;
+    }
+    case StmtKind::Break:
+    case StmtKind::Continue:
+    case StmtKind::Error:
+      return true;
+    }
+    return false;
+  }
+
+  bool expr(const Expression *e) {
+    if (!e)
+      return true;
+    switch (e->getKind()) {
+    case ExprKind::IntLit:
+    case ExprKind::FloatLit:
+    case ExprKind::StrLit:
+    case ExprKind::BoolLit:
+    case ExprKind::CharLit:
+    case ExprKind::NullLit:
+    case ExprKind::Error:
+      return true;
+    case ExprKind::Ident:
+      return cast<IdentExpr>(e)->name.symbol() != array_;
+    case ExprKind::BorrowArg:
+      return true;
+    case ExprKind::BorrowMutArg:
+      return !binds(cast<BorrowMutArgExpr>(e)->name.symbol());
+    case ExprKind::Binary: {
+      auto *b = cast<BinaryExpr>(e);
+      return expr(b->left.get()) && expr(b->right.get());
+    }
+    case ExprKind::ChainedCmp:
+      return exprs(cast<ChainedCmpExpr>(e)->operands);
+    case ExprKind::Unary:
+      return expr(cast<UnaryExpr>(e)->operand.get());
+    case ExprKind::Cast:
+      return expr(cast<CastExpr>(e)->expr.get());
+    case ExprKind::Call: {
+      auto *c = cast<CallExpr>(e);
+      return expr(c->callee.get()) && exprs(c->arguments);
+    }
+    case ExprKind::GenericCall:
+      return exprs(cast<GenericCallExpr>(e)->arguments);
+    case ExprKind::Assign: {
+      auto *a = cast<AssignExpr>(e);
+      return !binds(a->target.symbol()) && expr(a->value.get());
+    }
+    case ExprKind::Increment:
+      return !binds(cast<Increment>(e)->target.symbol());
+    case ExprKind::Decrement:
+      return !binds(cast<Decrement>(e)->target.symbol());
+    case ExprKind::CompoundAssign: {
+      auto *a = cast<CompoundAssignExpr>(e);
+      return !binds(a->target.symbol()) && expr(a->value.get());
+    }
+    case ExprKind::NewArray:
+      return exprs(cast<NewArrayExpr>(e)->sizes);
+    case ExprKind::ArrayIndex: {
+      auto *a = cast<ArrayIndexExpr>(e);
+      return expr(a->object.get()) && exprs(a->indices);
+    }
+    case ExprKind::ArrayIndexAssign: {
+      auto *a = cast<ArrayIndexAssignExpr>(e);
+      return expr(a->object.get()) && exprs(a->indices) &&
+             expr(a->value.get());
+    }
+    case ExprKind::LengthProperty:
+      return true;
+    case ExprKind::IndexedLength:
+      return exprs(cast<IndexedLengthExpr>(e)->indices);
+    case ExprKind::FieldAccess:
+      return expr(cast<FieldAccessExpr>(e)->object.get());
+    case ExprKind::FieldAssign: {
+      auto *f = cast<FieldAssignExpr>(e);
+      return expr(f->object.get()) && expr(f->value.get());
+    }
+    case ExprKind::StructLit:
+      return exprs(cast<StructLitExpr>(e)->values);
+    case ExprKind::TypeIntrinsic:
+      return expr(cast<TypeIntrinsicExpr>(e)->value.get());
+    case ExprKind::EnumConstructor:
+      return exprs(cast<EnumConstructorExpr>(e)->arguments);
+    }
+    return false;
+  }
+};
+
+} // namespace
+
+BoundsManager::BoundsManager(IRBuilder<> &B, LLVMContext &ctx, Module *M)
+    : B_(B), ctx_(ctx), M_(M) {}
+
+void BoundsManager::emitCheck(Value *idx, Value *len, const Token &at) {
+  if (mode_ == BoundsCheck::Off)
+    return;
+
+  llvm::Function *fn = B_.GetInsertBlock()->getParent();
+  Value *inRange = B_.CreateICmpULT(idx, len, "bounds.ok");
+  BasicBlock *failBB = BasicBlock::Create(ctx_, "bounds.fail", fn);
+  BasicBlock *okBB = BasicBlock::Create(ctx_, "bounds.cont", fn);
+  B_.CreateCondBr(inRange, okBB, failBB,
+                  MDBuilder(ctx_).createBranchWeights(1u << 20, 1));
+
+  B_.SetInsertPoint(failBB);
+  if (mode_ == BoundsCheck::On) {
+    B_.CreateIntrinsic(Intrinsic::trap, {}, {});
+  } else {
+    Type *i32Ty = Type::getInt32Ty(ctx_);
+    emitAbort("Runtime error: index %lld out of bounds for length %lld "
+              "(line %d, column %d)\n",
+              {idx, len, ConstantInt::get(i32Ty, at.getLine()),
+               ConstantInt::get(i32Ty, at.getColumn())});
+  }
+  B_.CreateUnreachable();
+
+  B_.SetInsertPoint(okBB);
+}
+
+void BoundsManager::emitShapeCheck(Value *src, Value *dst, unsigned rank,
+                                   const Token &at) {
+  llvm::Function *fn = B_.GetInsertBlock()->getParent();
+  Type *i32Ty = Type::getInt32Ty(ctx_);
+  for (unsigned d = 0; d < rank; ++d) {
+    Value *srcDim = ArrayEmitter::emitDim(B_, src, d);
+    Value *dstDim = ArrayEmitter::emitDim(B_, dst, d);
+    BasicBlock *failBB = BasicBlock::Create(ctx_, "shape.fail", fn);
+    BasicBlock *okBB = BasicBlock::Create(ctx_, "shape.cont", fn);
+    B_.CreateCondBr(B_.CreateICmpEQ(srcDim, dstDim, "shape.ok"), okBB, failBB,
+                    MDBuilder(ctx_).createBranchWeights(1u << 20, 1));
+
+    B_.SetInsertPoint(failBB);
+    emitAbort("Runtime error: array of length %lld assigned to a row of "
+              "length %lld (line %d, column %d)\n",
+              {srcDim, dstDim, ConstantInt::get(i32Ty, at.getLine()),
+               ConstantInt::get(i32Ty, at.getColumn())});
+    B_.CreateUnreachable();
+    B_.SetInsertPoint(okBB);
+  }
+}
+
+void BoundsManager::emitAbort(const char *fmt, ArrayRef<Value *> args) {
+  Type *i32Ty = Type::getInt32Ty(ctx_);
+  Type *ptrTy = PointerType::get(ctx_, 0);
+  FunctionCallee fprintfFn = M_->getOrInsertFunction(
+      "fprintf", FunctionType::get(i32Ty, {ptrTy, ptrTy}, true));
+  GlobalVariable *stderrVar = M_->getGlobalVariable("stderr");
+  if (!stderrVar)
+    stderrVar = new GlobalVariable(*M_, ptrTy, false,
+                                   GlobalValue::ExternalLinkage, nullptr,
+                                   "stderr");
+  std::vector<Value *> callArgs = {
+      B_.CreateLoad(ptrTy, stderrVar, "stderr.val"),
+      B_.CreateGlobalString(fmt, "bounds.fmt")};
+  callArgs.insert(callArgs.end(), args.begin(), args.end());
+  B_.CreateCall(fprintfFn, callArgs);
+
+  FunctionCallee abortFn = M_->getOrInsertFunction(
+      "abort", FunctionType::get(Type::getVoidTy(ctx_), false));
+  if (auto *f = dyn_cast<llvm::Function>(abortFn.getCallee())) {
+    f->setDoesNotReturn();
+    f->addFnAttr(Attribute::Cold);
+  }
+  B_.CreateCall(abortFn);
+}
+
+bool BoundsManager::isProven(Symbol array, unsigned dim,
+                             const Expression &index) const {
+  auto *id = dyn_cast<IdentExpr>(&index);
+  if (!id)
+    return false;
+  Symbol var = id->name.symbol();
+  for (const Fact &f : facts_)
+    if (f.index == var && f.array == array && f.dim == dim)
+      return true;
+  return false;
+}
+
+const Identifier *BoundsManager::loopArray(const ForRangeStmt &s) {
+  if (auto *len = dyn_cast<LengthPropertyExpr>(s.end.get()))
+    return &len->name;
+  if (auto *len = dyn_cast<IndexedLengthExpr>(s.end.get()))
+    return &len->arrayName;
+  return nullptr;
+}
+
+bool BoundsManager::enterLoop(const ForRangeStmt &s) {
+  if (mode_ == BoundsCheck::Off)
+    return false;
+  const Identifier *array = loopArray(s);
+  if (!array || smallLiteral(s.start.get()) < 0 ||
+      (s.step && smallLiteral(s.step.get()) != 1))
+    return false;
+
+  // i starts at or above 0 and rises by one while i < extent, so it cannot
+  // wrap; the extent was read before the first iteration, so the body must
+  // not be able to change it or i.
+  unsigned dim = 0;
+  if (auto *len = dyn_cast<IndexedLengthExpr>(s.end.get()))
+    dim = len->indices.size();
+  Symbol index = s.varName.symbol();
+  if (!BodyScan(index, array->symbol()).block(s.body.get()))
+    return false;
+
+  facts_.push_back({index, array->symbol(), dim});
+  return true;
+}
@@ -0,0 +1,80 @@
+#ifndef BOUNDS_MANAGER_H
+#define BOUNDS_MANAGER_H
+
+#include "../../AST/AST.h"
+#include "../CodeGenOptions.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Value.h"
+#include <vector>
+
+// -------------------------------------------------------------------- //
+// BoundsManager — subscript range checks (--bounds-check=off|on|debug) //
+// -------------------------------------------------------------------- //
+//
+// A check is one unsigned compare of the index against the extent, which
+// also rejects negative indices, branching to a cold block that never
+// returns: a trap with 'on', a diagnostic and abort() with 'debug'.
+//
+// Checks are left out where a range loop already guarantees them:
+//   for (i32 i : range(arr.length))     arr[i]
+//   for (i32 j : range(m[r].length))    m[x][j]
+// provided the start is a small non-negative literal, the step is 1, the
+// array is a local, and the body neither rebinds nor writes the array or
+// the loop variable (see enterLoop).
+class BoundsManager {
+public:
+  BoundsManager(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx, llvm::Module *M);
+
+  void setMode(BoundsCheck mode) { mode_ = mode; }
+  bool enabled() const { return mode_ != BoundsCheck::Off; }
+
+  // Emits the check idx < len (both i64) and leaves the builder on the path
+  // where it holds. `at` locates the subscript for 'debug' diagnostics.
+  void emitCheck(llvm::Value *idx, llvm::Value *len, const Token &at);
+
+  // Emits the check that an array assigned to a row of a dense array has
+  // the row's shape: dimension d of src (both rank `rank` array values)
+  // equals that of dst. Emitted in every mode, since a row cannot be
+  // resized; a mismatch prints a diagnostic and aborts.
+  void emitShapeCheck(llvm::Value *src, llvm::Value *dst, unsigned rank,
+                      const Token &at);
+
+  // True when `index`, used as subscript `dim` of `array`, is the variable
+  // of an enclosing loop proven to stay within that dimension.
+  bool isProven(Symbol array, unsigned dim, const Expression &index) const;
+
+  // Called around the body of a range loop. enterLoop records what the loop
+  // proves, if anything, and returns whether exitLoop must drop it. The
+  // caller checks that `array` names a local, non-reference array.
+  bool enterLoop(const ForRangeStmt &s);
+  void exitLoop() { facts_.pop_back(); }
+
+  // Facts of the function being emitted, set aside while another function
+  // is generated from inside it.
+  struct Fact {
+    Symbol index;
+    Symbol array;
+    unsigned dim;
+  };
+  std::vector<Fact> suspend() { return std::move(facts_); }
+  void resume(std::vector<Fact> facts) { facts_ = std::move(facts); }
+
+  // The array whose extent bounds a range loop (`arr` in range(arr.length)),
+  // if its end has that shape.
+  static const Identifier *loopArray(const ForRangeStmt &s);
+
+private:
+  // printf-style diagnostic on stderr followed by abort(), which never
+  // returns.
+  void emitAbort(const char *fmt, llvm::ArrayRef<llvm::Value *> args);
+
+  llvm::IRBuilder<> &B_;
+  llvm::LLVMContext &ctx_;
+  llvm::Module *M_;
+  BoundsCheck mode_ = BoundsCheck::Off;
+  std::vector<Fact> facts_;
+};
+
+#endif // BOUNDS_MANAGER_H
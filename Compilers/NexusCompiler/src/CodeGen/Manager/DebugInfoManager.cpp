@@ -0,0 +1,73 @@
+#include "DebugInfoManager.h"
+#include "llvm/BinaryFormat/Dwarf.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include <algorithm>
+
+using namespace llvm;
+
+static DIFile *createFile(DIBuilder &DIB, const std::string &sourcePath) {
+  SmallString<256> path(sourcePath);
+  sys::fs::make_absolute(path);
+  return DIB.createFile(sys::path::filename(path), sys::path::parent_path(path));
+}
+
+DebugInfoManager::DebugInfoManager(IRBuilder<> &B, Module &M,
+                                   const std::string &sourcePath,
+                                   bool optimized)
+    : B_(B), DIB_(M), optimized_(optimized) {
+  file_ = createFile(DIB_, sourcePath);
+
+  // DWARF has no language code for Nexus; C is the closest debuggers know.
+  DIB_.createCompileUnit(dwarf::DW_LANG_C, file_, "nexus", optimized, "", 0);
+  fnTy_ = DIB_.createSubroutineType(DIB_.getOrCreateTypeArray({}));
+
+  M.addModuleFlag(Module::Warning, "Debug Info Version",
+                  DEBUG_METADATA_VERSION);
+  M.addModuleFlag(Module::Warning, "Dwarf Version", 4);
+}
+
+DIFile *DebugInfoManager::fileFor(const std::string &sourcePath) {
+  if (sourcePath.empty())
+    return file_;
+  DIFile *&file = importedFiles_[sourcePath];
+  if (!file)
+    file = createFile(DIB_, sourcePath);
+  return file;
+}
+
+DebugInfoManager::Saved
+DebugInfoManager::enterFunction(llvm::Function *f, std::string_view name,
+                                int line, const std::string &sourcePath) {
+  Saved saved{scope_, B_.getCurrentDebugLocation()};
+  DIFile *file = fileFor(sourcePath);
+
+  DISubprogram::DISPFlags spFlags = DISubprogram::SPFlagDefinition;
+  if (optimized_)
+    spFlags |= DISubprogram::SPFlagOptimized;
+  unsigned l = line > 0 ? static_cast<unsigned>(line) : 0;
+  scope_ = DIB_.createFunction(file, StringRef(name.data(), name.size()),
+                               f->getName(), file, l, fnTy_, l,
+                               DINode::FlagPrototyped, spFlags);
+  f->setSubprogram(scope_);
+
+  // The prologue (parameter spills, runtime setup) belongs to the
+  // declaration line until the first statement says otherwise.
+  setLocation(line, 0);
+  return saved;
+}
+
+void DebugInfoManager::leaveFunction(Saved saved) {
+  if (scope_)
+    DIB_.finalizeSubprogram(scope_);
+  scope_ = saved.scope;
+  B_.SetCurrentDebugLocation(saved.loc);
+}
+
+void DebugInfoManager::setLocation(int line, int column) {
+  if (!scope_ || line <= 0)
+    return;
+  B_.SetCurrentDebugLocation(
+      DILocation::get(scope_->getContext(), static_cast<unsigned>(line),
+                      static_cast<unsigned>(std::max(column, 0)), scope_));
+}
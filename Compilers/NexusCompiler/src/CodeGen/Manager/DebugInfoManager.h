@@ -0,0 +1,59 @@
+#ifndef DEBUG_INFO_MANAGER_H
+#define DEBUG_INFO_MANAGER_H
+
+#include "llvm/IR/DIBuilder.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// ------------------------------------------------------ //
+// DebugInfoManager — line-table debug info for -g builds //
+// ------------------------------------------------------ //
+//
+// One compile unit per source file, one DISubprogram per emitted function
+// and a DILocation on every instruction lowered from a statement, which is
+// what debuggers and sanitizer reports need to map addresses back to
+// lines. Functions spliced in from imported modules point at a DIFile of
+// their own module. Variables and types are not described.
+class DebugInfoManager {
+public:
+  DebugInfoManager(llvm::IRBuilder<> &B, llvm::Module &M,
+                   const std::string &sourcePath, bool optimized);
+
+  // Attaches a subprogram for `name`, declared at `line` of sourcePath (the
+  // compile unit's file when empty), to f and makes it the scope of later
+  // locations, starting at that line. leaveFunction,
+  // due once f's body is emitted and before it is verified, completes the
+  // subprogram and restores the state handed back, which matters when f is
+  // emitted from inside another function (generic specializations).
+  struct Saved {
+    llvm::DISubprogram *scope;
+    llvm::DebugLoc loc;
+  };
+  Saved enterFunction(llvm::Function *f, std::string_view name, int line,
+                      const std::string &sourcePath = {});
+  void leaveFunction(Saved saved);
+
+  // Tags the instructions emitted from here on with line:column.
+  void setLocation(int line, int column);
+
+  // Resolves the pending metadata; call once, after the last function.
+  void finalize() { DIB_.finalize(); }
+
+private:
+  llvm::IRBuilder<> &B_;
+  llvm::DIBuilder DIB_;
+  llvm::DIFile *file_;
+  std::unordered_map<std::string, llvm::DIFile *> importedFiles_;
+  llvm::DISubroutineType *fnTy_;
+  llvm::DISubprogram *scope_ = nullptr;
+  bool optimized_;
+
+  llvm::DIFile *fileFor(const std::string &sourcePath);
+};
+
+#endif // DEBUG_INFO_MANAGER_H
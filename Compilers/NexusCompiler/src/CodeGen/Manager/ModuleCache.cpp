@@ -0,0 +1,69 @@
+#include "ModuleCache.h"
+#include "../../Driver/TimeReport.h"
+#include "../../FileReader/FileReader.h"
+#include "../../Lexer/Lexer.h"
+#include "../../Parser/Parser.h"
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+// 64-bit FNV-1a; only used to tell whether a touched file really changed.
+static std::uint64_t contentHash(std::string_view s) {
+  std::uint64_t h = 1469598103934665603ULL;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+ModuleCache::Module ModuleCache::get(const fs::path &canonicalPath) {
+  std::shared_ptr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> guard(mapLock_);
+    auto &slot = entries_[canonicalPath.string()];
+    if (!slot)
+      slot = std::make_shared<Entry>();
+    entry = slot;
+  }
+
+  // Per-entry lock: concurrent importers of the same module wait for a
+  // single parse instead of each doing their own.
+  std::lock_guard<std::mutex> guard(entry->lock);
+
+  std::error_code ec;
+  fs::file_time_type mtime = fs::last_write_time(canonicalPath, ec);
+  std::uintmax_t size = ec ? 0 : fs::file_size(canonicalPath, ec);
+  if (ec)
+    throw std::runtime_error("Cannot open module: " + canonicalPath.string());
+
+  if (entry->loaded && entry->mtime == mtime && entry->size == size)
+    return {entry->ast, entry->diagnostics};
+
+  std::optional<SourceBuffer> code = readFile(canonicalPath.string().c_str());
+  if (!code.has_value())
+    throw std::runtime_error("Cannot open module: " + canonicalPath.string());
+
+  std::uint64_t hash = contentHash(code->view());
+  if (!entry->loaded || entry->hash != hash) {
+    TimeScope scope("parse");
+    Lexer lexer(std::move(*code));
+    Parser parser(lexer);
+    std::shared_ptr<Program> ast = parser.parse();
+    for (auto &fn : ast->functions)
+      fn->sourcePath = canonicalPath.string();
+    entry->ast = std::move(ast);
+    std::ostringstream rendered;
+    for (const ParseDiagnostic &d : parser.diagnostics())
+      rendered << d;
+    entry->diagnostics = rendered.str();
+    TimeReport::count("modules parsed");
+    TimeReport::count("imported tokens", lexer.tokenCount());
+    TimeReport::count("imported AST nodes", entry->ast->arena->nodeCount());
+    entry->hash = hash;
+    entry->loaded = true;
+  }
+  entry->mtime = mtime;
+  entry->size = size;
+  return {entry->ast, entry->diagnostics};
+}
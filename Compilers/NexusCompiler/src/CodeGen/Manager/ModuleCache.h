@@ -0,0 +1,53 @@
+#pragma once
+#include "../../AST/AST.h"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+// Session-wide cache of parsed modules.
+//
+// One instance is shared by every ModuleManager in a nexus run, including
+// across -j workers, so each imported file is read, lexed and parsed once no
+// matter how many entry files import it. Entries are keyed by canonical path
+// and revalidated against the file's mtime and size; when those change the
+// content hash decides whether the module really has to be parsed again.
+//
+// The cached Program is immutable; importers splice its shared declarations
+// into their own Program instead of taking ownership.
+class ModuleCache {
+public:
+  ModuleCache() = default;
+  ModuleCache(const ModuleCache &) = delete;
+  ModuleCache &operator=(const ModuleCache &) = delete;
+
+  // A parsed module and the syntax errors its parse reported, already
+  // rendered. The errors are kept so that every build importing the module
+  // can replay them, not only the one that happened to parse it.
+  struct Module {
+    std::shared_ptr<const Program> ast;
+    std::string diagnostics;
+  };
+
+  // Returns the module at canonicalPath, parsing it on first use or if it
+  // changed on disk. Throws std::runtime_error if it cannot be read.
+  Module get(const fs::path &canonicalPath);
+
+private:
+  struct Entry {
+    std::mutex lock;
+    bool loaded = false;
+    fs::file_time_type mtime;
+    std::uintmax_t size = 0;
+    std::uint64_t hash = 0;
+    std::shared_ptr<const Program> ast;
+    std::string diagnostics;
+  };
+
+  std::mutex mapLock_;
+  std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;
+};
@@ -1,13 +1,13 @@
 #include "ModuleManager.h"
-#include "../../FileReader/FileReader.h"
-#include "../../Lexer/Lexer.h"
-#include "../../Parser/Parser.h"
+#include "../../Driver/TimeReport.h"
 #include <algorithm>
-#include <fstream>
+#include <iostream>
 #include <stdexcept>
 
-ModuleManager::ModuleManager(fs::path root, fs::path stdlib)
-    : projectRoot(std::move(root)), stdlibRoot(std::move(stdlib)) {}
+ModuleManager::ModuleManager(fs::path root, fs::path stdlib,
+                             ModuleCache &moduleCache)
+    : projectRoot(std::move(root)), stdlibRoot(std::move(stdlib)),
+      cache(moduleCache) {}
 
 fs::path ModuleManager::importPathToFile(const ImportPath &path,
                                          bool isStdLib) const {
@@ -22,37 +22,34 @@ fs::path ModuleManager::importPathToFile(const ImportPath &path,
   return result;
 }
 
-std::unique_ptr<Program> ModuleManager::parseFile(const fs::path &file) {
-  std::ifstream f(file);
-  if (!f)
-    throw std::runtime_error("Cannot open module: " + file.string());
-
-  std::optional<std::string> codeOpt = readFile(file.c_str());
-  if (!codeOpt.has_value()) {
-    std::cerr << "Failed to read file: " << file << "\n";
-  }
-
-  std::string code = codeOpt.value();
-
-  Lexer lexer(code);
-  auto tokens = lexer.Tokenize();
-  Parser parser(std::move(tokens));
-  return parser.parse();
+// A per-importer view of a cached module: shares the declarations but owns
+// the vectors, so resolveAll/applyFilter can edit it freely.
+std::unique_ptr<Program> ModuleManager::shallowCopy(const Program &src) {
+  auto view = std::make_unique<Program>();
+  view->imports = src.imports;
+  view->globals = src.globals;
+  view->functions = src.functions;
+  view->structs = src.structs;
+  view->enums = src.enums;
+  view->externBlocks = src.externBlocks;
+  return view;
 }
 
 void ModuleManager::applyFilter(Program &src,
                                 const std::vector<std::string> &symbols) {
   if (!symbols.empty()) {
-    std::unordered_set<std::string> wanted(symbols.begin(), symbols.end());
-    src.globals.erase(
-        std::remove_if(src.globals.begin(), src.globals.end(),
-                       [&](const auto &g) { return !wanted.count(g->name); }),
-        src.globals.end());
+    std::unordered_set<Symbol> wanted;
+    for (auto &name : symbols)
+      wanted.insert(Symbol::intern(name));
+    src.globals.erase(std::remove_if(src.globals.begin(), src.globals.end(),
+                                     [&](const auto &g) {
+                                       return !wanted.count(g->symbol);
+                                     }),
+                      src.globals.end());
     src.functions.erase(
-        std::remove_if(src.functions.begin(), src.functions.end(),
-                       [&](const auto &fn) {
-                         return !wanted.count(fn->name.token.getWord());
-                       }),
+        std::remove_if(
+            src.functions.begin(), src.functions.end(),
+            [&](const auto &fn) { return !wanted.count(fn->name.symbol()); }),
         src.functions.end());
     return;
   }
@@ -81,15 +78,22 @@ ResolvedModule &ModuleManager::resolveImport(const ImportDecl &decl) {
     return resolved[canonical];
 
   inProgress.insert(canonical);
+  TimeScope scope("import", canonical);
 
   auto &mod = resolved[canonical];
   mod.filePath = filePath;
   mod.importedSymbols = decl.symbols;
-  mod.ast = parseFile(filePath);
-
-  resolveAll(*mod.ast);
 
-  applyFilter(*mod.ast, decl.symbols);
+  ModuleCache::Module parsed = cache.get(canonical);
+  if (!parsed.diagnostics.empty()) {
+    std::cerr << "In module " << canonical << ":\n" << parsed.diagnostics;
+    diagnosed = true;
+  }
+  if (parsed.ast) {
+    mod.ast = shallowCopy(*parsed.ast);
+    resolveAll(*mod.ast);
+    applyFilter(*mod.ast, decl.symbols);
+  }
 
   inProgress.erase(canonical);
   return mod;
@@ -122,3 +126,12 @@ void ModuleManager::resolveAll(Program &prog) {
   }
   prog.imports.clear();
 }
+
+std::vector<fs::path> ModuleManager::dependencies() const {
+  std::vector<fs::path> deps;
+  deps.reserve(resolved.size());
+  for (const auto &[canonical, mod] : resolved)
+    deps.emplace_back(canonical);
+  std::sort(deps.begin(), deps.end());
+  return deps;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "../../AST/AST.h"
+#include "ModuleCache.h"
 #include <filesystem>
 #include <string>
 #include <unordered_map>
@@ -16,13 +17,21 @@ struct ResolvedModule {
 
 class ModuleManager {
 public:
-  explicit ModuleManager(fs::path projectRoot, fs::path stdlibRoot);
+  ModuleManager(fs::path projectRoot, fs::path stdlibRoot, ModuleCache &cache);
 
   void resolveAll(Program &prog);
 
+  // Canonical paths of every module resolved so far, transitively.
+  std::vector<fs::path> dependencies() const;
+
+  // True if any resolved module reported syntax errors.
+  bool hadDiagnostics() const { return diagnosed; }
+
 private:
   fs::path projectRoot;
   fs::path stdlibRoot;
+  ModuleCache &cache;
+  bool diagnosed = false;
 
   std::unordered_set<std::string> inProgress;
   std::unordered_map<std::string, ResolvedModule> resolved;
@@ -33,5 +42,5 @@ private:
 
   void applyFilter(Program &src, const std::vector<std::string> &symbols);
 
-  std::unique_ptr<Program> parseFile(const fs::path &file);
+  static std::unique_ptr<Program> shallowCopy(const Program &src);
 };
@@ -1,4 +1,6 @@
 #include "ScopeManager.h"
+#include "../Emitters/ArrayEmitter.h"
+#include "../Emitters/StringEmitter.h"
 #include "../TypeResolver.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -19,7 +21,7 @@ static bool blockHasTerminator(llvm::IRBuilder<> &B) {
 // ------------ //
 
 ScopeManager::ScopeManager(IRBuilder<> &B, LLVMContext &ctx, Module *M,
-                           std::map<std::string, VarInfo> &namedValues)
+                           VarTable &namedValues)
     : B_(B), ctx_(ctx), M_(M), namedValues_(namedValues) {}
 
 // --------------- //
@@ -27,20 +29,19 @@ ScopeManager::ScopeManager(IRBuilder<> &B, LLVMContext &ctx, Module *M,
 // --------------- //
 
 void ScopeManager::reset() {
-  stack_.clear();
+  namedValues_.resetToGlobals();
   tmpStack_.clear();
   destructorsEmitted_ = false;
   bbCounter_ = 0;
 }
 
 void ScopeManager::pushScope() {
-  stack_.emplace_back();
+  namedValues_.pushScope();
   tmpStack_.emplace_back();
 }
 
-void ScopeManager::declare(const std::string &name) {
-  if (!stack_.empty())
-    stack_.back().push_back(name);
+void ScopeManager::declare(Symbol name, const VarInfo &vi) {
+  namedValues_.declare(name, vi, /*owned=*/true);
 }
 
 void ScopeManager::declareTmp(llvm::AllocaInst *alloca, llvm::Type *ty) {
@@ -59,16 +60,15 @@ bool ScopeManager::isTmp(llvm::AllocaInst *alloca) const {
   return false;
 }
 
-std::vector<std::string> ScopeManager::popScope() {
-  if (stack_.empty())
-    return {};
+void ScopeManager::popScope() {
+  if (namedValues_.depth() == 0)
+    return;
 
   if (destructorsEmitted_) {
     if (!tmpStack_.empty())
       tmpStack_.pop_back();
-    auto names = stack_.back();
-    stack_.pop_back();
-    return names;
+    namedValues_.popScope();
+    return;
   }
 
   bool canEmit = !blockHasTerminator(B_);
@@ -79,71 +79,65 @@ std::vector<std::string> ScopeManager::popScope() {
         emitDestructor(vi);
     tmpStack_.pop_back();
   }
-  auto names = stack_.back();
   if (canEmit)
-    emitDestructorsFor(names);
-  stack_.pop_back();
-  return names;
+    emitDestructorsFor(namedValues_.depth() - 1);
+  namedValues_.popScope();
 }
 
 void ScopeManager::popAll() {
   if (destructorsEmitted_) {
-    stack_.clear();
+    while (namedValues_.depth() > 0)
+      namedValues_.popScope();
     tmpStack_.clear();
     return;
   }
-  while (!stack_.empty())
+  while (namedValues_.depth() > 0)
     popScope();
 }
 
+ScopeManager::Suspended ScopeManager::suspend() {
+  Suspended s{namedValues_.suspend(), std::move(tmpStack_),
+              destructorsEmitted_, bbCounter_};
+  tmpStack_.clear();
+  destructorsEmitted_ = false;
+  bbCounter_ = 0;
+  return s;
+}
+
+void ScopeManager::resume(Suspended s) {
+  namedValues_.resume(std::move(s.vars));
+  tmpStack_ = std::move(s.tmpStack);
+  destructorsEmitted_ = s.destructorsEmitted;
+  bbCounter_ = s.bbCounter;
+}
+
 void ScopeManager::emitAllDestructors() {
   if (destructorsEmitted_)
     return;
   destructorsEmitted_ = true;
 
-  for (int i = static_cast<int>(stack_.size()) - 1; i >= 0; --i) {
+  for (int i = static_cast<int>(namedValues_.depth()) - 1; i >= 0; --i) {
     if (i < static_cast<int>(tmpStack_.size()))
       for (auto &vi : tmpStack_[i])
         emitDestructor(vi);
-    emitDestructorsFor(stack_[i]);
+    emitDestructorsFor(static_cast<size_t>(i));
   }
 }
 
-// ----------- //
-// Depth query //
-// ----------- //
-
-bool ScopeManager::isLocal(const std::string &name) const {
-  if (stack_.empty())
-    return false;
-  for (const auto &n : stack_.back())
-    if (n == name)
-      return true;
-  return false;
-}
-
 // --------------------------- //
 // Private destructor emission //
 // --------------------------- //
 
-void ScopeManager::emitDestructorsFor(const std::vector<std::string> &names) {
-  for (auto it = names.rbegin(); it != names.rend(); ++it) {
+void ScopeManager::emitDestructorsFor(size_t scope) {
+  namedValues_.forEachOwned(scope, [&](VarInfo &vi) {
     if (blockHasTerminator(B_))
       return;
-
-    auto nv = namedValues_.find(*it);
-    if (nv == namedValues_.end())
-      continue;
-
-    VarInfo &vi = nv->second;
-
     if (!vi.ownsHeap)
-      continue;
+      return;
     if (vi.isMoved || vi.isBorrowed || vi.isReference)
-      continue;
-
+      return;
     emitDestructor(vi);
-  }
+  });
 }
 
 void ScopeManager::emitDestructor(VarInfo &vi) {
@@ -173,10 +167,7 @@ void ScopeManager::emitDestructor(VarInfo &vi) {
     std::string uid = std::to_string(bbCounter_++);
     BasicBlock *freeBB = BasicBlock::Create(ctx_, "str.free" + uid, fn);
     BasicBlock *skipBB = BasicBlock::Create(ctx_, "str.skip" + uid, fn);
-    Value *isNull = B_.CreateICmpEQ(
-        data, llvm::ConstantPointerNull::get(llvm::PointerType::get(ctx_, 0)),
-        "is.null");
-    B_.CreateCondBr(isNull, skipBB, freeBB);
+    B_.CreateCondBr(StringOps::ownsBuffer(B_, load), freeBB, skipBB);
 
     B_.SetInsertPoint(freeBB);
     B_.CreateCall(getFree(), {data});
@@ -215,9 +206,7 @@ void ScopeManager::emitStructFieldDestructors(llvm::StructType *st,
       std::string uid = std::to_string(bbCounter_++);
       BasicBlock *freeBB = BasicBlock::Create(ctx_, "str.free" + uid, fn);
       BasicBlock *skipBB = BasicBlock::Create(ctx_, "str.skip" + uid, fn);
-      Value *isNull = B_.CreateICmpEQ(
-          data, ConstantPointerNull::get(PointerType::get(ctx_, 0)), "is.null");
-      B_.CreateCondBr(isNull, skipBB, freeBB);
+      B_.CreateCondBr(StringOps::ownsBuffer(B_, load), freeBB, skipBB);
       B_.SetInsertPoint(freeBB);
       B_.CreateCall(getFree(), {data});
       B_.CreateBr(skipBB);
@@ -263,6 +252,10 @@ void ScopeManager::emitArrayFree(llvm::Value *arrPtr, llvm::StructType *arrSt,
   Value *loaded = B_.CreateLoad(arrSt, arrPtr);
   Value *dataPtr = B_.CreateExtractValue(loaded, {1}, "data");
   Value *len = B_.CreateExtractValue(loaded, {0}, "len");
+  // Every rank is one buffer of d0 * d1 * ... leaf elements.
+  unsigned rank = TypeResolver::arrayRank(arrSt);
+  for (unsigned d = 1; d < rank; ++d)
+    len = B_.CreateMul(len, ArrayEmitter::emitDim(B_, loaded, d), "len");
 
   std::string sfx = std::to_string(depth) + "_" + std::to_string(bbCounter_++);
   BasicBlock *nullCheckPassBB =
@@ -276,33 +269,32 @@ void ScopeManager::emitArrayFree(llvm::Value *arrPtr, llvm::StructType *arrSt,
   B_.CreateCondBr(isNull, nullCheckDoneBB, nullCheckPassBB);
   B_.SetInsertPoint(nullCheckPassBB);
 
-  Type *elemTy = TypeResolver::elemType(ctx_, arrSt);
+  Type *elemTy = arrSt;
+  for (unsigned d = 0; d < rank && elemTy; ++d)
+    elemTy = TypeResolver::elemType(ctx_, cast<StructType>(elemTy));
 
-  if (elemTy && TypeResolver::isArray(elemTy)) {
-    StructType *elemSt = cast<StructType>(elemTy);
-
-    BasicBlock *loopBB = BasicBlock::Create(ctx_, "free.loop" + sfx, fn);
-    BasicBlock *bodyBB = BasicBlock::Create(ctx_, "free.body" + sfx, fn);
-    BasicBlock *afterBB = BasicBlock::Create(ctx_, "free.after" + sfx, fn);
+  if (TypeResolver::isArray(elemTy)) {
+    // Jagged array: every row owns a buffer of its own.
+    StructType *rowSt = cast<StructType>(elemTy);
+    BasicBlock *loopBB = BasicBlock::Create(ctx_, "rfree.loop" + sfx, fn);
+    BasicBlock *bodyBB = BasicBlock::Create(ctx_, "rfree.body" + sfx, fn);
+    BasicBlock *afterBB = BasicBlock::Create(ctx_, "rfree.after" + sfx, fn);
 
-    AllocaInst *idx = B_.CreateAlloca(i64, nullptr, "fi" + sfx);
+    AllocaInst *idx = B_.CreateAlloca(i64, nullptr, "rfi" + sfx);
     B_.CreateStore(ConstantInt::get(i64, 0), idx);
     B_.CreateBr(loopBB);
 
     B_.SetInsertPoint(loopBB);
     Value *cur = B_.CreateLoad(i64, idx);
-    Value *cond = B_.CreateICmpULT(cur, len);
-    B_.CreateCondBr(cond, bodyBB, afterBB);
+    B_.CreateCondBr(B_.CreateICmpULT(cur, len), bodyBB, afterBB);
 
     B_.SetInsertPoint(bodyBB);
-    Value *slotPtr = B_.CreateGEP(elemSt, dataPtr, cur, "slot" + sfx);
-    emitArrayFree(slotPtr, elemSt, depth + 1);
-    Value *next = B_.CreateAdd(cur, ConstantInt::get(i64, 1));
-    B_.CreateStore(next, idx);
+    emitArrayFree(B_.CreateGEP(rowSt, dataPtr, cur, "rslot" + sfx), rowSt,
+                  depth + 1);
+    B_.CreateStore(B_.CreateAdd(cur, ConstantInt::get(i64, 1)), idx);
     B_.CreateBr(loopBB);
 
     B_.SetInsertPoint(afterBB);
-
   } else if (elemTy && elemTy->isStructTy() &&
              !TypeResolver::isString(elemTy)) {
     StructType *elemSt = cast<StructType>(elemTy);
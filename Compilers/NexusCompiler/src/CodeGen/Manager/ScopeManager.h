@@ -5,44 +5,62 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
-#include <map>
-#include <string>
 #include <vector>
 
 class ScopeManager {
 public:
   bool destructorsEmitted_ = false;
   ScopeManager(llvm::IRBuilder<> &B, llvm::LLVMContext &ctx, llvm::Module *M,
-               std::map<std::string, VarInfo> &namedValues);
+               VarTable &namedValues);
 
   void reset();
   void pushScope();
-  void declare(const std::string &name);
+  // Binds name in the innermost scope; its destructor runs when the scope
+  // is popped.
+  void declare(Symbol name, const VarInfo &vi);
 
   void declareTmp(llvm::AllocaInst *alloca, llvm::Type *ty);
 
   bool isTmp(llvm::AllocaInst *alloca) const;
 
-  std::vector<std::string> popScope();
+  void popScope();
   void popAll();
 
   void emitAllDestructors();
 
-  size_t depth() const { return stack_.size(); }
-  bool isLocal(const std::string &name) const;
+  // Frees the array at arrPtr and whatever its elements own, e.g. the row
+  // of a jagged array that is about to be replaced.
+  void releaseArray(llvm::Value *arrPtr, llvm::StructType *arrSt) {
+    emitArrayFree(arrPtr, arrSt, 0);
+  }
+
+  // Scope state of the function being emitted, set aside while another
+  // function is generated from inside it.
+  struct Suspended {
+    VarTable::Suspended vars;
+    std::vector<std::vector<VarInfo>> tmpStack;
+    bool destructorsEmitted;
+    unsigned bbCounter;
+  };
+  Suspended suspend();
+  void resume(Suspended s);
+
+  size_t depth() const { return namedValues_.depth(); }
+  bool isLocal(Symbol name) const {
+    return namedValues_.inInnermostScope(name);
+  }
 
 private:
   unsigned bbCounter_ = 0;
   llvm::IRBuilder<> &B_;
   llvm::LLVMContext &ctx_;
   llvm::Module *M_;
-  std::map<std::string, VarInfo> &namedValues_;
+  VarTable &namedValues_;
 
-  std::vector<std::vector<std::string>> stack_;
   std::vector<std::vector<VarInfo>> tmpStack_;
 
   void emitStructFieldDestructors(llvm::StructType *st, llvm::Value *ptr);
-  void emitDestructorsFor(const std::vector<std::string> &names);
+  void emitDestructorsFor(size_t scope);
   void emitDestructor(VarInfo &vi);
   void emitArrayFree(llvm::Value *arrPtr, llvm::StructType *arrSt, int depth);
 
@@ -11,6 +11,18 @@ llvm::Function *RTDecl::malloc_(llvm::Module *M, llvm::LLVMContext &ctx) {
   return f;
 }
 
+llvm::Function *RTDecl::realloc_(llvm::Module *M, llvm::LLVMContext &ctx) {
+  llvm::Function *f = M->getFunction("realloc");
+  if (!f) {
+    llvm::Type *ptrTy = llvm::PointerType::get(ctx, 0);
+    auto *ft = llvm::FunctionType::get(
+        ptrTy, {ptrTy, llvm::Type::getInt64Ty(ctx)}, false);
+    f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, "realloc",
+                               M);
+  }
+  return f;
+}
+
 llvm::Function *RTDecl::memcpy_(llvm::Module *M, llvm::LLVMContext &ctx) {
   const std::string name = "llvm.memcpy.p0.p0.i64";
   llvm::Function *f = M->getFunction(name);
@@ -37,17 +49,16 @@ llvm::Function *RTDecl::sprintf_(llvm::Module *M, llvm::LLVMContext &ctx) {
   }
   return f;
 }
-llvm::Function *RTDecl::strcmp_(llvm::Module *M, llvm::LLVMContext &ctx) {
-  llvm::Function *f = M->getFunction("strcmp");
+llvm::Function *RTDecl::memcmp_(llvm::Module *M, llvm::LLVMContext &ctx) {
+  llvm::Function *f = M->getFunction("memcmp");
   if (!f) {
-    llvm::Type *i8ptr =
-        llvm::PointerType::get(llvm::Type::getInt8Ty(ctx)->getContext(), 0);
-
-    llvm::FunctionType *ft = llvm::FunctionType::get(
-        llvm::Type::getInt32Ty(ctx), {i8ptr, i8ptr}, false);
-
-    f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, "strcmp",
-                               *M);
+    llvm::Type *ptrTy = llvm::PointerType::get(ctx, 0);
+    auto *ft = llvm::FunctionType::get(llvm::Type::getInt32Ty(ctx),
+                                       {ptrTy, ptrTy,
+                                        llvm::Type::getInt64Ty(ctx)},
+                                       false);
+    f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, "memcmp",
+                               M);
   }
   return f;
 }
@@ -71,3 +82,48 @@ llvm::Function *RTDecl::free_(llvm::Module *M, llvm::LLVMContext &ctx) {
   }
   return f;
 }
+
+llvm::Function *RTDecl::fwrite_(llvm::Module *M, llvm::LLVMContext &ctx) {
+  llvm::Function *f = M->getFunction("fwrite");
+  if (!f) {
+    llvm::Type *ptrTy = llvm::PointerType::get(ctx, 0);
+    llvm::Type *i64 = llvm::Type::getInt64Ty(ctx);
+    auto *ft = llvm::FunctionType::get(i64, {ptrTy, i64, i64, ptrTy}, false);
+    f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, "fwrite",
+                               M);
+  }
+  return f;
+}
+
+llvm::Function *RTDecl::fputc_(llvm::Module *M, llvm::LLVMContext &ctx) {
+  llvm::Function *f = M->getFunction("fputc");
+  if (!f) {
+    llvm::Type *i32 = llvm::Type::getInt32Ty(ctx);
+    auto *ft = llvm::FunctionType::get(
+        i32, {i32, llvm::PointerType::get(ctx, 0)}, false);
+    f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, "fputc",
+                               M);
+  }
+  return f;
+}
+
+llvm::Function *RTDecl::fflush_(llvm::Module *M, llvm::LLVMContext &ctx) {
+  llvm::Function *f = M->getFunction("fflush");
+  if (!f) {
+    auto *ft = llvm::FunctionType::get(llvm::Type::getInt32Ty(ctx),
+                                       {llvm::PointerType::get(ctx, 0)}, false);
+    f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, "fflush",
+                               M);
+  }
+  return f;
+}
+
+llvm::GlobalVariable *RTDecl::stdout_(llvm::Module *M,
+                                      llvm::LLVMContext &ctx) {
+  llvm::GlobalVariable *var = M->getGlobalVariable("stdout");
+  if (!var)
+    var = new llvm::GlobalVariable(*M, llvm::PointerType::get(ctx, 0), false,
+                                   llvm::GlobalValue::ExternalLinkage, nullptr,
+                                   "stdout");
+  return var;
+}
@@ -0,0 +1,295 @@
+#ifndef SCOPED_SYMBOL_TABLE_H
+#define SCOPED_SYMBOL_TABLE_H
+
+#include "../Token/Symbol.h"
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Symbol -> V map with lexical scopes (CodeGen's variable table).
+//
+// Each name gets one entry the first time it is seen and keeps it for the
+// life of the table; the index is a flat open-addressing array of entry
+// numbers, so a lookup is one hash and a short probe with no string
+// compares, and pointers returned by lookup() are never invalidated.
+//
+// declare() and erase() push the binding they replace onto an undo log and
+// popScope() replays the log back to where the scope began, so leaving a
+// scope costs O(bindings it changed), not O(table size). Bindings made
+// outside any scope are globals. A global changed through lookup() while a
+// scope is open is saved the first time it is touched, and resetToGlobals()
+// puts it back: every function starts from the same global state without
+// the table ever being copied.
+template <class V> class ScopedSymbolTable {
+  static constexpr uint32_t kEmpty = UINT32_MAX;
+  static constexpr size_t kInitialBuckets = 64;
+
+  struct Entry {
+    Symbol name;
+    V value{};
+    uint32_t depth = 0;
+    bool live = false;
+    bool globalSaved = false;
+  };
+
+  // The binding an entry had before a declare()/erase().
+  struct Undo {
+    uint32_t entry;
+    uint32_t depth;
+    bool live;
+    bool owned;
+    V value;
+  };
+
+  struct GlobalSave {
+    uint32_t entry;
+    V value;
+  };
+
+public:
+  ScopedSymbolTable() { index_.assign(kInitialBuckets, kEmpty); }
+
+  V *lookup(Symbol name) {
+    uint32_t e = find(name);
+    if (e == kEmpty || !entries_[e].live)
+      return nullptr;
+    Entry &entry = entries_[e];
+    if (entry.depth == 0 && !marks_.empty() && !entry.globalSaved) {
+      globalSaves_.push_back({e, entry.value});
+      entry.globalSaved = true;
+    }
+    return &entry.value;
+  }
+
+  const V *lookup(Symbol name) const {
+    uint32_t e = find(name);
+    return e != kEmpty && entries_[e].live ? &entries_[e].value : nullptr;
+  }
+
+  bool contains(Symbol name) const { return lookup(name) != nullptr; }
+
+  // Binds name in the innermost scope, hiding any outer binding until the
+  // scope is popped. owned marks bindings whose destructor the scope runs
+  // (see forEachOwned).
+  V &declare(Symbol name, V value, bool owned = false) {
+    uint32_t e = findOrInsert(name);
+    record(e, owned);
+    Entry &entry = entries_[e];
+    entry.value = std::move(value);
+    entry.live = true;
+    entry.depth = static_cast<uint32_t>(marks_.size());
+    return entry.value;
+  }
+
+  // Unbinds name until the current scope is popped.
+  void erase(Symbol name) {
+    uint32_t e = find(name);
+    if (e == kEmpty || !entries_[e].live)
+      return;
+    record(e, false);
+    entries_[e].live = false;
+  }
+
+  void pushScope() { marks_.push_back(log_.size()); }
+
+  void popScope() {
+    if (marks_.empty())
+      return;
+    rollback(marks_.back());
+    marks_.pop_back();
+  }
+
+  // Number of open scopes; 0 means only globals are visible.
+  size_t depth() const { return marks_.size(); }
+
+  // True if name is bound by the innermost open scope.
+  bool inInnermostScope(Symbol name) const {
+    uint32_t e = find(name);
+    return e != kEmpty && entries_[e].live && !marks_.empty() &&
+           entries_[e].depth == marks_.size();
+  }
+
+  // Closes every scope and undoes changes made to globals since the first
+  // scope was opened.
+  void resetToGlobals() {
+    rollback(0);
+    marks_.clear();
+    for (auto it = globalSaves_.rbegin(); it != globalSaves_.rend(); ++it) {
+      entries_[it->entry].value = std::move(it->value);
+      entries_[it->entry].globalSaved = false;
+    }
+    globalSaves_.clear();
+  }
+
+  void clear() {
+    entries_.clear();
+    index_.assign(kInitialBuckets, kEmpty);
+    log_.clear();
+    marks_.clear();
+    globalSaves_.clear();
+  }
+
+  // Calls fn(value) for every live binding, in no particular order.
+  template <class Fn> void forEach(Fn &&fn) {
+    for (Entry &entry : entries_)
+      if (entry.live)
+        fn(entry.value);
+  }
+
+  template <class Pred> bool anyOf(Pred &&pred) const {
+    for (const Entry &entry : entries_)
+      if (entry.live && pred(entry.value))
+        return true;
+    return false;
+  }
+
+  // Calls fn(value) for every owned binding declared in open scope
+  // `scope` (0 = outermost), most recent first. value is the binding that
+  // scope made even when a deeper scope currently shadows the name.
+  template <class Fn> void forEachOwned(size_t scope, Fn &&fn) {
+    if (scope >= marks_.size())
+      return;
+    const size_t begin = marks_[scope];
+    const size_t end =
+        scope + 1 < marks_.size() ? marks_[scope + 1] : log_.size();
+
+    // Walking backwards, `hidden` holds what each name was bound to just
+    // before the newest change seen so far, i.e. what older entries bound.
+    std::unordered_map<uint32_t, V *> hidden;
+    for (size_t i = log_.size(); i-- > begin;) {
+      Undo &u = log_[i];
+      if (i < end && u.owned) {
+        auto h = hidden.find(u.entry);
+        V *bound = h != hidden.end()      ? h->second
+                   : entries_[u.entry].live ? &entries_[u.entry].value
+                                            : nullptr;
+        if (bound)
+          fn(*bound);
+      }
+      hidden[u.entry] = u.live ? &u.value : nullptr;
+    }
+  }
+
+  // Everything opened since the last resetToGlobals(), taken off the table
+  // by suspend() and put back by resume(). Lets CodeGen emit another
+  // function from the middle of the current one.
+  class Suspended {
+    friend class ScopedSymbolTable;
+    std::vector<Undo> log;
+    std::vector<size_t> marks;
+    std::vector<GlobalSave> globalSaves;
+    // State of each log entry's binding just after that entry, and the
+    // changed value of each saved global.
+    std::vector<Undo> redo;
+    std::vector<GlobalSave> globalRedo;
+  };
+
+  Suspended suspend() {
+    Suspended s;
+    for (size_t i = log_.size(); i-- > 0;) {
+      s.redo.push_back(snapshot(log_[i].entry, log_[i].owned));
+      restore(log_[i]);
+    }
+    for (auto it = globalSaves_.rbegin(); it != globalSaves_.rend(); ++it) {
+      Entry &entry = entries_[it->entry];
+      s.globalRedo.push_back({it->entry, std::move(entry.value)});
+      entry.value = it->value;
+      entry.globalSaved = false;
+    }
+    s.log = std::move(log_);
+    s.marks = std::move(marks_);
+    s.globalSaves = std::move(globalSaves_);
+    log_.clear();
+    marks_.clear();
+    globalSaves_.clear();
+    return s;
+  }
+
+  // Drops whatever was opened since suspend() and reinstates s.
+  void resume(Suspended s) {
+    resetToGlobals();
+    for (auto it = s.globalRedo.rbegin(); it != s.globalRedo.rend(); ++it) {
+      entries_[it->entry].value = std::move(it->value);
+      entries_[it->entry].globalSaved = true;
+    }
+    for (auto it = s.redo.rbegin(); it != s.redo.rend(); ++it)
+      restore(*it);
+    log_ = std::move(s.log);
+    marks_ = std::move(s.marks);
+    globalSaves_ = std::move(s.globalSaves);
+  }
+
+private:
+  std::deque<Entry> entries_;
+  std::vector<uint32_t> index_; // power-of-two buckets of entry numbers
+  std::vector<Undo> log_;
+  std::vector<size_t> marks_; // log_ size at each pushScope()
+  std::vector<GlobalSave> globalSaves_;
+
+  size_t bucketOf(Symbol name) const {
+    return std::hash<Symbol>()(name) & (index_.size() - 1);
+  }
+
+  uint32_t find(Symbol name) const {
+    for (size_t b = bucketOf(name);; b = (b + 1) & (index_.size() - 1)) {
+      uint32_t e = index_[b];
+      if (e == kEmpty || entries_[e].name == name)
+        return e;
+    }
+  }
+
+  uint32_t findOrInsert(Symbol name) {
+    uint32_t e = find(name);
+    if (e != kEmpty)
+      return e;
+    if ((entries_.size() + 1) * 2 > index_.size())
+      grow();
+    e = static_cast<uint32_t>(entries_.size());
+    entries_.push_back(Entry{name});
+    size_t b = bucketOf(name);
+    while (index_[b] != kEmpty)
+      b = (b + 1) & (index_.size() - 1);
+    index_[b] = e;
+    return e;
+  }
+
+  void grow() {
+    index_.assign(index_.size() * 2, kEmpty);
+    for (uint32_t e = 0; e < entries_.size(); ++e) {
+      size_t b = bucketOf(entries_[e].name);
+      while (index_[b] != kEmpty)
+        b = (b + 1) & (index_.size() - 1);
+      index_[b] = e;
+    }
+  }
+
+  Undo snapshot(uint32_t e, bool owned) const {
+    const Entry &entry = entries_[e];
+    return {e, entry.depth, entry.live, owned, entry.value};
+  }
+
+  // Globals are never unwound, so changes made outside a scope are not
+  // logged.
+  void record(uint32_t e, bool owned) {
+    if (!marks_.empty())
+      log_.push_back(snapshot(e, owned));
+  }
+
+  void restore(const Undo &u) {
+    Entry &entry = entries_[u.entry];
+    entry.value = u.value;
+    entry.depth = u.depth;
+    entry.live = u.live;
+  }
+
+  void rollback(size_t to) {
+    while (log_.size() > to) {
+      restore(log_.back());
+      log_.pop_back();
+    }
+  }
+};
+
+#endif // SCOPED_SYMBOL_TABLE_H
@@ -3,6 +3,7 @@
 #include "llvm/IR/Function.h"
 #include "llvm/Support/Casting.h"
 #include <string>
+#include <vector>
 
 std::string TypeResolver::typeName(llvm::Type *ty) {
   if (!ty)
@@ -28,8 +29,7 @@ std::string TypeResolver::typeName(llvm::Type *ty) {
   return "unknown";
 }
 
-llvm::Type *TypeResolver::fromName(llvm::LLVMContext &ctx,
-                                   const std::string &t) {
+llvm::Type *TypeResolver::fromName(llvm::LLVMContext &ctx, llvm::StringRef t) {
   if (t == "i32" || t == "int" || t == "integer")
     return llvm::Type::getInt32Ty(ctx);
   if (t == "i64" || t == "long")
@@ -62,8 +62,12 @@ llvm::Type *TypeResolver::fromName(llvm::LLVMContext &ctx,
   if (t == "ptr")
     return llvm::PointerType::get(ctx, 0);
 
+  // Element type of a jagged array: the row array type after "row.".
+  if (t.size() > 4 && t.substr(0, 4) == "row.")
+    return fromName(ctx, t.substr(4));
+
   if (t.size() > 6 && t.substr(0, 6) == "array.") {
-    std::string innerName = t.substr(6);
+    llvm::StringRef innerName = t.substr(6);
     llvm::Type *innerTy = fromName(ctx, innerName);
     if (!innerTy)
       return nullptr;
@@ -78,7 +82,7 @@ llvm::Type *TypeResolver::fromName(llvm::LLVMContext &ctx,
 
 llvm::Type *TypeResolver::fromTypeDesc(llvm::LLVMContext &ctx,
                                        const TypeDesc &td) {
-  const std::string &name = td.base.token.getWord();
+  std::string_view name = td.base.token.getWord();
   llvm::Type *base = fromName(ctx, name);
   if (!base)
     return nullptr;
@@ -112,12 +116,32 @@ TypeResolver::getOrCreateArrayStruct(llvm::LLVMContext &ctx,
   if (llvm::StructType *existing = llvm::StructType::getTypeByName(ctx, name))
     return existing;
 
+  // An array of arrays is one N-D array stored densely: {i64 len, ptr data}
+  // followed by the extents of the inner dimensions. Fields 0 and 1 mean the
+  // same at every rank, so copying, moving and freeing ignore the rest.
   auto *dataPtrTy = llvm::PointerType::getUnqual(elementType->getContext());
-  llvm::StructType *st = llvm::StructType::create(
-      ctx, {llvm::Type::getInt64Ty(ctx), dataPtrTy}, name);
+  std::vector<llvm::Type *> fields = {llvm::Type::getInt64Ty(ctx), dataPtrTy};
+  fields.insert(fields.end(), arrayRank(elementType),
+                llvm::Type::getInt64Ty(ctx));
+  llvm::StructType *st = llvm::StructType::create(ctx, fields, name);
   return st;
 }
 
+llvm::StructType *
+TypeResolver::getOrCreateJaggedStruct(llvm::LLVMContext &ctx,
+                                     llvm::Type *rowType) {
+  if (!isArray(rowType))
+    return nullptr;
+  std::string name = "array.row." + typeName(rowType);
+  if (llvm::StructType *existing = llvm::StructType::getTypeByName(ctx, name))
+    return existing;
+
+  // {i64 len, ptr rows}: a rank-1 array whose elements are row descriptors.
+  return llvm::StructType::create(
+      ctx, {llvm::Type::getInt64Ty(ctx), llvm::PointerType::get(ctx, 0)},
+      name);
+}
+
 bool TypeResolver::isString(llvm::Type *ty) {
   return ty && ty->isStructTy() &&
          llvm::cast<llvm::StructType>(ty)->getName() == "string";
@@ -128,6 +152,11 @@ bool TypeResolver::isArray(llvm::Type *ty) {
          llvm::cast<llvm::StructType>(ty)->getName().starts_with("array.");
 }
 
+bool TypeResolver::isJagged(llvm::Type *ty) {
+  return isArray(ty) &&
+         llvm::cast<llvm::StructType>(ty)->getName().starts_with("array.row.");
+}
+
 bool TypeResolver::isNumeric(llvm::Type *ty) {
   return ty && (ty->isIntegerTy() || ty->isFloatingPointTy());
 }
@@ -143,6 +172,12 @@ llvm::Type *TypeResolver::elemType(llvm::LLVMContext &ctx,
   return fromName(ctx, innerName);
 }
 
+unsigned TypeResolver::arrayRank(llvm::Type *ty) {
+  if (!isArray(ty))
+    return 0;
+  return llvm::cast<llvm::StructType>(ty)->getNumElements() - 1;
+}
+
 llvm::Type *TypeResolver::largerType(llvm::Type *a, llvm::Type *b) {
   if (!a || !b)
     return a ? a : b;
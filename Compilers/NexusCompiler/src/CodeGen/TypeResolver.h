@@ -10,16 +10,23 @@
 
 class TypeResolver {
 public:
-  static llvm::Type *fromName(llvm::LLVMContext &ctx, const std::string &t);
+  static llvm::Type *fromName(llvm::LLVMContext &ctx, llvm::StringRef t);
   static llvm::Type *fromTypeDesc(llvm::LLVMContext &ctx, const TypeDesc &td);
   static llvm::StructType *getStringType(llvm::LLVMContext &ctx);
   static llvm::StructType *getOrCreateArrayStruct(llvm::LLVMContext &ctx,
                                                   llvm::Type *elementType);
+  // A jagged array (new T[][n]): a 1-D array whose elements are rowType
+  // arrays, each with a buffer and length of its own.
+  static llvm::StructType *getOrCreateJaggedStruct(llvm::LLVMContext &ctx,
+                                                   llvm::Type *rowType);
   static bool isString(llvm::Type *ty);
   static bool isArray(llvm::Type *ty);
+  static bool isJagged(llvm::Type *ty);
   static bool isNumeric(llvm::Type *ty);
   static bool isPtr(llvm::Type *ty);
   static llvm::Type *elemType(llvm::LLVMContext &ctx, llvm::StructType *arrTy);
+  // Number of dimensions of an array type; 0 for anything else.
+  static unsigned arrayRank(llvm::Type *ty);
   static llvm::Type *largerType(llvm::Type *a, llvm::Type *b);
   static llvm::Value *coerce(llvm::IRBuilder<> &B, llvm::Value *val,
                              llvm::Type *target, bool srcUnsigned = false);
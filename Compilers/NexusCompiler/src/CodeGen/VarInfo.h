@@ -2,9 +2,9 @@
 #ifndef VARINFO_H
 #define VARINFO_H
 
+#include "ScopedSymbolTable.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Type.h"
-#include <string>
 
 // ---------------------------------------------------- //
 // Per-variable metadata tracked during code generation //
@@ -17,15 +17,16 @@ struct VarInfo {
   bool isReference = false;
   bool isConst = false;
   llvm::Type *pointeeType = nullptr;
-  std::string sourceName;
   bool ownsHeap = false;
 
   VarInfo() = default;
   VarInfo(llvm::Value *a, llvm::Type *t, bool borrowed, bool moved,
-          bool ref = false, bool c = false, std::string src = "")
+          bool ref = false, bool c = false)
       : allocaInst(a), type(t), isBorrowed(borrowed), isMoved(moved),
-        isReference(ref), isConst(c), sourceName(std::move(src)),
-        ownsHeap(false) {}
+        isReference(ref), isConst(c), ownsHeap(false) {}
 };
 
+// Variables visible at the current point of code generation.
+using VarTable = ScopedSymbolTable<VarInfo>;
+
 #endif // VARINFO_H
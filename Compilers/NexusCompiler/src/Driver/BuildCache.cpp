@@ -0,0 +1,209 @@
+#include "BuildCache.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/SHA1.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+
+static const char *const kManifestHeader = "nexus-manifest 1";
+
+static std::string hashString(const std::string &data) {
+  auto digest = llvm::SHA1::hash(llvm::ArrayRef<uint8_t>(
+      reinterpret_cast<const uint8_t *>(data.data()), data.size()));
+  return llvm::toHex(digest, /*LowerCase=*/true);
+}
+
+static std::optional<std::string> hashFile(const fs::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return std::nullopt;
+  std::string content((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+  return hashString(content);
+}
+
+static fs::path canonicalOrSelf(const fs::path &p) {
+  std::error_code ec;
+  fs::path c = fs::weakly_canonical(p, ec);
+  return ec ? p : c;
+}
+
+// Writes data to dest atomically: a uniquely named sibling is written first
+// and then renamed over dest.
+static bool writeAtomically(const fs::path &dest, const std::string &data) {
+  std::random_device rd;
+  fs::path tmp = dest;
+  tmp += ".tmp" + std::to_string(rd());
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    if (!out)
+      return false;
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!out)
+      return false;
+  }
+  std::error_code ec;
+  fs::rename(tmp, dest, ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+BuildCache::BuildCache(fs::path root, std::string configKey)
+    : root_(std::move(root)) {
+  std::error_code ec;
+  fs::create_directories(root_ / "manifests", ec);
+  fs::create_directories(root_ / "objects", ec);
+  fs::create_directories(root_ / "compiler", ec);
+  configKey_ = std::move(configKey) + "|compiler " + compilerHash() +
+               "|llvm " LLVM_VERSION_STRING "|" LLVM_HOST_TRIPLE;
+}
+
+// Identifies the running nexus by the content of its binary, so a rebuilt
+// compiler never reuses objects from an older one. Hashing the binary takes
+// a moment; the result is memoised per path, size and mtime.
+std::string BuildCache::compilerHash() const {
+  std::string exe = llvm::sys::fs::getMainExecutable(
+      nullptr, reinterpret_cast<void *>(&hashString));
+  std::error_code ec;
+  std::uintmax_t size = exe.empty() ? 0 : fs::file_size(exe, ec);
+  fs::file_time_type mtime;
+  if (!ec && !exe.empty())
+    mtime = fs::last_write_time(exe, ec);
+  if (exe.empty() || ec)
+    return "unknown";
+
+  std::string stamp = exe + '\0' + std::to_string(size) + '\0' +
+                      std::to_string(mtime.time_since_epoch().count());
+  fs::path memo = root_ / "compiler" / hashString(stamp);
+  {
+    std::ifstream in(memo);
+    std::string known;
+    if (std::getline(in, known) && !known.empty())
+      return known;
+  }
+
+  auto hash = hashFile(exe);
+  if (!hash)
+    return stamp;
+  writeAtomically(memo, *hash + "\n");
+  return *hash;
+}
+
+fs::path BuildCache::manifestPath(const fs::path &entry) const {
+  return root_ / "manifests" /
+         hashString(canonicalOrSelf(entry).string() + '\0' + configKey_);
+}
+
+std::optional<fs::path> BuildCache::lookup(const fs::path &entry) const {
+  std::ifstream in(manifestPath(entry));
+  if (!in)
+    return std::nullopt;
+
+  std::string line;
+  if (!std::getline(in, line) || line != kManifestHeader)
+    return std::nullopt;
+
+  std::string objectName;
+  if (!std::getline(in, objectName) || objectName.empty())
+    return std::nullopt;
+
+  // Every recorded input must still hash to the same value.
+  while (std::getline(in, line)) {
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos)
+      return std::nullopt;
+    auto current = hashFile(line.substr(tab + 1));
+    if (!current || *current != line.substr(0, tab))
+      return std::nullopt;
+  }
+
+  fs::path object = root_ / "objects" / objectName;
+  std::error_code ec;
+  if (!fs::is_regular_file(object, ec))
+    return std::nullopt;
+
+  // Mark the entry as recently used for prune().
+  auto now = fs::file_time_type::clock::now();
+  fs::last_write_time(object, now, ec);
+  fs::last_write_time(manifestPath(entry), now, ec);
+  return object;
+}
+
+void BuildCache::store(const fs::path &entry, const std::vector<fs::path> &deps,
+                       const fs::path &artifact) const {
+  std::ostringstream inputs;
+  std::vector<fs::path> all{canonicalOrSelf(entry)};
+  for (const auto &d : deps)
+    all.push_back(canonicalOrSelf(d));
+
+  for (const auto &p : all) {
+    auto h = hashFile(p);
+    if (!h)
+      return;
+    inputs << *h << '\t' << p.string() << '\n';
+  }
+
+  std::ifstream in(artifact, std::ios::binary);
+  if (!in)
+    return;
+  std::string data((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+
+  std::string objectName =
+      hashString(configKey_ + '\0' + inputs.str()) +
+      artifact.extension().string();
+  if (!writeAtomically(root_ / "objects" / objectName, data))
+    return;
+
+  writeAtomically(manifestPath(entry), std::string(kManifestHeader) + "\n" +
+                                           objectName + "\n" + inputs.str());
+}
+
+void BuildCache::prune(std::uintmax_t maxBytes) const {
+  struct File {
+    fs::path path;
+    fs::file_time_type used;
+    std::uintmax_t size;
+  };
+  std::vector<File> files;
+  std::uintmax_t total = 0;
+
+  for (const char *dir : {"manifests", "objects"}) {
+    std::error_code ec;
+    for (fs::directory_iterator it(root_ / dir, ec), end; !ec && it != end;
+         it.increment(ec)) {
+      // Leave other processes' in-flight writes alone.
+      if (it->path().filename().string().find(".tmp") != std::string::npos)
+        continue;
+      std::error_code fileEc;
+      std::uintmax_t size = it->file_size(fileEc);
+      fs::file_time_type used = it->last_write_time(fileEc);
+      if (fileEc)
+        continue;
+      files.push_back({it->path(), used, size});
+      total += size;
+    }
+  }
+  if (total <= maxBytes)
+    return;
+
+  std::sort(files.begin(), files.end(),
+            [](const File &a, const File &b) { return a.used < b.used; });
+  for (const File &f : files) {
+    if (total <= maxBytes)
+      break;
+    std::error_code ec;
+    fs::remove(f.path, ec);
+    total -= f.size;
+  }
+}
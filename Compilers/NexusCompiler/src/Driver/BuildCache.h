@@ -0,0 +1,65 @@
+#ifndef BUILD_CACHE_H
+#define BUILD_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Persistent, content-addressed cache of compiled artifacts.
+//
+// Layout under the cache root (by default ~/.config/nexus/cache):
+//   manifests/<key>   one per entry file and configuration; lists every
+//                     source the last build read (entry + transitive
+//                     imports) together with its content hash
+//   objects/<key><ext> the artifact produced from exactly those sources
+//   compiler/<key>    memoised hash of a nexus binary, see below
+//
+// A lookup re-hashes the recorded sources; if none changed, the stored
+// artifact is reused and lexing, parsing, import resolution and codegen are
+// skipped. Entries are per entry file, not per module: imports are compiled
+// into the object of the file that imports them, so there is no artifact of
+// an imported module on its own to reuse, and editing an import invalidates
+// every entry file that read it.
+//
+// The configuration key covers the compiler binary (by content hash, so any
+// rebuild of nexus starts a fresh cache), the LLVM version, the target
+// triple, the standard library root and every flag that affects the
+// artifact. Builds that reported diagnostics, their imports' included, are
+// never stored. Writes go through a temp file plus rename, so concurrent
+// nexus processes can share a cache.
+//
+// A hit refreshes the entry's timestamps; prune() deletes the least
+// recently used entries once the cache outgrows its size limit.
+class BuildCache {
+public:
+  // Size the driver prunes the cache down to after every run.
+  static constexpr std::uintmax_t kDefaultMaxBytes = 512ull << 20;
+
+  BuildCache(fs::path root, std::string configKey);
+
+  // Returns the cached artifact for entry, if all recorded inputs are
+  // unchanged since it was stored.
+  std::optional<fs::path> lookup(const fs::path &entry) const;
+
+  // Records artifact as the result of compiling entry, which read the given
+  // dependency files. Failures are silently ignored (the cache is optional).
+  void store(const fs::path &entry, const std::vector<fs::path> &deps,
+             const fs::path &artifact) const;
+
+  // Deletes least recently used manifests and objects until the cache holds
+  // at most maxBytes. Files another process removes first are skipped.
+  void prune(std::uintmax_t maxBytes) const;
+
+private:
+  fs::path root_;
+  std::string configKey_;
+
+  fs::path manifestPath(const fs::path &entry) const;
+  std::string compilerHash() const;
+};
+
+#endif // BUILD_CACHE_H
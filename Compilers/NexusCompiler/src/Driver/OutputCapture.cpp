@@ -0,0 +1,81 @@
+#include "OutputCapture.h"
+
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+
+static thread_local OutputCapture *activeCapture = nullptr;
+
+// Unbuffered streambuf installed on std::cout / std::cerr. Every write
+// either lands in the calling thread's capture or goes to the original
+// buffer.
+class RoutingBuf : public std::streambuf {
+public:
+  RoutingBuf(std::streambuf *target, bool isErr)
+      : target_(target), isErr_(isErr) {}
+
+  std::streambuf *target() const { return target_; }
+
+protected:
+  int_type overflow(int_type ch) override {
+    if (traits_type::eq_int_type(ch, traits_type::eof()))
+      return traits_type::not_eof(ch);
+    char c = traits_type::to_char_type(ch);
+    return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+  }
+
+  std::streamsize xsputn(const char *s, std::streamsize n) override {
+    if (activeCapture) {
+      activeCapture->append(isErr_, s, n);
+      return n;
+    }
+    return target_->sputn(s, n);
+  }
+
+  int sync() override { return activeCapture ? 0 : target_->pubsync(); }
+
+private:
+  std::streambuf *target_;
+  bool isErr_;
+};
+
+static RoutingBuf *outBuf = nullptr;
+static RoutingBuf *errBuf = nullptr;
+
+void OutputCapture::install() {
+  static std::once_flag once;
+  std::call_once(once, [] {
+    // Intentionally leaked: std::cout / std::cerr keep using them until exit.
+    outBuf = new RoutingBuf(std::cout.rdbuf(), false);
+    errBuf = new RoutingBuf(std::cerr.rdbuf(), true);
+    std::cout.rdbuf(outBuf);
+    std::cerr.rdbuf(errBuf);
+  });
+}
+
+OutputCapture::OutputCapture() : previous_(activeCapture) {
+  activeCapture = this;
+}
+
+OutputCapture::~OutputCapture() { activeCapture = previous_; }
+
+void OutputCapture::append(bool isErr, const char *s, std::streamsize n) {
+  // Merge consecutive writes to the same stream into one chunk.
+  if (chunks_.empty() || chunks_.back().isErr != isErr)
+    chunks_.push_back({isErr, std::string()});
+  chunks_.back().text.append(s, static_cast<size_t>(n));
+}
+
+std::vector<OutputCapture::Chunk> OutputCapture::take() {
+  std::vector<Chunk> out;
+  out.swap(chunks_);
+  return out;
+}
+
+void OutputCapture::replay(const std::vector<Chunk> &chunks) {
+  for (const auto &c : chunks) {
+    std::ostream &os = c.isErr ? std::cerr : std::cout;
+    os.write(c.text.data(), static_cast<std::streamsize>(c.text.size()));
+    os.flush();
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef OUTPUT_CAPTURE_H
+#define OUTPUT_CAPTURE_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Per-thread capture of std::cout / std::cerr for parallel compilation.
+//
+// OutputCapture::install() routes both streams through a buffer that checks
+// whether the writing thread has an active capture. Threads without one
+// write straight through as before; threads with one record every write,
+// tagged with its stream, so the driver can replay a whole compilation's
+// output later in a deterministic order.
+class OutputCapture {
+public:
+  struct Chunk {
+    bool isErr;
+    std::string text;
+  };
+
+  // Swaps the std::cout / std::cerr buffers for the routing buffers.
+  // Idempotent; must be called before any worker thread starts.
+  static void install();
+
+  // Starts capturing on the current thread; stops on destruction.
+  OutputCapture();
+  ~OutputCapture();
+  OutputCapture(const OutputCapture &) = delete;
+  OutputCapture &operator=(const OutputCapture &) = delete;
+
+  // Returns everything captured so far and clears the buffer.
+  std::vector<Chunk> take();
+
+  // Writes captured chunks back to the real std::cout / std::cerr.
+  static void replay(const std::vector<Chunk> &chunks);
+
+private:
+  friend class RoutingBuf;
+  void append(bool isErr, const char *s, std::streamsize n);
+
+  std::vector<Chunk> chunks_;
+  OutputCapture *previous_;
+};
+
+#endif // OUTPUT_CAPTURE_H
@@ -0,0 +1,50 @@
+#ifndef TEMP_DIR_H
+#define TEMP_DIR_H
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <system_error>
+
+// Private scratch directory for intermediate artifacts of one nexus run.
+// Created under the system temp directory with a random name so that
+// concurrent invocations never share files; removed with its contents
+// when the object is destroyed.
+class TempDir {
+public:
+  TempDir() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path base = fs::temp_directory_path(ec);
+    if (ec)
+      base = fs::current_path();
+
+    std::random_device rd;
+    std::mt19937_64 rng((static_cast<unsigned long long>(rd()) << 32) ^ rd());
+    for (int attempt = 0; attempt < 16; ++attempt) {
+      fs::path candidate = base / ("nexus-" + std::to_string(rng()));
+      if (fs::create_directory(candidate, ec) && !ec) {
+        path_ = candidate;
+        return;
+      }
+    }
+  }
+
+  ~TempDir() {
+    if (!path_.empty()) {
+      std::error_code ec;
+      std::filesystem::remove_all(path_, ec);
+    }
+  }
+
+  TempDir(const TempDir &) = delete;
+  TempDir &operator=(const TempDir &) = delete;
+
+  bool valid() const { return !path_.empty(); }
+  const std::filesystem::path &path() const { return path_; }
+
+private:
+  std::filesystem::path path_;
+};
+
+#endif // TEMP_DIR_H
@@ -0,0 +1,202 @@
+#include "TimeReport.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static thread_local TimeReport *activeReport = nullptr;
+
+TimeReport::TimeReport() : previous_(activeReport) { activeReport = this; }
+
+TimeReport::~TimeReport() { activeReport = previous_; }
+
+TimeReport *TimeReport::current() { return activeReport; }
+
+double TimeReport::nowUs() {
+  static const Clock::time_point epoch = Clock::now();
+  return std::chrono::duration<double, std::micro>(Clock::now() - epoch)
+      .count();
+}
+
+void TimeReport::count(const char *name, size_t n) {
+  TimeReport *r = activeReport;
+  if (!r)
+    return;
+  for (auto &c : r->counters_)
+    if (c.first == name) {
+      c.second += n;
+      return;
+    }
+  r->counters_.emplace_back(name, n);
+}
+
+size_t TimeReport::begin(std::string name, std::string detail) {
+  regions_.push_back(
+      {std::move(name), std::move(detail), nowUs(), 0.0, depth_++});
+  return regions_.size() - 1;
+}
+
+void TimeReport::end(size_t region) {
+  Region &r = regions_[region];
+  r.durUs = nowUs() - r.startUs;
+  --depth_;
+}
+
+void TimeReport::beginPass(std::string_view name) {
+  std::string key(name);
+  auto it = passIndex_.find(key);
+  if (it == passIndex_.end()) {
+    it = passIndex_.emplace(key, passes_.size()).first;
+    passes_.push_back({std::move(key), 0.0, 0});
+  }
+  passStack_.push_back({it->second, nowUs(), 0.0});
+}
+
+void TimeReport::endPass() {
+  if (passStack_.empty())
+    return;
+  OpenPass p = passStack_.back();
+  passStack_.pop_back();
+  double total = nowUs() - p.startUs;
+  passes_[p.slot].selfUs += total - p.childUs;
+  ++passes_[p.slot].calls;
+  if (!passStack_.empty())
+    passStack_.back().childUs += total;
+}
+
+void TimeReport::print(std::ostream &os, const std::string &title,
+                       bool withTimes) const {
+  std::ios_base::fmtflags flags = os.flags();
+  std::streamsize precision = os.precision();
+  os << std::fixed;
+
+  os << "\n--- " << (withTimes ? "Time report" : "Stats") << ": " << title
+     << " ---\n";
+
+  if (withTimes) {
+    double totalUs = 0.0;
+    for (const Region &r : regions_)
+      if (r.depth == 0)
+        totalUs += r.durUs;
+
+    os << "   Wall (ms)   Share  Phase\n";
+    for (const Region &r : regions_) {
+      double share = totalUs > 0.0 ? 100.0 * r.durUs / totalUs : 0.0;
+      os << std::setw(12) << std::setprecision(3) << r.durUs / 1000.0
+         << std::setw(7) << std::setprecision(1) << share << "%  "
+         << std::string(2 * r.depth, ' ') << r.name;
+      if (!r.detail.empty())
+        os << "  " << r.detail;
+      os << "\n";
+    }
+
+    if (!passes_.empty()) {
+      std::vector<const PassTime *> sorted;
+      for (const PassTime &p : passes_)
+        sorted.push_back(&p);
+      std::stable_sort(sorted.begin(), sorted.end(),
+                       [](const PassTime *a, const PassTime *b) {
+                         return a->selfUs > b->selfUs;
+                       });
+
+      // The long tail of an -O2 pipeline is noise; show the costliest.
+      const size_t shown = std::min<size_t>(sorted.size(), 20);
+      os << "\n  LLVM passes (self time)\n";
+      os << "   Wall (ms)   Calls  Pass\n";
+      for (size_t i = 0; i < shown; ++i)
+        os << std::setw(12) << std::setprecision(3)
+           << sorted[i]->selfUs / 1000.0 << std::setw(8) << sorted[i]->calls
+           << "  " << sorted[i]->name << "\n";
+      if (shown < sorted.size())
+        os << "  (" << sorted.size() - shown << " more)\n";
+    }
+    os << "\n";
+  }
+
+  for (const auto &c : counters_)
+    os << "  " << std::left << std::setw(30) << c.first << std::right
+       << ": " << c.second << "\n";
+
+  os.flags(flags);
+  os.precision(precision);
+}
+
+// ------------ //
+// Chrome trace //
+// ------------ //
+
+static void writeJsonString(std::ostream &os, const std::string &s) {
+  os << '"';
+  for (char c : s) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (u < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", u);
+      os << buf;
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+void TraceLog::add(const TimeReport &report, size_t lane,
+                   const std::string &label) {
+  std::lock_guard<std::mutex> guard(lock_);
+  lanes_.push_back({lane, label, report.regions()});
+}
+
+bool TraceLog::write(const std::string &path) const {
+  std::ofstream out(path);
+  if (!out.is_open())
+    return false;
+
+  std::lock_guard<std::mutex> guard(lock_);
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (const Lane &lane : lanes_) {
+    out << (first ? "\n" : ",\n");
+    first = false;
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << lane.id << ",\"args\":{\"name\":";
+    writeJsonString(out, lane.label);
+    out << "}}";
+    for (const TimeReport::Region &r : lane.regions) {
+      out << ",\n{\"name\":";
+      writeJsonString(out, r.name);
+      out << ",\"cat\":\"nexus\",\"ph\":\"X\",\"ts\":" << r.startUs
+          << ",\"dur\":" << r.durUs << ",\"pid\":1,\"tid\":" << lane.id;
+      if (!r.detail.empty()) {
+        out << ",\"args\":{\"detail\":";
+        writeJsonString(out, r.detail);
+        out << "}";
+      }
+      out << "}";
+    }
+  }
+  out << "\n]}\n";
+  return static_cast<bool>(out);
+}
+
+size_t peakRssBytes() {
+#ifdef _WIN32
+  return 0;
+#else
+  rusage ru{};
+  if (getrusage(RUSAGE_SELF, &ru) != 0)
+    return 0;
+#ifdef __APPLE__
+  return static_cast<size_t>(ru.ru_maxrss); // bytes
+#else
+  return static_cast<size_t>(ru.ru_maxrss) * 1024; // kilobytes
+#endif
+#endif
+}
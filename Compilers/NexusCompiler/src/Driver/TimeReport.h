@@ -0,0 +1,128 @@
+#ifndef TIME_REPORT_H
+#define TIME_REPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Per-thread record of where one compilation spent its time (--time-report,
+// --stats, --trace).
+//
+// A TimeReport is made current for its thread on construction, like
+// OutputCapture. TimeScope regions and counters opened anywhere on that
+// thread are recorded into it, including those in the module cache and the
+// code generator. With no report active, TimeScope and count() cost one
+// thread-local load. Regions nest; they are kept in the order they were
+// opened, together with their depth.
+class TimeReport {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Region {
+    std::string name;
+    std::string detail; // file, module or artifact the region worked on
+    double startUs;     // since the process-wide epoch
+    double durUs;
+    unsigned depth;
+  };
+
+  struct PassTime {
+    std::string name;
+    double selfUs = 0.0;
+    size_t calls = 0;
+  };
+
+  TimeReport();
+  ~TimeReport();
+  TimeReport(const TimeReport &) = delete;
+  TimeReport &operator=(const TimeReport &) = delete;
+
+  // The report active on the calling thread, or null.
+  static TimeReport *current();
+
+  // Adds n to the named counter of the active report, if any.
+  static void count(const char *name, size_t n = 1);
+
+  size_t begin(std::string name, std::string detail);
+  void end(size_t region);
+
+  // LLVM pass timing. Passes nest (adaptors and pass managers run other
+  // passes); each one is charged only its own time, so the totals add up.
+  void beginPass(std::string_view name);
+  void endPass();
+
+  const std::vector<Region> &regions() const { return regions_; }
+
+  // Prints the region tree, the pass table and the counters. Timings are
+  // left out when withTimes is false (--stats alone).
+  void print(std::ostream &os, const std::string &title,
+             bool withTimes) const;
+
+  // Microseconds since the first call, shared by every thread.
+  static double nowUs();
+
+private:
+  struct OpenPass {
+    size_t slot;
+    double startUs;
+    double childUs;
+  };
+
+  TimeReport *previous_;
+  std::vector<Region> regions_;
+  unsigned depth_ = 0;
+  std::vector<std::pair<std::string, size_t>> counters_;
+  std::vector<PassTime> passes_;
+  std::unordered_map<std::string, size_t> passIndex_;
+  std::vector<OpenPass> passStack_;
+};
+
+// Times the enclosing block as a region of the thread's active report.
+class TimeScope {
+public:
+  explicit TimeScope(const char *name, std::string detail = {})
+      : report_(TimeReport::current()) {
+    if (report_)
+      region_ = report_->begin(name, std::move(detail));
+  }
+  ~TimeScope() {
+    if (report_)
+      report_->end(region_);
+  }
+  TimeScope(const TimeScope &) = delete;
+  TimeScope &operator=(const TimeScope &) = delete;
+
+private:
+  TimeReport *report_;
+  size_t region_ = 0;
+};
+
+// Regions of every compiled input, written out as Chrome trace-event JSON
+// (load in chrome://tracing or Perfetto). Each input gets its own track.
+class TraceLog {
+public:
+  // Thread-safe; called by each worker once its input is done.
+  void add(const TimeReport &report, size_t lane, const std::string &label);
+
+  bool write(const std::string &path) const;
+
+private:
+  struct Lane {
+    size_t id;
+    std::string label;
+    std::vector<TimeReport::Region> regions;
+  };
+
+  mutable std::mutex lock_;
+  std::vector<Lane> lanes_;
+};
+
+// Peak resident set size of the process in bytes, or 0 if unknown.
+size_t peakRssBytes();
+
+#endif // TIME_REPORT_H
@@ -1,24 +1,167 @@
 #include "FileReader.h"
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <iostream>
-#include <iterator>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
-std::string fileToString(const std::string &filename) {
-  std::ifstream file(filename, std::ios::binary);
-  return std::string(std::istreambuf_iterator<char>(file),
-                     std::istreambuf_iterator<char>());
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*--------------*/
+/* SourceBuffer */
+/*--------------*/
+
+SourceBuffer::SourceBuffer() : heap_(kPadding, '\0') { data_ = heap_.data(); }
+
+SourceBuffer::SourceBuffer(std::string text) : heap_(std::move(text)) {
+  size_ = heap_.size();
+  heap_.append(kPadding, '\0');
+  data_ = heap_.data();
+}
+
+SourceBuffer::~SourceBuffer() { release(); }
+
+SourceBuffer::SourceBuffer(SourceBuffer &&other) noexcept
+    : size_(other.size_), mapping_(other.mapping_),
+      mappingLen_(other.mappingLen_), heap_(std::move(other.heap_)) {
+  data_ = mapping_ ? static_cast<const char *>(mapping_) : heap_.data();
+  other.mapping_ = nullptr;
+  other.mappingLen_ = 0;
+  other.size_ = 0;
+  other.heap_.assign(kPadding, '\0');
+  other.data_ = other.heap_.data();
+}
+
+SourceBuffer &SourceBuffer::operator=(SourceBuffer &&other) noexcept {
+  if (this != &other) {
+    release();
+    size_ = other.size_;
+    mapping_ = other.mapping_;
+    mappingLen_ = other.mappingLen_;
+    heap_ = std::move(other.heap_);
+    data_ = mapping_ ? static_cast<const char *>(mapping_) : heap_.data();
+    other.mapping_ = nullptr;
+    other.mappingLen_ = 0;
+    other.size_ = 0;
+    other.heap_.assign(kPadding, '\0');
+    other.data_ = other.heap_.data();
+  }
+  return *this;
+}
+
+void SourceBuffer::release() {
+#ifndef _WIN32
+  if (mapping_)
+    munmap(mapping_, mappingLen_);
+#endif
+  mapping_ = nullptr;
+  mappingLen_ = 0;
+}
+
+#ifndef _WIN32
+
+// Reads everything left on fd; used for pipes and other unmappable files.
+static std::string readAll(int fd, const std::string &path) {
+  std::string out;
+  char chunk[64 * 1024];
+  for (;;) {
+    ssize_t n = ::read(fd, chunk, sizeof(chunk));
+    if (n == 0)
+      break;
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error("cannot read '" + path +
+                               "': " + std::strerror(errno));
+    }
+    out.append(chunk, static_cast<size_t>(n));
+  }
+  return out;
 }
 
-std::optional<std::string> readFile(const char *name) {
+// Maps size bytes of fd followed by zero padding. The whole range is first
+// reserved as anonymous zero pages, then the file is mapped over its start;
+// the kernel zero-fills the tail of the file's last page. Returns nullptr
+// if either mapping fails.
+static void *mapPadded(int fd, size_t size, size_t &mappingLen) {
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  mappingLen = (size + SourceBuffer::kPadding + page - 1) / page * page;
+
+  void *base = mmap(nullptr, mappingLen, PROT_READ,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+    return nullptr;
+  void *file = mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+  if (file == MAP_FAILED) {
+    munmap(base, mappingLen);
+    return nullptr;
+  }
+  return base;
+}
+
+SourceBuffer SourceBuffer::open(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::runtime_error("cannot open '" + path + "'");
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    SourceBuffer buf;
+    size_t size = static_cast<size_t>(st.st_size);
+    if (void *base = mapPadded(fd, size, buf.mappingLen_)) {
+      ::close(fd);
+      buf.mapping_ = base;
+      buf.data_ = static_cast<const char *>(base);
+      buf.size_ = size;
+      return buf;
+    }
+  }
+
+  // Pipe, device, empty file or mmap failure: fall back to reading.
+  try {
+    SourceBuffer buf(readAll(fd, path));
+    ::close(fd);
+    return buf;
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+}
+
+#else
+
+SourceBuffer SourceBuffer::open(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("cannot open '" + path + "'");
+  std::string text;
+  char chunk[64 * 1024];
+  while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0)
+    text.append(chunk, static_cast<size_t>(file.gcount()));
+  return SourceBuffer(std::move(text));
+}
+
+#endif
+
+/*----------*/
+/* readFile */
+/*----------*/
+
+std::optional<SourceBuffer> readFile(const char *name) {
   std::string filename = name;
 
   try {
 
     std::cout << "File : " << filename << "\n";
-    std::string content = fileToString(filename);
-    return content;
+    return SourceBuffer::open(filename);
 
   } catch (const std::exception &e) {
     std::cerr << "Error: " << e.what() << "\n";
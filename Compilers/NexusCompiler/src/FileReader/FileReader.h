@@ -1,9 +1,48 @@
 #ifndef File_Reader
 #define File_Reader
 
+#include <cstddef>
 #include <optional>
 #include <string>
+#include <string_view>
 
-std::optional<std::string> readFile(const char *name);
+// Read-only bytes of one source file.
+//
+// Regular files are memory-mapped; pipes, character devices and anything
+// mmap refuses are read into memory instead. Either way the contents are
+// followed by at least kPadding zero bytes, so vectorised scanners may load
+// a full chunk past size() without bounds checks.
+class SourceBuffer {
+public:
+  static constexpr size_t kPadding = 64;
+
+  SourceBuffer();
+  explicit SourceBuffer(std::string text);
+  ~SourceBuffer();
+
+  SourceBuffer(SourceBuffer &&other) noexcept;
+  SourceBuffer &operator=(SourceBuffer &&other) noexcept;
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+  std::string_view view() const { return std::string_view(data_, size_); }
+  bool isMapped() const { return mapping_ != nullptr; }
+
+  // Maps or reads the file at path. Throws std::runtime_error on failure.
+  static SourceBuffer open(const std::string &path);
+
+private:
+  const char *data_;
+  size_t size_ = 0;
+  void *mapping_ = nullptr; // mmap'd region, including the zero pages
+  size_t mappingLen_ = 0;
+  std::string heap_; // contents plus padding when not mapped
+
+  void release();
+};
+
+std::optional<SourceBuffer> readFile(const char *name);
 
 #endif
@@ -1,6 +1,6 @@
 #include "Lexer.h"
+#include "../Token/Keywords.h"
 #include <cstdint>
-#include <emmintrin.h>
 #include <iostream>
 
 /*------------*/
@@ -372,74 +372,6 @@ static inline InputCat classify(char c) {
   return uc < 128 ? catTable[uc] : InputCat::OTHER;
 }
 
-/*-----------------*/
-/* Keyword matcher */
-/*-----------------*/
-
-static inline TokenKind keywordOrIdent(std::string_view w) {
-  switch (w.size()) {
-  case 2:
-    if (w == "if")
-      return TokenKind::IF;
-    if (w == "fn")
-      return TokenKind::FN;
-    if (w == "as")
-      return TokenKind::AS;
-    break;
-  case 3:
-    if (w == "new")
-      return TokenKind::NEW;
-    if (w == "for")
-      return TokenKind::FOR;
-    if (w == "mut")
-      return TokenKind::MUT;
-    break;
-  case 4:
-    if (w == "else")
-      return TokenKind::ElSE;
-    if (w == "true")
-      return TokenKind::LIT_BOOL;
-    if (w == "loop")
-      return TokenKind::LOOP;
-    if (w == "enum")
-      return TokenKind::ENUM;
-    break;
-  case 5:
-    if (w == "while")
-      return TokenKind::WHILE;
-    if (w == "false")
-      return TokenKind::LIT_BOOL;
-    if (w == "const")
-      return TokenKind::CONST;
-    if (w == "break")
-      return TokenKind::BREAK;
-    if (w == "match")
-      return TokenKind::MATCH;
-    break;
-  case 6:
-    if (w == "return")
-      return TokenKind::RETURN;
-    if (w == "import")
-      return TokenKind::IMPORT;
-    if (w == "public")
-      return TokenKind::PUBLIC;
-    break;
-  case 7:
-    if (w == "private")
-      return TokenKind::PRIVATE;
-    break;
-  case 8:
-    if (w == "continue")
-      return TokenKind::CONTINUE;
-    break;
-  case 9:
-    if (w == "protected")
-      return TokenKind::PRIVATE;
-    break;
-  }
-  return TokenKind::IDENTIFIER;
-}
-
 /*-------------------*/
 /* Single-char kinds */
 /*-------------------*/
@@ -477,33 +409,29 @@ static inline TokenKind singleCharKind(char c) {
 /* Comment skippers */
 /*------------------*/
 
-static inline size_t skipLineComment(const char *src, size_t pos, size_t srcLen,
-                                     size_t &col) {
-  while (pos < srcLen && src[pos] != '\n') {
-    ++pos;
-    ++col;
-  }
-  return pos;
+void Lexer::skipLineComment() {
+  const char *p = scan.untilByte(src + pos, src + srcLen, '\n', line, col);
+  pos = static_cast<size_t>(p - src);
 }
 
-static inline size_t skipBlockComment(const char *src, size_t pos,
-                                      size_t srcLen, char closeA, char closeB,
-                                      size_t &line, size_t &col) {
-  while (pos + 1 < srcLen) {
-    if (src[pos] == closeA && src[pos + 1] == closeB) {
-      pos += 2;
+void Lexer::skipBlockComment(char closeA, char closeB) {
+  // The terminator is two bytes, so its first byte can't be the last one.
+  const char *last = src + srcLen - 1;
+  const char *p = src + pos;
+  while (p < last) {
+    p = scan.untilByte(p, last, closeA, line, col);
+    if (p >= last)
+      break;
+    if (p[1] == closeB) {
       col += 2;
-      return pos;
-    }
-    if (src[pos] == '\n') {
-      ++line;
-      col = 0;
+      pos = static_cast<size_t>(p + 2 - src);
+      return;
     }
     ++col;
-    ++pos;
+    ++p;
   }
   std::cerr << "\033[31mUnterminated block comment\033[0m\n";
-  return srcLen;
+  pos = srcLen;
 }
 
 /*--------------------*/
@@ -511,58 +439,7 @@ static inline size_t skipBlockComment(const char *src, size_t pos,
 /*--------------------*/
 
 void Lexer::skipWhitespace() {
-  const char *p = src + pos;
-  const char *end = src + srcLen;
-
-  // Scalar prefix — handles newlines and brings p to a natural alignment
-  // for the SIMD block (or exits early if already at non-whitespace).
-  auto scalarSkip = [&]() {
-    while (p < end && static_cast<unsigned char>(*p) <= 0x20) {
-      if (*p == '\n') {
-        ++line;
-        col = 0;
-      }
-      ++col;
-      ++p;
-    }
-  };
-
-  scalarSkip();
-
-  // SSE2: skip 16 bytes at a time when the entire chunk is whitespace.
-  const __m128i thresh = _mm_set1_epi8(0x20);
-  while (p + 16 <= end) {
-    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
-    __m128i cmp = _mm_cmpgt_epi8(chunk, thresh);
-    int mask = _mm_movemask_epi8(cmp);
-
-    if (mask != 0) {
-      // At least one non-whitespace byte in this chunk.
-      const int skip = __builtin_ctz(mask); // leading whitespace bytes
-      for (int i = 0; i < skip; ++i) {
-        if (p[i] == '\n') {
-          ++line;
-          col = 0;
-        }
-        ++col;
-      }
-      p += skip;
-      break;
-    }
-
-    // Whole 16-byte chunk is whitespace — track newlines and advance.
-    for (int i = 0; i < 16; ++i) {
-      if (p[i] == '\n') {
-        ++line;
-        col = 0;
-      }
-      ++col;
-    }
-    p += 16;
-  }
-
-  // Scalar tail — remainder after the last full 16-byte chunk.
-  scalarSkip();
+  const char *p = scan.whitespace(src + pos, src + srcLen, line, col);
   pos = static_cast<size_t>(p - src);
 }
 
@@ -570,18 +447,49 @@ void Lexer::skipWhitespace() {
 /* Token helper */
 /*--------------*/
 
+// spelling must be a view into src; the token records where, not what.
 Token Lexer::makeToken(TokenKind k, std::string_view spelling) const {
-  return Token(k, spelling, line, col);
+  return Token(k, base + static_cast<uint32_t>(spelling.data() - src),
+               static_cast<uint32_t>(spelling.size()), line, col);
+}
+
+// Identifiers are interned as they are lexed, so later phases can compare
+// and hash names by Symbol.
+Token Lexer::makeIdentifier(std::string_view spelling) const {
+  return Token(TokenKind::IDENTIFIER, Symbol::intern(spelling),
+               static_cast<uint32_t>(spelling.size()), line, col);
+}
+
+// Placeholder tokens ("<EOF>", "<UNKNOWN>") whose text is not in the source.
+Token Lexer::makeMarker(TokenKind k, std::string_view spelling) const {
+  return Token(k, spelling, static_cast<int>(line), static_cast<int>(col));
 }
 
 /*------------------------*/
 /* Main tokenisation loop */
 /*------------------------*/
 
+Token Lexer::next() {
+  Token tok(TokenKind::END_OF_FILE, 0u, 0u, line, col);
+  if (!lexToken(tok))
+    return makeMarker(TokenKind::END_OF_FILE, {});
+  ++lexed;
+  return tok;
+}
+
 std::vector<Token> Lexer::Tokenize() {
   std::vector<Token> tokens;
-  tokens.reserve(srcLen > 16 ? (srcLen / 4) + 8 : 8);
+  Token tok(TokenKind::END_OF_FILE, 0u, 0u, line, col);
+  while (lexToken(tok)) {
+    ++lexed;
+    tokens.push_back(tok);
+  }
+  return tokens;
+}
 
+// Scans the next token into out. Returns false, leaving out untouched, once
+// only whitespace and comments remain.
+bool Lexer::lexToken(Token &out) {
   while (pos < srcLen) {
     skipWhitespace();
     if (pos >= srcLen)
@@ -592,8 +500,8 @@ std::vector<Token> Lexer::Tokenize() {
     // Null byte → EOF marker (shouldn't appear in well-formed source).
     if (c == '\0') {
       ++pos;
-      tokens.push_back(makeToken(TokenKind::END_OF_FILE, "<EOF>"));
-      continue;
+      out = makeMarker(TokenKind::END_OF_FILE, "<EOF>");
+      return true;
     }
 
     // Comments — must be checked before the DFA so '//' isn't seen as two DIVs.
@@ -602,19 +510,19 @@ std::vector<Token> Lexer::Tokenize() {
       if (next == '/') {
         pos += 2;
         col += 2;
-        pos = skipLineComment(src, pos, srcLen, col);
+        skipLineComment();
         continue;
       }
       if (next == '*') {
         pos += 2;
         col += 2;
-        pos = skipBlockComment(src, pos, srcLen, '*', '/', line, col);
+        skipBlockComment('*', '/');
         continue;
       }
       if (next == '!') {
         pos += 2;
         col += 2;
-        pos = skipBlockComment(src, pos, srcLen, '!', '/', line, col);
+        skipBlockComment('!', '/');
         continue;
       }
     }
@@ -622,15 +530,15 @@ std::vector<Token> Lexer::Tokenize() {
     // '::' and ':'
     if (c == ':') {
       if (pos + 1 < srcLen && src[pos + 1] == ':') {
-        tokens.push_back(makeToken(TokenKind::COLON_COLON, "::"));
+        out = makeToken(TokenKind::COLON_COLON, std::string_view(src + pos, 2));
         pos += 2;
         col += 2;
       } else {
-        tokens.push_back(makeToken(TokenKind::COLON, ":"));
+        out = makeToken(TokenKind::COLON, std::string_view(src + pos, 1));
         ++pos;
         ++col;
       }
-      continue;
+      return true;
     }
 
     // Compound assignment operators: +=  -=  *=  /=
@@ -654,10 +562,10 @@ std::vector<Token> Lexer::Tokenize() {
         break;
       }
       if (kind != TokenKind::UNKNOWN) {
-        tokens.push_back(makeToken(kind, std::string_view(src + pos, 2)));
+        out = makeToken(kind, std::string_view(src + pos, 2));
         pos += 2;
         col += 2;
-        continue;
+        return true;
       }
     }
 
@@ -669,19 +577,18 @@ std::vector<Token> Lexer::Tokenize() {
     const State first = T[0][icat];
 
     if (first == State::END) {
-      tokens.push_back(
-          makeToken(singleCharKind(c), std::string_view(src + pos, 1)));
+      out = makeToken(singleCharKind(c), std::string_view(src + pos, 1));
       ++pos;
       ++col;
-      continue;
+      return true;
     }
 
     if (first == State::ERR) {
       std::cerr << "\033[31mUnknown symbol [" << c << "]\033[0m\n";
-      tokens.push_back(makeToken(TokenKind::UNKNOWN, "<UNKNOWN>"));
+      out = makeMarker(TokenKind::UNKNOWN, "<UNKNOWN>");
       ++pos;
       ++col;
-      continue;
+      return true;
     }
 
     const size_t spellingStart = pos;
@@ -694,6 +601,29 @@ std::vector<Token> Lexer::Tokenize() {
     State lastSignificantState = first;
 
     while (pos < srcLen) {
+      // Runs that loop on one state (identifier and digit characters,
+      // string bodies) are skipped in bulk; the DFA only sees the byte
+      // that ends them. One-byte lookahead keeps short tokens off the
+      // kernels.
+      const char *run = src + pos;
+      if (T[static_cast<int>(state)][static_cast<int>(classify(*run))] ==
+          state) {
+        if (state == State::S7)
+          run = scan.identifier(run, src + srcLen);
+        else if (state == State::S4 || state == State::S6)
+          run = scan.digits(run, src + srcLen);
+        else if (state == State::S14)
+          run = scan.untilByte(run, src + srcLen, '"', line, col);
+      }
+      if (run != src + pos) {
+        if (state != State::S14)
+          col += static_cast<size_t>(run - (src + pos));
+        pos = static_cast<size_t>(run - src);
+        lastSignificantState = state;
+        if (pos >= srcLen)
+          break;
+      }
+
       c = src[pos];
       const int icat2 = static_cast<int>(classify(c));
       const State ns = T[static_cast<int>(state)][icat2];
@@ -742,8 +672,8 @@ std::vector<Token> Lexer::Tokenize() {
       std::cerr << "\033[31mLexer error near ["
                 << std::string_view(src + spellingStart, pos - spellingStart)
                 << "]\033[0m\n";
-      tokens.push_back(makeToken(TokenKind::UNKNOWN, "<UNKNOWN>"));
-      continue;
+      out = makeMarker(TokenKind::UNKNOWN, "<UNKNOWN>");
+      return true;
     }
 
     const size_t spellingLen = pos - spellingStart;
@@ -756,11 +686,13 @@ std::vector<Token> Lexer::Tokenize() {
 
     const TokenKind finalKind =
         (lastSignificantState == State::S7)
-            ? keywordOrIdent(spelling)
+            ? keywordKind(spelling)
             : StateToToken[static_cast<size_t>(lastSignificantState)];
 
-    tokens.push_back(makeToken(finalKind, spelling));
+    out = finalKind == TokenKind::IDENTIFIER ? makeIdentifier(spelling)
+                                             : makeToken(finalKind, spelling);
+    return true;
   }
 
-  return tokens;
+  return false;
 }
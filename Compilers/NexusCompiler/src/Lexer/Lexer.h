@@ -2,27 +2,53 @@
 #define LEXER_H
 
 #include "../Token/TokenType.h"
+#include "Scan.h"
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
 
 class Lexer {
 public:
-  explicit Lexer(const std::string &source)
-      : src(source.data()), srcLen(source.size()) {}
+  // The source is handed to the SourceManager, which keeps it alive for as
+  // long as the tokens that point into it. The lexer scans it in place.
+  explicit Lexer(SourceBuffer source)
+      : srcLen(source.size()),
+        base(SourceManager::addBuffer(std::move(source))),
+        src(SourceManager::data(base)), scan(scanKernels()) {}
+  explicit Lexer(std::string source) : Lexer(SourceBuffer(std::move(source))) {}
 
+  // Returns the next token, or an END_OF_FILE token with an empty spelling
+  // once the input is exhausted (and on every call after that). Tokens are
+  // produced on demand, so a caller that pulls them one at a time never
+  // holds more than its own lookahead.
+  Token next();
+
+  // Lexes the rest of the input into a vector (without a trailing
+  // END_OF_FILE).
   std::vector<Token> Tokenize();
 
+  // Number of tokens produced so far.
+  size_t tokenCount() const { return lexed; }
+
 private:
-  const char *src;
   size_t srcLen;
+  uint32_t base; // SourceManager location of src[0]
+  const char *src;
+  const ScanKernels &scan;
   size_t pos = 0;
   size_t line = 1;
   size_t col = 1;
+  size_t lexed = 0;
 
+  bool lexToken(Token &out);
   void skipWhitespace();
+  void skipLineComment();
+  void skipBlockComment(char closeA, char closeB);
   Token makeToken(TokenKind k, std::string_view spelling) const;
+  Token makeIdentifier(std::string_view spelling) const;
+  Token makeMarker(TokenKind k, std::string_view spelling) const;
 };
 
 #endif // LEXER_H
@@ -0,0 +1,54 @@
+#include "Scan.h"
+#include "ScanKernels.h"
+#include <emmintrin.h>
+
+namespace {
+
+struct Sse2Ops {
+  using V = __m128i;
+  static constexpr int W = 16;
+
+  static V load(const char *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  }
+  static uint32_t mask(V v) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(v));
+  }
+  static uint32_t eq(V v, char c) {
+    return mask(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+  }
+  // lo..hi must be ASCII: bytes >= 0x80 compare as negative and fail.
+  static V inRange(V v, char lo, char hi) {
+    return _mm_and_si128(
+        _mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+        _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+  }
+  static uint32_t ident(V v) {
+    V lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    return mask(_mm_or_si128(
+        _mm_or_si128(inRange(v, '0', '9'), inRange(lower, 'a', 'z')),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8('_'))));
+  }
+  static uint32_t digit(V v) { return mask(inRange(v, '0', '9')); }
+  static uint32_t space(V v) {
+    // Unsigned v <= 0x20 iff saturating v - 0x20 is zero.
+    return mask(_mm_cmpeq_epi8(_mm_subs_epu8(v, _mm_set1_epi8(0x20)),
+                               _mm_setzero_si128()));
+  }
+};
+
+const ScanKernels &selectKernels() {
+#if defined(__x86_64__) || defined(__i386__)
+  if (const ScanKernels *avx2 = avx2ScanKernels())
+    if (__builtin_cpu_supports("avx2"))
+      return *avx2;
+#endif
+  return scan_detail::Kernels<Sse2Ops>::table;
+}
+
+} // namespace
+
+const ScanKernels &scanKernels() {
+  static const ScanKernels &kernels = selectKernels();
+  return kernels;
+}
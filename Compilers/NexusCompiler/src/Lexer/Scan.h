@@ -0,0 +1,35 @@
+#ifndef LEXER_SCAN_H
+#define LEXER_SCAN_H
+
+#include <cstddef>
+
+// Vectorised run scanners used by the Lexer.
+//
+// Each kernel starts at p, stops at the first byte that ends the run (or at
+// end) and returns that position. They load whole vectors and rely on the
+// source being zero-padded past end (SourceBuffer::kPadding). Kernels that
+// can cross lines add the newlines they pass to line and leave col where the
+// Lexer's per-byte loop would have: reset to 1 after a '\n' and incremented
+// for every other byte.
+struct ScanKernels {
+  // [A-Za-z0-9_]*
+  const char *(*identifier)(const char *p, const char *end);
+  // [0-9]*
+  const char *(*digits)(const char *p, const char *end);
+  // Everything up to the next `stop` byte.
+  const char *(*untilByte)(const char *p, const char *end, char stop,
+                           size_t &line, size_t &col);
+  // Bytes <= 0x20 (space, tabs, newlines, other control characters).
+  const char *(*whitespace)(const char *p, const char *end, size_t &line,
+                            size_t &col);
+};
+
+// The fastest kernels this CPU supports: AVX2 when available, SSE2
+// otherwise. Chosen once on first use.
+const ScanKernels &scanKernels();
+
+// AVX2 kernels, or null when they were not compiled in. Callers must check
+// the CPU supports AVX2 before using them.
+const ScanKernels *avx2ScanKernels();
+
+#endif // LEXER_SCAN_H
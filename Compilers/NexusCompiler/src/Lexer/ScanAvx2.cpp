@@ -0,0 +1,54 @@
+// Built with -mavx2 (see CMakeLists.txt). Nothing here may run before
+// scanKernels() has checked that the CPU supports AVX2.
+#include "Scan.h"
+
+#ifdef __AVX2__
+#include "ScanKernels.h"
+#include <immintrin.h>
+
+namespace {
+
+struct Avx2Ops {
+  using V = __m256i;
+  static constexpr int W = 32;
+
+  static V load(const char *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  static uint32_t mask(V v) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(v));
+  }
+  static uint32_t eq(V v, char c) {
+    return mask(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+  }
+  // lo..hi must be ASCII: bytes >= 0x80 compare as negative and fail.
+  static V inRange(V v, char lo, char hi) {
+    return _mm256_and_si256(
+        _mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+  }
+  static uint32_t ident(V v) {
+    V lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    return mask(_mm256_or_si256(
+        _mm256_or_si256(inRange(v, '0', '9'), inRange(lower, 'a', 'z')),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'))));
+  }
+  static uint32_t digit(V v) { return mask(inRange(v, '0', '9')); }
+  static uint32_t space(V v) {
+    // Unsigned v <= 0x20 iff saturating v - 0x20 is zero.
+    return mask(_mm256_cmpeq_epi8(_mm256_subs_epu8(v, _mm256_set1_epi8(0x20)),
+                                  _mm256_setzero_si256()));
+  }
+};
+
+} // namespace
+
+const ScanKernels *avx2ScanKernels() {
+  return &scan_detail::Kernels<Avx2Ops>::table;
+}
+
+#else
+
+const ScanKernels *avx2ScanKernels() { return nullptr; }
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef LEXER_SCAN_KERNELS_H
+#define LEXER_SCAN_KERNELS_H
+
+// Width-generic bodies of the ScanKernels. Included by Scan.cpp (SSE2) and
+// ScanAvx2.cpp (AVX2), each with its own Ops type:
+//
+//   static constexpr int W;       bytes per vector (at most 32)
+//   V load(const char *p);        unaligned load of W bytes
+//   uint32_t eq(V v, char c);     bit i set where byte i == c
+//   uint32_t ident(V v);          ... where byte i is [A-Za-z0-9_]
+//   uint32_t digit(V v);          ... where byte i is [0-9]
+//   uint32_t space(V v);          ... where byte i <= 0x20 (unsigned)
+
+#include "Scan.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace scan_detail {
+
+// Internal linkage: the AVX2 translation unit is compiled with -mavx2, and
+// its copies must not be picked by the linker for the SSE2 one.
+static inline uint32_t lowBits(size_t n) {
+  return n >= 32 ? ~0u : (1u << n) - 1;
+}
+
+// Accounts for n consumed bytes whose newlines are the set bits of nl.
+static inline void countLines(uint32_t nl, size_t n, size_t &line,
+                              size_t &col) {
+  if (nl == 0) {
+    col += n;
+    return;
+  }
+  line += static_cast<size_t>(__builtin_popcount(nl));
+  col = n - static_cast<size_t>(31 - __builtin_clz(nl));
+}
+
+// Skips bytes whose bit is clear in stop(v); nothing to count.
+template <class Ops, class Stop>
+const char *skipUntil(const char *p, const char *end, Stop stop) {
+  while (p < end) {
+    uint32_t hit = stop(Ops::load(p)) & lowBits(Ops::W);
+    if (hit) {
+      p += __builtin_ctz(hit);
+      return p < end ? p : end;
+    }
+    p += Ops::W;
+  }
+  return end;
+}
+
+// As skipUntil, counting the newlines skipped into line/col.
+template <class Ops, class Stop>
+const char *skipUntilCounting(const char *p, const char *end, Stop stop,
+                              size_t &line, size_t &col) {
+  while (p < end) {
+    typename Ops::V v = Ops::load(p);
+    uint32_t hit = stop(v) & lowBits(Ops::W);
+    size_t n = hit ? static_cast<size_t>(__builtin_ctz(hit)) : Ops::W;
+    if (n > static_cast<size_t>(end - p))
+      n = static_cast<size_t>(end - p);
+    countLines(Ops::eq(v, '\n') & lowBits(n), n, line, col);
+    p += n;
+    if (n < static_cast<size_t>(Ops::W))
+      return p;
+  }
+  return p;
+}
+
+template <class Ops> struct Kernels {
+  static const char *identifier(const char *p, const char *end) {
+    return skipUntil<Ops>(p, end,
+                          [](typename Ops::V v) { return ~Ops::ident(v); });
+  }
+
+  static const char *digits(const char *p, const char *end) {
+    return skipUntil<Ops>(p, end,
+                          [](typename Ops::V v) { return ~Ops::digit(v); });
+  }
+
+  static const char *untilByte(const char *p, const char *end, char stop,
+                               size_t &line, size_t &col) {
+    return skipUntilCounting<Ops>(
+        p, end, [stop](typename Ops::V v) { return Ops::eq(v, stop); }, line,
+        col);
+  }
+
+  static const char *whitespace(const char *p, const char *end, size_t &line,
+                                size_t &col) {
+    return skipUntilCounting<Ops>(
+        p, end, [](typename Ops::V v) { return ~Ops::space(v); }, line, col);
+  }
+
+  static constexpr ScanKernels table{identifier, digits, untilByte,
+                                     whitespace};
+};
+
+} // namespace scan_detail
+
+#endif // LEXER_SCAN_KERNELS_H
@@ -1,8 +1,8 @@
 #include "Parser.h"
+#include "../Lexer/Lexer.h"
 #include "../Token/TokenType.h"
 #include "ParserError.h"
 #include <cstddef>
-#include <iostream>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -12,29 +12,47 @@
 // ---------------- //
 // Token navigation //
 // ---------------- //
-const Token &Parser::peek() const {
-  if (currentIndex >= tokens.size()) {
-    static const Token EOF_TOKEN{TokenKind::END_OF_FILE, "", 0, 0};
-    return EOF_TOKEN;
-  }
-  return tokens[currentIndex];
-}
+Parser::Parser(Lexer &l)
+    : lexer(l),
+      window(kLookahead, Token(TokenKind::END_OF_FILE, 0u, 0u, 0, 0)) {}
+
+const Token &Parser::peek() const { return peekAt(0); }
 
 const Token &Parser::peekAt(size_t offset) const {
-  size_t idx = currentIndex + offset;
-  if (idx >= tokens.size()) {
-    static const Token EOF_TOKEN{TokenKind::END_OF_FILE, "", 0, 0};
-    return EOF_TOKEN;
+  if (panicking)
+    return panicEof;
+  size_t mask = window.size() - 1;
+  while (buffered <= offset) {
+    if (buffered > 0) {
+      // The lexer keeps returning END_OF_FILE; no need to buffer more.
+      const Token &last = window[(head + buffered - 1) & mask];
+      if (last.getKind() == TokenKind::END_OF_FILE)
+        return last;
+    }
+    if (buffered == window.size()) {
+      std::vector<Token> grown;
+      grown.reserve(window.size() * 2);
+      for (size_t i = 0; i < buffered; ++i)
+        grown.push_back(window[(head + i) & mask]);
+      grown.resize(window.size() * 2, grown.back());
+      window.swap(grown);
+      head = 0;
+      mask = window.size() - 1;
+    }
+    window[(head + buffered) & mask] = lexer.next();
+    ++buffered;
   }
-  return tokens[idx];
+  return window[(head + offset) & mask];
 }
 
+// END_OF_FILE is never consumed, so every read past the end sees it.
 const Token Parser::consume() {
-  if (currentIndex >= tokens.size()) {
-    static const Token EOF_TOKEN{TokenKind::END_OF_FILE, "", 0, 0};
-    return EOF_TOKEN;
+  Token tok = peek();
+  if (tok.getKind() != TokenKind::END_OF_FILE) {
+    head = (head + 1) & (window.size() - 1);
+    --buffered;
   }
-  return tokens[currentIndex++];
+  return tok;
 }
 
 bool Parser::match(TokenKind k) {
@@ -49,43 +67,140 @@ bool Parser::check(TokenKind kind) const {
   return !isAtEnd() && peek().getKind() == kind;
 }
 
+// On a mismatch, reports the error and returns an empty token of the
+// expected kind without consuming anything; the caller carries on with it
+// and unwinds, since the parser is now panicking.
 Token Parser::expect(TokenKind kind, std::string_view errorMsg) {
-  if (peek().getKind() == kind)
+  const Token &tok = peek();
+  if (tok.getKind() == kind)
     return consume();
-  std::string msg;
-  if (errorMsg.empty()) {
-    Token tmp(kind, "", 0, 0);
-    msg = "Expected: " + tmp.toString() + ", got: `" + peek().getWord() + "`";
-  } else {
-    msg = std::string(errorMsg);
+  if (!panicking) {
+    std::string msg;
+    if (errorMsg.empty()) {
+      Token tmp(kind, "", 0, 0);
+      msg = "Expected: " + tmp.toString() + ", got: `" +
+            std::string(tok.getWord()) + "`";
+    } else {
+      msg = std::string(errorMsg);
+    }
+    error(tok, std::move(msg));
   }
-  throw ParseError(peek().getLine(), peek().getColumn(), msg);
+  return Token(kind, 0u, 0u, tok.getLine(), tok.getColumn());
 }
 
 bool Parser::isAtEnd() const {
-  return currentIndex >= tokens.size() ||
-         peek().getKind() == TokenKind::END_OF_FILE;
+  return peek().getKind() == TokenKind::END_OF_FILE;
 }
 
+// Skips the rest of a malformed statement. The offending token may be the
+// statement's own ';' or the enclosing block's '}', which are not part of
+// the next statement; a braced body is skipped whole so that its '}' does
+// not close the enclosing block early.
 void Parser::synchronize() {
+  if (check(TokenKind::SEMI)) {
+    consume();
+    return;
+  }
+  if (check(TokenKind::RBRACE))
+    return;
   consume();
   while (!isAtEnd()) {
-    if (peek().getKind() == TokenKind::SEMI) {
+    switch (peek().getKind()) {
+    case TokenKind::SEMI:
       consume();
       return;
-    }
-    switch (peek().getKind()) {
     case TokenKind::RETURN:
+    case TokenKind::RBRACE:
       return;
-    case TokenKind::LBRACE:
-      consume();
+    case TokenKind::LBRACE: {
+      size_t depth = 0;
+      do {
+        if (check(TokenKind::LBRACE))
+          ++depth;
+        else if (check(TokenKind::RBRACE))
+          --depth;
+        consume();
+      } while (depth > 0 && !isAtEnd());
       return;
+    }
     default:
       consume();
     }
   }
 }
 
+// Skips to the next top-level declaration after a malformed one, stepping
+// over braced bodies, so their statements are not mistaken for top-level
+// items. start is where the malformed declaration began; if nothing was
+// consumed since, one token is, so that parsing always moves on.
+void Parser::synchronizeTopLevel(const Token &start) {
+  if (peek().getLine() == start.getLine() &&
+      peek().getColumn() == start.getColumn())
+    consume();
+  size_t depth = 0;
+  while (!isAtEnd()) {
+    if (depth == 0 &&
+        (check(TokenKind::FN) || check(TokenKind::ENUM) ||
+         check(TokenKind::IMPORT) || check(TokenKind::PUBLIC) ||
+         check(TokenKind::PRIVATE) || isIdentWord("struct") ||
+         isIdentWord("extern")))
+      return;
+    if (check(TokenKind::LBRACE))
+      ++depth;
+    else if (check(TokenKind::RBRACE) && depth > 0)
+      --depth;
+    consume();
+  }
+}
+
+// ----------------- //
+// Error recovery    //
+// ----------------- //
+
+// Only the first error of a panic is reported; the rest follow from it.
+void Parser::error(const Token &at, std::string message) {
+  if (panicking)
+    return;
+  diags.push_back({static_cast<int>(at.getLine()),
+                   static_cast<int>(at.getColumn()), std::move(message)});
+  panicking = true;
+}
+
+AstPtr<Expression> Parser::errorExpr(const Token &at, std::string message) {
+  error(at, std::move(message));
+  return arena->make<ErrorExpr>(at);
+}
+
+void Parser::recover() {
+  panicking = false;
+  synchronize();
+}
+
+// Blocks and expressions recurse once per nesting level. Past kMaxNesting
+// the input is rejected outright rather than risking the stack; this is the
+// one error parse() does not recover from.
+static constexpr unsigned kMaxNesting = 1024;
+
+class Parser::NestingGuard {
+public:
+  explicit NestingGuard(Parser &p) : parser(p) {
+    if (++parser.nesting > kMaxNesting) {
+      --parser.nesting;
+      const Token &at = parser.peek();
+      throw ParseError(static_cast<int>(at.getLine()),
+                       static_cast<int>(at.getColumn()),
+                       "Nesting too deep (limit " +
+                           std::to_string(kMaxNesting) + ")");
+    }
+  }
+  ~NestingGuard() { --parser.nesting; }
+  NestingGuard(const NestingGuard &) = delete;
+  NestingGuard &operator=(const NestingGuard &) = delete;
+
+private:
+  Parser &parser;
+};
+
 bool Parser::isIdentWord(std::string_view word) const {
   return peek().getKind() == TokenKind::IDENTIFIER && peek().getWord() == word;
 }
@@ -107,109 +222,128 @@ static bool looksLikeType(const Token &tok) {
 
 std::unique_ptr<Program> Parser::parse() {
   auto prog = std::make_unique<Program>();
-
-  while (!isAtEnd()) {
-    try {
-      if (check(TokenKind::IMPORT)) {
-        prog->imports.push_back(parseImportDecl());
-        continue;
+  prog->arena = arena;
+
+  try {
+    while (!isAtEnd()) {
+      const Token start = peek();
+      parseTopLevel(*prog);
+      if (panicking) {
+        panicking = false;
+        synchronizeTopLevel(start);
       }
+    }
+  } catch (const ParseError &e) {
+    // Too deeply nested to continue; keep what was parsed before it.
+    diags.push_back({e.line, e.column, e.what()});
+    panicking = false;
+  }
 
-      {
-        size_t offset = 0;
-        if (check(TokenKind::PUBLIC) || check(TokenKind::PRIVATE))
-          offset = 1;
-        if (peekAt(offset).getKind() == TokenKind::IDENTIFIER &&
-            peekAt(offset).getWord() == "extern") {
-          if (offset == 1)
-            consume();
-          prog->externBlocks.push_back(parseExternBlock());
-          continue;
-        }
-      }
+  return prog;
+}
 
-      bool isPublic = false;
-      if (check(TokenKind::PUBLIC)) {
-        consume();
-        isPublic = true;
-      } else if (check(TokenKind::PRIVATE)) {
-        consume();
-      }
+// Parses one top-level item into prog. A declaration that ends in panic
+// mode is dropped; parse() recovers.
+void Parser::parseTopLevel(Program &prog) {
+  if (check(TokenKind::IMPORT)) {
+    auto imp = parseImportDecl();
+    if (!panicking)
+      prog.imports.push_back(shareNode(std::move(imp), arena));
+    return;
+  }
 
-      if (isIdentWord("struct")) {
-        auto s = parseStructDecl();
-        s->isPublic = isPublic;
-        prog->structs.push_back(std::move(s));
-        continue;
-      }
+  {
+    size_t offset = 0;
+    if (check(TokenKind::PUBLIC) || check(TokenKind::PRIVATE))
+      offset = 1;
+    if (peekAt(offset).getKind() == TokenKind::IDENTIFIER &&
+        peekAt(offset).getWord() == "extern") {
+      if (offset == 1)
+        consume();
+      ExternBlock block = parseExternBlock();
+      if (!panicking)
+        prog.externBlocks.push_back(std::move(block));
+      return;
+    }
+  }
 
-      bool nextIsConst = check(TokenKind::CONST);
-      const Token &typeCheck = nextIsConst ? peekAt(1) : peek();
-      if (looksLikeType(typeCheck)) {
-        // Skip past the full type: base + optional <...> + optional [][]
-        // to check whether what follows is a variable name (global decl)
-        // rather than a function name (fn decl).
-        size_t off = nextIsConst ? 1 : 0; // points at base type identifier
-        ++off;                            // step past base identifier
-        // skip generic args <...>
-        if (peekAt(off).getKind() == TokenKind::LT) {
-          size_t depth = 1;
-          ++off;
-          while (depth > 0 && peekAt(off).getKind() != TokenKind::END_OF_FILE) {
-            TokenKind k = peekAt(off).getKind();
-            if (k == TokenKind::LT)
-              ++depth;
-            else if (k == TokenKind::GT)
-              --depth;
-            ++off;
-          }
-        }
-        // skip trailing [][]
-        while (peekAt(off).getKind() == TokenKind::LBRACKET &&
-               peekAt(off + 1).getKind() == TokenKind::RBRACKET)
-          off += 2;
-        // now off points at what should be the variable name
-        if (peekAt(off).getKind() == TokenKind::IDENTIFIER &&
-            peekAt(off + 1).getKind() != TokenKind::LPAREN) {
-          auto gv = parseGlobalVarDecl();
-          gv->isPublic = isPublic;
-          prog->globals.push_back(std::move(gv));
-          continue;
-        }
-      }
+  bool isPublic = false;
+  if (check(TokenKind::PUBLIC)) {
+    consume();
+    isPublic = true;
+  } else if (check(TokenKind::PRIVATE)) {
+    consume();
+  }
 
-      if (check(TokenKind::ENUM)) {
-        auto fn = parseEnumDecl();
-        fn->isPublic = isPublic;
-        prog->enums.push_back(std::move(fn));
-        continue;
-      }
+  if (isIdentWord("struct")) {
+    auto s = parseStructDecl();
+    s->isPublic = isPublic;
+    if (!panicking)
+      prog.structs.push_back(shareNode(std::move(s), arena));
+    return;
+  }
 
-      if (check(TokenKind::FN)) {
-        auto fn = parseFunctionDecl();
-        fn->isPublic = isPublic;
-        prog->functions.push_back(std::move(fn));
-        continue;
+  bool nextIsConst = check(TokenKind::CONST);
+  const Token &typeCheck = nextIsConst ? peekAt(1) : peek();
+  if (looksLikeType(typeCheck)) {
+    // Skip past the full type: base + optional <...> + optional [][]
+    // to check whether what follows is a variable name (global decl)
+    // rather than a function name (fn decl).
+    size_t off = nextIsConst ? 1 : 0; // points at base type identifier
+    ++off;                            // step past base identifier
+    // skip generic args <...>
+    if (peekAt(off).getKind() == TokenKind::LT) {
+      size_t depth = 1;
+      ++off;
+      while (depth > 0 && peekAt(off).getKind() != TokenKind::END_OF_FILE) {
+        TokenKind k = peekAt(off).getKind();
+        if (k == TokenKind::LT)
+          ++depth;
+        else if (k == TokenKind::GT)
+          --depth;
+        ++off;
       }
-      throw ParseError(peek().getLine(), peek().getColumn(),
-                       "Unexpected token at top level: `" + peek().getWord() +
-                           "`");
-
-    } catch (const ParseError &e) {
-      std::cerr << e.what() << "\n";
-      synchronize();
+    }
+    // skip trailing [][]
+    while (peekAt(off).getKind() == TokenKind::LBRACKET &&
+           peekAt(off + 1).getKind() == TokenKind::RBRACKET)
+      off += 2;
+    // now off points at what should be the variable name
+    if (peekAt(off).getKind() == TokenKind::IDENTIFIER &&
+        peekAt(off + 1).getKind() != TokenKind::LPAREN) {
+      auto gv = parseGlobalVarDecl();
+      gv->isPublic = isPublic;
+      if (!panicking)
+        prog.globals.push_back(shareNode(std::move(gv), arena));
+      return;
     }
   }
 
-  return prog;
+  if (check(TokenKind::ENUM)) {
+    auto fn = parseEnumDecl();
+    fn->isPublic = isPublic;
+    if (!panicking)
+      prog.enums.push_back(shareNode(std::move(fn), arena));
+    return;
+  }
+
+  if (check(TokenKind::FN)) {
+    auto fn = parseFunctionDecl();
+    fn->isPublic = isPublic;
+    if (!panicking)
+      prog.functions.push_back(shareNode(std::move(fn), arena));
+    return;
+  }
+  error(peek(), "Unexpected token at top level: `" +
+                    std::string(peek().getWord()) + "`");
 }
 
 ExternBlock Parser::parseExternBlock() {
   consume();
 
   if (peek().getKind() != TokenKind::LIT_STRING || peek().getWord() != "C") {
-    throw ParseError(peek().getLine(), peek().getColumn(),
-                     "Expected \"C\" after extern");
+    error(peek(), "Expected \"C\" after extern");
+    return {};
   }
   consume();
 
@@ -263,8 +397,9 @@ ExternBlock Parser::parseExternBlock() {
     }
 
     expect(TokenKind::SEMI, "Expected ';'");
-    block.decls.emplace_back(nameTok.getWord(), std::move(paramTypes),
-                             std::move(retType), declPrivate);
+    block.decls.emplace_back(std::string(nameTok.getWord()),
+                             std::move(paramTypes), std::move(retType),
+                             declPrivate);
   }
 
   expect(TokenKind::RBRACE, "Expected '}' to close extern block");
@@ -274,7 +409,7 @@ ExternBlock Parser::parseExternBlock() {
 // ------------------- //
 // Struct declaration  //
 // ------------------- //
-std::unique_ptr<StructDecl> Parser::parseStructDecl() {
+AstPtr<StructDecl> Parser::parseStructDecl() {
   consume();
   Token nameTok = expect(TokenKind::IDENTIFIER, "Expected struct name");
 
@@ -286,7 +421,7 @@ std::unique_ptr<StructDecl> Parser::parseStructDecl() {
 
   expect(TokenKind::LBRACE, "Expected '{'");
 
-  auto decl = std::make_unique<StructDecl>();
+  auto decl = arena->make<StructDecl>();
   decl->name = nameTok.getWord();
 
   while (!check(TokenKind::RBRACE) && !isAtEnd()) {
@@ -303,7 +438,7 @@ std::unique_ptr<StructDecl> Parser::parseStructDecl() {
     Token fieldTok = expect(TokenKind::IDENTIFIER, "Expected field name");
     expect(TokenKind::SEMI, "Expected ';' after field");
     decl->fields.emplace_back(TypeDesc{Identifier{typeTok}, dims},
-                              fieldTok.getWord());
+                              std::string(fieldTok.getWord()));
   }
 
   expect(TokenKind::RBRACE, "Expected '}'");
@@ -314,7 +449,7 @@ std::unique_ptr<StructDecl> Parser::parseStructDecl() {
 // ------------------- //
 // Enum declaration    //
 // ------------------- //
-std::unique_ptr<EnumDecl> Parser::parseEnumDecl() {
+AstPtr<EnumDecl> Parser::parseEnumDecl() {
   expect(TokenKind::ENUM, "Expected 'enum'");
   Token nameTok = expect(TokenKind::IDENTIFIER, "Expected enum name");
 
@@ -329,8 +464,8 @@ std::unique_ptr<EnumDecl> Parser::parseEnumDecl() {
   std::vector<EnumVariant> variants;
   while (!check(TokenKind::RBRACE) && !isAtEnd()) {
     if (!check(TokenKind::IDENTIFIER) && peek().getWord().empty()) {
-      throw ParseError(peek().getLine(), peek().getColumn(),
-                       "Expected variant name");
+      error(peek(), "Expected variant name");
+      break;
     }
     Token varTok = consume();
 
@@ -339,7 +474,8 @@ std::unique_ptr<EnumDecl> Parser::parseEnumDecl() {
       do {
         Token typeTok = expect(TokenKind::IDENTIFIER, "Expected payload type");
         Token bindTok = expect(TokenKind::IDENTIFIER, "Expected payload name");
-        fields.push_back({typeTok.getWord(), bindTok.getWord()});
+        fields.push_back({std::string(typeTok.getWord()),
+                          std::string(bindTok.getWord())});
       } while (match(TokenKind::COMMA));
       expect(TokenKind::RPAREN, "Expected ')'");
     }
@@ -349,25 +485,27 @@ std::unique_ptr<EnumDecl> Parser::parseEnumDecl() {
       bool neg = match(TokenKind::SUB);
       Token valTok = expect(TokenKind::LIT_INT,
                             "Expected integer after '=' in enum variant");
-      long long v = std::stoll(valTok.getWord());
-      explicitValue = neg ? -v : v;
+      if (!panicking) {
+        long long v = std::stoll(std::string(valTok.getWord()));
+        explicitValue = neg ? -v : v;
+      }
     }
-    variants.emplace_back(varTok.getWord(), std::move(fields),
+    variants.emplace_back(std::string(varTok.getWord()), std::move(fields),
                           std::move(explicitValue));
     match(TokenKind::COMMA);
   }
 
   expect(TokenKind::RBRACE, "Expected '}'");
 
-  return std::make_unique<EnumDecl>(nameTok.getWord(), std::move(typeParams),
-                                    std::move(variants));
+  return arena->make<EnumDecl>(std::string(nameTok.getWord()),
+                                    std::move(typeParams), std::move(variants));
 }
 
 std::vector<std::string> Parser::parseTypeParamList() {
   std::vector<std::string> params;
   do {
     Token t = expect(TokenKind::IDENTIFIER, "Expected type parameter name");
-    params.push_back(t.getWord());
+    params.emplace_back(t.getWord());
   } while (match(TokenKind::COMMA));
   expect(TokenKind::GT, "Expected '>' to close type parameter list");
   return params;
@@ -413,20 +551,21 @@ TypeDesc Parser::parseTypeDesc() {
 
   TypeDesc td(Identifier{typeTok}, dims);
   td.typeArgs = std::move(typeArgs);
+  td.seal();
   return td;
 }
 
 // ------------------- //
 // Import declaration  //
 // ------------------- //
-std::unique_ptr<ImportDecl> Parser::parseImportDecl() {
+AstPtr<ImportDecl> Parser::parseImportDecl() {
   expect(TokenKind::IMPORT, "Expected 'import'");
 
-  auto decl = std::make_unique<ImportDecl>();
+  auto decl = arena->make<ImportDecl>();
   decl->selective = false;
 
   Token first = expect(TokenKind::IDENTIFIER, "Expected module name");
-  decl->path.segments.push_back(first.getWord());
+  decl->path.segments.emplace_back(first.getWord());
   decl->path.isStdLib =
       (first.getWord() == "Nexus" || first.getWord() == "Std");
 
@@ -438,14 +577,14 @@ std::unique_ptr<ImportDecl> Parser::parseImportDecl() {
       if (!check(TokenKind::RBRACE)) {
         do {
           Token sym = expect(TokenKind::IDENTIFIER, "Expected symbol name");
-          decl->symbols.push_back(sym.getWord());
+          decl->symbols.emplace_back(sym.getWord());
         } while (match(TokenKind::COMMA));
       }
       expect(TokenKind::RBRACE, "Expected '}'");
       break;
     }
     Token seg = expect(TokenKind::IDENTIFIER, "Expected module path segment");
-    decl->path.segments.push_back(seg.getWord());
+    decl->path.segments.emplace_back(seg.getWord());
   }
 
   expect(TokenKind::SEMI, "Expected ';' after import");
@@ -454,7 +593,7 @@ std::unique_ptr<ImportDecl> Parser::parseImportDecl() {
 // ----------------------- //
 // Global variable decl    //
 // ----------------------- //
-std::unique_ptr<GlobalVarDecl> Parser::parseGlobalVarDecl() {
+AstPtr<GlobalVarDecl> Parser::parseGlobalVarDecl() {
   bool isConst = false;
   if (check(TokenKind::CONST)) {
     consume();
@@ -468,7 +607,7 @@ std::unique_ptr<GlobalVarDecl> Parser::parseGlobalVarDecl() {
   Token nameTok = expect(TokenKind::IDENTIFIER, "Expected variable name");
   expect(TokenKind::ASSIGN, "Global variables must be initialized");
 
-  std::unique_ptr<Expression> init;
+  AstPtr<Expression> init;
   if (check(TokenKind::LBRACE)) {
     consume();
     std::vector<ExprPtr> vals;
@@ -478,22 +617,22 @@ std::unique_ptr<GlobalVarDecl> Parser::parseGlobalVarDecl() {
       } while (match(TokenKind::COMMA));
     }
     expect(TokenKind::RBRACE, "Expected '}' to close struct literal");
-    init = std::make_unique<StructLitExpr>(td.base.token.getWord(),
-                                           std::move(vals));
+    init = arena->make<StructLitExpr>(
+        std::string(td.base.token.getWord()), std::move(vals));
   } else {
     init = parseExpression();
   }
 
   expect(TokenKind::SEMI, "Expected ';'");
 
-  return std::make_unique<GlobalVarDecl>(std::move(td), nameTok.getWord(),
-                                         std::move(init), isConst);
+  return arena->make<GlobalVarDecl>(std::move(td), nameTok, std::move(init),
+                                    isConst);
 }
 
 // -------------------- //
 // Function declaration //
 // -------------------- //
-std::unique_ptr<Function> Parser::parseFunctionDecl() {
+AstPtr<Function> Parser::parseFunctionDecl() {
   expect(TokenKind::FN, "Expected 'fn'");
   Token nameToken = expect(TokenKind::IDENTIFIER, "Expected function name");
   expect(TokenKind::LPAREN, "Expected '(' after function name");
@@ -538,7 +677,7 @@ std::unique_ptr<Function> Parser::parseFunctionDecl() {
 
     auto body = parseBlock();
     auto fn =
-        std::make_unique<Function>(Identifier{nameToken}, std::move(params),
+        arena->make<Function>(Identifier{nameToken}, std::move(params),
                                    std::move(body), std::move(retTd));
     fn->typeParams = std::move(typeParams);
     return fn;
@@ -546,14 +685,14 @@ std::unique_ptr<Function> Parser::parseFunctionDecl() {
 
   Token voidTok{TokenKind::IDENTIFIER, "void", nameToken.getLine(), 0};
   auto body = parseBlock();
-  auto fn = std::make_unique<Function>(Identifier{nameToken}, std::move(params),
+  auto fn = arena->make<Function>(Identifier{nameToken}, std::move(params),
                                        std::move(body),
                                        TypeDesc(Identifier{voidTok}));
   fn->typeParams = std::move(typeParams);
   return fn;
 }
 
-std::unique_ptr<Statement> Parser::parseTypeIntrinsicStmt() {
+AstPtr<Statement> Parser::parseTypeIntrinsicStmt() {
   consume();
   expect(TokenKind::LPAREN, "Expected '(' after 'Type'");
 
@@ -566,37 +705,39 @@ std::unique_ptr<Statement> Parser::parseTypeIntrinsicStmt() {
   expect(TokenKind::RPAREN, "Expected ')' after type in Type(...)");
   expect(TokenKind::SEMI, "Expected ';'");
 
-  return std::make_unique<ExprStmt>(
-      std::make_unique<TypeIntrinsicExpr>(std::move(valueExpr), std::move(td)));
+  return arena->make<ExprStmt>(
+      arena->make<TypeIntrinsicExpr>(std::move(valueExpr), std::move(td)));
 }
 
 // ------- //
 // Block   //
 // ------- //
-std::unique_ptr<Block> Parser::parseBlock(bool allowSingleStmt) {
-  auto block = std::make_unique<Block>();
+// A statement that fails to parse is replaced by an ErrorStmt and parsing
+// resumes after it. Entered while panicking (the error came before the
+// block), it returns at once and leaves recovery to the enclosing block.
+AstPtr<Block> Parser::parseBlock(bool allowSingleStmt) {
+  auto block = arena->make<Block>();
+  if (panicking)
+    return block;
+  NestingGuard guard(*this);
+  auto parseOne = [&] {
+    Token start = peek();
+    auto s = parseStatement();
+    if (panicking) {
+      block->statements.push_back(arena->make<ErrorStmt>(start));
+      recover();
+    } else if (s) {
+      s->setLocation(start);
+      block->statements.push_back(std::move(s));
+    }
+  };
   if (check(TokenKind::LBRACE)) {
     expect(TokenKind::LBRACE, "Expected '{'");
-    while (!check(TokenKind::RBRACE) && !isAtEnd()) {
-      try {
-        auto s = parseStatement();
-        if (s)
-          block->statements.push_back(std::move(s));
-      } catch (const ParseError &e) {
-        std::cerr << e.what() << "\n";
-        synchronize();
-      }
-    }
+    while (!check(TokenKind::RBRACE) && !isAtEnd())
+      parseOne();
     expect(TokenKind::RBRACE, "Expected '}'");
   } else if (allowSingleStmt) {
-    try {
-      auto s = parseStatement();
-      if (s)
-        block->statements.push_back(std::move(s));
-    } catch (const ParseError &e) {
-      std::cerr << e.what() << "\n";
-      synchronize();
-    }
+    parseOne();
   }
   return block;
 }
@@ -604,7 +745,7 @@ std::unique_ptr<Block> Parser::parseBlock(bool allowSingleStmt) {
 // ------------------------------------------------------------------ //
 // Statement dispatch                                                   //
 // ------------------------------------------------------------------ //
-std::unique_ptr<Statement> Parser::parseStatement() {
+AstPtr<Statement> Parser::parseStatement() {
   if (match(TokenKind::RETURN))
     return parseReturnStatement();
   if (match(TokenKind::IF))
@@ -669,26 +810,26 @@ std::unique_ptr<Statement> Parser::parseStatement() {
   }
   auto expr = parseExpression();
   expect(TokenKind::SEMI, "Expected ';'");
-  return std::make_unique<ExprStmt>(std::move(expr));
+  return arena->make<ExprStmt>(std::move(expr));
 }
 
 // ---------------------------------------- //
 // Uninitialised var decl:  TypeName name;  //
 // ---------------------------------------- //
-std::unique_ptr<VarDecl> Parser::parseVarDeclNoInit() {
+AstPtr<VarDecl> Parser::parseVarDeclNoInit() {
   // Parse full type: base + optional <TypeArgs> + optional [][]
   TypeDesc td = parseTypeDesc();
   Token nameTok = expect(TokenKind::IDENTIFIER, "Expected variable name");
   expect(TokenKind::SEMI, "Expected ';'");
 
-  return std::make_unique<VarDecl>(std::move(td), Identifier{nameTok}, nullptr,
+  return arena->make<VarDecl>(std::move(td), Identifier{nameTok}, nullptr,
                                    AssignKind::Copy, false);
 }
 
 // ------------------------ //
 // Array assignment helper  //
 // ------------------------ //
-std::unique_ptr<Statement> Parser::parseArrayAssign() {
+AstPtr<Statement> Parser::parseArrayAssign() {
   Token arrTok = consume();
   std::vector<ExprPtr> indices;
 
@@ -704,42 +845,42 @@ std::unique_ptr<Statement> Parser::parseArrayAssign() {
   auto value = parseExpression();
   expect(TokenKind::SEMI, "Expected ';'");
 
-  auto e = std::make_unique<ArrayIndexAssignExpr>(
+  auto e = arena->make<ArrayIndexAssignExpr>(
       Identifier{arrTok}, std::move(indices), std::move(value));
-  return std::make_unique<ExprStmt>(std::move(e));
+  return arena->make<ExprStmt>(std::move(e));
 }
 
 // ------------ //
 // Control flow //
 // ------------ //
-std::unique_ptr<IfStmt> Parser::parseIfStatement() {
+AstPtr<IfStmt> Parser::parseIfStatement() {
   expect(TokenKind::LPAREN, "Expected '('");
   auto cond = parseExpression();
   expect(TokenKind::RPAREN, "Expected ')'");
   auto thenBlock = parseBlock(true);
-  std::unique_ptr<Block> elseBlock;
+  AstPtr<Block> elseBlock;
   if (match(TokenKind::ElSE)) {
     if (match(TokenKind::IF)) {
       auto ei = parseIfStatement();
-      elseBlock = std::make_unique<Block>();
+      elseBlock = arena->make<Block>();
       elseBlock->statements.push_back(std::move(ei));
     } else {
       elseBlock = parseBlock(true);
     }
   }
-  return std::make_unique<IfStmt>(std::move(cond), std::move(thenBlock),
+  return arena->make<IfStmt>(std::move(cond), std::move(thenBlock),
                                   std::move(elseBlock));
 }
 
-std::unique_ptr<WhileStmt> Parser::parseWhileLoop() {
+AstPtr<WhileStmt> Parser::parseWhileLoop() {
   expect(TokenKind::LPAREN, "Expected '('");
   auto cond = parseExpression();
   expect(TokenKind::RPAREN, "Expected ')'");
   auto body = parseBlock();
-  return std::make_unique<WhileStmt>(std::move(cond), std::move(body));
+  return arena->make<WhileStmt>(std::move(cond), std::move(body));
 }
 
-std::unique_ptr<MatchStmt> Parser::parseMatchStmt() {
+AstPtr<MatchStmt> Parser::parseMatchStmt() {
   expect(TokenKind::LPAREN, "Expected '(' after 'match'");
   auto subject = parseExpression();
   expect(TokenKind::RPAREN, "Expected ')'");
@@ -751,7 +892,7 @@ std::unique_ptr<MatchStmt> Parser::parseMatchStmt() {
   }
 
   expect(TokenKind::RBRACE, "Expected '}'");
-  return std::make_unique<MatchStmt>(std::move(subject), std::move(arms));
+  return arena->make<MatchStmt>(std::move(subject), std::move(arms));
 }
 
 MatchArm Parser::parseMatchArm() {
@@ -770,7 +911,7 @@ MatchArm Parser::parseMatchArm() {
       do {
         Token bindTok =
             expect(TokenKind::IDENTIFIER, "Expected binding name in match arm");
-        arm.bindings.push_back(bindTok.getWord());
+        arm.bindings.emplace_back(bindTok);
       } while (match(TokenKind::COMMA));
       expect(TokenKind::RPAREN, "Expected ')'");
     }
@@ -783,18 +924,18 @@ MatchArm Parser::parseMatchArm() {
   return arm;
 }
 
-std::unique_ptr<WhileStmt> Parser::parseLoop() {
+AstPtr<WhileStmt> Parser::parseLoop() {
   Token tok = Token(TokenKind::LIT_BOOL, "true", 0, 0);
-  auto cond = std::make_unique<BoolLitExpr>(tok);
+  auto cond = arena->make<BoolLitExpr>(tok);
   auto body = parseBlock();
-  return std::make_unique<WhileStmt>(std::move(cond), std::move(body));
+  return arena->make<WhileStmt>(std::move(cond), std::move(body));
 }
 
 // Returns either a ForRangeStmt (for range()) or a ForEachStmt (for arrays).
 // Grammar:
 //   for ( [const] Type[][] varName : range(args...) ) body
 //   for ( [const] Type[][] varName : expr            ) body
-std::unique_ptr<Statement> Parser::parseForLoop() {
+AstPtr<Statement> Parser::parseForLoop() {
   expect(TokenKind::LPAREN, "Expected '(' after 'for'");
 
   bool isConst = false;
@@ -808,9 +949,7 @@ std::unique_ptr<Statement> Parser::parseForLoop() {
   // Build the initial TypeDesc from the base identifier, then extend it
   // with optional <TypeArgs> and trailing [][] so that loop variables like
   // Option<Animal>, Option<Animal>[], or i32[][] all parse correctly.
-  TypeDesc td(Identifier{Token{TokenKind::IDENTIFIER, typeTok.getWord(),
-                               typeTok.getLine(), typeTok.getColumn()}},
-              0, isConst);
+  TypeDesc td(Identifier{typeTok}, 0, isConst);
   if (check(TokenKind::LT)) {
     consume();
     td.typeArgs = parseTypeArgList();
@@ -821,6 +960,7 @@ std::unique_ptr<Statement> Parser::parseForLoop() {
     consume();
     ++td.dimensions;
   }
+  td.seal();
 
   Token nameTok = expect(TokenKind::IDENTIFIER, "Expected loop variable name");
   expect(TokenKind::COLON, "Expected ':' in for loop");
@@ -840,9 +980,9 @@ std::unique_ptr<Statement> Parser::parseForLoop() {
     expect(TokenKind::RPAREN, "Expected ')' to close for(...)");
 
     ExprPtr startExpr, endExpr, stepExpr;
-    auto intLit = [](long long v, int line = 0, int col = 0) -> ExprPtr {
+    auto intLit = [this](long long v, int line = 0, int col = 0) -> ExprPtr {
       Token t{TokenKind::LIT_INT, std::to_string(v), line, col};
-      return std::make_unique<IntLitExpr>(t);
+      return arena->make<IntLitExpr>(t);
     };
 
     if (rangeArgs.size() == 1) {
@@ -858,12 +998,12 @@ std::unique_ptr<Statement> Parser::parseForLoop() {
       endExpr = std::move(rangeArgs[1]);
       stepExpr = std::move(rangeArgs[2]);
     } else {
-      throw ParseError(peek().getLine(), peek().getColumn(),
-                       "range() takes 1, 2 or 3 arguments");
+      error(peek(), "range() takes 1, 2 or 3 arguments");
+      return nullptr;
     }
 
     auto body = parseBlock(true);
-    return std::make_unique<ForRangeStmt>(
+    return arena->make<ForRangeStmt>(
         std::move(td), Identifier{nameTok}, std::move(startExpr),
         std::move(endExpr), std::move(stepExpr), std::move(body));
   }
@@ -875,11 +1015,11 @@ std::unique_ptr<Statement> Parser::parseForLoop() {
   expect(TokenKind::RPAREN, "Expected ')' to close for(...)");
 
   auto body = parseBlock(true);
-  return std::make_unique<ForEachStmt>(std::move(td), Identifier{nameTok},
+  return arena->make<ForEachStmt>(std::move(td), Identifier{nameTok},
                                        std::move(iterable), std::move(body));
 }
-std::unique_ptr<Return> Parser::parseReturnStatement() {
-  auto ret = std::make_unique<Return>();
+AstPtr<Return> Parser::parseReturnStatement() {
+  auto ret = arena->make<Return>();
   if (match(TokenKind::SEMI))
     return ret;
   ret->value = parseExpression();
@@ -887,20 +1027,20 @@ std::unique_ptr<Return> Parser::parseReturnStatement() {
   return ret;
 }
 
-std::unique_ptr<Statement> Parser::parseLoopBreak() {
+AstPtr<Statement> Parser::parseLoopBreak() {
   if (match(TokenKind::CONTINUE)) {
     expect(TokenKind::SEMI, "Expected ';' after continue");
-    return std::make_unique<Continue>();
+    return arena->make<Continue>();
   }
   expect(TokenKind::BREAK, "Expected 'break' or 'continue'");
   expect(TokenKind::SEMI, "Expected ';' after break");
-  return std::make_unique<Break>();
+  return arena->make<Break>();
 }
 
 // -------------------- //
 // Variable declaration //
 // -------------------- //
-std::unique_ptr<VarDecl> Parser::parseVarDeclStatement(AssignKind kind) {
+AstPtr<VarDecl> Parser::parseVarDeclStatement(AssignKind kind) {
   bool isConst = false;
   if (check(TokenKind::CONST)) {
     consume();
@@ -912,9 +1052,7 @@ std::unique_ptr<VarDecl> Parser::parseVarDeclStatement(AssignKind kind) {
 
   // Parse optional generic type arguments and array dims via parseTypeDesc
   // when not using type inference: Option<Animal>[], Map<str, i32>, etc.
-  TypeDesc td(Identifier{Token{TokenKind::IDENTIFIER, typeTok.getWord(),
-                               typeTok.getLine(), typeTok.getColumn()}},
-              0, isConst);
+  TypeDesc td(Identifier{typeTok.withKind(TokenKind::IDENTIFIER)}, 0, isConst);
   if (!isInferred) {
     // Parse <TypeArgs> if present
     if (check(TokenKind::LT)) {
@@ -929,6 +1067,7 @@ std::unique_ptr<VarDecl> Parser::parseVarDeclStatement(AssignKind kind) {
       ++td.dimensions;
     }
   }
+  td.seal();
   Token nameTok = expect(TokenKind::IDENTIFIER, "Expected variable name");
 
   if (match(TokenKind::ASSIGN))
@@ -938,10 +1077,9 @@ std::unique_ptr<VarDecl> Parser::parseVarDeclStatement(AssignKind kind) {
   else if (match(TokenKind::BORROW))
     kind = AssignKind::Borrow;
   else
-    throw ParseError(peek().getLine(), peek().getColumn(),
-                     "Expected '=', '<-', or '&='");
+    error(peek(), "Expected '=', '<-', or '&='");
 
-  std::unique_ptr<Expression> init;
+  AstPtr<Expression> init;
   if (!isInferred && check(TokenKind::LBRACE)) {
     consume(); // '{'
     std::vector<ExprPtr> vals;
@@ -951,80 +1089,78 @@ std::unique_ptr<VarDecl> Parser::parseVarDeclStatement(AssignKind kind) {
       } while (match(TokenKind::COMMA));
     }
     expect(TokenKind::RBRACE, "Expected '}' to close struct literal");
-    init = std::make_unique<StructLitExpr>(typeTok.getWord(), std::move(vals));
+    init = arena->make<StructLitExpr>(std::string(typeTok.getWord()),
+                                           std::move(vals));
   } else {
     init = parseExpression();
   }
   expect(TokenKind::SEMI, "Expected ';'");
 
-  return std::make_unique<VarDecl>(std::move(td), Identifier{nameTok},
+  return arena->make<VarDecl>(std::move(td), Identifier{nameTok},
                                    std::move(init), kind, isConst);
 }
 
 // ---------- //
 // Expression //
 // ---------- //
-std::unique_ptr<Expression> Parser::parseExpression() {
+AstPtr<Expression> Parser::parseExpression() {
+  NestingGuard guard(*this);
   return parseAssignment();
 }
 
-std::unique_ptr<Expression> Parser::parseAssignment() {
+AstPtr<Expression> Parser::parseAssignment() {
   auto left = parseOr();
 
   if (match(TokenKind::ASSIGN)) {
-    if (auto *id = dynamic_cast<IdentExpr *>(left.get())) {
+    if (auto *id = dyn_cast<IdentExpr>(left.get())) {
       auto val = parseAssignment();
-      return std::make_unique<AssignExpr>(id->name, std::move(val),
+      return arena->make<AssignExpr>(id->name, std::move(val),
                                           AssignKind::Copy);
     }
-    if (auto *ai = dynamic_cast<ArrayIndexExpr *>(left.get())) {
+    if (auto *ai = dyn_cast<ArrayIndexExpr>(left.get())) {
       auto val = parseAssignment();
       if (ai->object) {
-        return std::make_unique<ArrayIndexAssignExpr>(
+        return arena->make<ArrayIndexAssignExpr>(
             std::move(ai->object), std::move(ai->indices), std::move(val));
       } else {
-        return std::make_unique<ArrayIndexAssignExpr>(
+        return arena->make<ArrayIndexAssignExpr>(
             ai->array, std::move(ai->indices), std::move(val));
       }
     }
-    if (auto *fa = dynamic_cast<FieldAccessExpr *>(left.get())) {
+    if (auto *fa = dyn_cast<FieldAccessExpr>(left.get())) {
       auto val = parseAssignment();
-      return std::make_unique<FieldAssignExpr>(std::move(fa->object), fa->field,
+      return arena->make<FieldAssignExpr>(std::move(fa->object), fa->field,
                                                std::move(val));
     }
-    throw ParseError(peek().getLine(), peek().getColumn(),
-                     "Invalid assignment target");
+    return errorExpr(peek(), "Invalid assignment target");
   }
   if (match(TokenKind::MOVE)) {
-    if (auto *id = dynamic_cast<IdentExpr *>(left.get())) {
+    if (auto *id = dyn_cast<IdentExpr>(left.get())) {
       auto val = parseAssignment();
-      return std::make_unique<AssignExpr>(id->name, std::move(val),
+      return arena->make<AssignExpr>(id->name, std::move(val),
                                           AssignKind::Move);
     }
-    throw ParseError(peek().getLine(), peek().getColumn(),
-                     "'<-' requires an identifier");
+    return errorExpr(peek(), "'<-' requires an identifier");
   }
   if (match(TokenKind::BORROW)) {
-    if (auto *id = dynamic_cast<IdentExpr *>(left.get())) {
+    if (auto *id = dyn_cast<IdentExpr>(left.get())) {
       auto val = parseAssignment();
-      return std::make_unique<AssignExpr>(id->name, std::move(val),
+      return arena->make<AssignExpr>(id->name, std::move(val),
                                           AssignKind::Borrow);
     }
-    throw ParseError(peek().getLine(), peek().getColumn(),
-                     "'&=' requires an identifier");
+    return errorExpr(peek(), "'&=' requires an identifier");
   }
 
   auto tryCompound = [&](TokenKind tk,
-                         BinaryOp op) -> std::unique_ptr<Expression> {
+                         BinaryOp op) -> AstPtr<Expression> {
     if (match(tk)) {
-      if (auto *id = dynamic_cast<IdentExpr *>(left.get())) {
+      if (auto *id = dyn_cast<IdentExpr>(left.get())) {
         auto rhs = parseAssignment();
-        return std::make_unique<CompoundAssignExpr>(id->name, op,
+        return arena->make<CompoundAssignExpr>(id->name, op,
                                                     std::move(rhs));
       }
-      throw ParseError(
-          peek().getLine(), peek().getColumn(),
-          "Compound assignment requires an identifier on the left");
+      return errorExpr(
+          peek(), "Compound assignment requires an identifier on the left");
     }
     return nullptr;
   };
@@ -1041,22 +1177,22 @@ std::unique_ptr<Expression> Parser::parseAssignment() {
   return left;
 }
 
-std::unique_ptr<Expression> Parser::parseOr() {
+AstPtr<Expression> Parser::parseOr() {
   auto expr = parseAnd();
   while (match(TokenKind::OR))
     expr =
-        std::make_unique<BinaryExpr>(BinaryOp::Or, std::move(expr), parseAnd());
+        arena->make<BinaryExpr>(BinaryOp::Or, std::move(expr), parseAnd());
   return expr;
 }
 
-std::unique_ptr<Expression> Parser::parseAnd() {
+AstPtr<Expression> Parser::parseAnd() {
   auto expr = parseEquality();
   while (true) {
     if (match(TokenKind::DOUBLE_AND))
-      expr = std::make_unique<BinaryExpr>(BinaryOp::And, std::move(expr),
+      expr = arena->make<BinaryExpr>(BinaryOp::And, std::move(expr),
                                           parseEquality());
     else if (match(TokenKind::AND))
-      expr = std::make_unique<BinaryExpr>(BinaryOp::BitAnd, std::move(expr),
+      expr = arena->make<BinaryExpr>(BinaryOp::BitAnd, std::move(expr),
                                           parseEquality());
     else
       break;
@@ -1064,14 +1200,14 @@ std::unique_ptr<Expression> Parser::parseAnd() {
   return expr;
 }
 
-std::unique_ptr<Expression> Parser::parseEquality() {
+AstPtr<Expression> Parser::parseEquality() {
   auto expr = parseComparison();
   while (true) {
     if (match(TokenKind::EQ))
-      expr = std::make_unique<BinaryExpr>(BinaryOp::Eq, std::move(expr),
+      expr = arena->make<BinaryExpr>(BinaryOp::Eq, std::move(expr),
                                           parseComparison());
     else if (match(TokenKind::NE))
-      expr = std::make_unique<BinaryExpr>(BinaryOp::Ne, std::move(expr),
+      expr = arena->make<BinaryExpr>(BinaryOp::Ne, std::move(expr),
                                           parseComparison());
     else
       break;
@@ -1100,7 +1236,7 @@ static bool peekRelOp(TokenKind k, BinaryOp &op) {
   }
 }
 
-std::unique_ptr<Expression> Parser::parseComparison() {
+AstPtr<Expression> Parser::parseComparison() {
   auto lhs = parseAdditive();
 
   BinaryOp firstOp;
@@ -1109,7 +1245,7 @@ std::unique_ptr<Expression> Parser::parseComparison() {
 
   consume();
   std::vector<BinaryOp> ops;
-  std::vector<std::unique_ptr<Expression>> operands;
+  std::vector<AstPtr<Expression>> operands;
   ops.push_back(firstOp);
   operands.push_back(parseAdditive());
 
@@ -1121,21 +1257,21 @@ std::unique_ptr<Expression> Parser::parseComparison() {
   }
 
   if (ops.size() == 1)
-    return std::make_unique<BinaryExpr>(ops[0], std::move(lhs),
+    return arena->make<BinaryExpr>(ops[0], std::move(lhs),
                                         std::move(operands[0]));
 
-  return std::make_unique<ChainedCmpExpr>(std::move(lhs), std::move(ops),
+  return arena->make<ChainedCmpExpr>(std::move(lhs), std::move(ops),
                                           std::move(operands));
 }
 
-std::unique_ptr<Expression> Parser::parseAdditive() {
+AstPtr<Expression> Parser::parseAdditive() {
   auto expr = parseMultiplicative();
   while (true) {
     if (match(TokenKind::ADD))
-      expr = std::make_unique<BinaryExpr>(BinaryOp::Add, std::move(expr),
+      expr = arena->make<BinaryExpr>(BinaryOp::Add, std::move(expr),
                                           parseMultiplicative());
     else if (match(TokenKind::SUB))
-      expr = std::make_unique<BinaryExpr>(BinaryOp::Sub, std::move(expr),
+      expr = arena->make<BinaryExpr>(BinaryOp::Sub, std::move(expr),
                                           parseMultiplicative());
     else
       break;
@@ -1143,7 +1279,7 @@ std::unique_ptr<Expression> Parser::parseAdditive() {
   return expr;
 }
 
-std::unique_ptr<Expression> Parser::parseMultiplicative() {
+AstPtr<Expression> Parser::parseMultiplicative() {
   auto expr = parseUnary();
   while (true) {
     BinaryOp op;
@@ -1155,20 +1291,24 @@ std::unique_ptr<Expression> Parser::parseMultiplicative() {
       op = BinaryOp::Mod;
     else
       break;
-    expr = std::make_unique<BinaryExpr>(op, std::move(expr), parseUnary());
+    expr = arena->make<BinaryExpr>(op, std::move(expr), parseUnary());
   }
   return expr;
 }
 
-std::unique_ptr<Expression> Parser::parseUnary() {
-  if (match(TokenKind::NOT))
-    return std::make_unique<UnaryExpr>(UnaryOp::Not, parseUnary());
-  if (match(TokenKind::SUB))
-    return std::make_unique<UnaryExpr>(UnaryOp::Negate, parseUnary());
+AstPtr<Expression> Parser::parseUnary() {
+  if (match(TokenKind::NOT)) {
+    NestingGuard guard(*this);
+    return arena->make<UnaryExpr>(UnaryOp::Not, parseUnary());
+  }
+  if (match(TokenKind::SUB)) {
+    NestingGuard guard(*this);
+    return arena->make<UnaryExpr>(UnaryOp::Negate, parseUnary());
+  }
   return parsePostfix();
 }
 
-std::unique_ptr<Expression> Parser::parsePostfix() {
+AstPtr<Expression> Parser::parsePostfix() {
   auto expr = parsePrimary();
 
   while (true) {
@@ -1179,10 +1319,10 @@ std::unique_ptr<Expression> Parser::parsePostfix() {
         expect(TokenKind::RBRACKET, "Expected ']'");
       } while (match(TokenKind::LBRACKET));
 
-      if (auto *id = dynamic_cast<IdentExpr *>(expr.get())) {
-        expr = std::make_unique<ArrayIndexExpr>(id->name, std::move(indices));
+      if (auto *id = dyn_cast<IdentExpr>(expr.get())) {
+        expr = arena->make<ArrayIndexExpr>(id->name, std::move(indices));
       } else {
-        expr = std::make_unique<ArrayIndexExpr>(std::move(expr),
+        expr = arena->make<ArrayIndexExpr>(std::move(expr),
                                                 std::move(indices));
       }
       continue;
@@ -1192,20 +1332,20 @@ std::unique_ptr<Expression> Parser::parsePostfix() {
       Token prop = expect(TokenKind::IDENTIFIER, "Expected property name");
 
       if (prop.getWord() == "length") {
-        if (auto *id = dynamic_cast<IdentExpr *>(expr.get())) {
-          expr = std::make_unique<LengthPropertyExpr>(id->name);
-        } else if (auto *arr = dynamic_cast<ArrayIndexExpr *>(expr.get())) {
-          expr = std::make_unique<IndexedLengthExpr>(arr->array,
+        if (auto *id = dyn_cast<IdentExpr>(expr.get())) {
+          expr = arena->make<LengthPropertyExpr>(id->name);
+        } else if (auto *arr = dyn_cast<ArrayIndexExpr>(expr.get())) {
+          expr = arena->make<IndexedLengthExpr>(arr->array,
                                                      std::move(arr->indices));
         } else {
-          throw ParseError(prop.getLine(), prop.getColumn(),
-                           "'.length' requires an array identifier");
+          return errorExpr(prop, "'.length' requires an array identifier");
         }
         continue; // Keep the loop going for any chaining after .length (if
                   // supported)
       }
 
-      expr = std::make_unique<FieldAccessExpr>(std::move(expr), prop.getWord());
+      expr = arena->make<FieldAccessExpr>(std::move(expr),
+                                               std::string(prop.getWord()));
       continue;
     }
 
@@ -1220,12 +1360,12 @@ std::unique_ptr<Expression> Parser::parsePostfix() {
               Token nameTok = expect(TokenKind::IDENTIFIER,
                                      "Expected variable name after '&mut'");
               args.push_back(
-                  std::make_unique<BorrowMutArgExpr>(Identifier{nameTok}));
+                  arena->make<BorrowMutArgExpr>(Identifier{nameTok}));
             } else {
               Token nameTok = expect(TokenKind::IDENTIFIER,
                                      "Expected variable name after '&'");
               args.push_back(
-                  std::make_unique<BorrowArgExpr>(Identifier{nameTok}));
+                  arena->make<BorrowArgExpr>(Identifier{nameTok}));
             }
           } else {
             args.push_back(parseExpression());
@@ -1234,32 +1374,30 @@ std::unique_ptr<Expression> Parser::parsePostfix() {
         expect(TokenKind::RPAREN, "Expected ')'");
       }
 
-      expr = std::make_unique<CallExpr>(std::move(expr), std::move(args));
+      expr = arena->make<CallExpr>(std::move(expr), std::move(args));
       continue;
     }
 
     if (match(TokenKind::INCREMENT)) {
-      if (auto *id = dynamic_cast<IdentExpr *>(expr.get())) {
-        expr = std::make_unique<Increment>(id->name);
+      if (auto *id = dyn_cast<IdentExpr>(expr.get())) {
+        expr = arena->make<Increment>(id->name);
         continue;
       }
-      throw ParseError(peek().getLine(), peek().getColumn(),
-                       "'++' requires an identifier");
+      return errorExpr(peek(), "'++' requires an identifier");
     }
 
     if (match(TokenKind::DECREMENT)) {
-      if (auto *id = dynamic_cast<IdentExpr *>(expr.get())) {
-        expr = std::make_unique<Decrement>(id->name);
+      if (auto *id = dyn_cast<IdentExpr>(expr.get())) {
+        expr = arena->make<Decrement>(id->name);
         continue;
       }
-      throw ParseError(peek().getLine(), peek().getColumn(),
-                       "'--' requires an identifier");
+      return errorExpr(peek(), "'--' requires an identifier");
     }
 
     if (match(TokenKind::AS)) {
       Token castTok = expect(TokenKind::IDENTIFIER, "Expected type after 'as'");
       TypeDesc td(Identifier{castTok});
-      expr = std::make_unique<CastExpr>(std::move(expr), std::move(td));
+      expr = arena->make<CastExpr>(std::move(expr), std::move(td));
       continue;
     }
 
@@ -1271,7 +1409,7 @@ std::unique_ptr<Expression> Parser::parsePostfix() {
 bool Parser::isGenericCallAhead() const {
   size_t i = 1;
   int depth = 1;
-  while (depth > 0 && currentIndex + i < tokens.size()) {
+  while (depth > 0) {
     TokenKind k = this->peekAt(i).getKind();
     if (k == TokenKind::LT)
       ++depth;
@@ -1284,40 +1422,49 @@ bool Parser::isGenericCallAhead() const {
   return depth == 0 && this->peekAt(i).getKind() == TokenKind::LPAREN;
 }
 
-std::unique_ptr<Expression> Parser::parsePrimary() {
+AstPtr<Expression> Parser::parsePrimary() {
   if (isIdentWord("null")) {
     consume();
-    return std::make_unique<NullLitExpr>();
+    return arena->make<NullLitExpr>();
   }
 
-  Token tok = consume();
+  if (check(TokenKind::NEW))
+    return parseNewArray();
+
+  // Only a token that starts an expression is consumed; any other is left
+  // for synchronize(), which needs to see a ';' that ends the statement.
+  Token tok = peek();
   switch (tok.getKind()) {
   case TokenKind::LIT_INT:
-    return std::make_unique<IntLitExpr>(tok);
+    consume();
+    return arena->make<IntLitExpr>(tok);
   case TokenKind::LIT_FLOAT:
-    return std::make_unique<FloatLitExpr>(tok);
+    consume();
+    return arena->make<FloatLitExpr>(tok);
   case TokenKind::LIT_STRING: {
-    std::string combined = tok.getWord();
+    consume();
+    std::string combined(tok.getWord());
     while (peek().getKind() == TokenKind::LIT_STRING) {
       combined += consume().getWord();
     }
     Token merged(TokenKind::LIT_STRING, combined, tok.getLine(),
                  tok.getColumn());
-    return std::make_unique<StrLitExpr>(merged);
+    return arena->make<StrLitExpr>(merged);
   }
   case TokenKind::LIT_CHAR:
-    return std::make_unique<CharLitExpr>(tok);
+    consume();
+    return arena->make<CharLitExpr>(tok);
   case TokenKind::LIT_BOOL:
-    return std::make_unique<BoolLitExpr>(tok);
-  case TokenKind::NEW:
-    --currentIndex;
-    return parseNewArray();
+    consume();
+    return arena->make<BoolLitExpr>(tok);
   case TokenKind::LPAREN: {
+    consume();
     auto expr = parseExpression();
     expect(TokenKind::RPAREN, "Expected ')' after grouped expression");
     return expr;
   }
   case TokenKind::IDENTIFIER: {
+    consume();
     Identifier id{tok};
 
     if (this->check(TokenKind::LT) && this->isGenericCallAhead()) {
@@ -1331,19 +1478,19 @@ std::unique_ptr<Expression> Parser::parsePrimary() {
         } while (this->match(TokenKind::COMMA));
         this->expect(TokenKind::RPAREN, "Expected ')'");
       }
-      return std::make_unique<GenericCallExpr>(id, std::move(typeArgs),
+      return arena->make<GenericCallExpr>(id, std::move(typeArgs),
                                                std::move(args));
     }
 
-    return std::make_unique<IdentExpr>(id);
+    return arena->make<IdentExpr>(id);
   }
   default:
-    throw ParseError(tok.getLine(), tok.getColumn(),
-                     "Unexpected token: `" + tok.getWord() + "`");
+    return errorExpr(tok, "Unexpected token: `" + std::string(tok.getWord()) +
+                              "`");
   }
 }
 
-std::unique_ptr<Expression> Parser::parseNewArray() {
+AstPtr<Expression> Parser::parseNewArray() {
   expect(TokenKind::NEW, "Expected 'new'");
 
   // Parse the element type in full — base + optional <TypeArgs> + optional [][]
@@ -1360,5 +1507,5 @@ std::unique_ptr<Expression> Parser::parseNewArray() {
     consume();
   } while (true);
 
-  return std::make_unique<NewArrayExpr>(std::move(elemTd), std::move(sizes));
+  return arena->make<NewArrayExpr>(std::move(elemTd), std::move(sizes));
 }
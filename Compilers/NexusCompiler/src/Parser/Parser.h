@@ -5,16 +5,29 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 // Custom
 #include "../AST/AST.h"
 #include "../Token/TokenType.h"
+#include "ParserError.h"
+
+class Lexer;
 
 class Parser {
 private:
-  std::vector<Token> tokens;
-  size_t currentIndex = 0;
+  Lexer &lexer;
+  // Lookahead window pulled from the lexer on demand: peekAt(i) is
+  // window[(head + i) & (window.size() - 1)] for i < buffered. The size is
+  // a power of two; it only grows past kLookahead when a scan (generic
+  // argument lists) looks further ahead than that.
+  static constexpr size_t kLookahead = 16;
+  mutable std::vector<Token> window;
+  mutable size_t head = 0;
+  mutable size_t buffered = 0;
+  // Every node is allocated here; parse() hands it to the Program.
+  std::shared_ptr<AstArena> arena = std::make_shared<AstArena>();
   const Token &peek() const;
   const Token &peekAt(size_t offset) const;
   const Token consume();
@@ -23,49 +36,72 @@ private:
   Token expect(TokenKind kind, std::string_view errorMsg = {});
   bool isAtEnd() const;
 
+  // Error recovery. error() records a diagnostic and puts the parser in
+  // panic mode: until recover(), peekAt() answers panicEof, so every
+  // production sees END_OF_FILE and unwinds to the nearest recovery point
+  // (a statement in parseBlock, or a top-level declaration) without
+  // consuming input or reporting follow-on errors. The input position is
+  // left at the offending token, where synchronize() resumes.
+  std::vector<ParseDiagnostic> diags;
+  bool panicking = false;
+  Token panicEof{TokenKind::END_OF_FILE, 0u, 0u, 0, 0};
+  void error(const Token &at, std::string message);
+  AstPtr<Expression> errorExpr(const Token &at, std::string message);
+  void recover();
+  void parseTopLevel(Program &prog);
+  void synchronizeTopLevel(const Token &start);
+
+  // Recursion depth of blocks and expressions; see NestingGuard.
+  unsigned nesting = 0;
+  class NestingGuard;
+
 protected:
   void synchronize();
 
 public:
-  explicit Parser(const std::vector<Token> &t) : tokens(t) {}
+  // Pulls tokens from lexer as it goes; lexer must outlive parse().
+  explicit Parser(Lexer &l);
+  // Never returns null. Syntax errors do not stop the parse; check
+  // diagnostics() before using the Program.
   std::unique_ptr<Program> parse();
-  std::unique_ptr<ImportDecl> parseImportDecl();
-  std::unique_ptr<GlobalVarDecl> parseGlobalVarDecl();
+  const std::vector<ParseDiagnostic> &diagnostics() const { return diags; }
+  AstPtr<ImportDecl> parseImportDecl();
+  AstPtr<GlobalVarDecl> parseGlobalVarDecl();
   bool isIdentWord(std::string_view word) const;
   ExternBlock parseExternBlock();
-  std::unique_ptr<EnumDecl> parseEnumDecl();
-  std::unique_ptr<MatchStmt> parseMatchStmt();
+  AstPtr<EnumDecl> parseEnumDecl();
+  AstPtr<MatchStmt> parseMatchStmt();
   MatchArm parseMatchArm();
-  std::unique_ptr<StructDecl> parseStructDecl();
-  std::unique_ptr<VarDecl> parseVarDeclNoInit();
+  AstPtr<StructDecl> parseStructDecl();
+  AstPtr<VarDecl> parseVarDeclNoInit();
   std::vector<std::string> parseTypeParamList();
   std::vector<TypeDesc> parseTypeArgList();
   TypeDesc parseTypeDesc();
   bool isGenericCallAhead() const;
-  std::unique_ptr<Function> parseFunctionDecl();
-  std::unique_ptr<Block> parseBlock(bool uni = false);
-  std::unique_ptr<Statement> parseStatement();
-  std::unique_ptr<Expression> parseExpression();
-  std::unique_ptr<VarDecl> parseVarDeclStatement(AssignKind kind);
-  std::unique_ptr<IfStmt> parseIfStatement();
-  std::unique_ptr<WhileStmt> parseWhileLoop();
-  std::unique_ptr<WhileStmt> parseLoop();
-  std::unique_ptr<Statement> parseForLoop();
-  std::unique_ptr<Return> parseReturnStatement();
-  std::unique_ptr<Statement> parseLoopBreak();
-  std::unique_ptr<Expression> parsePrimary();
-  std::unique_ptr<Expression> parseNewArray();
-  std::unique_ptr<Statement> parseArrayAssign();
-  std::unique_ptr<Statement> parseTypeIntrinsicStmt();
-  std::unique_ptr<Expression> parseAssignment();
-  std::unique_ptr<Expression> parseOr();
-  std::unique_ptr<Expression> parseAnd();
-  std::unique_ptr<Expression> parseEquality();
-  std::unique_ptr<Expression> parseComparison();
-  std::unique_ptr<Expression> parseAdditive();
-  std::unique_ptr<Expression> parseMultiplicative();
-  std::unique_ptr<Expression> parseUnary();
-  std::unique_ptr<Expression> parsePostfix();
+  AstPtr<Function> parseFunctionDecl();
+  AstPtr<Block> parseBlock(bool uni = false);
+  AstPtr<Statement> parseStatement();
+  AstPtr<Expression> parseExpression();
+  AstPtr<VarDecl> parseVarDeclStatement(AssignKind kind);
+  AstPtr<IfStmt> parseIfStatement();
+  AstPtr<WhileStmt> parseWhileLoop();
+  AstPtr<WhileStmt> parseLoop();
+  AstPtr<Statement> parseForLoop();
+  AstPtr<Return> parseReturnStatement();
+  AstPtr<Statement> parseLoopBreak();
+  AstPtr<Expression> parsePrimary();
+  AstPtr<Expression> parseNewArray();
+  AstPtr<Statement> parseArrayAssign();
+  AstPtr<Statement> parseTypeIntrinsicStmt();
+  AstPtr<Expression> parseAssignment();
+  AstPtr<Expression> parseOr();
+  AstPtr<Expression> parseAnd();
+  AstPtr<Expression> parseEquality();
+  AstPtr<Expression> parseComparison();
+  AstPtr<Expression> parseAdditive();
+  AstPtr<Expression> parseMultiplicative();
+  AstPtr<Expression> parseUnary();
+  AstPtr<Expression> parsePostfix();
 };
 
 #endif
@@ -1,20 +1,32 @@
 #ifndef PARSE_ERROR_H
 #define PARSE_ERROR_H
 
-#include <iostream>
+#include <ostream>
 #include <stdexcept>
 #include <string>
 
+// One syntax error. The parser records these and recovers; it does not
+// print them. Callers read them from Parser::diagnostics().
+struct ParseDiagnostic {
+  int line;
+  int column;
+  std::string message;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const ParseDiagnostic &d) {
+  return os << "\033[31m" << d.message << " | Line : " << d.line
+            << " Column : " << d.column << "\033[0m\n";
+}
+
+// Thrown only for input the parser cannot continue through (nesting deeper
+// than it is willing to recurse). parse() turns it into a final diagnostic.
 class ParseError : public std::runtime_error {
 public:
   int line;
   int column;
 
   ParseError(int l, int c, const std::string &message)
-      : std::runtime_error(message), line(l), column(c) {
-    std::cout << "\033[31m" << message << " | Line : " << l << " Column : " << c
-              << "\033[0m\n";
-  }
+      : std::runtime_error(message), line(l), column(c) {}
 };
 
 #endif
@@ -0,0 +1,124 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include "TokenType.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Reserved words and the token each one lexes to.
+struct Keyword {
+  std::string_view spelling;
+  TokenKind kind;
+};
+
+inline constexpr Keyword kKeywords[] = {
+    {"if", TokenKind::IF},
+    {"fn", TokenKind::FN},
+    {"as", TokenKind::AS},
+    {"new", TokenKind::NEW},
+    {"for", TokenKind::FOR},
+    {"mut", TokenKind::MUT},
+    {"else", TokenKind::ElSE},
+    {"true", TokenKind::LIT_BOOL},
+    {"loop", TokenKind::LOOP},
+    {"enum", TokenKind::ENUM},
+    {"while", TokenKind::WHILE},
+    {"false", TokenKind::LIT_BOOL},
+    {"const", TokenKind::CONST},
+    {"break", TokenKind::BREAK},
+    {"match", TokenKind::MATCH},
+    {"return", TokenKind::RETURN},
+    {"import", TokenKind::IMPORT},
+    {"public", TokenKind::PUBLIC},
+    {"private", TokenKind::PRIVATE},
+    {"continue", TokenKind::CONTINUE},
+    // The parser has no protected visibility; it reads as private.
+    {"protected", TokenKind::PRIVATE},
+};
+
+// Perfect hash over kKeywords, found at compile time.
+//
+// A word's slot is (length + first * F + last * L) mod kSlots. The
+// multipliers F and L are the first pair that sends every keyword to a
+// different slot. Recognising a word therefore costs one hash, one table
+// load and at most one compare, whatever its length. Adding a keyword only
+// needs an entry above. If no pair works any more, the static_assert below
+// fires; raise kSlots.
+namespace keyword_detail {
+
+constexpr size_t kCount = sizeof(kKeywords) / sizeof(kKeywords[0]);
+constexpr size_t kSlots = 64;
+
+struct Hash {
+  uint32_t first;
+  uint32_t last;
+};
+
+constexpr uint32_t slotOf(std::string_view w, Hash h) {
+  return (static_cast<uint32_t>(w.size()) +
+          static_cast<unsigned char>(w.front()) * h.first +
+          static_cast<unsigned char>(w.back()) * h.last) &
+         (kSlots - 1);
+}
+
+constexpr Hash findHash() {
+  for (uint32_t f = 1; f < kSlots; ++f) {
+    for (uint32_t l = 0; l < kSlots; ++l) {
+      bool used[kSlots] = {};
+      bool ok = true;
+      for (size_t i = 0; i < kCount && ok; ++i) {
+        uint32_t s = slotOf(kKeywords[i].spelling, {f, l});
+        ok = !used[s];
+        used[s] = true;
+      }
+      if (ok)
+        return {f, l};
+    }
+  }
+  return {0, 0};
+}
+
+constexpr Hash kHash = findHash();
+static_assert(kHash.first != 0, "no perfect hash for kKeywords; grow kSlots");
+
+// slots[s] is 1 + the index of the keyword hashed to s, or 0.
+struct Table {
+  uint8_t slots[kSlots] = {};
+  size_t minLen = ~size_t(0);
+  size_t maxLen = 0;
+};
+
+constexpr Table buildTable() {
+  Table t;
+  for (size_t i = 0; i < kCount; ++i) {
+    std::string_view w = kKeywords[i].spelling;
+    t.slots[slotOf(w, kHash)] = static_cast<uint8_t>(i + 1);
+    t.minLen = w.size() < t.minLen ? w.size() : t.minLen;
+    t.maxLen = w.size() > t.maxLen ? w.size() : t.maxLen;
+  }
+  return t;
+}
+
+constexpr Table kTable = buildTable();
+
+} // namespace keyword_detail
+
+// The keyword's token kind, or IDENTIFIER if w is not a keyword.
+constexpr TokenKind keywordKind(std::string_view w) {
+  using namespace keyword_detail;
+  if (w.size() < kTable.minLen || w.size() > kTable.maxLen)
+    return TokenKind::IDENTIFIER;
+  uint8_t entry = kTable.slots[slotOf(w, kHash)];
+  if (entry == 0 || kKeywords[entry - 1].spelling != w)
+    return TokenKind::IDENTIFIER;
+  return kKeywords[entry - 1].kind;
+}
+
+static_assert(keywordKind("protected") == TokenKind::PRIVATE &&
+                  keywordKind("if") == TokenKind::IF &&
+                  keywordKind("iff") == TokenKind::IDENTIFIER &&
+                  keywordKind("x") == TokenKind::IDENTIFIER,
+              "keyword table is inconsistent");
+
+#endif // KEYWORDS_H
@@ -0,0 +1,87 @@
+#include "SourceManager.h"
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+const char *SourceManager::chunks[1u << (32 - SourceManager::kChunkBits)];
+
+namespace {
+
+constexpr uint32_t kNumChunks = 1u << (32 - SourceManager::kChunkBits);
+
+std::mutex registryLock;
+std::vector<std::unique_ptr<SourceBuffer>> buffers;
+std::vector<std::unique_ptr<char[]>> scratchBlocks;
+
+// Chunk 0 is reserved so that location 0 never names a real byte.
+uint32_t nextChunk = 1;
+
+// Free tail of the current scratch block.
+char *scratchPtr = nullptr;
+uint32_t scratchLoc = 0;
+uint32_t scratchLeft = 0;
+
+// Reserves enough whole chunks for size bytes and returns the first one.
+// Must be called with registryLock held.
+uint32_t reserveChunks(size_t size) {
+  size_t count = (size + SourceManager::kChunkMask) >> SourceManager::kChunkBits;
+  if (count == 0)
+    count = 1;
+  if (count > kNumChunks - nextChunk)
+    throw std::runtime_error("source location space exhausted (4 GiB)");
+  uint32_t first = nextChunk;
+  nextChunk += static_cast<uint32_t>(count);
+  return first;
+}
+
+} // namespace
+
+void SourceManager::mapChunks(uint32_t base, const char *bytes, size_t size) {
+  uint32_t first = base >> kChunkBits;
+  size_t count = size == 0 ? 1 : (size + kChunkMask) >> kChunkBits;
+  for (size_t i = 0; i < count; ++i)
+    chunks[first + i] = bytes + i * kChunkSize;
+}
+
+uint32_t SourceManager::addBuffer(SourceBuffer buffer) {
+  std::lock_guard<std::mutex> guard(registryLock);
+
+  buffers.push_back(std::make_unique<SourceBuffer>(std::move(buffer)));
+  const SourceBuffer &owned = *buffers.back();
+
+  uint32_t base;
+  try {
+    base = reserveChunks(owned.size()) << kChunkBits;
+  } catch (...) {
+    buffers.pop_back();
+    throw;
+  }
+  mapChunks(base, owned.data(), owned.size());
+  return base;
+}
+
+uint32_t SourceManager::addScratch(std::string_view text) {
+  if (text.empty())
+    return 0;
+  // Large spellings are not worth packing; give them their own buffer.
+  if (text.size() > kChunkSize / 4)
+    return addBuffer(SourceBuffer(std::string(text)));
+
+  std::lock_guard<std::mutex> guard(registryLock);
+  if (text.size() > scratchLeft) {
+    uint32_t base = reserveChunks(kChunkSize) << kChunkBits;
+    scratchBlocks.push_back(std::make_unique<char[]>(kChunkSize));
+    scratchPtr = scratchBlocks.back().get();
+    scratchLoc = base;
+    scratchLeft = kChunkSize;
+    mapChunks(base, scratchPtr, kChunkSize);
+  }
+
+  uint32_t loc = scratchLoc;
+  text.copy(scratchPtr, text.size());
+  scratchPtr += text.size();
+  scratchLoc += static_cast<uint32_t>(text.size());
+  scratchLeft -= static_cast<uint32_t>(text.size());
+  return loc;
+}
@@ -0,0 +1,55 @@
+#ifndef SOURCE_MANAGER_H
+#define SOURCE_MANAGER_H
+
+#include "../FileReader/FileReader.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Session-wide owner of every byte a Token can point at.
+//
+// Buffers are laid out in a single 32-bit location space, so a token only
+// needs (location, length) to find its spelling. Each buffer starts on a
+// 64 KiB chunk boundary and a flat chunk table maps a location back to its
+// bytes without locking or searching. Source files are registered whole by
+// the Lexer; spellings the parser synthesises (merged string literals,
+// desugared range bounds) go to a small scratch area.
+//
+// Buffers live until the process exits: parsed modules are cached for the
+// whole run, and their tokens must stay valid for as long as the AST does.
+// Location 0 is never handed out and stands for "no spelling".
+class SourceManager {
+public:
+  static constexpr unsigned kChunkBits = 16;
+  static constexpr uint32_t kChunkSize = 1u << kChunkBits;
+  static constexpr uint32_t kChunkMask = kChunkSize - 1;
+
+  // Takes ownership of buffer (mapping and padding included) and returns
+  // the location of its first byte. Throws std::runtime_error once the
+  // location space is exhausted.
+  static uint32_t addBuffer(SourceBuffer buffer);
+
+  // Copies text into scratch storage and returns its location.
+  static uint32_t addScratch(std::string_view text);
+
+  // Pointer to the byte at loc. loc must come from one of the functions
+  // above (or an offset into the buffer they returned).
+  static const char *data(uint32_t loc) {
+    return chunks[loc >> kChunkBits] + (loc & kChunkMask);
+  }
+
+  static std::string_view spelling(uint32_t loc, uint32_t length) {
+    if (length == 0)
+      return {};
+    return std::string_view(data(loc), length);
+  }
+
+private:
+  // chunks[i] points at the bytes of location i * kChunkSize. Entries are
+  // written once, before the location is returned to any caller.
+  static const char *chunks[1u << (32 - kChunkBits)];
+
+  static void mapChunks(uint32_t base, const char *bytes, size_t size);
+};
+
+#endif // SOURCE_MANAGER_H
@@ -0,0 +1,65 @@
+#include "Symbol.h"
+#include "SourceManager.h"
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+// Interned spellings are stored in SourceManager scratch as a 4-byte length
+// followed by the bytes; the symbol id is the location of the first byte.
+
+namespace {
+
+constexpr size_t kShards = 64;
+
+struct Shard {
+  std::mutex lock;
+  std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+Shard shards[kShards];
+
+uint32_t store(std::string_view text) {
+  std::string record(sizeof(uint32_t) + text.size(), '\0');
+  const uint32_t len = static_cast<uint32_t>(text.size());
+  std::memcpy(&record[0], &len, sizeof(len));
+  std::memcpy(&record[sizeof(len)], text.data(), text.size());
+  return SourceManager::addScratch(record) + sizeof(len);
+}
+
+} // namespace
+
+Symbol Symbol::intern(std::string_view text) {
+  if (text.empty())
+    return Symbol();
+
+  // Per-thread front cache; keys point at interned bytes, so they stay
+  // valid for the whole run.
+  thread_local std::unordered_map<std::string_view, uint32_t> cache;
+  auto hit = cache.find(text);
+  if (hit != cache.end())
+    return fromId(hit->second);
+
+  Shard &shard = shards[std::hash<std::string_view>()(text) % kShards];
+  uint32_t id;
+  {
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto it = shard.ids.find(text);
+    if (it != shard.ids.end()) {
+      id = it->second;
+    } else {
+      id = store(text);
+      shard.ids.emplace(fromId(id).str(), id);
+    }
+  }
+  cache.emplace(fromId(id).str(), id);
+  return fromId(id);
+}
+
+std::string_view Symbol::str() const {
+  if (id_ == 0)
+    return {};
+  const char *bytes = SourceManager::data(id_);
+  uint32_t len;
+  std::memcpy(&len, bytes - sizeof(len), sizeof(len));
+  return std::string_view(bytes, len);
+}
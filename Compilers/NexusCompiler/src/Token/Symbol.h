@@ -0,0 +1,55 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Interned name: identifiers, type names and mangled symbols.
+//
+// Every distinct spelling is stored once for the whole run and identified by
+// a stable 32-bit id, so comparing or hashing two Symbols is an integer
+// operation. The id is the SourceManager location of the interned bytes,
+// which means a Token can carry it in place of its source location and
+// str() never takes a lock. Interning is thread-safe; each thread keeps a
+// small front cache so -j workers rarely contend on the shared table.
+class Symbol {
+public:
+  // The empty symbol (id 0, spelling "").
+  Symbol() = default;
+
+  static Symbol intern(std::string_view text);
+
+  // Rebuilds a Symbol from id(); id must come from a live Symbol.
+  static Symbol fromId(uint32_t id) {
+    Symbol s;
+    s.id_ = id;
+    return s;
+  }
+
+  uint32_t id() const { return id_; }
+  bool empty() const { return id_ == 0; }
+
+  // The interned spelling; valid until the process exits.
+  std::string_view str() const;
+
+  friend bool operator==(Symbol a, Symbol b) { return a.id_ == b.id_; }
+  friend bool operator!=(Symbol a, Symbol b) { return a.id_ != b.id_; }
+  // Orders by id, not alphabetically.
+  friend bool operator<(Symbol a, Symbol b) { return a.id_ < b.id_; }
+
+private:
+  uint32_t id_ = 0;
+};
+
+namespace std {
+template <> struct hash<Symbol> {
+  size_t operator()(Symbol s) const noexcept {
+    // Ids are byte offsets that cluster; mix so the low bits vary.
+    return static_cast<size_t>(s.id() * 0x9E3779B1u);
+  }
+};
+} // namespace std
+
+#endif // SYMBOL_H
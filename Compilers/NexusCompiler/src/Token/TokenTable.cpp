@@ -1,8 +1,8 @@
+#include "Keywords.h"
 #include "TokenType.h"
 #include <optional>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 
 class TokenTable {
 private:
@@ -13,23 +13,18 @@ public:
     return TokenTable::table[static_cast<int>(k)];
   }
 
+  // Keyword kind for s; same table the Lexer uses.
   static std::optional<TokenKind> getKindFromSpelling(std::string_view s) {
-    static const std::unordered_map<std::string_view, TokenKind> keywordMap = {
-        {"i32", TokenKind::IDENTIFIER},
-        {"return", TokenKind::RETURN},
-    };
-
-    auto it = keywordMap.find(s);
-    if (it != keywordMap.end())
-      return it->second;
-
+    TokenKind k = keywordKind(s);
+    if (k != TokenKind::IDENTIFIER)
+      return k;
     return std::nullopt;
   }
 };
 
 // This only serves for debugging //
 std::string Token::toString() {
-  switch (this->kind) {
+  switch (getKind()) {
   case TokenKind::IDENTIFIER:
     return "IDENTIFIER  ";
   case TokenKind::IF:
@@ -1,11 +1,15 @@
 #ifndef TokenType
 #define TokenType
 
+#include "SourceManager.h"
+#include "Symbol.h"
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <string_view>
+#include <type_traits>
 
-enum class TokenKind {
+enum class TokenKind : uint8_t {
   // KeyWords
   IDENTIFIER,
   IF,
@@ -90,23 +94,60 @@ struct TokenInfo {
   const char *spelling;
 };
 
+// A token is a 16-byte value: its spelling lives in a buffer owned by the
+// SourceManager, so copying a token never allocates and getWord() is a view.
+// Identifiers produced by the Lexer are interned: their location is the
+// Symbol id, so getSymbol() is free.
 class Token {
 private:
-  TokenKind kind;
-  std::string word;
-  int line;
-  int column;
+  uint32_t loc;    // SourceManager location of the spelling (or Symbol id)
+  uint32_t length; // spelling length in bytes
+  uint32_t line;
+  uint32_t column : 23;
+  uint32_t interned : 1; // loc is a Symbol id
+  uint32_t kind : 8;
 
 public:
+  // Token spelled by bytes already owned by the SourceManager (the Lexer).
+  Token(TokenKind k, uint32_t at, uint32_t len, size_t l, size_t c)
+      : loc(at), length(len), line(static_cast<uint32_t>(l)),
+        column(static_cast<uint32_t>(c)), interned(0),
+        kind(static_cast<uint32_t>(k)) {}
+
+  // Interned token: the spelling is the symbol's.
+  Token(TokenKind k, Symbol sym, uint32_t len, size_t l, size_t c)
+      : Token(k, sym.id(), len, l, c) {
+    interned = 1;
+  }
+
+  // Token with a synthesised spelling, copied into SourceManager scratch.
   Token(TokenKind k, std::string_view w, int l, int c)
-      : kind(k), word(w), line(l), column(c) {}
+      : Token(k, SourceManager::addScratch(w), static_cast<uint32_t>(w.size()),
+              l, c) {}
 
   // getters
-  TokenKind getKind() const { return this->kind; }
-  std::string getWord() const { return this->word; }
-  int getLine() const { return this->line; }
-  int getColumn() const { return this->column; }
+  TokenKind getKind() const { return static_cast<TokenKind>(this->kind); }
+  std::string_view getWord() const {
+    return SourceManager::spelling(this->loc, this->length);
+  }
+  int getLine() const { return static_cast<int>(this->line); }
+  int getColumn() const { return static_cast<int>(this->column); }
+  Symbol getSymbol() const {
+    return interned ? Symbol::fromId(loc) : Symbol::intern(getWord());
+  }
+
+  // Same spelling and position, different kind (e.g. a keyword reused as a
+  // type name).
+  Token withKind(TokenKind k) const {
+    Token t = *this;
+    t.kind = static_cast<uint32_t>(k);
+    return t;
+  }
   std::string toString();
 };
 
+static_assert(sizeof(Token) == 16, "Token should stay a compact 16 bytes");
+static_assert(std::is_trivially_copyable_v<Token>,
+              "Token should stay trivially copyable");
+
 #endif
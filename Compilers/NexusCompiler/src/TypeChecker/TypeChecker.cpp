@@ -6,20 +6,22 @@
 //  Scope / symbol helpers   //
 // ------------------------- //
 
-void TypeChecker::declareVar(const std::string &name, const NexusType &type) {
+void TypeChecker::declareVar(Symbol name, const NexusType &type) {
   if (scopes_.empty()) {
-    error("Internal: no active scope when declaring '" + name + "'");
+    error("Internal: no active scope when declaring '" +
+          std::string(name.str()) + "'");
     return;
   }
   auto &top = scopes_.back();
   if (top.count(name)) {
-    error("Redeclaration of variable '" + name + "' in the same scope");
+    error("Redeclaration of variable '" + std::string(name.str()) +
+          "' in the same scope");
     return;
   }
   top[name] = type;
 }
 
-std::optional<NexusType> TypeChecker::lookupVar(const std::string &name) const {
+std::optional<NexusType> TypeChecker::lookupVar(Symbol name) const {
   for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
     auto found = it->find(name);
     if (found != it->end())
@@ -35,6 +37,9 @@ bool TypeChecker::typeExists(const std::string &name) const {
   for (auto &p : primitives)
     if (p == name)
       return true;
+  for (auto &tp : typeParams_)
+    if (tp == name)
+      return true;
   return structs_.count(name) > 0;
 }
 
@@ -60,6 +65,7 @@ bool TypeChecker::isAssignable(const NexusType &from,
 void TypeChecker::registerStructs(const Program &prog) {
   for (auto &sd : prog.structs) {
     std::vector<std::pair<std::string, NexusType>> fields;
+    typeParams_ = sd->typeParams;
     for (auto &f : sd->fields) {
       NexusType ft = NexusType::fromTypeDesc(f.type);
       if (!typeExists(ft.base))
@@ -69,36 +75,39 @@ void TypeChecker::registerStructs(const Program &prog) {
     }
     structs_[sd->name] = std::move(fields);
   }
+  typeParams_.clear();
 }
 
 void TypeChecker::registerFunctions(const Program &prog) {
   for (auto &fn : prog.functions) {
-    const std::string &nm = fn->name.token.getWord();
     FuncSig sig;
+    sig.typeParams = fn->typeParams;
     sig.ret = NexusType::fromTypeDesc(fn->returnType);
     for (auto &p : fn->params)
       sig.params.push_back(NexusType::fromTypeDesc(p.type));
-    funcs_[nm] = std::move(sig);
+    funcs_[fn->name.symbol()] = std::move(sig);
   }
 }
 
 void TypeChecker::registerExterns(const Program &prog) {
   for (auto &eb : prog.externBlocks) {
     for (auto &decl : eb.decls) {
-      if (funcs_.count(decl.name))
+      Symbol name = Symbol::intern(decl.name);
+      if (funcs_.count(name))
         continue; // allow shadowing by user fn
       FuncSig sig;
       sig.ret = NexusType::fromTypeDesc(decl.returnType);
       for (auto &pt : decl.paramTypes)
         sig.params.push_back(NexusType::fromTypeDesc(pt));
-      funcs_[decl.name] = std::move(sig);
+      funcs_[name] = std::move(sig);
     }
   }
 }
 
 void TypeChecker::registerBuiltins() {
-  auto reg = [&](const std::string &name, NexusType ret,
+  auto reg = [&](std::string_view spelling, NexusType ret,
                  std::vector<NexusType> params = {}) {
+    Symbol name = Symbol::intern(spelling);
     if (!funcs_.count(name)) {
       FuncSig sig;
       sig.ret = std::move(ret);
@@ -129,7 +138,7 @@ void TypeChecker::registerGlobals(const Program &prog) {
         error("Global '" + gv->name + "': initialiser type '" + it.str() +
               "' is not assignable to declared type '" + gt.str() + "'");
     }
-    declareVar(gv->name, gt);
+    declareVar(gv->symbol, gt);
   }
 }
 
@@ -159,20 +168,23 @@ bool TypeChecker::check(const Program &prog) {
 
 void TypeChecker::checkFunction(const Function &fn) {
   currentReturnType_ = NexusType::fromTypeDesc(fn.returnType);
+  typeParams_ = fn.typeParams;
 
   pushScope();
   for (auto &p : fn.params) {
     NexusType pt = NexusType::fromTypeDesc(p.type);
     if (!typeExists(pt.base))
-      error("Function '" + fn.name.token.getWord() + "' parameter '" +
-            p.name.token.getWord() + "' has unknown type '" + pt.base + "'");
-    declareVar(p.name.token.getWord(), pt);
+      error("Function '" + std::string(fn.name.token.getWord()) +
+            "' parameter '" + std::string(p.name.token.getWord()) +
+            "' has unknown type '" + pt.base + "'");
+    declareVar(p.name.symbol(), pt);
   }
 
   if (fn.body)
     checkBlock(*fn.body);
 
   popScope();
+  typeParams_.clear();
 }
 
 // ------------------ //
@@ -187,35 +199,39 @@ void TypeChecker::checkBlock(const Block &block) {
 }
 
 void TypeChecker::checkStatement(const Statement &stmt) {
-  if (auto *s = dynamic_cast<const VarDecl *>(&stmt))
-    return checkVarDecl(*s);
-  if (auto *s = dynamic_cast<const ExprStmt *>(&stmt))
-    return checkExprStmt(*s);
-  if (auto *s = dynamic_cast<const IfStmt *>(&stmt))
-    return checkIfStmt(*s);
-  if (auto *s = dynamic_cast<const WhileStmt *>(&stmt))
-    return checkWhileStmt(*s);
-  if (auto *s = dynamic_cast<const ForRangeStmt *>(&stmt))
-    return checkForRange(*s);
-  if (auto *s = dynamic_cast<const Return *>(&stmt))
-    return checkReturn(*s);
-  // Break / Continue have no types to check.
+  switch (stmt.getKind()) {
+  case StmtKind::VarDecl:
+    return checkVarDecl(cast<VarDecl>(stmt));
+  case StmtKind::Expr:
+    return checkExprStmt(cast<ExprStmt>(stmt));
+  case StmtKind::If:
+    return checkIfStmt(cast<IfStmt>(stmt));
+  case StmtKind::While:
+    return checkWhileStmt(cast<WhileStmt>(stmt));
+  case StmtKind::ForRange:
+    return checkForRange(cast<ForRangeStmt>(stmt));
+  case StmtKind::Return:
+    return checkReturn(cast<Return>(stmt));
+  default:
+    // Break / Continue / Error have no types to check.
+    return;
+  }
 }
 
 void TypeChecker::checkVarDecl(const VarDecl &s) {
   NexusType declared = NexusType::fromTypeDesc(s.type);
   if (!typeExists(declared.base))
-    error("Variable '" + s.name.token.getWord() + "' has unknown type '" +
-          declared.base + "'");
+    error("Variable '" + std::string(s.name.token.getWord()) +
+          "' has unknown type '" + declared.base + "'");
 
   if (s.initializer) {
     NexusType init = inferExpr(*s.initializer);
     if (!isAssignable(init, declared))
-      error("Variable '" + s.name.token.getWord() + "': initialiser type '" +
-            init.str() + "' is not assignable to declared type '" +
-            declared.str() + "'");
+      error("Variable '" + std::string(s.name.token.getWord()) +
+            "': initialiser type '" + init.str() +
+            "' is not assignable to declared type '" + declared.str() + "'");
   }
-  declareVar(s.name.token.getWord(), declared);
+  declareVar(s.name.symbol(), declared);
 }
 
 void TypeChecker::checkExprStmt(const ExprStmt &s) {
@@ -246,7 +262,7 @@ void TypeChecker::checkForRange(const ForRangeStmt &s) {
 
   NexusType varTy = NexusType::fromTypeDesc(s.varType);
   if (!typeExists(varTy.base))
-    error("For-range variable '" + s.varName.token.getWord() +
+    error("For-range variable '" + std::string(s.varName.token.getWord()) +
           "' has unknown type '" + varTy.base + "'");
 
   if (s.start) {
@@ -265,7 +281,7 @@ void TypeChecker::checkForRange(const ForRangeStmt &s) {
       error("For-range step must be 'int', got '" + sp.str() + "'");
   }
 
-  declareVar(s.varName.token.getWord(), varTy);
+  declareVar(s.varName.symbol(), varTy);
   if (s.body)
     checkBlock(*s.body);
 
@@ -290,50 +306,59 @@ void TypeChecker::checkReturn(const Return &s) {
 // --------------------------- //
 
 NexusType TypeChecker::inferExpr(const Expression &expr) {
-  if (auto *e = dynamic_cast<const IntLitExpr *>(&expr))
-    return inferIntLit(*e);
-  if (auto *e = dynamic_cast<const FloatLitExpr *>(&expr))
-    return inferFloatLit(*e);
-  if (auto *e = dynamic_cast<const StrLitExpr *>(&expr))
-    return inferStrLit(*e);
-  if (auto *e = dynamic_cast<const BoolLitExpr *>(&expr))
-    return inferBoolLit(*e);
-  if (auto *e = dynamic_cast<const CharLitExpr *>(&expr))
-    return inferCharLit(*e);
-  if (auto *e = dynamic_cast<const NullLitExpr *>(&expr))
-    return inferNullLit(*e);
-  if (auto *e = dynamic_cast<const IdentExpr *>(&expr))
-    return inferIdent(*e);
-  if (auto *e = dynamic_cast<const BinaryExpr *>(&expr))
-    return inferBinary(*e);
-  if (auto *e = dynamic_cast<const UnaryExpr *>(&expr))
-    return inferUnary(*e);
-  if (auto *e = dynamic_cast<const CallExpr *>(&expr))
-    return inferCall(*e);
-  if (auto *e = dynamic_cast<const AssignExpr *>(&expr))
-    return inferAssign(*e);
-  if (auto *e = dynamic_cast<const Increment *>(&expr))
-    return inferIncDec(e->target.token.getWord());
-  if (auto *e = dynamic_cast<const Decrement *>(&expr))
-    return inferIncDec(e->target.token.getWord());
-  if (auto *e = dynamic_cast<const NewArrayExpr *>(&expr))
-    return inferNewArray(*e);
-  if (auto *e = dynamic_cast<const ArrayIndexExpr *>(&expr))
-    return inferArrayIndex(*e);
-  if (auto *e = dynamic_cast<const ArrayIndexAssignExpr *>(&expr))
-    return inferArrayIndexAssign(*e);
-  if (auto *e = dynamic_cast<const LengthPropertyExpr *>(&expr))
-    return inferLengthProp(*e);
-  if (auto *e = dynamic_cast<const IndexedLengthExpr *>(&expr))
-    return inferIndexedLength(*e);
-  if (auto *e = dynamic_cast<const FieldAccessExpr *>(&expr))
-    return inferFieldAccess(*e);
-  if (auto *e = dynamic_cast<const FieldAssignExpr *>(&expr))
-    return inferFieldAssign(*e);
-  if (auto *e = dynamic_cast<const StructLitExpr *>(&expr))
-    return inferStructLit(*e);
-  if (auto *e = dynamic_cast<const CompoundAssignExpr *>(&expr))
-    return inferCompoundAssign(*e);
+  switch (expr.getKind()) {
+  case ExprKind::IntLit:
+    return inferIntLit(cast<IntLitExpr>(expr));
+  case ExprKind::FloatLit:
+    return inferFloatLit(cast<FloatLitExpr>(expr));
+  case ExprKind::StrLit:
+    return inferStrLit(cast<StrLitExpr>(expr));
+  case ExprKind::BoolLit:
+    return inferBoolLit(cast<BoolLitExpr>(expr));
+  case ExprKind::CharLit:
+    return inferCharLit(cast<CharLitExpr>(expr));
+  case ExprKind::NullLit:
+    return inferNullLit(cast<NullLitExpr>(expr));
+  case ExprKind::Ident:
+    return inferIdent(cast<IdentExpr>(expr));
+  case ExprKind::Binary:
+    return inferBinary(cast<BinaryExpr>(expr));
+  case ExprKind::Unary:
+    return inferUnary(cast<UnaryExpr>(expr));
+  case ExprKind::Call:
+    return inferCall(cast<CallExpr>(expr));
+  case ExprKind::GenericCall:
+    return inferGenericCall(cast<GenericCallExpr>(expr));
+  case ExprKind::Assign:
+    return inferAssign(cast<AssignExpr>(expr));
+  case ExprKind::Increment:
+    return inferIncDec(cast<Increment>(expr).target.symbol());
+  case ExprKind::Decrement:
+    return inferIncDec(cast<Decrement>(expr).target.symbol());
+  case ExprKind::NewArray:
+    return inferNewArray(cast<NewArrayExpr>(expr));
+  case ExprKind::ArrayIndex:
+    return inferArrayIndex(cast<ArrayIndexExpr>(expr));
+  case ExprKind::ArrayIndexAssign:
+    return inferArrayIndexAssign(cast<ArrayIndexAssignExpr>(expr));
+  case ExprKind::LengthProperty:
+    return inferLengthProp(cast<LengthPropertyExpr>(expr));
+  case ExprKind::IndexedLength:
+    return inferIndexedLength(cast<IndexedLengthExpr>(expr));
+  case ExprKind::FieldAccess:
+    return inferFieldAccess(cast<FieldAccessExpr>(expr));
+  case ExprKind::FieldAssign:
+    return inferFieldAssign(cast<FieldAssignExpr>(expr));
+  case ExprKind::StructLit:
+    return inferStructLit(cast<StructLitExpr>(expr));
+  case ExprKind::CompoundAssign:
+    return inferCompoundAssign(cast<CompoundAssignExpr>(expr));
+  case ExprKind::Error:
+    // The parser has reported it already.
+    return NexusType::make("error");
+  default:
+    break;
+  }
 
   error("Unknown expression kind encountered");
   return NexusType::make("error");
@@ -367,8 +392,8 @@ NexusType TypeChecker::inferNullLit(const NullLitExpr &) {
 // ---------------- //
 
 NexusType TypeChecker::inferIdent(const IdentExpr &e) {
-  const std::string &nm = e.name.token.getWord();
-  auto opt = lookupVar(nm);
+  const std::string nm(e.name.token.getWord());
+  auto opt = lookupVar(e.name.symbol());
   if (!opt) {
     error("Use of undeclared variable '" + nm + "'");
     return NexusType::make("error");
@@ -468,13 +493,13 @@ NexusType TypeChecker::inferCall(const CallExpr &e) {
   std::string nm = "";
   std::string enumPrefix = "";
 
-  if (auto *id = dynamic_cast<const IdentExpr *>(e.callee.get())) {
+  if (auto *id = dyn_cast<IdentExpr>(e.callee.get())) {
     nm = id->name.token.getWord();
-  } else if (auto *fa = dynamic_cast<const FieldAccessExpr *>(e.callee.get())) {
+  } else if (auto *fa = dyn_cast<FieldAccessExpr>(e.callee.get())) {
     std::string variantName = fa->field;
 
-    if (auto *baseId = dynamic_cast<const IdentExpr *>(fa->object.get())) {
-      std::string enumName = baseId->name.token.getWord();
+    if (auto *baseId = dyn_cast<IdentExpr>(fa->object.get())) {
+      std::string enumName(baseId->name.token.getWord());
       nm = enumName + "$" + variantName;
     } else {
       nm = variantName;
@@ -484,7 +509,7 @@ NexusType TypeChecker::inferCall(const CallExpr &e) {
     return NexusType::make("error");
   }
 
-  auto it = funcs_.find(nm);
+  auto it = funcs_.find(Symbol::intern(nm));
   if (it == funcs_.end()) {
     error("Call to undeclared function or variant constructor '" + nm + "'");
     return NexusType::make("error");
@@ -508,13 +533,62 @@ NexusType TypeChecker::inferCall(const CallExpr &e) {
   return sig.ret;
 }
 
+// A generic call is checked against its function's signature with each
+// type parameter replaced by the matching explicit type argument.
+NexusType TypeChecker::inferGenericCall(const GenericCallExpr &e) {
+  const std::string nm(e.callee.token.getWord());
+  auto it = funcs_.find(e.callee.symbol());
+  if (it == funcs_.end() || it->second.typeParams.empty()) {
+    error("Call to undeclared generic function '" + nm + "'");
+    return NexusType::make("error");
+  }
+
+  const FuncSig &sig = it->second;
+  if (e.typeArgs.size() != sig.typeParams.size()) {
+    error("Generic function '" + nm + "' expects " +
+          std::to_string(sig.typeParams.size()) + " type argument(s), got " +
+          std::to_string(e.typeArgs.size()));
+    return NexusType::make("error");
+  }
+  for (auto &ta : e.typeArgs) {
+    NexusType t = NexusType::fromTypeDesc(ta);
+    if (!typeExists(t.base))
+      error("Generic function '" + nm + "' given unknown type argument '" +
+            t.base + "'");
+  }
+
+  auto substitute = [&](const NexusType &t) {
+    for (size_t i = 0; i < sig.typeParams.size(); ++i)
+      if (t.base == sig.typeParams[i]) {
+        NexusType arg = NexusType::fromTypeDesc(e.typeArgs[i]);
+        return NexusType::make(arg.base, arg.dims + t.dims, arg.isPtr);
+      }
+    return t;
+  };
+
+  if (e.arguments.size() != sig.params.size()) {
+    error("Function '" + nm + "' expects " + std::to_string(sig.params.size()) +
+          " argument(s), got " + std::to_string(e.arguments.size()));
+  } else {
+    for (size_t i = 0; i < e.arguments.size(); ++i) {
+      NexusType want = substitute(sig.params[i]);
+      NexusType at = inferExpr(*e.arguments[i]);
+      if (!isAssignable(at, want))
+        error("Function '" + nm + "' argument " + std::to_string(i + 1) +
+              ": expected '" + want.str() + "', got '" + at.str() + "'");
+    }
+  }
+
+  return substitute(sig.ret);
+}
+
 // --------------- //
 //  Assignment     //
 // --------------- //
 
 NexusType TypeChecker::inferAssign(const AssignExpr &e) {
-  const std::string &nm = e.target.token.getWord();
-  auto opt = lookupVar(nm);
+  const std::string nm(e.target.token.getWord());
+  auto opt = lookupVar(e.target.symbol());
   if (!opt) {
     error("Assignment to undeclared variable '" + nm + "'");
     return NexusType::make("error");
@@ -530,10 +604,10 @@ NexusType TypeChecker::inferAssign(const AssignExpr &e) {
 //  Increment / Decrement  //
 // ----------------------- //
 
-NexusType TypeChecker::inferIncDec(const std::string &varName) {
+NexusType TypeChecker::inferIncDec(Symbol varName) {
   auto opt = lookupVar(varName);
   if (!opt) {
-    error("++/-- on undeclared variable '" + varName + "'");
+    error("++/-- on undeclared variable '" + std::string(varName.str()) + "'");
     return NexusType::make("error");
   }
   if (!opt->isNumeric())
@@ -551,12 +625,15 @@ NexusType TypeChecker::inferNewArray(const NewArrayExpr &e) {
     if (!st.isIntegral())
       error("Array size must be 'int', got '" + st.str() + "'");
   }
-  return NexusType::fromTypeDesc(e.arrayType);
+  // arrayType is the element type: new i32[n] is i32[], new i32[][n] i32[][].
+  NexusType t = NexusType::fromTypeDesc(e.arrayType);
+  t.dims += static_cast<int>(e.sizes.size());
+  return t;
 }
 
 NexusType TypeChecker::inferArrayIndex(const ArrayIndexExpr &e) {
-  const std::string &nm = e.array.token.getWord();
-  auto opt = lookupVar(nm);
+  const std::string nm(e.array.token.getWord());
+  auto opt = lookupVar(e.array.symbol());
   if (!opt) {
     error("Array index on undeclared variable '" + nm + "'");
     return NexusType::make("error");
@@ -580,8 +657,8 @@ NexusType TypeChecker::inferArrayIndex(const ArrayIndexExpr &e) {
 }
 
 NexusType TypeChecker::inferArrayIndexAssign(const ArrayIndexAssignExpr &e) {
-  const std::string &nm = e.array.token.getWord();
-  auto opt = lookupVar(nm);
+  const std::string nm(e.array.token.getWord());
+  auto opt = lookupVar(e.array.symbol());
   if (!opt) {
     error("Array index assign on undeclared variable '" + nm + "'");
     return NexusType::make("error");
@@ -609,8 +686,8 @@ NexusType TypeChecker::inferArrayIndexAssign(const ArrayIndexAssignExpr &e) {
 // ----------- //
 
 NexusType TypeChecker::inferLengthProp(const LengthPropertyExpr &e) {
-  const std::string &nm = e.name.token.getWord();
-  auto opt = lookupVar(nm);
+  const std::string nm(e.name.token.getWord());
+  auto opt = lookupVar(e.name.symbol());
   if (!opt) {
     error("'.length' on undeclared variable '" + nm + "'");
     return NexusType::make("int");
@@ -622,8 +699,8 @@ NexusType TypeChecker::inferLengthProp(const LengthPropertyExpr &e) {
 }
 
 NexusType TypeChecker::inferIndexedLength(const IndexedLengthExpr &e) {
-  const std::string &nm = e.arrayName.token.getWord();
-  auto opt = lookupVar(nm);
+  const std::string nm(e.arrayName.token.getWord());
+  auto opt = lookupVar(e.arrayName.symbol());
   if (!opt) {
     error("Indexed '.length' on undeclared variable '" + nm + "'");
     return NexusType::make("int");
@@ -705,8 +782,8 @@ NexusType TypeChecker::inferStructLit(const StructLitExpr &e) {
 // ------------------ //
 
 NexusType TypeChecker::inferCompoundAssign(const CompoundAssignExpr &e) {
-  const std::string &nm = e.target.token.getWord();
-  auto opt = lookupVar(nm);
+  const std::string nm(e.target.token.getWord());
+  auto opt = lookupVar(e.target.symbol());
   if (!opt) {
     error("Compound assignment to undeclared variable '" + nm + "'");
     return NexusType::make("error");
@@ -2,6 +2,7 @@
 #define TYPE_CHECKER_H
 
 #include "../AST/AST.h"
+#include "../Token/Symbol.h"
 
 #include <optional>
 #include <stdexcept>
@@ -47,7 +48,7 @@ struct NexusType {
   }
 
   static NexusType fromTypeDesc(const TypeDesc &td) {
-    std::string raw = td.isPtr ? "ptr" : td.base.token.getWord();
+    std::string raw(td.isPtr ? "ptr" : td.base.token.getWord());
     return make(normalizeBase(raw), td.dimensions, td.isPtr);
   }
 
@@ -113,27 +114,31 @@ public:
 
 private:
   struct FuncSig {
+    std::vector<std::string> typeParams; // generic functions only
     std::vector<NexusType> params;
     NexusType ret;
   };
 
-  std::unordered_map<std::string, FuncSig> funcs_;
+  std::unordered_map<Symbol, FuncSig> funcs_;
   std::unordered_map<std::string,
                      std::vector<std::pair<std::string, NexusType>>>
       structs_;
 
-  using Scope = std::unordered_map<std::string, NexusType>;
+  using Scope = std::unordered_map<Symbol, NexusType>;
   std::vector<Scope> scopes_;
 
   NexusType currentReturnType_;
+  // Type parameters of the generic struct or function being checked; they
+  // stand for any type, so only their spelling is checked.
+  std::vector<std::string> typeParams_;
 
   std::vector<std::string> errors_;
 
   void pushScope() { scopes_.emplace_back(); }
   void popScope() { scopes_.pop_back(); }
 
-  void declareVar(const std::string &name, const NexusType &type);
-  std::optional<NexusType> lookupVar(const std::string &name) const;
+  void declareVar(Symbol name, const NexusType &type);
+  std::optional<NexusType> lookupVar(Symbol name) const;
 
   void error(const std::string &msg) { errors_.push_back(msg); }
   bool typeExists(const std::string &name) const;
@@ -168,8 +173,9 @@ private:
   NexusType inferBinary(const BinaryExpr &e);
   NexusType inferUnary(const UnaryExpr &e);
   NexusType inferCall(const CallExpr &e);
+  NexusType inferGenericCall(const GenericCallExpr &e);
   NexusType inferAssign(const AssignExpr &e);
-  NexusType inferIncDec(const std::string &varName);
+  NexusType inferIncDec(Symbol varName);
   NexusType inferNewArray(const NewArrayExpr &e);
   NexusType inferArrayIndex(const ArrayIndexExpr &e);
   NexusType inferArrayIndexAssign(const ArrayIndexAssignExpr &e);
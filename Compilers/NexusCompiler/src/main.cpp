@@ -1,18 +1,28 @@
 #include "CodeGen/CodeGen.h"
+#include "CodeGen/CodeGenOptions.h"
 #include "CodeGen/Manager/ModuleManager.h"
+#include "Driver/BuildCache.h"
+#include "Driver/OutputCapture.h"
+#include "Driver/TempDir.h"
+#include "Driver/ThreadPool.h"
+#include "Driver/TimeReport.h"
 #include "FileReader/FileReader.h"
 #include "Lexer/Lexer.h"
 #include "Parser/Parser.h"
 #include "Token/TokenType.h"
 #include "TypeChecker/TypeChecker.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <optional>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -150,6 +160,8 @@ std::string setupStdlibPath() {
 // Utility functions  //
 // ------------------ //
 
+const char *const kNexusVersion = "1.5.0";
+
 bool endsWith(const std::string &str, const std::string &suffix) {
   if (str.length() < suffix.length())
     return false;
@@ -161,15 +173,345 @@ bool hasValidExt(const std::string &f) {
   return endsWith(f, ".nx") || endsWith(f, ".nex") || endsWith(f, ".nexus");
 }
 
-std::string getOutputName(const std::string &file) {
-  size_t pos = file.find_last_of('.');
-  std::string base = (pos == std::string::npos) ? file : file.substr(0, pos);
+#ifdef _WIN32
+const char *const kExecutableExt = ".exe";
+#else
+const char *const kExecutableExt = ".x";
+#endif
+
+// Shown after a successful link; relative paths get a "./" prefix on unix.
+std::string runHint(const fs::path &output) {
+#ifdef _WIN32
+  return output.string();
+#else
+  if (output.is_absolute() || output.string().rfind(".", 0) == 0)
+    return output.string();
+  return "./" + output.string();
+#endif
+}
 
+// Runs a shell command, forwarding its combined output through std::cerr so
+// it is captured together with the rest of a compilation's diagnostics.
+int runCommand(const std::string &cmd) {
 #ifdef _WIN32
-  return base + ".exe";
+  FILE *pipe = _popen((cmd + " 2>&1").c_str(), "r");
 #else
-  return base + ".x";
+  FILE *pipe = popen((cmd + " 2>&1").c_str(), "r");
 #endif
+  if (!pipe)
+    return -1;
+
+  char buf[4096];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), pipe)) > 0)
+    std::cerr.write(buf, static_cast<std::streamsize>(n));
+
+#ifdef _WIN32
+  return _pclose(pipe);
+#else
+  return pclose(pipe);
+#endif
+}
+
+void printUsage(std::ostream &os) {
+  os << "Usage: nexus [options] [files...]\n";
+  os << "Options:\n";
+  os << "  init          Initialize or reconfigure standard library path\n";
+  os << "  --version     Show version information\n";
+  os << "  --help        Show this message\n";
+  os << "  --profile=<p> Build profile: debug (default), release or sanitize\n";
+  os << "  -O<level>     Optimisation level 0-3 or s (overrides profile)\n";
+  os << "  --emit=<kind> Stop after writing obj, asm, llvm-ir or bitcode\n";
+  os << "  --bounds-check=<m>\n";
+  os << "                Index checks: off (default), on (trap) or debug\n";
+  os << "  --output-buffer=<m>\n";
+  os << "                stdout flushing: auto (default), line or full\n";
+  os << "  -j <N>        Compile up to N files in parallel (0 = all cores)\n";
+  os << "  -o <file>     Output path (single input only)\n";
+  os << "  --out-dir <d> Directory for outputs, named after each input\n";
+  os << "                (inputs must have distinct file names)\n";
+  os << "  --no-cache    Do not read or write the incremental build cache\n";
+  os << "  --time-report Print per-phase timings and stats for each input\n";
+  os << "  --stats       Print AST, IR and generic instantiation counts\n";
+  os << "  --trace=<f>   Write a Chrome trace of every phase to <f>\n";
+}
+
+// ------------------ //
+// Single compilation //
+// ------------------ //
+
+struct DriverConfig {
+  std::string stdlibRoot;
+  CodeGenOptions cgOpts;
+  bool linkOutput = true;
+  std::optional<fs::path> outFile;    // -o
+  std::optional<fs::path> outDir;     // --out-dir
+  fs::path tempDir;                   // private scratch dir for objects
+  ModuleCache *moduleCache = nullptr; // parsed imports, shared by all files
+  BuildCache *buildCache = nullptr;   // on-disk artifacts; null = --no-cache
+  bool timeReport = false;            // --time-report
+  bool stats = false;                 // --stats
+  TraceLog *trace = nullptr;          // --trace; null = no trace
+};
+
+// Final artifact path for one input: -o wins, then --out-dir, otherwise the
+// file sits next to the input. ext is the extension to use when no -o is
+// given (executable or --emit artifact).
+fs::path resolveOutputPath(const std::string &file, const DriverConfig &cfg,
+                           const std::string &ext) {
+  if (cfg.outFile)
+    return *cfg.outFile;
+  fs::path name = fs::path(file).filename().replace_extension(ext);
+  if (cfg.outDir)
+    return *cfg.outDir / name;
+  return fs::path(file).replace_extension(ext);
+}
+
+// Runs the front end and code generation for one input and writes the
+// result to artifact. deps receives every module file the input imported.
+// cacheable is cleared when diagnostics were reported: a cache hit would
+// reuse the artifact without showing them again.
+bool generateArtifact(const std::string &file, const DriverConfig &cfg,
+                      const fs::path &artifact, std::vector<fs::path> &deps,
+                      bool &cacheable) {
+  cacheable = false;
+  std::optional<SourceBuffer> codeOpt;
+  {
+    TimeScope scope("read");
+    codeOpt = readFile(file.c_str());
+  }
+  if (!codeOpt.has_value()) {
+    std::cerr << "Failed to read file: " << file << "\n";
+    return false;
+  }
+
+  std::cout << "\n--- " << file << " ---\n";
+
+  // Lexer + parser: the parser pulls tokens as it needs them, so the two
+  // run interleaved and are timed together.
+  auto parseStart = std::chrono::high_resolution_clock::now();
+  std::optional<TimeScope> parseScope(std::in_place, "parse");
+
+  Lexer lexer(std::move(*codeOpt));
+  Parser parser(lexer);
+  auto parsed = parser.parse();
+
+  parseScope.reset();
+  auto parseEnd = std::chrono::high_resolution_clock::now();
+  double parseMs =
+      std::chrono::duration<double, std::milli>(parseEnd - parseStart).count();
+  double parseS = parseMs / 1000.0;
+  double tokPerSec = lexer.tokenCount() / (parseS > 0.0 ? parseS : 1.0);
+
+  std::cout << "Tokens     : " << lexer.tokenCount() << "\n";
+  std::cout << "Parse time : " << parseS << " s  ("
+            << static_cast<long long>(tokPerSec) << " tok/s)\n";
+
+  // Syntax errors are reported, and the statements they hit dropped, but
+  // compilation carries on as it always has.
+  for (const ParseDiagnostic &d : parser.diagnostics())
+    std::cerr << d;
+
+  TimeReport::count("tokens", lexer.tokenCount());
+  TimeReport::count("AST nodes", parsed->arena->nodeCount());
+
+  fs::path projectRoot = fs::path(file).parent_path();
+
+  // Linking modules I need
+  ModuleManager mm(projectRoot, fs::path(cfg.stdlibRoot), *cfg.moduleCache);
+  {
+    TimeScope scope("resolve imports");
+    mm.resolveAll(*parsed);
+  }
+
+  // Type-checker
+  /*TypeChecker tc;
+  if (!tc.check(*parsed)) {
+    std::cerr << "Type errors in '" << file << "':\n";
+    for (const auto &err : tc.errors())
+      std::cerr << "  error: " << err << "\n";
+    std::cerr << tc.errors().size() << " error(s) — compilation aborted.\n";
+    return false;
+  }*/
+  std::cout << "Type-check : OK\n";
+
+  // Code generation
+  bool generated;
+  {
+    TimeScope scope("codegen");
+    CodeGenerator cg(cfg.cgOpts);
+    generated = cg.generate(*parsed, artifact.string(), file);
+    cacheable = !cg.reportedErrors();
+  }
+  if (!generated) {
+    std::cerr << "error: code generation failed for '" << file << "'\n";
+    return false;
+  }
+
+  // Syntax errors in imports count too: they dropped declarations the
+  // artifact would otherwise contain.
+  cacheable =
+      cacheable && parser.diagnostics().empty() && !mm.hadDiagnostics();
+  deps = mm.dependencies();
+  return true;
+}
+
+// Links a compiled object into the final executable for file.
+bool linkArtifact(const std::string &file, const DriverConfig &cfg,
+                  const fs::path &artifact) {
+  fs::path output = resolveOutputPath(file, cfg, kExecutableExt);
+
+  fs::path shimsPath = fs::path(cfg.stdlibRoot) / "nexus_shims.c";
+  std::string shimsArg =
+      fs::exists(shimsPath) ? " \"" + shimsPath.string() + "\"" : "";
+
+  fs::path gladPath = fs::path(cfg.stdlibRoot) / "src" / "glad.c";
+  std::string gladArg =
+      fs::exists(gladPath) ? " \"" + gladPath.string() + "\"" : "";
+
+  std::string includeArg = "";
+  if (fs::exists(shimsPath) || fs::exists(gladPath)) {
+    includeArg = " -I\"" + cfg.stdlibRoot + "/include\"";
+  }
+
+  // The object is already compiled; clang only drives the system linker
+  // (and compiles the C shims, hence the optimisation level).
+  std::string cmd = std::string("clang ") + optLevelFlag(cfg.cgOpts.optLevel);
+  if (cfg.cgOpts.debugInfo)
+    cmd += " -g";
+  if (cfg.cgOpts.sanitizeAddress)
+    cmd += " -fsanitize=address -fsanitize=leak";
+  cmd += includeArg + " \"" + artifact.string() + "\"" + shimsArg + gladArg +
+         " -o \"" + output.string() + "\"";
+
+  std::cout << "Linking    : " << output.string() << "\n";
+  int res;
+  {
+    TimeScope scope("link", output.string());
+    res = runCommand(cmd);
+  }
+
+  if (res != 0) {
+    std::cerr << "error: clang link failed for '" << file << "'\n";
+    return false;
+  }
+
+  std::cout << "OK         : " << output.string() << "\n";
+  std::cout << "Run with   : " << runHint(output) << "\n";
+  return true;
+}
+
+// Everything besides the compiler binary, which BuildCache hashes itself,
+// that changes the compiled artifact, for the build cache key: the flags and
+// the standard library imports resolve against. The project root is the entry file's directory, which
+// the cache already keys on. Link-only settings (output paths) are
+// deliberately left out.
+std::string buildConfigKey(const CodeGenOptions &opts,
+                           const std::string &stdlibRoot) {
+  std::error_code ec;
+  fs::path stdlib = fs::weakly_canonical(stdlibRoot, ec);
+  if (ec)
+    stdlib = stdlibRoot;
+  return std::string("nexus ") + kNexusVersion + "|stdlib " + stdlib.string() +
+         "|" + optLevelFlag(opts.optLevel) + "|" + emitExtension(opts.emit) + "|" +
+         (opts.debugInfo ? "g" : "nog") + "|" +
+         (opts.sanitizeAddress ? "asan" : "noasan") + "|bounds-" +
+         boundsCheckName(opts.boundsCheck) + "|out-" +
+         outputBufferName(opts.outputBuffer);
+}
+
+// Compiles and links one input file. All output goes through std::cout /
+// std::cerr so that parallel builds can capture it per file. index is the
+// file's position on the command line and keeps scratch names unique.
+bool buildFile(const std::string &file, size_t index,
+               const DriverConfig &cfg) {
+  if (!hasValidExt(file)) {
+    std::cerr << "Skipping invalid file: " << file << "\n";
+    return false;
+  }
+
+  // --emit writes straight to the requested location; otherwise the object
+  // is a scratch file in this run's private temp dir, unique per input.
+  std::string ext = emitExtension(cfg.cgOpts.emit);
+  fs::path scratchName = fs::path(file).filename().replace_extension(ext);
+  fs::path artifact =
+      cfg.linkOutput
+          ? cfg.tempDir / (std::to_string(index) + "-" + scratchName.string())
+          : resolveOutputPath(file, cfg, ext);
+
+  std::optional<fs::path> cached;
+  if (cfg.buildCache) {
+    TimeScope scope("cache lookup");
+    cached = cfg.buildCache->lookup(file);
+  }
+
+  if (cached) {
+    std::cout << "\n--- " << file << " ---\n";
+    std::cout << "Cache      : hit\n";
+    if (cfg.linkOutput) {
+      // Link straight from the cache entry; it is never modified.
+      artifact = *cached;
+    } else {
+      std::error_code ec;
+      fs::copy_file(*cached, artifact, fs::copy_options::overwrite_existing,
+                    ec);
+      if (ec) {
+        std::cerr << "error: cannot write '" << artifact.string()
+                  << "': " << ec.message() << "\n";
+        return false;
+      }
+    }
+  } else {
+    std::vector<fs::path> deps;
+    bool cacheable;
+    if (!generateArtifact(file, cfg, artifact, deps, cacheable))
+      return false;
+    if (cfg.buildCache && cacheable) {
+      TimeScope scope("cache store");
+      cfg.buildCache->store(file, deps, artifact);
+    }
+  }
+
+  if (!cfg.linkOutput) {
+    std::cout << "Emitted    : " << artifact.string() << "\n";
+    return true;
+  }
+
+  return linkArtifact(file, cfg, artifact);
+}
+
+// buildFile, turning an exception it throws (a circular import, an
+// unreadable module) into this file's failure rather than the whole run's.
+// The error is written after whatever the file already printed, so under -j
+// it is replayed behind the worker's captured diagnostics, not instead of
+// them.
+bool buildFileOrReport(const std::string &file, size_t index,
+                       const DriverConfig &cfg) {
+  try {
+    return buildFile(file, index, cfg);
+  } catch (const std::exception &e) {
+    std::cerr << "error: " << file << ": " << e.what() << "\n";
+    return false;
+  }
+}
+
+// buildFile, recording a TimeReport for --time-report, --stats and --trace.
+bool compileFile(const std::string &file, size_t index,
+                 const DriverConfig &cfg) {
+  if (!cfg.timeReport && !cfg.stats && !cfg.trace)
+    return buildFileOrReport(file, index, cfg);
+
+  TimeReport report;
+  bool ok;
+  {
+    TimeScope scope("compile");
+    ok = buildFileOrReport(file, index, cfg);
+  }
+  if (cfg.timeReport || cfg.stats)
+    report.print(std::cout, file, cfg.timeReport);
+  if (cfg.trace)
+    cfg.trace->add(report, index, file);
+  return ok;
 }
 
 // ----- //
@@ -178,18 +520,19 @@ std::string getOutputName(const std::string &file) {
 
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    std::cerr << "Usage: nexus [options] [files...]\n";
-    std::cerr << "Options:\n";
-    std::cerr
-        << "  init          Initialize or reconfigure standard library path\n";
-    std::cerr << "  --version     Show version information\n";
+    printUsage(std::cerr);
     return EXIT_FAILURE;
   }
 
   std::string firstArg = argv[1];
 
+  if (firstArg == "--help" || firstArg == "-h") {
+    printUsage(std::cout);
+    return 0;
+  }
+
   if (firstArg == "--version") {
-    std::cout << "nexus 1.5.0\n";
+    std::cout << "nexus " << kNexusVersion << "\n";
     return 0;
   }
 
@@ -200,18 +543,102 @@ int main(int argc, char *argv[]) {
     return 0;
   }
 
-  std::optional<std::string> stdlibOpt = loadStdlibPath();
-
-  if (!stdlibOpt.has_value()) {
-    std::cout << "No standard library path has been configured yet.\n";
-    stdlibOpt = setupStdlibPath();
-  }
-
-  std::string stdlibRoot = stdlibOpt.value();
-
+  CodeGenOptions cgOpts;
+  BuildProfile profile = BuildProfile::Debug;
+  std::optional<OptLevel> optOverride;
+  bool linkOutput = true;
+  unsigned jobs = 1;
+  std::optional<fs::path> outFile;
+  std::optional<fs::path> outDir;
+  bool useCache = true;
+  bool timeReport = false;
+  bool stats = false;
+  std::optional<std::string> tracePath;
   std::vector<std::string> inputs;
   for (int i = 1; i < argc; i++) {
-    inputs.push_back(argv[i]);
+    std::string arg = argv[i];
+    if (auto level = parseOptLevel(arg)) {
+      optOverride = *level;
+    } else if (arg.rfind("-j", 0) == 0) {
+      std::string n = arg.size() > 2 ? arg.substr(2) : "";
+      if (n.empty() && i + 1 < argc)
+        n = argv[++i];
+      bool isNumber =
+          !n.empty() && n.find_first_not_of("0123456789") == std::string::npos;
+      if (!isNumber) {
+        std::cerr << "Error: -j expects a number of jobs\n";
+        return EXIT_FAILURE;
+      }
+      jobs = static_cast<unsigned>(std::stoul(n));
+      if (jobs == 0)
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    } else if (arg.rfind("--profile=", 0) == 0) {
+      auto p = parseBuildProfile(arg.substr(10));
+      if (!p) {
+        std::cerr << "Error: Unknown profile '" << arg.substr(10)
+                  << "' (expected debug, release or sanitize)\n";
+        return EXIT_FAILURE;
+      }
+      profile = *p;
+    } else if (arg.rfind("--bounds-check=", 0) == 0) {
+      auto mode = parseBoundsCheck(arg.substr(15));
+      if (!mode) {
+        std::cerr << "Error: Unknown bounds-check mode '" << arg.substr(15)
+                  << "' (expected off, on or debug)\n";
+        return EXIT_FAILURE;
+      }
+      cgOpts.boundsCheck = *mode;
+    } else if (arg.rfind("--output-buffer=", 0) == 0) {
+      auto mode = parseOutputBuffer(arg.substr(16));
+      if (!mode) {
+        std::cerr << "Error: Unknown output-buffer mode '" << arg.substr(16)
+                  << "' (expected auto, line or full)\n";
+        return EXIT_FAILURE;
+      }
+      cgOpts.outputBuffer = *mode;
+    } else if (arg.rfind("--emit=", 0) == 0) {
+      auto kind = parseEmitKind(arg.substr(7));
+      if (!kind) {
+        std::cerr << "Error: Unknown emit kind '" << arg.substr(7)
+                  << "' (expected obj, asm, llvm-ir or bitcode)\n";
+        return EXIT_FAILURE;
+      }
+      cgOpts.emit = *kind;
+      linkOutput = false;
+    } else if (arg == "-o" || arg == "--out-dir" ||
+               arg.rfind("--out-dir=", 0) == 0) {
+      std::string value;
+      if (arg.rfind("--out-dir=", 0) == 0)
+        value = arg.substr(10);
+      else if (i + 1 < argc)
+        value = argv[++i];
+      if (value.empty()) {
+        std::cerr << "Error: " << arg << " expects a path\n";
+        return EXIT_FAILURE;
+      }
+      if (arg == "-o")
+        outFile = fs::path(value);
+      else
+        outDir = fs::path(value);
+    } else if (arg == "--no-cache") {
+      useCache = false;
+    } else if (arg == "--time-report") {
+      timeReport = true;
+    } else if (arg == "--stats") {
+      stats = true;
+    } else if (arg.rfind("--trace=", 0) == 0) {
+      if (arg.size() == 8) {
+        std::cerr << "Error: --trace expects a path\n";
+        return EXIT_FAILURE;
+      }
+      tracePath = arg.substr(8);
+    } else if (arg.size() > 1 && arg[0] == '-') {
+      std::cerr << "Error: Unknown option '" << arg << "'\n";
+      printUsage(std::cerr);
+      return EXIT_FAILURE;
+    } else {
+      inputs.push_back(arg);
+    }
   }
 
   if (inputs.empty()) {
@@ -219,128 +646,140 @@ int main(int argc, char *argv[]) {
     return EXIT_FAILURE;
   }
 
-  std::cout << "Compiling " << inputs.size() << " Nexus file(s)...\n";
-
-  int compiled = 0;
-  int failed = 0;
-
-  for (const auto &file : inputs) {
-    if (!hasValidExt(file)) {
-      std::cerr << "Skipping invalid file: " << file << "\n";
-      ++failed;
-      continue;
-    }
-
-    std::optional<std::string> codeOpt = readFile(file.c_str());
-    if (!codeOpt.has_value()) {
-      std::cerr << "Failed to read file: " << file << "\n";
-      ++failed;
-      continue;
+  if (outFile && inputs.size() > 1) {
+    std::cerr << "Error: -o cannot be used with multiple input files "
+                 "(use --out-dir)\n";
+    return EXIT_FAILURE;
+  }
+  if (outDir) {
+    std::error_code ec;
+    fs::create_directories(*outDir, ec);
+    if (ec) {
+      std::cerr << "Error: Could not create output directory '"
+                << outDir->string() << "': " << ec.message() << "\n";
+      return EXIT_FAILURE;
     }
+  }
 
-    std::string code = codeOpt.value();
+  // An explicit -O level wins over the profile's default.
+  applyProfile(cgOpts, profile);
+  if (optOverride)
+    cgOpts.optLevel = *optOverride;
 
-    std::cout << "\n--- " << file << " ---\n";
+  std::optional<std::string> stdlibOpt = loadStdlibPath();
 
-    // Lexer
-    auto lexStart = std::chrono::high_resolution_clock::now();
+  if (!stdlibOpt.has_value()) {
+    std::cout << "No standard library path has been configured yet.\n";
+    stdlibOpt = setupStdlibPath();
+  }
 
-    Lexer lexer(code);
-    std::vector<Token> tokens = lexer.Tokenize();
+  std::string stdlibRoot = stdlibOpt.value();
 
-    auto lexEnd = std::chrono::high_resolution_clock::now();
-    double lexMs =
-        std::chrono::duration<double, std::milli>(lexEnd - lexStart).count();
-    double lexS = lexMs / 1000.0;
-    double tokPerSec = tokens.size() / (lexS > 0.0 ? lexS : 1.0);
+  std::cout << "Compiling " << inputs.size() << " Nexus file(s)...\n";
 
-    std::cout << "Tokens     : " << tokens.size() << "\n";
-    std::cout << "Lex time   : " << lexS << " s  ("
-              << static_cast<long long>(tokPerSec) << " tok/s)\n";
+  int compiled = 0;
+  int failed = 0;
 
-    // Parser
-    Parser parser(tokens);
-    auto parsed = parser.parse();
+  TempDir scratch;
+  if (!scratch.valid()) {
+    std::cerr << "Error: Could not create a temporary directory\n";
+    return EXIT_FAILURE;
+  }
 
-    if (!parsed) {
-      std::cerr << "error: parsing failed for '" << file << "'\n";
-      ++failed;
-      continue;
+  ModuleCache moduleCache;
+  std::optional<BuildCache> buildCache;
+  if (useCache)
+    buildCache.emplace(getConfigDir() / "cache",
+                       buildConfigKey(cgOpts, stdlibRoot));
+
+  DriverConfig cfg;
+  cfg.stdlibRoot = stdlibRoot;
+  cfg.cgOpts = cgOpts;
+  cfg.linkOutput = linkOutput;
+  cfg.outFile = outFile;
+  cfg.outDir = outDir;
+  cfg.tempDir = scratch.path();
+  cfg.moduleCache = &moduleCache;
+  cfg.buildCache = buildCache ? &*buildCache : nullptr;
+  cfg.timeReport = timeReport;
+  cfg.stats = stats;
+  TraceLog trace;
+  cfg.trace = tracePath ? &trace : nullptr;
+
+  // --out-dir keeps only file names, so a/main.nx and b/main.nx would both
+  // write <dir>/main, and under -j at the same time.
+  {
+    std::string ext = linkOutput ? kExecutableExt : emitExtension(cgOpts.emit);
+    std::unordered_map<std::string, const std::string *> writers;
+    for (const std::string &input : inputs) {
+      fs::path out = resolveOutputPath(input, cfg, ext);
+      std::error_code ec;
+      if (fs::path canonical = fs::weakly_canonical(out, ec); !ec)
+        out = canonical;
+      auto [it, fresh] = writers.emplace(out.string(), &input);
+      if (!fresh) {
+        std::cerr << "Error: '" << *it->second << "' and '" << input
+                  << "' would both write '" << out.string() << "'\n";
+        return EXIT_FAILURE;
+      }
     }
+  }
 
-    fs::path projectRoot = fs::path(file).parent_path();
-
-    // Linking modules I need
-    ModuleManager mm(projectRoot, fs::path(stdlibRoot));
-    mm.resolveAll(*parsed);
-
-    // Type-checker
-    /*TypeChecker tc;
-    if (!tc.check(*parsed)) {
-      std::cerr << "Type errors in '" << file << "':\n";
-      for (const auto &err : tc.errors())
-        std::cerr << "  error: " << err << "\n";
-      std::cerr << tc.errors().size() << " error(s) — compilation aborted.\n";
-      ++failed;
-      continue;
-    }*/
-    std::cout << "Type-check : OK\n";
-
-    // Code generation
-    CodeGenerator cg;
-    if (!cg.generate(*parsed, "out")) {
-      std::cerr << "error: code generation failed for '" << file << "'\n";
-      ++failed;
-      continue;
+  if (jobs <= 1 || inputs.size() < 2) {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (compileFile(inputs[i], i, cfg))
+        ++compiled;
+      else
+        ++failed;
     }
-
-    // Linking
-    std::string output = getOutputName(file);
-
-    fs::path shimsPath = fs::path(stdlibRoot) / "nexus_shims.c";
-    std::string shimsArg =
-        fs::exists(shimsPath) ? " \"" + shimsPath.string() + "\"" : "";
-
-    fs::path gladPath = fs::path(stdlibRoot) / "src" / "glad.c";
-    std::string gladArg =
-        fs::exists(gladPath) ? " \"" + gladPath.string() + "\"" : "";
-
-    std::string includeArg = "";
-    if (fs::exists(shimsPath) || fs::exists(gladPath)) {
-      includeArg = " -I\"" + stdlibRoot + "/include\"";
+  } else {
+    // Each worker captures its own output; results are replayed in input
+    // order so the log reads exactly as it would for a serial build.
+    OutputCapture::install();
+    struct FileResult {
+      bool ok;
+      std::vector<OutputCapture::Chunk> output;
+    };
+
+    ThreadPool pool(std::min<unsigned>(jobs, inputs.size()));
+    std::vector<std::future<FileResult>> results;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      results.push_back(pool.submit([&cfg, &inputs, i] {
+        OutputCapture capture;
+        bool ok = compileFile(inputs[i], i, cfg);
+        return FileResult{ok, capture.take()};
+      }));
     }
 
-    std::string cmd = "clang -Wno-override-module -fsanitize=address "
-                      "-fsanitize=leak -g" +
-                      includeArg + " out.ll" + shimsArg + gladArg + " -o \"" +
-                      output + "\"";
-
-    std::cout << "Linking    : " << output << "\n";
-    int res = std::system(cmd.c_str());
-    // system("rm -rf out.ll");
-
-    if (res != 0) {
-      std::cerr << "error: clang link failed for '" << file << "'\n";
-      ++failed;
-      continue;
+    for (auto &r : results) {
+      FileResult res = r.get();
+      OutputCapture::replay(res.output);
+      if (res.ok)
+        ++compiled;
+      else
+        ++failed;
     }
-
-    std::cout << "OK         : " << output << "\n";
-    std::cout << "Run with   : "
-#ifdef _WIN32
-              << output << "\n";
-#else
-              << "./" << output << "\n";
-#endif
-    ++compiled;
   }
 
+  if (buildCache)
+    buildCache->prune(BuildCache::kDefaultMaxBytes);
+
   // -------- //
   // Summary  //
   // -------- //
   std::cout << "\n--- Summary ---\n";
   std::cout << "Compiled : " << compiled << "\n";
   std::cout << "Failed   : " << failed << "\n";
+  if (timeReport || stats)
+    std::cout << "Peak RSS : " << peakRssBytes() / (1024 * 1024) << " MiB\n";
+
+  if (tracePath) {
+    if (trace.write(*tracePath))
+      std::cout << "Trace    : " << *tracePath << "\n";
+    else
+      std::cerr << "Warning: Could not write trace file '" << *tracePath
+                << "'\n";
+  }
 
   return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
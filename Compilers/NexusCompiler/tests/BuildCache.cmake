@@ -0,0 +1,70 @@
+# Builds a program with an import twice through the on-disk build cache.
+#
+#   cmake -DNEXUS=<compiler> -DWORK_DIR=<dir> -P BuildCache.cmake
+#
+# While the import has a syntax error the build must not be stored, so the
+# second build compiles again and reports the error again. Once the import
+# is fixed, the second build is a cache hit.
+
+foreach(var NEXUS WORK_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "BuildCache.cmake: ${var} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/home/.config/nexus" "${WORK_DIR}/stdlib")
+file(WRITE "${WORK_DIR}/home/.config/nexus/config" "${WORK_DIR}/stdlib\n")
+set(ENV{HOME} "${WORK_DIR}/home")
+
+file(WRITE "${WORK_DIR}/main.nx" [=[
+import Util;
+
+fn Main() -> i32 {
+    i32 v = Twice(21);
+    Printf("{v}\n");
+    return 0;
+}
+]=])
+
+function(write_util body)
+    file(WRITE "${WORK_DIR}/Util.nx" [=[
+public fn Twice(i32 x) -> i32 {
+    return x * 2;
+}
+public fn Other() -> i32 {
+]=] "    ${body}\n    return 1;\n}\n")
+endfunction()
+
+# Sets <out> to the compiler's combined output.
+function(build out)
+    execute_process(
+        COMMAND "${NEXUS}" -o "${WORK_DIR}/program" "${WORK_DIR}/main.nx"
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+    )
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "compilation failed (${result}):\n${output}")
+    endif()
+    set(${out} "${output}" PARENT_SCOPE)
+endfunction()
+
+write_util("i32 y = ;")
+build(first)
+build(second)
+string(FIND "${second}" "Cache      : hit" hit)
+string(FIND "${second}" "In module" diagnosed)
+if(NOT hit EQUAL -1 OR diagnosed EQUAL -1)
+    message(FATAL_ERROR "a build whose import had syntax errors was cached:\n"
+                        "${second}")
+endif()
+
+write_util("i32 y = 1;")
+build(first)
+build(second)
+string(FIND "${second}" "Cache      : hit" hit)
+if(hit EQUAL -1)
+    message(FATAL_ERROR "a clean build was not reused:\n${second}")
+endif()
@@ -0,0 +1,56 @@
+# Checks that debug info places each function in the file it came from.
+#
+#   cmake -DNEXUS=<compiler> -DWORK_DIR=<dir> -P DebugInfo.cmake
+#
+# main.nx imports Util.nx; in the emitted IR, Twice's DISubprogram must
+# point at a DIFile for Util.nx and Main's at one for main.nx.
+
+foreach(var NEXUS WORK_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "DebugInfo.cmake: ${var} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/home/.config/nexus" "${WORK_DIR}/stdlib")
+file(WRITE "${WORK_DIR}/home/.config/nexus/config" "${WORK_DIR}/stdlib\n")
+set(ENV{HOME} "${WORK_DIR}/home")
+
+file(WRITE "${WORK_DIR}/Util.nx" [=[
+public fn Twice(i32 x) -> i32 {
+    return x * 2;
+}
+]=])
+file(WRITE "${WORK_DIR}/main.nx" [=[
+import Util;
+
+fn Main() -> i32 {
+    i32 v = Twice(21);
+    return v;
+}
+]=])
+
+execute_process(
+    COMMAND "${NEXUS}" --no-cache --emit=llvm-ir -o "${WORK_DIR}/main.ll"
+            "${WORK_DIR}/main.nx"
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "compilation failed (${result}):\n${output}")
+endif()
+file(READ "${WORK_DIR}/main.ll" ir)
+
+foreach(pair "Twice;Util.nx" "Main;main.nx")
+    list(GET pair 0 fn)
+    list(GET pair 1 want)
+    if(NOT ir MATCHES "DISubprogram\\(name: \"${fn}\"[^\n]* file: (![0-9]+)")
+        message(FATAL_ERROR "no subprogram for ${fn}:\n${ir}")
+    endif()
+    set(id "${CMAKE_MATCH_1}")
+    if(NOT ir MATCHES "\n${id} = !DIFile\\(filename: \"${want}\"")
+        message(FATAL_ERROR "${fn} is not described in ${want}:\n${ir}")
+    endif()
+endforeach()
@@ -0,0 +1,55 @@
+# Builds three inputs that import the same module in one -j run.
+#
+#   cmake -DNEXUS=<compiler> -DWORK_DIR=<dir> -P ModuleCache.cmake
+#
+# Each input gets its own --time-report, and only the build that parsed the
+# module counts it, so across all reports "modules parsed" must add up to 1.
+
+foreach(var NEXUS WORK_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "ModuleCache.cmake: ${var} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/home/.config/nexus" "${WORK_DIR}/stdlib")
+file(WRITE "${WORK_DIR}/home/.config/nexus/config" "${WORK_DIR}/stdlib\n")
+set(ENV{HOME} "${WORK_DIR}/home")
+
+file(WRITE "${WORK_DIR}/Util.nx" [=[
+public fn Twice(i32 x) -> i32 {
+    return x * 2;
+}
+]=])
+foreach(input a b c)
+    file(WRITE "${WORK_DIR}/${input}.nx" [=[
+import Util;
+
+fn Main() -> i32 {
+    return Twice(2) - 4;
+}
+]=])
+endforeach()
+
+execute_process(
+    COMMAND "${NEXUS}" --no-cache -j2 --time-report --out-dir "${WORK_DIR}/out"
+            a.nx b.nx c.nx
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "build failed (${result}):\n${output}")
+endif()
+
+string(REGEX MATCHALL "modules parsed *: *[0-9]+" counts "${output}")
+set(parsed 0)
+foreach(line IN LISTS counts)
+    string(REGEX REPLACE ".*: *" "" n "${line}")
+    math(EXPR parsed "${parsed} + ${n}")
+endforeach()
+if(NOT parsed EQUAL 1)
+    message(FATAL_ERROR "Util.nx was parsed ${parsed} times, expected once:\n"
+                        "${output}")
+endif()
@@ -0,0 +1,57 @@
+# Builds two inputs into one --out-dir.
+#
+#   cmake -DNEXUS=<compiler> -DWORK_DIR=<dir> -P OutDir.cmake
+#
+# a/main.nx and b/main.nx would both become <dir>/main, so the driver must
+# refuse before compiling either. Inputs with different names both build.
+
+foreach(var NEXUS WORK_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "OutDir.cmake: ${var} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/home/.config/nexus" "${WORK_DIR}/stdlib")
+file(WRITE "${WORK_DIR}/home/.config/nexus/config" "${WORK_DIR}/stdlib\n")
+set(ENV{HOME} "${WORK_DIR}/home")
+
+set(program [=[
+fn Main() -> i32 {
+    return 0;
+}
+]=])
+foreach(src a/main.nx b/main.nx b/other.nx)
+    file(WRITE "${WORK_DIR}/${src}" "${program}")
+endforeach()
+
+execute_process(
+    COMMAND "${NEXUS}" --no-cache -j2 --out-dir "${WORK_DIR}/out"
+            a/main.nx b/main.nx
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+)
+string(FIND "${output}" "would both write" at)
+if(result EQUAL 0 OR at EQUAL -1)
+    message(FATAL_ERROR "colliding outputs were not rejected (${result}):\n"
+                        "${output}")
+endif()
+file(GLOB written "${WORK_DIR}/out/*")
+if(written)
+    message(FATAL_ERROR "rejected build still wrote: ${written}")
+endif()
+
+execute_process(
+    COMMAND "${NEXUS}" --no-cache -j2 --out-dir "${WORK_DIR}/out"
+            a/main.nx b/other.nx
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "distinct outputs failed to build (${result}):\n"
+                        "${output}")
+endif()
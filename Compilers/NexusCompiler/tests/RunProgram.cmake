@@ -0,0 +1,103 @@
+# Compiles one Nexus program, runs it and checks what it does.
+#
+#   cmake -DNEXUS=<compiler> -DSOURCE=<file.nx> -DWORK_DIR=<dir>
+#         [-DFLAGS=<flag;...>] [-DEXPECTED=<file.out>]
+#         [-DEXPECT_STDERR=<text>] [-DEXPECT_EXIT=0|nonzero]
+#         [-DEXPECT_COMPILE_ERROR=<text>]
+#         [-DEXPECT_DIAGNOSTICS=<text;...>] -P RunProgram.cmake
+#
+# EXPECTED holds the exact stdout, with ESC written as \e so colour
+# sequences stay readable. EXPECT_STDERR must appear somewhere in stderr.
+# EXPECT_COMPILE_ERROR means compilation must fail and print that text.
+# Each of EXPECT_DIAGNOSTICS must appear in the compiler's output of an
+# otherwise successful build.
+#
+# nexus reads the standard library path from $HOME/.config/nexus/config and
+# asks for it interactively when it is missing, so the test gets a HOME of
+# its own inside WORK_DIR.
+
+foreach(var NEXUS SOURCE WORK_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "RunProgram.cmake: ${var} is not set")
+    endif()
+endforeach()
+if(NOT DEFINED EXPECT_EXIT)
+    set(EXPECT_EXIT 0)
+endif()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/home/.config/nexus" "${WORK_DIR}/stdlib")
+file(WRITE "${WORK_DIR}/home/.config/nexus/config" "${WORK_DIR}/stdlib\n")
+set(ENV{HOME} "${WORK_DIR}/home")
+
+set(program "${WORK_DIR}/program")
+execute_process(
+    COMMAND "${NEXUS}" --no-cache ${FLAGS} -o "${program}" "${SOURCE}"
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE compile_result
+    OUTPUT_VARIABLE compile_out
+    ERROR_VARIABLE compile_out
+)
+
+if(DEFINED EXPECT_COMPILE_ERROR)
+    string(FIND "${compile_out}" "${EXPECT_COMPILE_ERROR}" at)
+    if(compile_result EQUAL 0 OR at EQUAL -1)
+        message(FATAL_ERROR "expected compilation to fail with "
+                            "'${EXPECT_COMPILE_ERROR}', got (${compile_result}):\n"
+                            "${compile_out}")
+    endif()
+    return()
+endif()
+
+if(NOT compile_result EQUAL 0 OR NOT EXISTS "${program}")
+    message(FATAL_ERROR "compilation failed (${compile_result}):\n${compile_out}")
+endif()
+
+foreach(diagnostic IN LISTS EXPECT_DIAGNOSTICS)
+    string(FIND "${compile_out}" "${diagnostic}" at)
+    if(at EQUAL -1)
+        message(FATAL_ERROR "compiler output lacks '${diagnostic}':\n"
+                            "${compile_out}")
+    endif()
+endforeach()
+
+# glibc aborts on double or invalid frees and scribbles over freed memory,
+# so an ownership bug fails the test instead of passing by luck.
+set(ENV{MALLOC_CHECK_} 3)
+set(ENV{MALLOC_PERTURB_} 165)
+execute_process(
+    COMMAND "${program}"
+    WORKING_DIRECTORY "${WORK_DIR}"
+    INPUT_FILE /dev/null
+    RESULT_VARIABLE run_result
+    OUTPUT_VARIABLE run_out
+    ERROR_VARIABLE run_err
+)
+
+if(EXPECT_EXIT STREQUAL "nonzero")
+    if(run_result EQUAL 0)
+        message(FATAL_ERROR "expected a failing exit status, got 0\n"
+                            "stdout:\n${run_out}\nstderr:\n${run_err}")
+    endif()
+elseif(NOT run_result STREQUAL EXPECT_EXIT)
+    message(FATAL_ERROR "expected exit status ${EXPECT_EXIT}, got "
+                        "'${run_result}'\nstdout:\n${run_out}\n"
+                        "stderr:\n${run_err}")
+endif()
+
+if(DEFINED EXPECTED)
+    file(READ "${EXPECTED}" want)
+    string(ASCII 27 esc)
+    string(REPLACE "${esc}" "\\e" got "${run_out}")
+    if(NOT got STREQUAL want)
+        message(FATAL_ERROR "stdout differs from ${EXPECTED}\n"
+                            "--- expected ---\n${want}--- got ---\n${got}")
+    endif()
+endif()
+
+if(DEFINED EXPECT_STDERR)
+    string(FIND "${run_err}" "${EXPECT_STDERR}" at)
+    if(at EQUAL -1)
+        message(FATAL_ERROR "stderr lacks '${EXPECT_STDERR}':\n${run_err}")
+    endif()
+endif()
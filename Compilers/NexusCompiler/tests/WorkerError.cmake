@@ -0,0 +1,68 @@
+# Builds a file whose imports form a cycle next to a clean file, with -j2.
+#
+#   cmake -DNEXUS=<compiler> -DWORK_DIR=<dir> -P WorkerError.cmake
+#
+# The cycle makes the worker throw after bad.nx has already reported a syntax
+# error. That error must still be printed, ahead of the failure, and good.nx
+# must build as usual.
+
+foreach(var NEXUS WORK_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "WorkerError.cmake: ${var} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/home/.config/nexus" "${WORK_DIR}/stdlib")
+file(WRITE "${WORK_DIR}/home/.config/nexus/config" "${WORK_DIR}/stdlib\n")
+set(ENV{HOME} "${WORK_DIR}/home")
+
+file(WRITE "${WORK_DIR}/A.nx" [=[
+import B;
+
+public fn FromA() -> i32 {
+    return 1;
+}
+]=])
+file(WRITE "${WORK_DIR}/B.nx" [=[
+import A;
+
+public fn FromB() -> i32 {
+    return 2;
+}
+]=])
+file(WRITE "${WORK_DIR}/bad.nx" [=[
+import A;
+
+fn Main() -> i32 {
+    i32 x = ;
+    return 0;
+}
+]=])
+file(WRITE "${WORK_DIR}/good.nx" [=[
+fn Main() -> i32 {
+    return 0;
+}
+]=])
+
+execute_process(
+    COMMAND "${NEXUS}" --no-cache -j2 --out-dir "${WORK_DIR}/out"
+            bad.nx good.nx
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+)
+if(result EQUAL 0 OR NOT result MATCHES "^[0-9]+$")
+    message(FATAL_ERROR "expected a clean failure, got ${result}:\n${output}")
+endif()
+
+string(FIND "${output}" "Unexpected token" syntax)
+string(FIND "${output}" "Circular import detected" cycle)
+if(syntax EQUAL -1 OR cycle EQUAL -1 OR syntax GREATER cycle)
+    message(FATAL_ERROR "bad.nx's diagnostics should precede its failure:\n"
+                        "${output}")
+endif()
+if(NOT output MATCHES "Compiled : 1" OR NOT output MATCHES "Failed   : 1")
+    message(FATAL_ERROR "good.nx should still build:\n${output}")
+endif()